@@ -0,0 +1,206 @@
+//
+//  BGMChunkedTransferTests.m
+//  UHNBGMControllerTests
+//
+//  Created by agent on 2026-10-19.
+//  Copyright © 2026 University Health Network. All rights reserved.
+//
+
+#import <UHNBGMController/UHNBGMController.h>
+#import "BGMSimulatedMeter.h"
+
+SpecBegin(BGMChunkedTransferSpecs)
+
+describe(@"Chunked transfer", ^{
+    __block BGMRecordingDelegate *delegate;
+    __block UHNBGMController *controller;
+    __block BGMSimulatedMeter *meter;
+    
+    beforeEach(^{
+        delegate = [[BGMRecordingDelegate alloc] init];
+        controller = [[UHNBGMController alloc] initWithDelegate:delegate];
+        meter = [[BGMSimulatedMeter alloc] initWithController:controller];
+        [meter addStoredRecordsWithSequenceNumbers:NSMakeRange(1, 50)];
+    });
+    
+    it(@"should transfer the stored records one chunk at a time, reporting the progress", ^{
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"transferComplete"])
+                {
+                    done();
+                }
+            };
+            
+            [controller getStoredRecordsInChunksOfSize:20 fromSequenceNumber:1];
+            expect([controller isChunkedTransferInProgress]).to.beTruthy();
+        });
+        
+        expect(delegate.measurements.count).to.equal(50);
+        expect(delegate.chunkedTransferProgress).to.equal(@[@0.4f, @0.8f, @1.f]);
+        expect([controller chunkedTransferCheckpoint]).to.equal(61);
+        expect([controller isChunkedTransferInProgress]).to.beFalsy();
+        
+        // the count and three range reports
+        expect(meter.writtenCommands.count).to.equal(4);
+    });
+    
+    it(@"should only transfer the records from the first sequence number", ^{
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"transferComplete"])
+                {
+                    done();
+                }
+            };
+            
+            [controller getStoredRecordsInChunksOfSize:20 fromSequenceNumber:41];
+        });
+        
+        expect(delegate.measurements.count).to.equal(10);
+        expect(delegate.measurements[0][kGlucoseMeasurementKeySequenceNumber]).to.equal(41);
+        expect(delegate.chunkedTransferProgress).to.equal(@[@1.f]);
+    });
+    
+    it(@"should complete when the record filter discards the records", ^{
+        UHNBGMRecordFilter *filter = [[UHNBGMRecordFilter alloc] init];
+        filter.latestDate = [NSDate dateWithTimeIntervalSince1970:0];
+        [controller setRecordFilter:filter];
+        
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"transferComplete"])
+                {
+                    done();
+                }
+            };
+            
+            [controller getStoredRecordsInChunksOfSize:20 fromSequenceNumber:1];
+        });
+        
+        expect(delegate.measurements.count).to.equal(0);
+        expect(delegate.chunkedTransferProgress).to.equal(@[@0.4f, @0.8f, @1.f]);
+        expect(meter.writtenCommands.count).to.equal(4);
+    });
+    
+    it(@"should not start another transfer while a chunked transfer is in progress", ^{
+        __block BOOL didCommit = NO;
+        
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"transferComplete"])
+                {
+                    done();
+                }
+            };
+            
+            [controller getStoredRecordsInChunksOfSize:20 fromSequenceNumber:1];
+            [controller getAllStoredRecords];
+            [controller syncStoredRecordsFromSequenceNumber:1 toSequenceNumber:50 commitHandler:^(NSArray *measurements, NSArray *measurementContexts, UHNBGMSyncCommitCompletion completion) {
+                didCommit = YES;
+                completion(YES);
+            }];
+        });
+        
+        expect(didCommit).to.beFalsy();
+        expect(delegate.measurements.count).to.equal(50);
+        expect(meter.writtenCommands.count).to.equal(4);
+        expect([meter storedSequenceNumbers].count).to.equal(50);
+    });
+    
+    it(@"should complete without a range report when there are no records to transfer", ^{
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"transferComplete"])
+                {
+                    done();
+                }
+            };
+            
+            [controller getStoredRecordsInChunksOfSize:20 fromSequenceNumber:51];
+        });
+        
+        expect(delegate.measurements.count).to.equal(0);
+        expect(meter.writtenCommands.count).to.equal(1);
+    });
+    
+    it(@"should complete when the notifications of counted records were lost", ^{
+        meter.lostSequenceNumbers = [NSSet setWithObject:@45];
+        
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"transferComplete"])
+                {
+                    done();
+                }
+            };
+            
+            [controller getStoredRecordsInChunksOfSize:20 fromSequenceNumber:1];
+        });
+        
+        expect(delegate.measurements.count).to.equal(49);
+        
+        // the count, three range reports, the empty range after them and the count that finds no records left
+        expect(meter.writtenCommands.count).to.equal(6);
+    });
+    
+    it(@"should cross a gap in the sequence numbers in a few requests", ^{
+        [meter addStoredRecordsWithSequenceNumbers:NSMakeRange(40000, 5)];
+        
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"transferComplete"])
+                {
+                    done();
+                }
+            };
+            
+            [controller getStoredRecordsInChunksOfSize:20 fromSequenceNumber:1];
+        });
+        
+        expect(delegate.measurements.count).to.equal(55);
+        expect([[delegate.measurements lastObject][kGlucoseMeasurementKeySequenceNumber] integerValue]).to.equal(40004);
+        expect(meter.writtenCommands.count).to.beLessThan(40);
+    });
+    
+    it(@"should resume from the last completed chunk after a disconnect", ^{
+        meter.disconnectAfterNumberOfRecords = 25;
+        
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"disconnect"])
+                {
+                    done();
+                }
+            };
+            
+            [controller getStoredRecordsInChunksOfSize:20 fromSequenceNumber:1];
+        });
+        
+        expect([controller isChunkedTransferInProgress]).to.beFalsy();
+        expect([controller chunkedTransferCheckpoint]).to.equal(21);
+        expect(delegate.measurements.count).to.equal(25);
+        
+        meter.disconnectAfterNumberOfRecords = NSNotFound;
+        [meter reconnect];
+        
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"transferComplete"])
+                {
+                    done();
+                }
+            };
+            
+            expect([controller resumeChunkedTransfer]).to.beTruthy();
+        });
+        
+        // the five records of the interrupted chunk are transferred again
+        expect(delegate.measurements.count).to.equal(55);
+        expect(delegate.measurements[25][kGlucoseMeasurementKeySequenceNumber]).to.equal(21);
+        expect([delegate.chunkedTransferProgress lastObject]).to.equal(1.f);
+        expect([controller resumeChunkedTransfer]).to.beFalsy();
+    });
+});
+
+SpecEnd
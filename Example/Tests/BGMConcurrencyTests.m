@@ -0,0 +1,145 @@
+//
+//  BGMConcurrencyTests.m
+//  UHNBGMControllerTests
+//
+//  Created by agent on 2026-10-19.
+//  Copyright © 2026 University Health Network. All rights reserved.
+//
+
+#import <UHNBGMController/UHNBGMController.h>
+#import "BGMSimulatedMeter.h"
+
+@interface BGMQueueCheckingSink : NSObject <UHNBGMRecordSink>
+@property (nonatomic, assign) const void *expectedQueueKey;
+@property (nonatomic, assign) NSUInteger numberOfMeasurements;
+@property (nonatomic, assign) NSUInteger numberOfMeasurementsOffQueue;
+@end
+
+@implementation BGMQueueCheckingSink
+
+- (UHNBGMRecordSinkInterest) recordSinkInterests;
+{
+    return UHNBGMRecordSinkInterestMeasurements;
+}
+
+- (void) bgmController:(UHNBGMController *) controller didReceiveGlucoseMeasurement:(NSDictionary *) measurementDetails;
+{
+    self.numberOfMeasurements += 1;
+    
+    if (NULL == dispatch_get_specific(self.expectedQueueKey))
+    {
+        self.numberOfMeasurementsOffQueue += 1;
+    }
+}
+
+@end
+
+static const void *kBGMDelegateQueueKey = &kBGMDelegateQueueKey;
+
+SpecBegin(BGMConcurrencySpecs)
+
+describe(@"Concurrency", ^{
+    __block BGMRecordingDelegate *delegate;
+    __block UHNBGMController *controller;
+    __block BGMSimulatedMeter *meter;
+    
+    beforeEach(^{
+        delegate = [[BGMRecordingDelegate alloc] init];
+        controller = [[UHNBGMController alloc] initWithDelegate:delegate];
+        meter = [[BGMSimulatedMeter alloc] initWithController:controller];
+        [meter addStoredRecordsWithSequenceNumbers:NSMakeRange(1, 500)];
+    });
+    
+    it(@"should deliver the records on the delegate queue", ^{
+        dispatch_queue_t delegateQueue = dispatch_queue_create("org.uhn.bgmcontroller.tests.delegate", DISPATCH_QUEUE_SERIAL);
+        dispatch_queue_set_specific(delegateQueue, kBGMDelegateQueueKey, (void *) kBGMDelegateQueueKey, NULL);
+        
+        BGMQueueCheckingSink *sink = [[BGMQueueCheckingSink alloc] init];
+        sink.expectedQueueKey = kBGMDelegateQueueKey;
+        
+        [controller setDelegateQueue:delegateQueue];
+        [controller addRecordSink:sink];
+        
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"transferComplete"])
+                {
+                    dispatch_async(dispatch_get_main_queue(), ^{
+                        done();
+                    });
+                }
+            };
+            
+            // requests may come from any queue
+            dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+                [controller getAllStoredRecords];
+            });
+        });
+        
+        expect(delegate.measurements.count).to.equal(500);
+        expect(sink.numberOfMeasurements).to.equal(500);
+        expect(sink.numberOfMeasurementsOffQueue).to.equal(0);
+        expect(meter.numberOfCallsOffMainQueue).to.equal(0);
+    });
+    
+    it(@"should stay consistent while it is called from many queues during a transfer", ^{
+        __block NSUInteger numberOfTransfers = 0;
+        
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"transferComplete"])
+                {
+                    numberOfTransfers += 1;
+                    done();
+                }
+            };
+            
+            [controller getAllStoredRecords];
+            
+            // hammer the public API while the records are being transferred
+            dispatch_apply(2000, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t iteration) {
+                BGMQueueCheckingSink *sink = [[BGMQueueCheckingSink alloc] init];
+                
+                switch (iteration % 8)
+                {
+                    case 0:
+                        [controller addRecordSink:sink];
+                        [controller removeRecordSink:sink];
+                        break;
+                    case 1:
+                        [controller setHypoglycemiaThreshold:(70 + iteration % 10) hyperglycemiaThreshold:250];
+                        break;
+                    case 2:
+                        [controller isRecordTransferInProgress];
+                        break;
+                    case 3:
+                        [controller isLowBatterySupported];
+                        [controller isGlucoseMeasurementContextSupported];
+                        break;
+                    case 4:
+                        [controller enableLazyRecordParsing:(iteration % 16 < 8)];
+                        break;
+                    case 5:
+                        [controller isSyncInProgress];
+                        [controller isChunkedTransferInProgress];
+                        break;
+                    case 6:
+                        [controller isConnected];
+                        [controller deviceProfile];
+                        break;
+                    default:
+                        [controller chunkedTransferCheckpoint];
+                        break;
+                }
+            });
+        });
+        
+        expect(numberOfTransfers).to.equal(1);
+        expect(delegate.measurements.count).to.equal(500);
+        expect(delegate.measurements[499][kGlucoseMeasurementKeySequenceNumber]).to.equal(500);
+        expect([controller isRecordTransferInProgress]).to.beFalsy();
+        expect(meter.numberOfCallsOffMainQueue).to.equal(0);
+    });
+});
+
+SpecEnd
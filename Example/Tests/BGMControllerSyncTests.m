@@ -0,0 +1,161 @@
+//
+//  BGMControllerSyncTests.m
+//  UHNBGMControllerTests
+//
+//  Created by agent on 2026-10-19.
+//  Copyright © 2026 University Health Network. All rights reserved.
+//
+
+#import <UHNBGMController/UHNBGMController.h>
+#import "BGMSimulatedMeter.h"
+
+SpecBegin(BGMControllerSyncSpecs)
+
+describe(@"Confirmed sync with the simulated meter", ^{
+    __block BGMRecordingDelegate *delegate;
+    __block UHNBGMController *controller;
+    __block BGMSimulatedMeter *meter;
+    __block NSArray *allSequenceNumbers;
+    
+    beforeEach(^{
+        delegate = [[BGMRecordingDelegate alloc] init];
+        controller = [[UHNBGMController alloc] initWithDelegate:delegate];
+        meter = [[BGMSimulatedMeter alloc] initWithController:controller];
+        [meter addStoredRecordsWithSequenceNumbers:NSMakeRange(1, 20)];
+        allSequenceNumbers = [meter storedSequenceNumbers];
+    });
+    
+    it(@"should delete exactly the committed range once the commit succeeds", ^{
+        __block NSArray *committedMeasurements = nil;
+        
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"syncComplete"])
+                {
+                    done();
+                }
+            };
+            
+            [controller syncStoredRecordsFromSequenceNumber:5 toSequenceNumber:14 commitHandler:^(NSArray *measurements, NSArray *measurementContexts, UHNBGMSyncCommitCompletion completion) {
+                committedMeasurements = measurements;
+                completion(YES);
+            }];
+        });
+        
+        expect(committedMeasurements.count).to.equal(10);
+        expect(delegate.numberOfSyncedRecords).to.equal(10);
+        expect([meter storedSequenceNumbers]).to.equal([@[@1, @2, @3, @4] arrayByAddingObjectsFromArray:@[@15, @16, @17, @18, @19, @20]]);
+        expect([controller isSyncInProgress]).to.beFalsy();
+    });
+    
+    it(@"should not delete a record lost in the middle of the transfer", ^{
+        __block NSArray *committedMeasurements = nil;
+        meter.lostSequenceNumbers = [NSSet setWithObjects:@9, @10, nil];
+        
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"syncComplete"])
+                {
+                    done();
+                }
+            };
+            
+            [controller syncStoredRecordsFromSequenceNumber:5 toSequenceNumber:14 commitHandler:^(NSArray *measurements, NSArray *measurementContexts, UHNBGMSyncCommitCompletion completion) {
+                committedMeasurements = measurements;
+                completion(YES);
+            }];
+        });
+        
+        expect(committedMeasurements.count).to.equal(8);
+        expect(delegate.numberOfSyncedRecords).to.equal(8);
+        expect([meter storedSequenceNumbers]).to.equal(@[@1, @2, @3, @4, @9, @10, @15, @16, @17, @18, @19, @20]);
+        
+        // the transfer, then one delete for each run of committed records
+        expect(meter.writtenCommands.count).to.equal(3);
+    });
+    
+    it(@"should not delete anything if the app crashes before the commit completes", ^{
+        waitUntil(^(DoneCallback done) {
+            [controller syncStoredRecordsFromSequenceNumber:1 toSequenceNumber:20 commitHandler:^(NSArray *measurements, NSArray *measurementContexts, UHNBGMSyncCommitCompletion completion) {
+                // the store crashes mid-commit and the completion is never called
+                dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.2 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+                    done();
+                });
+            }];
+        });
+        
+        expect([meter storedSequenceNumbers]).to.equal(allSequenceNumbers);
+        expect(meter.writtenCommands.count).to.equal(1);
+        expect([controller isSyncInProgress]).to.beTruthy();
+    });
+    
+    it(@"should not delete anything if the commit fails", ^{
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"syncFailed"])
+                {
+                    done();
+                }
+            };
+            
+            [controller syncStoredRecordsFromSequenceNumber:1 toSequenceNumber:20 commitHandler:^(NSArray *measurements, NSArray *measurementContexts, UHNBGMSyncCommitCompletion completion) {
+                completion(NO);
+            }];
+        });
+        
+        expect(delegate.didFailSyncWithRecordsCommitted).to.beFalsy();
+        expect([meter storedSequenceNumbers]).to.equal(allSequenceNumbers);
+    });
+    
+    it(@"should not commit or delete anything if the meter disconnects mid-transfer", ^{
+        __block BOOL didCommit = NO;
+        meter.disconnectAfterNumberOfRecords = 7;
+        
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"syncFailed"])
+                {
+                    done();
+                }
+            };
+            
+            [controller syncStoredRecordsFromSequenceNumber:1 toSequenceNumber:20 commitHandler:^(NSArray *measurements, NSArray *measurementContexts, UHNBGMSyncCommitCompletion completion) {
+                didCommit = YES;
+                completion(YES);
+            }];
+        });
+        
+        expect(didCommit).to.beFalsy();
+        expect(delegate.measurements.count).to.equal(7);
+        expect([meter storedSequenceNumbers]).to.equal(allSequenceNumbers);
+    });
+    
+    it(@"should ignore a late commit after the meter disconnected", ^{
+        __block UHNBGMSyncCommitCompletion lateCompletion = nil;
+        
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"disconnect"])
+                {
+                    lateCompletion(YES);
+                }
+                else if ([event isEqualToString:@"syncFailed"])
+                {
+                    // the failure reaches the delegate queue after the disconnect
+                    done();
+                }
+            };
+            
+            [controller syncStoredRecordsFromSequenceNumber:1 toSequenceNumber:20 commitHandler:^(NSArray *measurements, NSArray *measurementContexts, UHNBGMSyncCommitCompletion completion) {
+                lateCompletion = completion;
+                [meter cancelConnection];
+            }];
+        });
+        
+        expect(delegate.didFailSync).to.beTruthy();
+        expect(delegate.didFailSyncWithRecordsCommitted).to.beTruthy();
+        expect([meter storedSequenceNumbers]).to.equal(allSequenceNumbers);
+    });
+});
+
+SpecEnd
@@ -0,0 +1,122 @@
+//
+//  BGMDeviceProfileTests.m
+//  UHNBGMControllerTests
+//
+//  Created by agent on 2026-10-19.
+//  Copyright © 2026 University Health Network. All rights reserved.
+//
+
+#import <UHNBGMController/UHNBGMController.h>
+#import "BGMSimulatedMeter.h"
+
+SpecBegin(BGMDeviceProfileSpecs)
+
+describe(@"Device profile", ^{
+    __block BGMRecordingDelegate *delegate;
+    __block UHNBGMController *controller;
+    __block BGMSimulatedMeter *meter;
+    __block NSUUID *peripheralIdentifier;
+    
+    beforeEach(^{
+        delegate = [[BGMRecordingDelegate alloc] init];
+        controller = [[UHNBGMController alloc] initWithDelegate:delegate];
+        meter = [[BGMSimulatedMeter alloc] initWithController:controller];
+        meter.readLatency = 0.05;
+        peripheralIdentifier = [NSUUID UUID];
+        [meter discoverDeviceInformationServiceWithPeripheralIdentifier:peripheralIdentifier];
+    });
+    
+    afterEach(^{
+        [UHNBGMDeviceProfile removeCachedProfileForPeripheralIdentifier:peripheralIdentifier];
+    });
+    
+    it(@"should read the features and device information as one pipelined batch", ^{
+        __block NSDate *start = [NSDate date];
+        __block NSTimeInterval setupTime = 0;
+        
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"deviceProfile"])
+                {
+                    setupTime = -[start timeIntervalSinceNow];
+                    done();
+                }
+            };
+            
+            [controller getDeviceProfile];
+        });
+        
+        UHNBGMDeviceProfile *profile = delegate.deviceProfile;
+        expect(profile).to.beIdenticalTo([controller deviceProfile]);
+        expect(profile.peripheralIdentifier).to.equal(peripheralIdentifier);
+        expect(profile.modelNumber).to.equal(@"BGM-1");
+        expect(profile.serialNumber).to.equal(@"SN0042");
+        expect(profile.firmwareRevision).to.equal(@"1.2.3");
+        expect(profile.systemID.length).to.equal(8);
+        expect([controller isLowBatterySupported]).to.beTruthy();
+        expect([controller isTimeFaultSupported]).to.beTruthy();
+        
+        // five reads in two round trips rather than five
+        expect(meter.readCharacteristicUUIDs.count).to.equal(5);
+        expect(meter.maximumNumberOfOutstandingReads).to.equal(4);
+        expect(setupTime).to.beLessThan(5 * meter.readLatency);
+    });
+    
+    it(@"should deliver the cached profile of a known peripheral without reading it again", ^{
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"deviceProfile"])
+                {
+                    done();
+                }
+            };
+            
+            [controller getDeviceProfile];
+        });
+        
+        UHNBGMDeviceProfile *profile = delegate.deviceProfile;
+        
+        BGMRecordingDelegate *otherDelegate = [[BGMRecordingDelegate alloc] init];
+        UHNBGMController *otherController = [[UHNBGMController alloc] initWithDelegate:otherDelegate];
+        BGMSimulatedMeter *otherMeter = [[BGMSimulatedMeter alloc] initWithController:otherController];
+        [otherMeter discoverDeviceInformationServiceWithPeripheralIdentifier:peripheralIdentifier];
+        
+        waitUntil(^(DoneCallback done) {
+            otherDelegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"deviceProfile"])
+                {
+                    done();
+                }
+            };
+            
+            [otherController getDeviceProfile];
+        });
+        
+        expect(otherDelegate.deviceProfile).to.beIdenticalTo(profile);
+        expect(otherMeter.readCharacteristicUUIDs.count).to.equal(0);
+        expect([otherController isLowBatterySupported]).to.beTruthy();
+    });
+    
+    it(@"should only read the features when the device information service is not discovered", ^{
+        BGMRecordingDelegate *otherDelegate = [[BGMRecordingDelegate alloc] init];
+        UHNBGMController *otherController = [[UHNBGMController alloc] initWithDelegate:otherDelegate];
+        BGMSimulatedMeter *otherMeter = [[BGMSimulatedMeter alloc] initWithController:otherController];
+        
+        waitUntil(^(DoneCallback done) {
+            otherDelegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"deviceProfile"])
+                {
+                    done();
+                }
+            };
+            
+            [otherController getDeviceProfile];
+        });
+        
+        expect(otherMeter.readCharacteristicUUIDs).to.equal(@[kGlucoseServiceCharacteristicUUIDSupportedFeatures]);
+        expect(otherDelegate.deviceProfile.modelNumber).to.beNil();
+        expect(otherDelegate.deviceProfile.features).notTo.equal(0);
+    });
+});
+
+SpecEnd
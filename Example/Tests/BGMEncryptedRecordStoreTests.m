@@ -0,0 +1,273 @@
+//
+//  BGMEncryptedRecordStoreTests.m
+//  UHNBGMControllerTests
+//
+//  Created by agent on 2026-10-19.
+//  Copyright © 2026 University Health Network. All rights reserved.
+//
+
+#import <UHNBGMController/NSData+GlucoseMeasurementContextParser.h>
+#import <UHNBGMController/UHNBGMController.h>
+#import <UHNBGMController/UHNBGMEncryptedRecordStore.h>
+#import "BGMSimulatedMeter.h"
+
+static NSData *BGMStoreKey(uint8_t value)
+{
+    NSMutableData *key = [NSMutableData dataWithLength:kEncryptedRecordStoreKeyLength];
+    memset([key mutableBytes], value, kEncryptedRecordStoreKeyLength);
+    return key;
+}
+
+static NSString *BGMStorePath(void)
+{
+    return [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+}
+
+static void BGMStoreAddRecords(UHNBGMEncryptedRecordStore *store, NSRange sequenceNumbers)
+{
+    for (NSUInteger sequenceNumber = sequenceNumbers.location; sequenceNumber < NSMaxRange(sequenceNumbers); sequenceNumber++)
+    {
+        BOOL hasContext = (0 == sequenceNumber % 4);
+        NSData *measurementData = [BGMSimulatedMeter measurementWithSequenceNumber:sequenceNumber glucoseConcentration:(80 + sequenceNumber % 120) hasContext:hasContext];
+        NSData *contextData = (hasContext ? [BGMSimulatedMeter measurementContextWithSequenceNumber:sequenceNumber meal:GlucoseMeasurementContextMealPostprandial] : nil);
+        [store addMeasurementData:measurementData contextData:contextData];
+    }
+}
+
+SpecBegin(BGMEncryptedRecordStoreSpecs)
+
+describe(@"Encrypted record store", ^{
+    it(@"should read back the records of a sync from any segment", ^{
+        NSString *path = BGMStorePath();
+        UHNBGMEncryptedRecordStore *store = [[UHNBGMEncryptedRecordStore alloc] initWithPath:path key:BGMStoreKey(1) keyIdentifier:1];
+        store.maximumSegmentLength = 4096;
+        BGMStoreAddRecords(store, NSMakeRange(1, 1000));
+        expect([store flush]).to.beTruthy();
+        expect(store.numberOfRecords).to.equal(1000);
+        expect(store.numberOfSegments).to.beGreaterThan(1);
+        
+        // the file is opened again from its segment headers
+        store = [[UHNBGMEncryptedRecordStore alloc] initWithPath:path key:BGMStoreKey(1) keyIdentifier:1];
+        expect(store.numberOfRecords).to.equal(1000);
+        
+        __block NSUInteger sequenceNumber = 1;
+        __block NSUInteger numberOfContexts = 0;
+        BOOL enumerated = [store enumerateRecordsUsingBlock:^(NSData *measurementData, NSData *measurementContextData, BOOL *stop) {
+            expect(measurementData).to.equal([BGMSimulatedMeter measurementWithSequenceNumber:sequenceNumber glucoseConcentration:(80 + sequenceNumber % 120) hasContext:(nil != measurementContextData)]);
+            numberOfContexts += (measurementContextData ? 1 : 0);
+            sequenceNumber++;
+        }];
+        expect(enumerated).to.beTruthy();
+        expect(sequenceNumber).to.equal(1001);
+        expect(numberOfContexts).to.equal(250);
+        
+        // a segment is read on its own
+        NSUInteger firstSequenceNumber = 1;
+        for (NSUInteger segmentIndex = 0; segmentIndex < 2; segmentIndex++)
+        {
+            firstSequenceNumber += [store numberOfRecordsInSegmentAtIndex:segmentIndex];
+        }
+        
+        __block NSUInteger numberOfRecords = 0;
+        __block NSData *firstMeasurementData = nil;
+        [store enumerateRecordsInSegmentAtIndex:2 usingBlock:^(NSData *measurementData, NSData *measurementContextData, BOOL *stop) {
+            firstMeasurementData = (firstMeasurementData ?: measurementData);
+            numberOfRecords++;
+        }];
+        expect(numberOfRecords).to.equal([store numberOfRecordsInSegmentAtIndex:2]);
+        expect(firstMeasurementData).to.equal([BGMSimulatedMeter measurementWithSequenceNumber:firstSequenceNumber glucoseConcentration:(80 + firstSequenceNumber % 120) hasContext:(0 == firstSequenceNumber % 4)]);
+        expect([store enumerateRecordsInSegmentAtIndex:store.numberOfSegments usingBlock:^(NSData *measurementData, NSData *measurementContextData, BOOL *stop) {}]).to.beFalsy();
+        
+        // no record is stored in the clear
+        NSData *fileData = [NSData dataWithContentsOfFile:path];
+        NSData *measurementData = [BGMSimulatedMeter measurementWithSequenceNumber:500 glucoseConcentration:(80 + 500 % 120) hasContext:NO];
+        expect([fileData rangeOfData:measurementData options:0 range:NSMakeRange(0, [fileData length])].location).to.equal(NSNotFound);
+        
+        [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+    });
+    
+    it(@"should reject a tampered segment", ^{
+        NSString *path = BGMStorePath();
+        UHNBGMEncryptedRecordStore *store = [[UHNBGMEncryptedRecordStore alloc] initWithPath:path key:BGMStoreKey(1) keyIdentifier:1];
+        BGMStoreAddRecords(store, NSMakeRange(1, 10));
+        [store flush];
+        BGMStoreAddRecords(store, NSMakeRange(11, 10));
+        [store flush];
+        store = nil;
+        
+        // one bit of the ciphertext of the last segment is flipped
+        NSMutableData *fileData = [NSMutableData dataWithContentsOfFile:path];
+        ((uint8_t *) [fileData mutableBytes])[[fileData length] - 40] ^= 0x01;
+        [fileData writeToFile:path atomically:YES];
+        
+        store = [[UHNBGMEncryptedRecordStore alloc] initWithPath:path key:BGMStoreKey(1) keyIdentifier:1];
+        UHNBGMEncryptedRecordBlock block = ^(NSData *measurementData, NSData *measurementContextData, BOOL *stop) {};
+        expect([store enumerateRecordsInSegmentAtIndex:0 usingBlock:block]).to.beTruthy();
+        expect([store enumerateRecordsInSegmentAtIndex:1 usingBlock:block]).to.beFalsy();
+        
+        // the wrong key fails authentication too
+        store = [[UHNBGMEncryptedRecordStore alloc] initWithPath:path key:BGMStoreKey(2) keyIdentifier:1];
+        expect([store enumerateRecordsInSegmentAtIndex:0 usingBlock:block]).to.beFalsy();
+        
+        [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+    });
+    
+    it(@"should not open a store with its segments out of order", ^{
+        NSString *path = BGMStorePath();
+        UHNBGMEncryptedRecordStore *store = [[UHNBGMEncryptedRecordStore alloc] initWithPath:path key:BGMStoreKey(1) keyIdentifier:1];
+        BGMStoreAddRecords(store, NSMakeRange(1, 10));
+        [store flush];
+        NSUInteger firstSegmentEnd = (NSUInteger) [[[NSFileManager defaultManager] attributesOfItemAtPath:path error:nil] fileSize];
+        BGMStoreAddRecords(store, NSMakeRange(11, 10));
+        [store flush];
+        store = nil;
+        
+        // the first segment is copied after the last one, every byte of it still authentic
+        NSData *fileData = [NSData dataWithContentsOfFile:path];
+        NSData *firstSegment = [fileData subdataWithRange:NSMakeRange(8, firstSegmentEnd - 8)];
+        NSMutableData *duplicatedData = [fileData mutableCopy];
+        [duplicatedData appendData:firstSegment];
+        [duplicatedData writeToFile:path atomically:YES];
+        expect([[UHNBGMEncryptedRecordStore alloc] initWithPath:path key:BGMStoreKey(1) keyIdentifier:1]).to.beNil();
+        
+        // the first segment is removed, so the second one is read in its place
+        NSMutableData *removedData = [fileData mutableCopy];
+        [removedData replaceBytesInRange:NSMakeRange(8, firstSegmentEnd - 8) withBytes:NULL length:0];
+        [removedData writeToFile:path atomically:YES];
+        expect([[UHNBGMEncryptedRecordStore alloc] initWithPath:path key:BGMStoreKey(1) keyIdentifier:1]).to.beNil();
+        
+        [fileData writeToFile:path atomically:YES];
+        store = [[UHNBGMEncryptedRecordStore alloc] initWithPath:path key:BGMStoreKey(1) keyIdentifier:1];
+        expect(store.numberOfSegments).to.equal(2);
+        
+        [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+    });
+    
+    it(@"should rotate keys", ^{
+        NSString *path = BGMStorePath();
+        UHNBGMEncryptedRecordStore *store = [[UHNBGMEncryptedRecordStore alloc] initWithPath:path key:BGMStoreKey(1) keyIdentifier:1];
+        BGMStoreAddRecords(store, NSMakeRange(1, 10));
+        expect([store rotateToKey:BGMStoreKey(2) identifier:2]).to.beTruthy();
+        BGMStoreAddRecords(store, NSMakeRange(11, 10));
+        [store flush];
+        expect([store keyIdentifierOfSegmentAtIndex:0]).to.equal(1);
+        expect([store keyIdentifierOfSegmentAtIndex:1]).to.equal(2);
+        
+        // the segments of an unknown key cannot be read until the key is added
+        store = [[UHNBGMEncryptedRecordStore alloc] initWithPath:path key:BGMStoreKey(2) keyIdentifier:2];
+        UHNBGMEncryptedRecordBlock block = ^(NSData *measurementData, NSData *measurementContextData, BOOL *stop) {};
+        expect([store enumerateRecordsInSegmentAtIndex:0 usingBlock:block]).to.beFalsy();
+        expect([store enumerateRecordsInSegmentAtIndex:1 usingBlock:block]).to.beTruthy();
+        expect([store addKey:BGMStoreKey(1) forIdentifier:1]).to.beTruthy();
+        expect([store enumerateRecordsInSegmentAtIndex:0 usingBlock:block]).to.beTruthy();
+        
+        expect([store reencryptSegmentsWithCurrentKey]).to.beTruthy();
+        [store removeKeyForIdentifier:1];
+        expect([store keyIdentifierOfSegmentAtIndex:0]).to.equal(2);
+        
+        store = [[UHNBGMEncryptedRecordStore alloc] initWithPath:path key:BGMStoreKey(2) keyIdentifier:2];
+        __block NSUInteger numberOfRecords = 0;
+        expect([store enumerateRecordsUsingBlock:^(NSData *measurementData, NSData *measurementContextData, BOOL *stop) {
+            numberOfRecords++;
+        }]).to.beTruthy();
+        expect(numberOfRecords).to.equal(20);
+        
+        [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+    });
+    
+    it(@"should truncate an incomplete segment", ^{
+        NSString *path = BGMStorePath();
+        expect([[UHNBGMEncryptedRecordStore alloc] initWithPath:path key:[NSData data] keyIdentifier:1]).to.beNil();
+        
+        UHNBGMEncryptedRecordStore *store = [[UHNBGMEncryptedRecordStore alloc] initWithPath:path key:BGMStoreKey(1) keyIdentifier:1];
+        BGMStoreAddRecords(store, NSMakeRange(1, 10));
+        store = nil;
+        unsigned long long fileSize = [[[NSFileManager defaultManager] attributesOfItemAtPath:path error:nil] fileSize];
+        
+        // the start of a segment header, as left by a crash
+        NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingAtPath:path];
+        [fileHandle seekToEndOfFile];
+        [fileHandle writeData:[NSData dataWithBytes:"UHNS\x01\x00\x00\x00" length:8]];
+        [fileHandle closeFile];
+        
+        store = [[UHNBGMEncryptedRecordStore alloc] initWithPath:path key:BGMStoreKey(1) keyIdentifier:1];
+        expect(store.numberOfSegments).to.equal(1);
+        expect(store.numberOfRecords).to.equal(10);
+        expect([[[NSFileManager defaultManager] attributesOfItemAtPath:path error:nil] fileSize]).to.equal(fileSize);
+        
+        // a file that is not a store is not opened
+        [[NSData dataWithBytes:"not a store" length:11] writeToFile:path atomically:YES];
+        expect([[UHNBGMEncryptedRecordStore alloc] initWithPath:path key:BGMStoreKey(1) keyIdentifier:1]).to.beNil();
+        
+        [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+    });
+    
+    it(@"should not open a store damaged before its last segment", ^{
+        NSString *path = BGMStorePath();
+        UHNBGMEncryptedRecordStore *store = [[UHNBGMEncryptedRecordStore alloc] initWithPath:path key:BGMStoreKey(1) keyIdentifier:1];
+        BGMStoreAddRecords(store, NSMakeRange(1, 10000));
+        store = nil;
+        unsigned long long fileSize = [[[NSFileManager defaultManager] attributesOfItemAtPath:path error:nil] fileSize];
+        
+        // the magic of the first segment, right after the file header, is overwritten
+        NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingAtPath:path];
+        [fileHandle seekToFileOffset:8];
+        [fileHandle writeData:[NSData dataWithBytes:"XXXX" length:4]];
+        [fileHandle closeFile];
+        
+        expect([[UHNBGMEncryptedRecordStore alloc] initWithPath:path key:BGMStoreKey(1) keyIdentifier:1]).to.beNil();
+        expect([[[NSFileManager defaultManager] attributesOfItemAtPath:path error:nil] fileSize]).to.equal(fileSize);
+        
+        [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+    });
+    
+    it(@"should store the records of a transfer", ^{
+        // the records parsed eagerly are encoded again, the others are stored as received
+        for (NSNumber *lazyRecordParsing in @[@YES, @NO])
+        {
+            NSString *path = BGMStorePath();
+            BGMRecordingDelegate *delegate = [[BGMRecordingDelegate alloc] init];
+            UHNBGMController *controller = [[UHNBGMController alloc] initWithDelegate:delegate];
+            BGMSimulatedMeter *meter = [[BGMSimulatedMeter alloc] initWithController:controller];
+            [meter addStoredRecordsWithSequenceNumbers:NSMakeRange(1, 5)];
+            [meter addStoredRecordWithSequenceNumber:6 glucoseConcentration:120 mealContext:GlucoseMeasurementContextMealPreprandial];
+            
+            UHNBGMEncryptedRecordStore *store = [[UHNBGMEncryptedRecordStore alloc] initWithPath:path key:BGMStoreKey(1) keyIdentifier:1];
+            [controller enableLazyRecordParsing:[lazyRecordParsing boolValue]];
+            [controller addRecordSink:store];
+            
+            waitUntil(^(DoneCallback done) {
+                delegate.eventHandler = ^(NSString *event) {
+                    if ([event isEqualToString:@"transferComplete"])
+                    {
+                        done();
+                    }
+                };
+                
+                [controller getAllStoredRecords];
+            });
+            
+            waitUntil(^(DoneCallback done) {
+                [controller waitForPendingCallbacksWithCompletion:^{
+                    done();
+                }];
+            });
+            
+            expect(store.numberOfSegments).to.equal(1);
+            expect(store.numberOfRecords).to.equal(6);
+            
+            __block NSData *lastContextData = nil;
+            [store enumerateRecordsUsingBlock:^(NSData *measurementData, NSData *measurementContextData, BOOL *stop) {
+                lastContextData = measurementContextData;
+            }];
+            NSDictionary *contextDetails = [lastContextData parseGlucoseMeasurementContextCharacteristicDetails:NO];
+            expect(contextDetails[kGlucoseMeasurementContextKeySequenceNumber]).to.equal(@6);
+            expect(contextDetails[kGlucoseMeasurementContextKeyMeal]).to.equal(@(GlucoseMeasurementContextMealPreprandial));
+            
+            [controller removeRecordSink:store];
+            [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+        }
+    });
+});
+
+SpecEnd
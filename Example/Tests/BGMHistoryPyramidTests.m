@@ -0,0 +1,218 @@
+//
+//  BGMHistoryPyramidTests.m
+//  UHNBGMControllerTests
+//
+//  Created by agent on 2026-10-19.
+//  Copyright © 2026 University Health Network. All rights reserved.
+//
+
+#import <UHNBGMController/UHNBGMController.h>
+#import <UHNBGMController/UHNBGMHistoryPyramid.h>
+#import "BGMSimulatedMeter.h"
+
+#define kBGMSecondsPerHour      3600
+#define kBGMSecondsPerDay       86400
+
+static UHNBGMHistoryReading BGMPyramidReading(NSTimeInterval time, float milligramsPerDecilitre)
+{
+    UHNBGMHistoryReading reading = {0};
+    reading.timeIntervalSince1970 = time;
+    reading.glucoseConcentration = milligramsPerDecilitre / 100000.f;
+    reading.flags = GlucoseMeasurementFlagPresentGlucoseConcentrationTypeAndSampleLocation;
+    return reading;
+}
+
+SpecBegin(BGMHistoryPyramidSpecs)
+
+describe(@"Glucose history pyramid", ^{
+    it(@"should summarize readings into hourly, daily and weekly buckets", ^{
+        UHNBGMHistoryPyramid *pyramid = [[UHNBGMHistoryPyramid alloc] initWithTimeZone:[NSTimeZone timeZoneForSecondsFromGMT:0]];
+        UHNBGMHistoryReading readings[3] = {BGMPyramidReading(0, 100), BGMPyramidReading(1800, 200), BGMPyramidReading(kBGMSecondsPerHour, 0)};
+        
+        // the last reading is in mmol/L
+        readings[2].flags |= GlucoseMeasurementFlagGlucoseConcentrationUnits;
+        readings[2].glucoseConcentration = 150.f / (kGlucoseMolarMass * 100.f);
+        
+        for (NSUInteger index = 0; index < 3; index++)
+        {
+            expect([pyramid addReading:&readings[index]]).to.beTruthy();
+        }
+        
+        // readings without a glucose concentration are ignored
+        UHNBGMHistoryReading emptyReading = BGMPyramidReading(0, NAN);
+        expect([pyramid addReading:&emptyReading]).to.beFalsy();
+        expect(pyramid.count).to.equal(3);
+        
+        UHNBGMHistoryBucket buckets[4];
+        NSDate *startDate = [NSDate dateWithTimeIntervalSince1970:-7 * kBGMSecondsPerDay];
+        NSDate *endDate = [NSDate dateWithTimeIntervalSince1970:7 * kBGMSecondsPerDay];
+        expect([pyramid getBuckets:buckets count:4 resolution:UHNBGMHistoryResolutionHour fromDate:startDate toDate:endDate]).to.equal(2);
+        expect(buckets[0].startTime).to.equal(0);
+        expect(buckets[0].count).to.equal(2);
+        expect(buckets[0].minimum).to.beCloseToWithin(100, 0.01);
+        expect(buckets[0].maximum).to.beCloseToWithin(200, 0.01);
+        expect(buckets[0].mean).to.beCloseToWithin(150, 0.01);
+        expect(buckets[1].startTime).to.equal(kBGMSecondsPerHour);
+        expect(buckets[1].mean).to.beCloseToWithin(150, 0.01);
+        
+        expect([pyramid getBuckets:buckets count:4 resolution:UHNBGMHistoryResolutionDay fromDate:startDate toDate:endDate]).to.equal(1);
+        expect(buckets[0].count).to.equal(3);
+        expect(buckets[0].mean).to.beCloseToWithin(150, 0.01);
+        
+        // 1970-01-01 was a Thursday, so its week started on Monday 1969-12-29
+        expect([pyramid getBuckets:buckets count:4 resolution:UHNBGMHistoryResolutionWeek fromDate:startDate toDate:endDate]).to.equal(1);
+        expect(buckets[0].startTime).to.equal(-3 * kBGMSecondsPerDay);
+        expect(buckets[0].count).to.equal(3);
+    });
+    
+    it(@"should align days to the time zone", ^{
+        UHNBGMHistoryPyramid *pyramid = [[UHNBGMHistoryPyramid alloc] initWithTimeZone:[NSTimeZone timeZoneForSecondsFromGMT:-5 * kBGMSecondsPerHour]];
+        UHNBGMHistoryReading readings[2] = {BGMPyramidReading(kBGMSecondsPerDay + kBGMSecondsPerHour, 100), BGMPyramidReading(kBGMSecondsPerDay + 6 * kBGMSecondsPerHour, 120)};
+        [pyramid addReading:&readings[0]];
+        [pyramid addReading:&readings[1]];
+        
+        // 01:00 UTC is still the previous day at UTC-5
+        expect([pyramid numberOfBucketsAtResolution:UHNBGMHistoryResolutionDay]).to.equal(2);
+        
+        UHNBGMHistoryBucket buckets[2];
+        [pyramid getBuckets:buckets count:2 resolution:UHNBGMHistoryResolutionDay fromDate:[NSDate dateWithTimeIntervalSince1970:0] toDate:[NSDate dateWithTimeIntervalSince1970:2 * kBGMSecondsPerDay]];
+        expect(buckets[0].startTime).to.equal(5 * kBGMSecondsPerHour);
+        expect(buckets[1].startTime).to.equal(kBGMSecondsPerDay + 5 * kBGMSecondsPerHour);
+    });
+    
+    it(@"should align days to midnight on either side of a daylight saving change", ^{
+        UHNBGMHistoryPyramid *pyramid = [[UHNBGMHistoryPyramid alloc] initWithTimeZone:[NSTimeZone timeZoneWithName:@"America/Toronto"]];
+        NSTimeInterval summerMidnight = 1467345600; // 2016-07-01 00:00 EDT
+        NSTimeInterval winterMidnight = 1480568400; // 2016-12-01 00:00 EST
+        UHNBGMHistoryReading readings[4] = {BGMPyramidReading(summerMidnight - 1800, 100), BGMPyramidReading(summerMidnight + 1800, 110), BGMPyramidReading(winterMidnight - 1800, 120), BGMPyramidReading(winterMidnight + 1800, 130)};
+        
+        for (NSUInteger index = 0; index < 4; index++)
+        {
+            [pyramid addReading:&readings[index]];
+        }
+        
+        expect([pyramid numberOfBucketsAtResolution:UHNBGMHistoryResolutionDay]).to.equal(4);
+        
+        UHNBGMHistoryBucket buckets[4];
+        NSUInteger numberOfBuckets = [pyramid getBuckets:buckets count:4 resolution:UHNBGMHistoryResolutionDay fromDate:[NSDate dateWithTimeIntervalSince1970:summerMidnight] toDate:[NSDate dateWithTimeIntervalSince1970:winterMidnight + 1]];
+        expect(numberOfBuckets).to.equal(3);
+        expect(buckets[0].startTime).to.equal(summerMidnight);
+        expect(buckets[0].mean).to.beCloseToWithin(110, 0.01);
+        expect(buckets[1].startTime).to.equal(winterMidnight - kBGMSecondsPerDay);
+        expect(buckets[1].mean).to.beCloseToWithin(120, 0.01);
+        expect(buckets[2].startTime).to.equal(winterMidnight);
+        expect(buckets[2].mean).to.beCloseToWithin(130, 0.01);
+    });
+    
+    it(@"should keep buckets sorted when readings arrive out of order", ^{
+        UHNBGMHistoryPyramid *pyramid = [[UHNBGMHistoryPyramid alloc] initWithTimeZone:[NSTimeZone timeZoneForSecondsFromGMT:0]];
+        NSUInteger hours[6] = {5, 2, 9, 2, 0, 7};
+        
+        for (NSUInteger index = 0; index < 6; index++)
+        {
+            UHNBGMHistoryReading reading = BGMPyramidReading(hours[index] * kBGMSecondsPerHour, 100 + index);
+            [pyramid addReading:&reading];
+        }
+        
+        UHNBGMHistoryBucket buckets[6];
+        NSUInteger numberOfBuckets = [pyramid getBuckets:buckets count:6 resolution:UHNBGMHistoryResolutionHour fromDate:[NSDate dateWithTimeIntervalSince1970:0] toDate:[NSDate dateWithTimeIntervalSince1970:kBGMSecondsPerDay]];
+        expect(numberOfBuckets).to.equal(5);
+        
+        NSTimeInterval expectedStartTimes[5] = {0, 2, 5, 7, 9};
+        for (NSUInteger index = 0; index < numberOfBuckets; index++)
+        {
+            expect(buckets[index].startTime).to.equal(expectedStartTimes[index] * kBGMSecondsPerHour);
+        }
+        expect(buckets[1].count).to.equal(2);
+        expect(buckets[1].minimum).to.beCloseToWithin(101, 0.01);
+        expect(buckets[1].maximum).to.beCloseToWithin(103, 0.01);
+        
+        // the range is inclusive of its start and exclusive of its end
+        numberOfBuckets = [pyramid getBuckets:buckets count:6 resolution:UHNBGMHistoryResolutionHour fromDate:[NSDate dateWithTimeIntervalSince1970:2 * kBGMSecondsPerHour] toDate:[NSDate dateWithTimeIntervalSince1970:7 * kBGMSecondsPerHour]];
+        expect(numberOfBuckets).to.equal(2);
+    });
+    
+    it(@"should pick the coarsest resolution that fits the columns", ^{
+        UHNBGMHistoryPyramid *pyramid = [[UHNBGMHistoryPyramid alloc] initWithTimeZone:[NSTimeZone timeZoneForSecondsFromGMT:0]];
+        expect([pyramid resolutionForDuration:kBGMSecondsPerDay numberOfColumns:300]).to.equal(UHNBGMHistoryResolutionHour);
+        expect([pyramid resolutionForDuration:90 * kBGMSecondsPerDay numberOfColumns:90]).to.equal(UHNBGMHistoryResolutionDay);
+        expect([pyramid resolutionForDuration:365 * kBGMSecondsPerDay numberOfColumns:300]).to.equal(UHNBGMHistoryResolutionDay);
+        expect([pyramid resolutionForDuration:3650 * kBGMSecondsPerDay numberOfColumns:300]).to.equal(UHNBGMHistoryResolutionWeek);
+    });
+    
+    it(@"should summarize ten years of readings into chart columns", ^{
+        UHNBGMHistoryPyramid *pyramid = [[UHNBGMHistoryPyramid alloc] initWithTimeZone:[NSTimeZone timeZoneForSecondsFromGMT:0]];
+        NSTimeInterval startTime = 1451865600; // Monday 2016-01-04
+        NSUInteger numberOfDays = 3640;
+        NSUInteger numberOfReadings = numberOfDays * 24;
+        
+        for (NSUInteger index = 0; index < numberOfReadings; index++)
+        {
+            UHNBGMHistoryReading reading = BGMPyramidReading(startTime + index * kBGMSecondsPerHour, 60 + index % 240);
+            [pyramid addReading:&reading];
+        }
+        
+        expect(pyramid.count).to.equal(numberOfReadings);
+        expect([pyramid numberOfBucketsAtResolution:UHNBGMHistoryResolutionHour]).to.equal(numberOfReadings);
+        expect([pyramid numberOfBucketsAtResolution:UHNBGMHistoryResolutionDay]).to.equal(numberOfDays);
+        expect([pyramid numberOfBucketsAtResolution:UHNBGMHistoryResolutionWeek]).to.equal(numberOfDays / 7);
+        
+        // one column per week, so each column reads a single weekly bucket
+        NSUInteger numberOfColumns = numberOfDays / 7;
+        UHNBGMHistoryBucket *columns = calloc(numberOfColumns, sizeof(UHNBGMHistoryBucket));
+        [pyramid getColumns:columns numberOfColumns:numberOfColumns fromDate:[NSDate dateWithTimeIntervalSince1970:startTime] toDate:[NSDate dateWithTimeIntervalSince1970:startTime + numberOfDays * kBGMSecondsPerDay]];
+        
+        NSUInteger totalCount = 0;
+        float minimum = INFINITY;
+        float maximum = -INFINITY;
+        for (NSUInteger index = 0; index < numberOfColumns; index++)
+        {
+            expect(columns[index].startTime).to.equal(startTime + index * 7 * kBGMSecondsPerDay);
+            expect(columns[index].count).to.equal(7 * 24);
+            totalCount += columns[index].count;
+            minimum = MIN(minimum, columns[index].minimum);
+            maximum = MAX(maximum, columns[index].maximum);
+        }
+        free(columns);
+        
+        expect(totalCount).to.equal(numberOfReadings);
+        expect(minimum).to.beCloseToWithin(60, 0.01);
+        expect(maximum).to.beCloseToWithin(299, 0.01);
+        
+        // columns with no readings are left empty
+        UHNBGMHistoryBucket emptyColumns[10];
+        [pyramid getColumns:emptyColumns numberOfColumns:10 fromDate:[NSDate dateWithTimeIntervalSince1970:0] toDate:[NSDate dateWithTimeIntervalSince1970:10 * kBGMSecondsPerDay]];
+        expect(emptyColumns[0].count).to.equal(0);
+        expect(isnan(emptyColumns[0].mean)).to.beTruthy();
+        
+        [pyramid removeAllBuckets];
+        expect(pyramid.count).to.equal(0);
+        expect([pyramid numberOfBucketsAtResolution:UHNBGMHistoryResolutionWeek]).to.equal(0);
+    });
+    
+    it(@"should be built from the records of a transfer", ^{
+        BGMRecordingDelegate *delegate = [[BGMRecordingDelegate alloc] init];
+        UHNBGMController *controller = [[UHNBGMController alloc] initWithDelegate:delegate];
+        BGMSimulatedMeter *meter = [[BGMSimulatedMeter alloc] initWithController:controller];
+        [meter addStoredRecordsWithSequenceNumbers:NSMakeRange(1, 30)];
+        
+        UHNBGMHistoryPyramid *pyramid = [[UHNBGMHistoryPyramid alloc] init];
+        [controller addRecordSink:pyramid];
+        
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"transferComplete"])
+                {
+                    done();
+                }
+            };
+            
+            [controller getAllStoredRecords];
+        });
+        
+        expect(pyramid.count).to.equal(30);
+        expect([pyramid numberOfBucketsAtResolution:UHNBGMHistoryResolutionDay]).to.equal(1);
+    });
+});
+
+SpecEnd
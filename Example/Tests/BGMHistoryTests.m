@@ -0,0 +1,139 @@
+//
+//  BGMHistoryTests.m
+//  UHNBGMControllerTests
+//
+//  Created by agent on 2026-10-19.
+//  Copyright © 2026 University Health Network. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+#import <UHNBGMController/UHNBGMHistory.h>
+#import <UHNBGMController/UHNBGMConstants.h>
+
+static UHNBGMHistoryReading BGMHistoryReading(NSTimeInterval time, uint16_t sequenceNumber)
+{
+    UHNBGMHistoryReading reading = {0};
+    reading.timeIntervalSince1970 = time;
+    reading.glucoseConcentration = sequenceNumber;
+    reading.sequenceNumber = sequenceNumber;
+    return reading;
+}
+
+SpecBegin(BGMHistorySpecs)
+
+describe(@"Glucose reading history", ^{
+    it(@"should evict the oldest readings once full", ^{
+        UHNBGMHistory *history = [[UHNBGMHistory alloc] initWithCapacity:100];
+        
+        for (uint16_t sequenceNumber = 0; sequenceNumber < 250; sequenceNumber++)
+        {
+            UHNBGMHistoryReading reading = BGMHistoryReading(sequenceNumber * 60, sequenceNumber);
+            expect([history addReading:&reading]).to.beTruthy();
+        }
+        
+        expect(history.count).to.equal(100);
+        
+        UHNBGMHistoryReading readings[100];
+        expect([history getReadings:readings range:NSMakeRange(0, 100)]).to.equal(100);
+        
+        for (NSUInteger index = 0; index < 100; index++)
+        {
+            expect(readings[index].sequenceNumber).to.equal(150 + index);
+        }
+        
+        // older than everything kept, so it would be evicted straight away
+        UHNBGMHistoryReading reading = BGMHistoryReading(0, 0);
+        expect([history addReading:&reading]).to.beFalsy();
+    });
+    
+    it(@"should keep readings added out of order sorted by time", ^{
+        UHNBGMHistory *history = [[UHNBGMHistory alloc] initWithCapacity:10];
+        uint16_t sequenceNumbers[] = {5, 1, 9, 3, 7, 2, 8, 4, 6, 0};
+        
+        for (NSUInteger index = 0; index < 10; index++)
+        {
+            UHNBGMHistoryReading reading = BGMHistoryReading(sequenceNumbers[index] * 60, sequenceNumbers[index]);
+            [history addReading:&reading];
+        }
+        
+        NSTimeInterval times[10];
+        float glucoseConcentrations[10];
+        expect([history getTimes:times glucoseConcentrations:glucoseConcentrations range:NSMakeRange(0, 10)]).to.equal(10);
+        
+        for (NSUInteger index = 0; index < 10; index++)
+        {
+            expect(times[index]).to.equal(index * 60);
+            expect(glucoseConcentrations[index]).to.equal(index);
+        }
+    });
+    
+    it(@"should answer latest and between dates queries", ^{
+        UHNBGMHistory *history = [[UHNBGMHistory alloc] initWithCapacity:1000];
+        
+        for (uint16_t sequenceNumber = 0; sequenceNumber < 1000; sequenceNumber++)
+        {
+            UHNBGMHistoryReading reading = BGMHistoryReading(sequenceNumber * 60, sequenceNumber);
+            [history addReading:&reading];
+        }
+        
+        UHNBGMHistoryReading latest[3];
+        expect([history getLatestReadings:latest count:3]).to.equal(3);
+        expect(latest[0].sequenceNumber).to.equal(999);
+        expect(latest[2].sequenceNumber).to.equal(997);
+        
+        NSRange range = [history rangeOfReadingsFromDate:[NSDate dateWithTimeIntervalSince1970:600] toDate:[NSDate dateWithTimeIntervalSince1970:1199]];
+        expect(range.location).to.equal(10);
+        expect(range.length).to.equal(10);
+        
+        __block NSUInteger numberOfReadings = 0;
+        [history enumerateReadingsInRange:range usingBlock:^(const UHNBGMHistoryReading *reading, NSUInteger index, BOOL *stop) {
+            expect(reading->sequenceNumber).to.equal(index);
+            numberOfReadings++;
+        }];
+        expect(numberOfReadings).to.equal(10);
+        
+        range = [history rangeOfReadingsFromDate:[NSDate dateWithTimeIntervalSince1970:100000] toDate:[NSDate dateWithTimeIntervalSince1970:200000]];
+        expect(range.length).to.equal(0);
+    });
+    
+    it(@"should link a measurement context meal to its measurement", ^{
+        UHNBGMHistory *history = [[UHNBGMHistory alloc] init];
+        NSDictionary *measurementDetails = @{kGlucoseMeasurementKeySequenceNumber: @12,
+                                             kGlucoseMeasurementKeyCreationDate: [NSDate dateWithTimeIntervalSince1970:1456136705],
+                                             kGlucoseMeasurementKeyGlucoseConcentration: @0.0014,
+                                             kGlucoseMeasurementKeyGlucoseConcentrationUnits: @(GlucoseMeasurementGlucoseConcentrationUnitsKgPerL)};
+        expect([history addMeasurement:measurementDetails]).to.beTruthy();
+        expect([history setMeal:GlucoseMeasurementContextMealPostprandial forSequenceNumber:12]).to.beTruthy();
+        expect([history setMeal:GlucoseMeasurementContextMealPostprandial forSequenceNumber:13]).to.beFalsy();
+        
+        UHNBGMHistoryReading reading;
+        [history getLatestReadings:&reading count:1];
+        expect(reading.meal).to.equal(GlucoseMeasurementContextMealPostprandial);
+        expect(reading.flags).to.equal(GlucoseMeasurementFlagPresentGlucoseConcentrationTypeAndSampleLocation);
+        expect(reading.glucoseConcentration).to.beCloseToWithin(0.0014, 1e-9);
+    });
+    
+    it(@"should trim on a memory warning", ^{
+        UHNBGMHistory *history = [[UHNBGMHistory alloc] initWithCapacity:10000];
+        history.retainedCountOnMemoryWarning = 10;
+        
+        for (uint16_t sequenceNumber = 0; sequenceNumber < 5000; sequenceNumber++)
+        {
+            UHNBGMHistoryReading reading = BGMHistoryReading(sequenceNumber * 60, sequenceNumber);
+            [history addReading:&reading];
+        }
+        
+        [[NSNotificationCenter defaultCenter] postNotificationName:UIApplicationDidReceiveMemoryWarningNotification object:nil];
+        expect(history.count).to.equal(10);
+        
+        UHNBGMHistoryReading reading = BGMHistoryReading(5000 * 60, 5000);
+        [history addReading:&reading];
+        
+        UHNBGMHistoryReading readings[11];
+        expect([history getReadings:readings range:NSMakeRange(0, 20)]).to.equal(11);
+        expect(readings[0].sequenceNumber).to.equal(4990);
+        expect(readings[10].sequenceNumber).to.equal(5000);
+    });
+});
+
+SpecEnd
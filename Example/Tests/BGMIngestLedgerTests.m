@@ -0,0 +1,269 @@
+//
+//  BGMIngestLedgerTests.m
+//  UHNBGMControllerTests
+//
+//  Created by agent on 2026-10-19.
+//  Copyright © 2026 University Health Network. All rights reserved.
+//
+
+#import <UHNBGMController/UHNBGMController.h>
+#import <UHNBGMController/UHNBGMIngestLedger.h>
+#import "BGMSimulatedMeter.h"
+
+static NSData *BGMMeasurementData(uint16_t sequenceNumber, uint16_t year)
+{
+    NSMutableData *measurementData = [[BGMSimulatedMeter measurementWithSequenceNumber:sequenceNumber glucoseConcentration:100 hasContext:NO] mutableCopy];
+    uint8_t yearBytes[2] = {year, (year >> 8)};
+    [measurementData replaceBytesInRange:NSMakeRange(3, 2) withBytes:yearBytes];
+    
+    return measurementData;
+}
+
+// evaluates a measurement and commits it as the controller does once it was delivered
+static BOOL BGMIngest(UHNBGMIngestLedger *ledger, NSData *measurementData, NSUUID *peripheralIdentifier)
+{
+    if (![ledger shouldIngestMeasurementData:measurementData fromPeripheralWithIdentifier:peripheralIdentifier])
+    {
+        return NO;
+    }
+    
+    [ledger commitMeasurementData:measurementData fromPeripheralWithIdentifier:peripheralIdentifier];
+    
+    return YES;
+}
+
+SpecBegin(BGMIngestLedgerSpecs)
+
+describe(@"Idempotent ingest", ^{
+    it(@"should drop measurements received again", ^{
+        UHNBGMIngestLedger *ledger = [[UHNBGMIngestLedger alloc] initWithPath:nil];
+        NSUUID *peripheralIdentifier = [NSUUID UUID];
+        
+        // received out of order, with a gap filled in later
+        for (NSNumber *sequenceNumber in @[@1, @2, @5, @4, @3, @6])
+        {
+            expect(BGMIngest(ledger, BGMMeasurementData([sequenceNumber unsignedShortValue], 2016), peripheralIdentifier)).to.beTruthy();
+        }
+        
+        for (uint16_t sequenceNumber = 1; sequenceNumber <= 6; sequenceNumber++)
+        {
+            expect(BGMIngest(ledger, BGMMeasurementData(sequenceNumber, 2016), peripheralIdentifier)).to.beFalsy();
+        }
+        
+        expect([ledger numberOfRecordsForPeripheralWithIdentifier:peripheralIdentifier]).to.equal(6);
+        expect(ledger.numberOfDuplicatesDropped).to.equal(6);
+        
+        // another glucose sensor has its own sequence numbers
+        expect(BGMIngest(ledger, BGMMeasurementData(1, 2016), [NSUUID UUID])).to.beTruthy();
+        expect(BGMIngest(ledger, BGMMeasurementData(1, 2016), nil)).to.beTruthy();
+        expect(BGMIngest(ledger, BGMMeasurementData(1, 2016), nil)).to.beFalsy();
+    });
+    
+    it(@"should drop the context of a dropped measurement", ^{
+        UHNBGMIngestLedger *ledger = [[UHNBGMIngestLedger alloc] initWithPath:nil];
+        NSData *contextData = [BGMSimulatedMeter measurementContextWithSequenceNumber:7 meal:GlucoseMeasurementContextMealFasting];
+        
+        expect(BGMIngest(ledger, BGMMeasurementData(7, 2016), nil)).to.beTruthy();
+        expect([ledger shouldIngestMeasurementContextData:contextData fromPeripheralWithIdentifier:nil]).to.beTruthy();
+        expect(BGMIngest(ledger, BGMMeasurementData(7, 2016), nil)).to.beFalsy();
+        expect([ledger shouldIngestMeasurementContextData:contextData fromPeripheralWithIdentifier:nil]).to.beFalsy();
+    });
+    
+    it(@"should remember the dropped measurement of each glucose sensor", ^{
+        UHNBGMIngestLedger *ledger = [[UHNBGMIngestLedger alloc] initWithPath:nil];
+        NSUUID *firstPeripheralIdentifier = [NSUUID UUID];
+        NSUUID *secondPeripheralIdentifier = [NSUUID UUID];
+        NSData *contextData = [BGMSimulatedMeter measurementContextWithSequenceNumber:7 meal:GlucoseMeasurementContextMealFasting];
+        
+        expect(BGMIngest(ledger, BGMMeasurementData(7, 2016), firstPeripheralIdentifier)).to.beTruthy();
+        expect(BGMIngest(ledger, BGMMeasurementData(7, 2016), firstPeripheralIdentifier)).to.beFalsy();
+        
+        // a measurement of another glucose sensor sharing the ledger arrives before the dropped context
+        expect(BGMIngest(ledger, BGMMeasurementData(7, 2016), secondPeripheralIdentifier)).to.beTruthy();
+        expect([ledger shouldIngestMeasurementContextData:contextData fromPeripheralWithIdentifier:secondPeripheralIdentifier]).to.beTruthy();
+        expect([ledger shouldIngestMeasurementContextData:contextData fromPeripheralWithIdentifier:firstPeripheralIdentifier]).to.beFalsy();
+    });
+    
+    it(@"should only enter a measurement once it is committed", ^{
+        UHNBGMIngestLedger *ledger = [[UHNBGMIngestLedger alloc] initWithPath:nil];
+        NSData *measurementData = BGMMeasurementData(1, 2016);
+        
+        // a measurement that was not persisted is ingested again by a retry
+        expect([ledger shouldIngestMeasurementData:measurementData fromPeripheralWithIdentifier:nil]).to.beTruthy();
+        expect([ledger containsMeasurementData:measurementData fromPeripheralWithIdentifier:nil]).to.beFalsy();
+        expect([ledger shouldIngestMeasurementData:measurementData fromPeripheralWithIdentifier:nil]).to.beTruthy();
+        
+        [ledger commitMeasurementData:measurementData fromPeripheralWithIdentifier:nil];
+        expect([ledger containsMeasurementData:measurementData fromPeripheralWithIdentifier:nil]).to.beTruthy();
+        expect([ledger shouldIngestMeasurementData:measurementData fromPeripheralWithIdentifier:nil]).to.beFalsy();
+        expect([ledger numberOfRecordsForPeripheralWithIdentifier:nil]).to.equal(1);
+    });
+    
+    it(@"should only drop a measurement with the same sequence number and base time", ^{
+        UHNBGMIngestLedger *ledger = [[UHNBGMIngestLedger alloc] initWithPath:nil];
+        NSUUID *peripheralIdentifier = [NSUUID UUID];
+        
+        expect(BGMIngest(ledger, BGMMeasurementData(1, 2016), peripheralIdentifier)).to.beTruthy();
+        expect(BGMIngest(ledger, BGMMeasurementData(2, 2016), peripheralIdentifier)).to.beTruthy();
+        expect(BGMIngest(ledger, BGMMeasurementData(3, 2018), peripheralIdentifier)).to.beTruthy();
+        
+        // a base time between those of its neighbours is another record of a reset glucose sensor
+        expect(BGMIngest(ledger, BGMMeasurementData(2, 2017), peripheralIdentifier)).to.beTruthy();
+        expect([ledger numberOfGenerationsForPeripheralWithIdentifier:peripheralIdentifier]).to.equal(2);
+        expect(BGMIngest(ledger, BGMMeasurementData(2, 2016), peripheralIdentifier)).to.beFalsy();
+        expect(BGMIngest(ledger, BGMMeasurementData(2, 2017), peripheralIdentifier)).to.beFalsy();
+        expect([ledger numberOfRecordsForPeripheralWithIdentifier:peripheralIdentifier]).to.equal(4);
+    });
+    
+    it(@"should start a new generation when the sequence numbers start over", ^{
+        UHNBGMIngestLedger *ledger = [[UHNBGMIngestLedger alloc] initWithPath:nil];
+        NSUUID *peripheralIdentifier = [NSUUID UUID];
+        
+        for (uint16_t sequenceNumber = 1; sequenceNumber <= 10; sequenceNumber++)
+        {
+            BGMIngest(ledger, BGMMeasurementData(sequenceNumber, 2016), peripheralIdentifier);
+        }
+        
+        // the glucose sensor was reset and numbers its new records from 1 again
+        for (uint16_t sequenceNumber = 1; sequenceNumber <= 5; sequenceNumber++)
+        {
+            expect(BGMIngest(ledger, BGMMeasurementData(sequenceNumber, 2017), peripheralIdentifier)).to.beTruthy();
+        }
+        
+        expect([ledger numberOfGenerationsForPeripheralWithIdentifier:peripheralIdentifier]).to.equal(2);
+        expect([ledger numberOfRecordsForPeripheralWithIdentifier:peripheralIdentifier]).to.equal(15);
+        expect(BGMIngest(ledger, BGMMeasurementData(3, 2016), peripheralIdentifier)).to.beFalsy();
+        expect(BGMIngest(ledger, BGMMeasurementData(3, 2017), peripheralIdentifier)).to.beFalsy();
+        expect(BGMIngest(ledger, BGMMeasurementData(6, 2017), peripheralIdentifier)).to.beTruthy();
+        expect([ledger numberOfGenerationsForPeripheralWithIdentifier:peripheralIdentifier]).to.equal(2);
+    });
+    
+    it(@"should keep a million records per glucose sensor", ^{
+        UHNBGMIngestLedger *ledger = [[UHNBGMIngestLedger alloc] initWithPath:nil];
+        NSUUID *peripheralIdentifier = [NSUUID UUID];
+        NSMutableData *measurementData = [BGMMeasurementData(0, 2000) mutableCopy];
+        uint8_t *bytes = [measurementData mutableBytes];
+        NSUInteger numberOfRecords = 0;
+        
+        // 16 resets of a glucose sensor that used all its sequence numbers each time
+        for (uint16_t year = 2000; year < 2016; year++)
+        {
+            bytes[3] = year;
+            bytes[4] = year >> 8;
+            for (uint32_t sequenceNumber = 0; sequenceNumber <= UINT16_MAX; sequenceNumber++)
+            {
+                bytes[1] = sequenceNumber;
+                bytes[2] = sequenceNumber >> 8;
+                numberOfRecords += BGMIngest(ledger, measurementData, peripheralIdentifier);
+            }
+        }
+        
+        expect(numberOfRecords).to.equal(16 * 65536);
+        expect([ledger numberOfRecordsForPeripheralWithIdentifier:peripheralIdentifier]).to.equal(16 * 65536);
+        expect([ledger numberOfGenerationsForPeripheralWithIdentifier:peripheralIdentifier]).to.equal(16);
+        
+        // every lookup of a record that was never delivered searches all 16 generations
+        CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+        NSUInteger numberOfDuplicates = 0;
+        bytes[3] = 2016 & 0xFF;
+        bytes[4] = 2016 >> 8;
+        for (uint32_t sequenceNumber = 0; sequenceNumber <= UINT16_MAX; sequenceNumber++)
+        {
+            bytes[1] = sequenceNumber;
+            bytes[2] = sequenceNumber >> 8;
+            numberOfDuplicates += [ledger containsMeasurementData:measurementData fromPeripheralWithIdentifier:peripheralIdentifier];
+        }
+        CFAbsoluteTime lookupTime = CFAbsoluteTimeGetCurrent() - startTime;
+        NSLog(@"Ingest ledger: %lu bytes of keys for %lu records, %.0f ns per lookup", (unsigned long) (numberOfRecords * sizeof(uint64_t)), (unsigned long) numberOfRecords, lookupTime * 1e9 / 65536);
+        expect(numberOfDuplicates).to.equal(0);
+        
+        bytes[1] = 1234 & 0xFF;
+        bytes[2] = 1234 >> 8;
+        bytes[3] = 2007 & 0xFF;
+        bytes[4] = 2007 >> 8;
+        expect([ledger containsMeasurementData:measurementData fromPeripheralWithIdentifier:peripheralIdentifier]).to.beTruthy();
+        bytes[3] = 2016 & 0xFF;
+        bytes[4] = 2016 >> 8;
+        expect([ledger containsMeasurementData:measurementData fromPeripheralWithIdentifier:peripheralIdentifier]).to.beFalsy();
+    });
+    
+    it(@"should be saved and loaded", ^{
+        NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+        NSUUID *peripheralIdentifier = [NSUUID UUID];
+        UHNBGMIngestLedger *ledger = [[UHNBGMIngestLedger alloc] initWithPath:path];
+        
+        for (uint16_t sequenceNumber = 1; sequenceNumber <= 10; sequenceNumber += 2)
+        {
+            BGMIngest(ledger, BGMMeasurementData(sequenceNumber, 2016), peripheralIdentifier);
+        }
+        BGMIngest(ledger, BGMMeasurementData(1, 2017), peripheralIdentifier);
+        expect([ledger save]).to.beTruthy();
+        
+        UHNBGMIngestLedger *loadedLedger = [[UHNBGMIngestLedger alloc] initWithPath:path];
+        expect([loadedLedger numberOfRecordsForPeripheralWithIdentifier:peripheralIdentifier]).to.equal(6);
+        expect([loadedLedger numberOfGenerationsForPeripheralWithIdentifier:peripheralIdentifier]).to.equal(2);
+        expect([loadedLedger containsMeasurementData:BGMMeasurementData(9, 2016) fromPeripheralWithIdentifier:peripheralIdentifier]).to.beTruthy();
+        expect([loadedLedger containsMeasurementData:BGMMeasurementData(2, 2016) fromPeripheralWithIdentifier:peripheralIdentifier]).to.beFalsy();
+        
+        // a damaged ledger is started over
+        [[NSData dataWithBytes:"UHNL" length:4] writeToFile:path atomically:YES];
+        expect([[[UHNBGMIngestLedger alloc] initWithPath:path] numberOfRecordsForPeripheralWithIdentifier:peripheralIdentifier]).to.equal(0);
+        [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+    });
+    
+    it(@"should not deliver the records of a transfer again", ^{
+        BGMRecordingDelegate *delegate = [[BGMRecordingDelegate alloc] init];
+        UHNBGMController *controller = [[UHNBGMController alloc] initWithDelegate:delegate];
+        BGMSimulatedMeter *meter = [[BGMSimulatedMeter alloc] initWithController:controller];
+        [meter addStoredRecordsWithSequenceNumbers:NSMakeRange(1, 5)];
+        [meter addStoredRecordWithSequenceNumber:6 glucoseConcentration:120 mealContext:GlucoseMeasurementContextMealPreprandial];
+        [controller setIngestLedger:[[UHNBGMIngestLedger alloc] initWithPath:nil]];
+        
+        for (NSUInteger transfer = 0; transfer < 2; transfer++)
+        {
+            waitUntil(^(DoneCallback done) {
+                delegate.eventHandler = ^(NSString *event) {
+                    if ([event isEqualToString:@"transferComplete"])
+                    {
+                        done();
+                    }
+                };
+                
+                [controller getAllStoredRecords];
+            });
+        }
+        
+        expect(delegate.measurements.count).to.equal(6);
+        expect(delegate.measurementContexts.count).to.equal(1);
+    });
+    
+    it(@"should only enter the records of a transfer once the sinks were told it completed", ^{
+        BGMRecordingDelegate *delegate = [[BGMRecordingDelegate alloc] init];
+        UHNBGMController *controller = [[UHNBGMController alloc] initWithDelegate:delegate];
+        BGMSimulatedMeter *meter = [[BGMSimulatedMeter alloc] initWithController:controller];
+        UHNBGMIngestLedger *ledger = [[UHNBGMIngestLedger alloc] initWithPath:nil];
+        __block NSUInteger numberOfRecordsAtCompletion = NSNotFound;
+        [meter addStoredRecordsWithSequenceNumbers:NSMakeRange(1, 5)];
+        [controller setIngestLedger:ledger];
+        
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"transferComplete"])
+                {
+                    // the delegate and the sinks persist the records here, before the ledger holds them
+                    numberOfRecordsAtCompletion = [ledger numberOfRecordsForPeripheralWithIdentifier:nil];
+                    [controller waitForPendingCallbacksWithCompletion:^{
+                        done();
+                    }];
+                }
+            };
+            
+            [controller getAllStoredRecords];
+        });
+        
+        expect(numberOfRecordsAtCompletion).to.equal(0);
+        expect([ledger numberOfRecordsForPeripheralWithIdentifier:nil]).to.equal(5);
+    });
+});
+
+SpecEnd
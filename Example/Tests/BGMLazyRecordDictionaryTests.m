@@ -0,0 +1,93 @@
+//
+//  BGMLazyRecordDictionaryTests.m
+//  UHNBGMControllerTests
+//
+//  Created by agent on 2026-10-19.
+//  Copyright © 2026 University Health Network. All rights reserved.
+//
+
+#import <UHNBGMController/NSData+GlucoseMeasurementContextParser.h>
+#import <UHNBGMController/NSData+GlucoseMeasurementParser.h>
+#import <UHNBGMController/UHNBGMLazyRecordDictionary.h>
+#import "BGMSimulatedMeter.h"
+
+SpecBegin(BGMLazyRecordDictionarySpecs)
+
+describe(@"Lazily decoded records", ^{
+    it(@"should match an eagerly parsed measurement", ^{
+        uint8_t flag = 0x0B; // Time Offset, Glucose Concentration, Type and Sample Location, Status Present, Kg/L
+        uint16_t sequenceNumber = 0x000C;
+        uint16_t year = 2016;
+        int16_t timeOffset = -5;
+        uint16_t glucoseConcentration = 0xB08C; // 140 mg/dL
+        uint16_t status = 0x0485;
+        NSData *measurementData = [NSData dataWithBytes:(uint8_t[]){flag, sequenceNumber, (sequenceNumber >> 8), year, (year >> 8), 2, 22, 10, 30, 5, timeOffset, (timeOffset >> 8), glucoseConcentration, (glucoseConcentration >> 8), 0x11, status, (status >> 8)} length:17];
+        NSDictionary *measurementDetails = [measurementData parseGlucoseMeasurementCharacteristicDetails:NO];
+        NSDictionary *lazyMeasurementDetails = [measurementData lazilyParseGlucoseMeasurementCharacteristicDetails:NO];
+        
+        expect(lazyMeasurementDetails).to.beKindOf([UHNBGMLazyMeasurementDictionary class]);
+        expect([lazyMeasurementDetails count]).to.equal([measurementDetails count]);
+        expect([NSSet setWithArray:[lazyMeasurementDetails allKeys]]).to.equal([NSSet setWithArray:[measurementDetails allKeys]]);
+        expect(lazyMeasurementDetails).to.equal(measurementDetails);
+        expect(measurementDetails).to.equal(lazyMeasurementDetails);
+    });
+    
+    it(@"should only have the keys of the fields that are present", ^{
+        NSData *measurementData = [BGMSimulatedMeter measurementWithSequenceNumber:3 glucoseConcentration:100 hasContext:NO];
+        NSDictionary *measurementDetails = [measurementData parseGlucoseMeasurementCharacteristicDetails:NO];
+        NSDictionary *lazyMeasurementDetails = [measurementData lazilyParseGlucoseMeasurementCharacteristicDetails:NO];
+        
+        expect(lazyMeasurementDetails).to.equal(measurementDetails);
+        expect(lazyMeasurementDetails[kGlucoseMeasurementKeySensorStatusAnnunciation]).to.beNil();
+        expect(lazyMeasurementDetails[@"UnknownKey"]).to.beNil();
+        
+        NSMutableSet *enumeratedKeys = [NSMutableSet set];
+        
+        for (NSString *key in lazyMeasurementDetails)
+        {
+            [enumeratedKeys addObject:key];
+        }
+        
+        expect(enumeratedKeys).to.equal([NSSet setWithArray:[measurementDetails allKeys]]);
+    });
+    
+    it(@"should match an eagerly parsed measurement context", ^{
+        uint8_t flag = 0x5F; // carb ID and carbs present, meal present, tester-health present, exercise duration and intensity present, med ID and med present, med units = Kg, HbA1c present
+        uint16_t sequenceNumber = 0x000F;
+        uint16_t carbs = 90;
+        uint8_t jointValue = GlucoseMeasurementContextTesterHealthCareProfessional | (GlucoseMeasurementContextHealthUnderStress << 4);
+        uint16_t exerciseDuration = 30 * 60;
+        uint16_t meds = 15;
+        uint16_t HbA1c = 6;
+        NSData *contextData = [NSData dataWithBytes:(uint8_t[]){flag, sequenceNumber, (sequenceNumber >> 8), GlucoseMeasurementContextCarbohydrateIDBreakfast, carbs, (carbs >> 8), GlucoseMeasurementContextMealPostprandial, jointValue, exerciseDuration, (exerciseDuration >> 8), 75, GlucoseMeasurementContextMedicationIDShortActingInsulin, meds, (meds >> 8), HbA1c, (HbA1c >> 8)} length:16];
+        NSDictionary *contextDetails = [contextData parseGlucoseMeasurementContextCharacteristicDetails:NO];
+        NSDictionary *lazyContextDetails = [contextData lazilyParseGlucoseMeasurementContextCharacteristicDetails:NO];
+        
+        expect(lazyContextDetails).to.beKindOf([UHNBGMLazyMeasurementContextDictionary class]);
+        expect([lazyContextDetails count]).to.equal([contextDetails count]);
+        expect(lazyContextDetails).to.equal(contextDetails);
+        expect(lazyContextDetails[kGlucoseMeasurementContextKeyTester]).to.equal(GlucoseMeasurementContextTesterHealthCareProfessional);
+        expect(lazyContextDetails[kGlucoseMeasurementContextKeyHealth]).to.equal(GlucoseMeasurementContextHealthUnderStress);
+    });
+    
+    it(@"should cache decoded values", ^{
+        NSData *measurementData = [BGMSimulatedMeter measurementWithSequenceNumber:3 glucoseConcentration:100 hasContext:NO];
+        NSDictionary *lazyMeasurementDetails = [measurementData lazilyParseGlucoseMeasurementCharacteristicDetails:NO];
+        
+        NSDate *creationDate = lazyMeasurementDetails[kGlucoseMeasurementKeyCreationDate];
+        expect(creationDate).notTo.beNil();
+        expect(lazyMeasurementDetails[kGlucoseMeasurementKeyCreationDate]).to.beIdenticalTo(creationDate);
+        expect([lazyMeasurementDetails copy]).to.beIdenticalTo(lazyMeasurementDetails);
+    });
+    
+    it(@"should archive as a plain dictionary", ^{
+        NSData *measurementData = [BGMSimulatedMeter measurementWithSequenceNumber:3 glucoseConcentration:100 hasContext:NO];
+        NSDictionary *lazyMeasurementDetails = [measurementData lazilyParseGlucoseMeasurementCharacteristicDetails:NO];
+        NSDictionary *unarchivedDetails = [NSKeyedUnarchiver unarchiveObjectWithData:[NSKeyedArchiver archivedDataWithRootObject:lazyMeasurementDetails]];
+        
+        expect(unarchivedDetails).notTo.beKindOf([UHNBGMLazyRecordDictionary class]);
+        expect(unarchivedDetails).to.equal(lazyMeasurementDetails);
+    });
+});
+
+SpecEnd
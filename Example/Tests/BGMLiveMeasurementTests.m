@@ -0,0 +1,111 @@
+//
+//  BGMLiveMeasurementTests.m
+//  UHNBGMControllerTests
+//
+//  Created by agent on 2026-10-19.
+//  Copyright © 2026 University Health Network. All rights reserved.
+//
+
+#import <UHNBGMController/UHNBGMController.h>
+#import "BGMSimulatedMeter.h"
+
+SpecBegin(BGMLiveMeasurementSpecs)
+
+describe(@"Live measurements", ^{
+    __block BGMRecordingDelegate *delegate;
+    __block UHNBGMController *controller;
+    __block BGMSimulatedMeter *meter;
+    
+    beforeEach(^{
+        delegate = [[BGMRecordingDelegate alloc] init];
+        controller = [[UHNBGMController alloc] initWithDelegate:delegate];
+        meter = [[BGMSimulatedMeter alloc] initWithController:controller];
+        [meter addStoredRecordsWithSequenceNumbers:NSMakeRange(1, 50)];
+        [controller setHypoglycemiaThreshold:70 hyperglycemiaThreshold:250];
+    });
+    
+    it(@"should report measurements taken outside of a transfer as live, with their alerts", ^{
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"liveMeasurement"] && delegate.liveMeasurements.count == 3)
+                {
+                    done();
+                }
+            };
+            
+            [meter takeMeasurementWithSequenceNumber:51 glucoseConcentration:55];
+            [meter takeMeasurementWithSequenceNumber:52 glucoseConcentration:120];
+            [meter takeMeasurementWithSequenceNumber:53 glucoseConcentration:300];
+        });
+        
+        expect(delegate.liveAlerts).to.equal(@[@(UHNBGMGlucoseAlertHypoglycemia), @(UHNBGMGlucoseAlertNone), @(UHNBGMGlucoseAlertHyperglycemia)]);
+        
+        // live measurements are still reported as usual
+        expect(delegate.measurements.count).to.equal(3);
+        expect(delegate.measurements[0]).to.beIdenticalTo(delegate.liveMeasurements[0]);
+    });
+    
+    it(@"should not report stored records as live", ^{
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"transferComplete"])
+                {
+                    expect([controller isRecordTransferInProgress]).to.beFalsy();
+                    [meter takeMeasurementWithSequenceNumber:51 glucoseConcentration:60];
+                }
+                else if ([event isEqualToString:@"liveMeasurement"])
+                {
+                    done();
+                }
+            };
+            
+            [controller getAllStoredRecords];
+            expect([controller isRecordTransferInProgress]).to.beTruthy();
+        });
+        
+        expect(delegate.measurements.count).to.equal(51);
+        expect(delegate.liveMeasurements.count).to.equal(1);
+        expect(delegate.liveMeasurements[0][kGlucoseMeasurementKeySequenceNumber]).to.equal(51);
+        expect(delegate.liveAlerts[0]).to.equal(UHNBGMGlucoseAlertHypoglycemia);
+    });
+    
+    it(@"should report a live measurement ahead of the stored records still waiting for the delegate queue", ^{
+        dispatch_queue_t delegateQueue = dispatch_queue_create("org.uhn.bgmcontroller.tests.delegate", DISPATCH_QUEUE_SERIAL);
+        [controller setDelegateQueue:delegateQueue];
+        
+        // hold the stored records back on the delegate queue until the transfer is over
+        dispatch_suspend(delegateQueue);
+        [controller getAllStoredRecords];
+        expect([controller isRecordTransferInProgress]).will.beFalsy();
+        
+        __block NSUInteger numberOfMeasurementsBeforeLive = NSNotFound;
+        
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"liveMeasurement"])
+                {
+                    numberOfMeasurementsBeforeLive = delegate.measurements.count;
+                }
+                else if ([event isEqualToString:@"transferComplete"])
+                {
+                    dispatch_async(dispatch_get_main_queue(), ^{
+                        done();
+                    });
+                }
+            };
+            
+            [meter takeMeasurementWithSequenceNumber:51 glucoseConcentration:300];
+            
+            // the measurement is notified on the main queue, then handled on the controller queue before the delegate queue is let go
+            dispatch_async(dispatch_get_main_queue(), ^{
+                expect([controller isRecordTransferInProgress]).to.beFalsy();
+                dispatch_resume(delegateQueue);
+            });
+        });
+        
+        expect(numberOfMeasurementsBeforeLive).to.equal(0);
+        expect(delegate.liveAlerts).to.equal(@[@(UHNBGMGlucoseAlertHyperglycemia)]);
+    });
+});
+
+SpecEnd
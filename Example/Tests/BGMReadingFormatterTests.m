@@ -0,0 +1,153 @@
+//
+//  BGMReadingFormatterTests.m
+//  UHNBGMControllerTests
+//
+//  Created by agent on 2026-10-19.
+//  Copyright © 2026 University Health Network. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+#import <UHNBGMController/UHNBGMReadingFormatter.h>
+#import <UHNBGMController/UHNBGMConstants.h>
+
+// 2016-03-23 08:01:00 UTC
+#define kBGMFormatterReadingTime        1458720060
+
+static UHNBGMHistoryReading BGMFormatterReading(NSTimeInterval time, float kilogramsPerLitre)
+{
+    UHNBGMHistoryReading reading = {0};
+    reading.timeIntervalSince1970 = time;
+    reading.glucoseConcentration = kilogramsPerLitre;
+    reading.flags = GlucoseMeasurementFlagPresentGlucoseConcentrationTypeAndSampleLocation;
+    return reading;
+}
+
+static NSString *BGMFormattedReading(UHNBGMReadingFormatter *formatter, const UHNBGMHistoryReading *reading, uint8_t carbohydrateID)
+{
+    unichar characters[kReadingFormatterMaximumLength];
+    NSUInteger length = [formatter getCharacters:characters maxLength:kReadingFormatterMaximumLength forReading:reading carbohydrateID:carbohydrateID];
+    return [NSString stringWithCharacters:characters length:length];
+}
+
+static NSString *BGMShortDate(NSLocale *locale, NSTimeZone *timeZone, NSTimeInterval time)
+{
+    NSDateFormatter *dateFormatter = [[NSDateFormatter alloc] init];
+    dateFormatter.locale = locale;
+    dateFormatter.timeZone = timeZone;
+    dateFormatter.dateStyle = NSDateFormatterShortStyle;
+    return [dateFormatter stringFromDate:[NSDate dateWithTimeIntervalSince1970:time]];
+}
+
+SpecBegin(BGMReadingFormatterSpecs)
+
+describe(@"Reading formatter", ^{
+    NSLocale *locale = [[NSLocale alloc] initWithLocaleIdentifier:@"en_US_POSIX"];
+    NSTimeZone *utc = [NSTimeZone timeZoneForSecondsFromGMT:0];
+    
+    it(@"should format a reading with its context", ^{
+        UHNBGMReadingFormatter *formatter = [[UHNBGMReadingFormatter alloc] initWithLocale:locale timeZone:utc];
+        UHNBGMHistoryReading reading = BGMFormatterReading(kBGMFormatterReadingTime, 0.001f);
+        reading.meal = GlucoseMeasurementContextMealPreprandial;
+        
+        NSString *day = BGMShortDate(locale, utc, kBGMFormatterReadingTime);
+        expect(BGMFormattedReading(formatter, &reading, GlucoseMeasurementContextCarbohydrateIDBreakfast)).to.equal([NSString stringWithFormat:@"5.6 mmol/L, %@ 8:01 AM, Before meal, Breakfast", day]);
+        
+        formatter.units = UHNBGMReadingFormatterUnitsMgPerDl;
+        expect(BGMFormattedReading(formatter, &reading, 0)).to.equal([NSString stringWithFormat:@"100 mg/dL, %@ 8:01 AM, Before meal", day]);
+        
+        // a measurement in mol/L
+        formatter.units = UHNBGMReadingFormatterUnitsMmolPerL;
+        reading = BGMFormatterReading(kBGMFormatterReadingTime + 12 * 3600, 0.0055f);
+        reading.flags |= GlucoseMeasurementFlagGlucoseConcentrationUnits;
+        expect(BGMFormattedReading(formatter, &reading, 0)).to.equal([NSString stringWithFormat:@"5.5 mmol/L, %@ 8:01 PM", day]);
+        
+        // the same dictionary as shown by the example app
+        NSDictionary *measurementDetails = @{kGlucoseMeasurementKeyCreationDate: [NSDate dateWithTimeIntervalSince1970:kBGMFormatterReadingTime],
+                                             kGlucoseMeasurementKeyGlucoseConcentration: @(0.001f),
+                                             kGlucoseMeasurementKeyGlucoseConcentrationUnits: @(GlucoseMeasurementGlucoseConcentrationUnitsKgPerL),
+                                             kGlucoseMeasurementContextKeyMeal: @(GlucoseMeasurementContextMealPostprandial),
+                                             kGlucoseMeasurementContextKeyCarbohydrateID: @(GlucoseMeasurementContextCarbohydrateIDDinner)};
+        expect([formatter stringForMeasurementDetails:measurementDetails]).to.equal([NSString stringWithFormat:@"5.6 mmol/L, %@ 8:01 AM, After meal, Dinner", day]);
+        expect([formatter stringForMeasurementDetails:@{}]).to.equal(@"");
+    });
+    
+    it(@"should show results out of range and missing values", ^{
+        UHNBGMReadingFormatter *formatter = [[UHNBGMReadingFormatter alloc] initWithLocale:locale timeZone:utc];
+        UHNBGMHistoryReading reading = BGMFormatterReading(kBGMFormatterReadingTime, 0.006f);
+        reading.flags |= GlucoseMeasurementFlagPresentSensorStatusAnnunciation;
+        reading.sensorStatusAnnunciation = GlucoseMeasurementStatusResultExceedsSensorLimitUpper;
+        expect([BGMFormattedReading(formatter, &reading, 0) hasPrefix:@"HI, "]).to.beTruthy();
+        
+        reading.sensorStatusAnnunciation = GlucoseMeasurementStatusResultExceedsSensorLimitLower;
+        expect([BGMFormattedReading(formatter, &reading, 0) hasPrefix:@"LO, "]).to.beTruthy();
+        
+        reading = BGMFormatterReading(kBGMFormatterReadingTime, NAN);
+        expect([BGMFormattedReading(formatter, &reading, 0) hasPrefix:@"--, "]).to.beTruthy();
+    });
+    
+    it(@"should follow the conventions of the locale", ^{
+        NSLocale *frenchLocale = [[NSLocale alloc] initWithLocaleIdentifier:@"fr_FR"];
+        UHNBGMReadingFormatter *formatter = [[UHNBGMReadingFormatter alloc] initWithLocale:frenchLocale timeZone:utc];
+        UHNBGMHistoryReading reading = BGMFormatterReading(kBGMFormatterReadingTime, 0.001f);
+        
+        expect(BGMFormattedReading(formatter, &reading, 0)).to.equal([NSString stringWithFormat:@"5,6 mmol/L, %@ 08:01", BGMShortDate(frenchLocale, utc, kBGMFormatterReadingTime)]);
+    });
+    
+    it(@"should cut the text short to fit the buffer", ^{
+        UHNBGMReadingFormatter *formatter = [[UHNBGMReadingFormatter alloc] initWithLocale:locale timeZone:utc];
+        UHNBGMHistoryReading reading = BGMFormatterReading(kBGMFormatterReadingTime, 0.001f);
+        reading.meal = GlucoseMeasurementContextMealBedtime;
+        
+        for (NSUInteger maxLength = 0; maxLength < 40; maxLength++)
+        {
+            unichar characters[41];
+            characters[maxLength] = 0xFFFF;
+            NSUInteger length = [formatter getCharacters:characters maxLength:maxLength forReading:&reading carbohydrateID:0];
+            expect(length).to.equal(maxLength);
+            expect(characters[maxLength]).to.equal(0xFFFF);
+        }
+    });
+    
+    it(@"should label every context value", ^{
+        expect([UHNBGMReadingFormatter labelForField:UHNBGMReadingLabelFieldMeal value:GlucoseMeasurementContextMealFasting]).to.equal(@"Fasting");
+        expect([UHNBGMReadingFormatter labelForField:UHNBGMReadingLabelFieldCarbohydrateID value:GlucoseMeasurementContextCarbohydrateIDBrunch]).to.equal(@"Brunch");
+        expect([UHNBGMReadingFormatter labelForField:UHNBGMReadingLabelFieldTester value:GlucoseMeasurementContextTesterValueNotAvailable]).to.equal(@"Tester not available");
+        expect([UHNBGMReadingFormatter labelForField:UHNBGMReadingLabelFieldHealth value:GlucoseMeasurementContextHealthUnderStress]).to.equal(@"Under stress");
+        expect([UHNBGMReadingFormatter labelForField:UHNBGMReadingLabelFieldMedicationID value:GlucoseMeasurementContextMedicationIDPreMixedInsulin]).to.equal(@"Pre-mixed insulin");
+        expect([UHNBGMReadingFormatter labelForField:UHNBGMReadingLabelFieldMeal value:GlucoseMeasurementContextMealReserved]).to.beNil();
+        expect([UHNBGMReadingFormatter labelForField:UHNBGMReadingLabelFieldCarbohydrateID value:200]).to.beNil();
+    });
+    
+    it(@"should match NSDateFormatter over tens of thousands of rows across daylight saving changes", ^{
+        NSTimeZone *toronto = [NSTimeZone timeZoneWithName:@"America/Toronto"];
+        UHNBGMReadingFormatter *formatter = [[UHNBGMReadingFormatter alloc] initWithLocale:locale timeZone:toronto];
+        NSDateFormatter *timeFormatter = [[NSDateFormatter alloc] init];
+        timeFormatter.locale = locale;
+        timeFormatter.timeZone = toronto;
+        timeFormatter.dateFormat = @"h:mm a";
+        NSDateFormatter *dateFormatter = [[NSDateFormatter alloc] init];
+        dateFormatter.locale = locale;
+        dateFormatter.timeZone = toronto;
+        dateFormatter.dateStyle = NSDateFormatterShortStyle;
+        
+        // every 37 minutes from 2015-01-01 for about two years, a little out of order
+        NSTimeInterval startTime = 1420070400;
+        NSUInteger numberOfMismatches = 0;
+        for (NSUInteger index = 0; index < 30000; index++)
+        {
+            NSTimeInterval time = startTime + (index ^ 7) * 37 * 60;
+            UHNBGMHistoryReading reading = BGMFormatterReading(time, NAN);
+            NSDate *date = [NSDate dateWithTimeIntervalSince1970:time];
+            NSString *expectedString = [NSString stringWithFormat:@"--, %@ %@", [dateFormatter stringFromDate:date], [timeFormatter stringFromDate:date]];
+            
+            if (![BGMFormattedReading(formatter, &reading, 0) isEqualToString:expectedString])
+            {
+                numberOfMismatches++;
+            }
+        }
+        
+        expect(numberOfMismatches).to.equal(0);
+    });
+});
+
+SpecEnd
@@ -0,0 +1,156 @@
+//
+//  BGMRecordDecoderTests.m
+//  UHNBGMControllerTests
+//
+//  Created by agent on 2026-10-19.
+//  Copyright © 2026 University Health Network. All rights reserved.
+//
+
+#import <UHNBGMController/NSData+GlucoseMeasurementContextParser.h>
+#import <UHNBGMController/NSData+GlucoseMeasurementParser.h>
+#import <UHNBGMController/UHNBGMBulkDecoder.h>
+#import "BGMSimulatedMeter.h"
+
+SpecBegin(BGMRecordDecoderSpecs)
+
+describe(@"Foundation free record decoding", ^{
+    it(@"should decode a measurement like the measurement parser", ^{
+        uint8_t flag = 0x0B; // Time Offset, Glucose Concentration, Type and Sample Location, Status Present, Kg/L
+        uint16_t sequenceNumber = 0x000C;
+        uint16_t year = 2016;
+        int16_t timeOffset = -5;
+        uint16_t glucoseConcentration = 0xB08C; // 140 mg/dL
+        uint16_t status = 0x0485;
+        NSData *measurementData = [NSData dataWithBytes:(uint8_t[]){flag, sequenceNumber, (sequenceNumber >> 8), year, (year >> 8), 2, 22, 10, 30, 5, timeOffset, (timeOffset >> 8), glucoseConcentration, (glucoseConcentration >> 8), 0x11, status, (status >> 8)} length:17];
+        NSDictionary *measurementDetails = [measurementData parseGlucoseMeasurementCharacteristicDetails:NO];
+        
+        UHNBGMMeasurementRecord record;
+        expect(UHNBGMDecodeMeasurement([measurementData bytes], [measurementData length], &record)).to.beTruthy();
+        expect(record.sequenceNumber).to.equal([measurementDetails[kGlucoseMeasurementKeySequenceNumber] unsignedIntegerValue]);
+        expect(record.glucoseConcentration).to.beCloseToWithin([measurementDetails[kGlucoseMeasurementKeyGlucoseConcentration] floatValue], 1e-9);
+        expect(record.type).to.equal([measurementDetails[kGlucoseMeasurementKeyType] unsignedIntegerValue]);
+        expect(record.sampleLocation).to.equal([measurementDetails[kGlucoseMeasurementKeySampleLocation] unsignedIntegerValue]);
+        expect(record.sensorStatusAnnunciation).to.equal(status);
+        
+        // 2016-02-22 10:25:05 local time of the meter
+        expect(UHNBGMMeasurementLocalTimestamp(&record)).to.equal(1456136705);
+    });
+    
+    it(@"should reject a truncated measurement", ^{
+        NSData *measurementData = [BGMSimulatedMeter measurementWithSequenceNumber:1 glucoseConcentration:100 hasContext:NO];
+        UHNBGMMeasurementRecord record;
+        
+        expect(UHNBGMDecodeMeasurement([measurementData bytes], [measurementData length] - 1, &record)).to.beFalsy();
+    });
+    
+    it(@"should decode a measurement context like the measurement context parser", ^{
+        uint16_t sequenceNumber = 0x000F;
+        NSData *contextData = [NSData dataWithBytes:(uint8_t[]){0x5F, sequenceNumber, (sequenceNumber >> 8), 1, 90, 0, 2, 0x42, 0x08, 0x07, 75, 2, 15, 0, 6, 0} length:16];
+        NSDictionary *contextDetails = [contextData parseGlucoseMeasurementContextCharacteristicDetails:NO];
+        
+        UHNBGMMeasurementContextRecord record;
+        expect(UHNBGMDecodeMeasurementContext([contextData bytes], [contextData length], &record)).to.beTruthy();
+        expect(record.sequenceNumber).to.equal([contextDetails[kGlucoseMeasurementContextKeySequenceNumber] unsignedIntegerValue]);
+        expect(record.carbohydrate).to.beCloseToWithin([contextDetails[kGlucoseMeasurementContextKeyCarbohydrate] floatValue], 1e-9);
+        expect(record.meal).to.equal([contextDetails[kGlucoseMeasurementContextKeyMeal] unsignedIntegerValue]);
+        expect(record.tester).to.equal([contextDetails[kGlucoseMeasurementContextKeyTester] unsignedIntegerValue]);
+        expect(record.health).to.equal([contextDetails[kGlucoseMeasurementContextKeyHealth] unsignedIntegerValue]);
+        expect(record.exerciseDuration).to.equal([contextDetails[kGlucoseMeasurementContextKeyExerciseDuration] unsignedIntegerValue]);
+        expect(record.medication).to.beCloseToWithin([contextDetails[kGlucoseMeasurementContextKeyMedicationValue] floatValue], 1e-9);
+        expect(record.hbA1c).to.beCloseToWithin([contextDetails[kGlucoseMeasurementContextKeyHbA1c] floatValue], 1e-9);
+    });
+    
+    it(@"should encode records that decode to the same values", ^{
+        uint16_t year = 2016;
+        int16_t timeOffset = -5;
+        uint16_t status = 0x0485;
+        NSData *measurementData = [NSData dataWithBytes:(uint8_t[]){0x0B, 0x0C, 0x00, year, (year >> 8), 2, 22, 10, 30, 5, timeOffset, (timeOffset >> 8), 0x8C, 0xB0, 0x11, status, (status >> 8)} length:17];
+        NSData *contextData = [NSData dataWithBytes:(uint8_t[]){0x5F, 0x0F, 0x00, 1, 90, 0, 2, 0x42, 0x08, 0x07, 75, 2, 15, 0, 6, 0} length:16];
+        
+        UHNBGMMeasurementRecord measurement, encodedMeasurement;
+        uint8_t bytes[kUHNBGMMaximumRecordLength];
+        UHNBGMDecodeMeasurement([measurementData bytes], [measurementData length], &measurement);
+        expect(UHNBGMEncodeMeasurement(&measurement, bytes)).to.equal(17);
+        expect(UHNBGMDecodeMeasurement(bytes, 17, &encodedMeasurement)).to.beTruthy();
+        expect(UHNBGMMeasurementLocalTimestamp(&encodedMeasurement)).to.equal(UHNBGMMeasurementLocalTimestamp(&measurement));
+        expect(encodedMeasurement.flags).to.equal(measurement.flags);
+        expect(encodedMeasurement.glucoseConcentration).to.beCloseToWithin(measurement.glucoseConcentration, 1e-9);
+        expect(encodedMeasurement.type).to.equal(measurement.type);
+        expect(encodedMeasurement.sampleLocation).to.equal(measurement.sampleLocation);
+        expect(encodedMeasurement.sensorStatusAnnunciation).to.equal(status);
+        
+        UHNBGMMeasurementContextRecord context, encodedContext;
+        UHNBGMDecodeMeasurementContext([contextData bytes], [contextData length], &context);
+        expect(UHNBGMEncodeMeasurementContext(&context, bytes)).to.equal(16);
+        expect(UHNBGMDecodeMeasurementContext(bytes, 16, &encodedContext)).to.beTruthy();
+        expect(encodedContext.sequenceNumber).to.equal(context.sequenceNumber);
+        expect(encodedContext.carbohydrateID).to.equal(context.carbohydrateID);
+        expect(encodedContext.carbohydrate).to.beCloseToWithin(context.carbohydrate, 1e-9);
+        expect(encodedContext.meal).to.equal(context.meal);
+        expect(encodedContext.tester).to.equal(context.tester);
+        expect(encodedContext.health).to.equal(context.health);
+        expect(encodedContext.exerciseDuration).to.equal(context.exerciseDuration);
+        expect(encodedContext.exerciseIntensity).to.equal(context.exerciseIntensity);
+        expect(encodedContext.medication).to.beCloseToWithin(context.medication, 1e-9);
+        
+        expect(UHNBGMShortFloatRawValue(NAN)).to.equal(0x07FF);
+        expect(UHNBGMShortFloatRawValue(INFINITY)).to.equal(0x07FE);
+        expect(UHNBGMShortFloatRawValue(-1e12f)).to.equal(0x0802);
+    });
+    
+    it(@"should decode a batch of values stored back to back", ^{
+        NSMutableData *bytes = [NSMutableData data];
+        size_t lengths[3];
+        
+        for (uint16_t sequenceNumber = 0; sequenceNumber < 3; sequenceNumber++)
+        {
+            NSData *measurementData = [BGMSimulatedMeter measurementWithSequenceNumber:(sequenceNumber + 1) glucoseConcentration:100 hasContext:NO];
+            lengths[sequenceNumber] = (1 == sequenceNumber ? 2 : [measurementData length]);
+            [bytes appendBytes:[measurementData bytes] length:lengths[sequenceNumber]];
+        }
+        
+        UHNBGMMeasurementRecord records[3];
+        bool valid[3];
+        
+        expect(UHNBGMDecodeMeasurementBatch([bytes bytes], lengths, 3, records, valid)).to.equal(2);
+        expect(valid[0]).to.beTruthy();
+        expect(valid[1]).to.beFalsy();
+        expect(valid[2]).to.beTruthy();
+        expect(records[0].sequenceNumber).to.equal(1);
+        expect(records[2].sequenceNumber).to.equal(3);
+    });
+    
+    it(@"should bulk decode measurements in parallel in payload order", ^{
+        NSMutableArray *payloads = [NSMutableArray array];
+        
+        for (uint16_t sequenceNumber = 0; sequenceNumber < 10000; sequenceNumber++)
+        {
+            [payloads addObject:[BGMSimulatedMeter measurementWithSequenceNumber:sequenceNumber glucoseConcentration:(80 + sequenceNumber % 120) hasContext:NO]];
+        }
+        
+        [payloads addObject:[NSData dataWithBytes:(uint8_t[]){0x02, 0x01} length:2]];
+        
+        UHNBGMBulkDecoder *decoder = [[UHNBGMBulkDecoder alloc] init];
+        decoder.chunkSize = 512;
+        UHNBGMMeasurementColumns *columns = [decoder decodeMeasurementPayloads:payloads];
+        const uint16_t *sequenceNumbers = [columns.sequenceNumbers bytes];
+        const float *glucoseConcentrations = [columns.glucoseConcentrations bytes];
+        const uint8_t *valid = [columns.valid bytes];
+        
+        expect(columns.count).to.equal(10001);
+        expect(valid[10000]).to.equal(0);
+        
+        for (NSUInteger index = 0; index < 10000; index++)
+        {
+            NSDictionary *measurementDetails = [payloads[index] parseGlucoseMeasurementCharacteristicDetails:NO];
+            
+            if (sequenceNumbers[index] != index || fabsf(glucoseConcentrations[index] - [measurementDetails[kGlucoseMeasurementKeyGlucoseConcentration] floatValue]) > 1e-9 || !valid[index])
+            {
+                failure([NSString stringWithFormat:@"Measurement %lu was not decoded like the measurement parser", (unsigned long) index]);
+                break;
+            }
+        }
+    });
+});
+
+SpecEnd
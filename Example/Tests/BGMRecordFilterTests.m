@@ -0,0 +1,155 @@
+//
+//  BGMRecordFilterTests.m
+//  UHNBGMControllerTests
+//
+//  Created by agent on 2026-10-19.
+//  Copyright © 2026 University Health Network. All rights reserved.
+//
+
+#import <UHNBGMController/UHNBGMController.h>
+#import <UHNBGMController/NSData+GlucoseMeasurementParser.h>
+#import "BGMSimulatedMeter.h"
+
+static NSData *BGMMeasurementData(uint16_t sequenceNumber, uint8_t jointValue, uint16_t status)
+{
+    uint8_t flag = 0x0A; // Glucose Concentration, Type and Sample Location, Status Present, Kg/L
+    uint16_t year = 2016;
+    uint16_t glucoseConcentration = 0xB064; // 100 mg/dL
+    
+    return [NSData dataWithBytes:(uint8_t[]){flag, sequenceNumber, (sequenceNumber >> 8), year, (year >> 8), 3, 7, 9, 15, 0, glucoseConcentration, (glucoseConcentration >> 8), jointValue, status, (status >> 8)} length:15];
+}
+
+SpecBegin(BGMRecordFilterSpecs)
+
+describe(@"Record filter", ^{
+    it(@"should discard control solution and faulty readings", ^{
+        UHNBGMRecordFilter *filter = [[UHNBGMRecordFilter alloc] init];
+        filter.excludesControlSolution = YES;
+        filter.excludedSensorStatusAnnunciationMask = GlucoseMeasurementStatusDeviceBatteryLow;
+        
+        expect([filter shouldDeliverMeasurementData:BGMMeasurementData(1, 0x11, 0)]).to.beTruthy();
+        expect([filter shouldDeliverMeasurementData:BGMMeasurementData(2, 0x1A, 0)]).to.beFalsy(); // control solution fluid type
+        expect([filter shouldDeliverMeasurementData:BGMMeasurementData(3, 0x41, 0)]).to.beFalsy(); // control solution sample location
+        expect([filter shouldDeliverMeasurementData:BGMMeasurementData(4, 0x11, GlucoseMeasurementStatusDeviceBatteryLow)]).to.beFalsy();
+        
+        expect(filter.numberOfMeasurementsEvaluated).to.equal(4);
+        expect(filter.numberOfMeasurementsFilteredAsControlSolution).to.equal(2);
+        expect(filter.numberOfMeasurementsFilteredBySensorStatus).to.equal(1);
+        
+        // the context of the discarded measurement goes with it
+        expect([filter shouldDeliverMeasurementContextData:[BGMSimulatedMeter measurementContextWithSequenceNumber:4 meal:GlucoseMeasurementContextMealFasting]]).to.beFalsy();
+        expect([filter shouldDeliverMeasurementContextData:[BGMSimulatedMeter measurementContextWithSequenceNumber:1 meal:GlucoseMeasurementContextMealFasting]]).to.beTruthy();
+        expect(filter.numberOfMeasurementContextsFiltered).to.equal(1);
+    });
+    
+    it(@"should compare dates like the parser", ^{
+        NSData *measurementData = BGMMeasurementData(1, 0x11, 0);
+        NSDate *creationDate = [measurementData parseGlucoseMeasurementCharacteristicDetails:NO][kGlucoseMeasurementKeyCreationDate];
+        UHNBGMRecordFilter *filter = [[UHNBGMRecordFilter alloc] init];
+        
+        filter.earliestDate = creationDate;
+        filter.latestDate = creationDate;
+        expect([filter shouldDeliverMeasurementData:measurementData]).to.beTruthy();
+        
+        filter.earliestDate = [creationDate dateByAddingTimeInterval:1];
+        filter.latestDate = nil;
+        expect([filter shouldDeliverMeasurementData:measurementData]).to.beFalsy();
+        
+        filter.earliestDate = nil;
+        filter.latestDate = [creationDate dateByAddingTimeInterval:-1];
+        expect([filter shouldDeliverMeasurementData:measurementData]).to.beFalsy();
+        expect(filter.numberOfMeasurementsFilteredByDate).to.equal(2);
+    });
+    
+    it(@"should convert each record with its own UTC offset across a daylight saving change", ^{
+        NSTimeZone *defaultTimeZone = [NSTimeZone defaultTimeZone];
+        [NSTimeZone setDefaultTimeZone:[NSTimeZone timeZoneWithName:@"America/Toronto"]];
+        
+        // 2016-11-06 01:30 is the first pass through the repeated hour, in daylight time
+        uint8_t flag = 0x02;
+        uint16_t year = 2016;
+        uint16_t glucoseConcentration = 0xB064;
+        NSData *measurementData = [NSData dataWithBytes:(uint8_t[]){flag, 1, 0, year, (year >> 8), 11, 6, 1, 30, 0, glucoseConcentration, (glucoseConcentration >> 8), 0x11} length:13];
+        NSDate *creationDate = [measurementData parseGlucoseMeasurementCharacteristicDetails:NO][kGlucoseMeasurementKeyCreationDate];
+        UHNBGMRecordFilter *filter = [[UHNBGMRecordFilter alloc] init];
+        
+        filter.latestDate = creationDate;
+        expect([filter shouldDeliverMeasurementData:measurementData]).to.beTruthy();
+        
+        // half an hour later is 01:00 again, in standard time, which is after the measurement despite its earlier wall clock
+        filter.earliestDate = [creationDate dateByAddingTimeInterval:1800];
+        filter.latestDate = nil;
+        expect([filter shouldDeliverMeasurementData:measurementData]).to.beFalsy();
+        
+        [NSTimeZone setDefaultTimeZone:defaultTimeZone];
+    });
+    
+    it(@"should refuse a first sequence number greater than the last", ^{
+        UHNBGMRecordFilter *filter = [[UHNBGMRecordFilter alloc] init];
+        filter.lastSequenceNumber = 10;
+        
+        expect(^{
+            filter.firstSequenceNumber = 11;
+        }).to.raise(NSInvalidArgumentException);
+        
+        expect(^{
+            [filter setFirstSequenceNumber:20 lastSequenceNumber:5];
+        }).to.raise(NSInvalidArgumentException);
+        
+        [filter setFirstSequenceNumber:20 lastSequenceNumber:30];
+        expect(filter.firstSequenceNumber).to.equal(20);
+        expect(filter.lastSequenceNumber).to.equal(30);
+    });
+    
+    it(@"should push the sequence number bounds into the RACP request", ^{
+        BGMRecordingDelegate *delegate = [[BGMRecordingDelegate alloc] init];
+        UHNBGMController *controller = [[UHNBGMController alloc] initWithDelegate:delegate];
+        BGMSimulatedMeter *meter = [[BGMSimulatedMeter alloc] initWithController:controller];
+        [meter addStoredRecordsWithSequenceNumbers:NSMakeRange(1, 20)];
+        
+        UHNBGMRecordFilter *filter = [[UHNBGMRecordFilter alloc] init];
+        filter.firstSequenceNumber = 5;
+        filter.lastSequenceNumber = 9;
+        [controller setRecordFilter:filter];
+        
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"transferComplete"])
+                {
+                    done();
+                }
+            };
+            
+            [controller getAllStoredRecords];
+        });
+        
+        uint8_t expectedCommand[] = {0x01, GlucoseRACPOperatorWithinRange, GlucoseRACPFilterTypeSequenceNumber, 5, 0, 9, 0};
+        expect(meter.writtenCommands[0]).to.equal([NSData dataWithBytes:expectedCommand length:sizeof(expectedCommand)]);
+        expect(delegate.measurements.count).to.equal(5);
+        expect(filter.numberOfMeasurementsFilteredBySequenceNumber).to.equal(0);
+    });
+    
+    it(@"should request all stored records without a filter", ^{
+        BGMRecordingDelegate *delegate = [[BGMRecordingDelegate alloc] init];
+        UHNBGMController *controller = [[UHNBGMController alloc] initWithDelegate:delegate];
+        BGMSimulatedMeter *meter = [[BGMSimulatedMeter alloc] initWithController:controller];
+        [meter addStoredRecordsWithSequenceNumbers:NSMakeRange(1, 20)];
+        
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"transferComplete"])
+                {
+                    done();
+                }
+            };
+            
+            [controller getAllStoredRecords];
+        });
+        
+        uint8_t expectedCommand[] = {0x01, GlucoseRACPOperatorAllRecords};
+        expect(meter.writtenCommands[0]).to.equal([NSData dataWithBytes:expectedCommand length:sizeof(expectedCommand)]);
+        expect(delegate.measurements.count).to.equal(20);
+    });
+});
+
+SpecEnd
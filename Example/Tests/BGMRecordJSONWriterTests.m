@@ -0,0 +1,231 @@
+//
+//  BGMRecordJSONWriterTests.m
+//  UHNBGMControllerTests
+//
+//  Created by agent on 2026-10-19.
+//  Copyright © 2026 University Health Network. All rights reserved.
+//
+
+#import <UHNBGMController/UHNBGMController.h>
+#import <UHNBGMController/UHNBGMRecordJSONWriter.h>
+#import "BGMSimulatedMeter.h"
+#import <fcntl.h>
+
+static NSArray *BGMJSONObjectsFromLines(NSData *data)
+{
+    NSMutableArray *objects = [NSMutableArray array];
+    NSString *text = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+    
+    for (NSString *line in [text componentsSeparatedByString:@"\n"])
+    {
+        if ([line length] > 0)
+        {
+            [objects addObject:[NSJSONSerialization JSONObjectWithData:[line dataUsingEncoding:NSUTF8StringEncoding] options:0 error:nil]];
+        }
+    }
+    
+    return objects;
+}
+
+SpecBegin(BGMRecordJSONWriterSpecs)
+
+describe(@"Streaming JSON record writer", ^{
+    it(@"should write JSON lines with only the fields present", ^{
+        NSMutableData *output = [NSMutableData data];
+        UHNBGMRecordJSONWriter *writer = [[UHNBGMRecordJSONWriter alloc] initWithMutableData:output format:UHNBGMRecordJSONFormatJSONLines];
+        writer.meterTimeZone = [NSTimeZone timeZoneForSecondsFromGMT:-5 * 3600];
+        
+        uint8_t flag = 0x0B; // Time Offset, Glucose Concentration, Type and Sample Location, Status Present, Kg/L
+        uint16_t year = 2016;
+        int16_t timeOffset = -5;
+        uint16_t glucoseConcentration = 0xB08C; // 140 mg/dL
+        uint16_t status = 0x0485;
+        NSData *measurementData = [NSData dataWithBytes:(uint8_t[]){flag, 0x0C, 0x00, year, (year >> 8), 2, 22, 10, 30, 5, timeOffset, (timeOffset >> 8), glucoseConcentration, (glucoseConcentration >> 8), 0x11, status, (status >> 8)} length:17];
+        
+        expect([writer writeMeasurementData:measurementData contextData:[BGMSimulatedMeter measurementContextWithSequenceNumber:0x0C meal:GlucoseMeasurementContextMealPostprandial]]).to.beTruthy();
+        expect([writer writeMeasurementData:[BGMSimulatedMeter measurementWithSequenceNumber:13 glucoseConcentration:0x07FF hasContext:NO] contextData:nil]).to.beTruthy();
+        expect([writer flush]).to.beTruthy();
+        
+        NSArray *lines = BGMJSONObjectsFromLines(output);
+        expect(lines.count).to.equal(2);
+        expect(writer.numberOfRecordsWritten).to.equal(2);
+        expect(writer.numberOfBytesWritten).to.equal(output.length);
+        
+        // 2016-02-22 10:25:05 in the UTC-5 time zone of the meter
+        expect(lines[0]).to.equal(@{@"sequenceNumber": @12, @"time": @"2016-02-22T15:25:05Z", @"glucose": @140, @"unit": @"mg/dL", @"type": @1, @"sampleLocation": @1, @"sensorStatus": @(status), @"meal": @(GlucoseMeasurementContextMealPostprandial)});
+        
+        // NaN is not a JSON number
+        expect(lines[1][@"glucose"]).to.equal([NSNull null]);
+        expect(lines[1][@"sensorStatus"]).to.beNil();
+        expect(lines[1][@"meal"]).to.beNil();
+    });
+    
+    it(@"should write mmol/L with a fixed number of decimals", ^{
+        NSMutableData *output = [NSMutableData data];
+        UHNBGMRecordJSONWriter *writer = [[UHNBGMRecordJSONWriter alloc] initWithMutableData:output format:UHNBGMRecordJSONFormatJSONLines];
+        
+        uint16_t year = 2016;
+        uint16_t glucoseConcentration = 0xC04E; // 7.8 mmol/L is 78 x 10^-4 mol/L
+        NSData *measurementData = [NSData dataWithBytes:(uint8_t[]){0x06, 1, 0, year, (year >> 8), 3, 17, 9, 0, 0, glucoseConcentration, (glucoseConcentration >> 8), 0x11} length:13];
+        
+        [writer writeMeasurementData:measurementData contextData:nil];
+        [writer flush];
+        
+        NSString *line = [[NSString alloc] initWithData:output encoding:NSUTF8StringEncoding];
+        expect(line).to.contain(@"\"glucose\":7.8,\"unit\":\"mmol/L\"");
+        expect(line).to.contain(@"\"time\":\"2016-03-17T09:00:00Z\"");
+    });
+    
+    it(@"should convert each time with the offset in effect at that time", ^{
+        NSMutableData *output = [NSMutableData data];
+        UHNBGMRecordJSONWriter *writer = [[UHNBGMRecordJSONWriter alloc] initWithMutableData:output format:UHNBGMRecordJSONFormatJSONLines];
+        writer.meterTimeZone = [NSTimeZone timeZoneWithName:@"America/Toronto"];
+        
+        uint16_t year = 2016;
+        [writer writeMeasurementData:[NSData dataWithBytes:(uint8_t[]){0x00, 1, 0, year, (year >> 8), 7, 1, 12, 0, 0} length:10] contextData:nil];
+        [writer writeMeasurementData:[NSData dataWithBytes:(uint8_t[]){0x00, 2, 0, year, (year >> 8), 12, 1, 12, 0, 0} length:10] contextData:nil];
+        [writer flush];
+        
+        // daylight saving time in July, standard time in December
+        NSArray *lines = BGMJSONObjectsFromLines(output);
+        expect(lines[0][@"time"]).to.equal(@"2016-07-01T16:00:00Z");
+        expect(lines[1][@"time"]).to.equal(@"2016-12-01T17:00:00Z");
+    });
+    
+    it(@"should write FHIR Observation resources", ^{
+        NSMutableData *output = [NSMutableData data];
+        UHNBGMRecordJSONWriter *writer = [[UHNBGMRecordJSONWriter alloc] initWithMutableData:output format:UHNBGMRecordJSONFormatFHIRObservation];
+        writer.patientReference = @"Patient/\"123\"";
+        writer.deviceReference = @"Device/456";
+        
+        [writer writeMeasurementData:[BGMSimulatedMeter measurementWithSequenceNumber:7 glucoseConcentration:120 hasContext:YES] contextData:[BGMSimulatedMeter measurementContextWithSequenceNumber:7 meal:GlucoseMeasurementContextMealFasting]];
+        [writer writeMeasurementData:[BGMSimulatedMeter measurementWithSequenceNumber:8 glucoseConcentration:0x07FF hasContext:NO] contextData:nil];
+        [writer flush];
+        
+        NSArray *observations = BGMJSONObjectsFromLines(output);
+        expect(observations.count).to.equal(2);
+        
+        NSDictionary *observation = observations[0];
+        expect(observation[@"resourceType"]).to.equal(@"Observation");
+        expect(observation[@"status"]).to.equal(@"final");
+        expect(observation[@"identifier"][0][@"value"]).to.equal(@"7");
+        expect(observation[@"code"][@"coding"][0][@"code"]).to.equal(@"41653-7");
+        expect(observation[@"subject"][@"reference"]).to.equal(@"Patient/\"123\"");
+        expect(observation[@"device"][@"reference"]).to.equal(@"Device/456");
+        expect(observation[@"effectiveDateTime"]).to.equal(@"2016-02-01T08:07:00Z");
+        expect(observation[@"valueQuantity"]).to.equal(@{@"value": @120, @"unit": @"mg/dL", @"system": @"http://unitsofmeasure.org", @"code": @"mg/dL"});
+        expect(observation[@"extension"]).to.equal(@[@{@"url": @"urn:uhn:bgm:meal", @"valueInteger": @(GlucoseMeasurementContextMealFasting)}]);
+        
+        expect(observations[1][@"valueQuantity"]).to.beNil();
+        expect(observations[1][@"dataAbsentReason"][@"coding"][0][@"code"]).to.equal(@"error");
+        expect(observations[1][@"extension"]).to.beNil();
+    });
+    
+    it(@"should write the same bytes to a file descriptor in constant memory", ^{
+        NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+        int fileDescriptor = open([path fileSystemRepresentation], O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        expect(fileDescriptor).to.beGreaterThanOrEqualTo(0);
+        
+        NSMutableData *output = [NSMutableData data];
+        UHNBGMRecordJSONWriter *dataWriter = [[UHNBGMRecordJSONWriter alloc] initWithMutableData:output format:UHNBGMRecordJSONFormatFHIRObservation];
+        UHNBGMRecordJSONWriter *fileWriter = [[UHNBGMRecordJSONWriter alloc] initWithFileDescriptor:fileDescriptor format:UHNBGMRecordJSONFormatFHIRObservation];
+        dataWriter.patientReference = fileWriter.patientReference = @"Patient/123";
+        
+        for (uint16_t sequenceNumber = 0; sequenceNumber < 5000; sequenceNumber++)
+        {
+            UHNBGMMeasurementRecord measurement;
+            NSData *measurementData = [BGMSimulatedMeter measurementWithSequenceNumber:sequenceNumber glucoseConcentration:(60 + sequenceNumber % 300) hasContext:NO];
+            UHNBGMDecodeMeasurement([measurementData bytes], [measurementData length], &measurement);
+            
+            [dataWriter writeMeasurement:&measurement context:NULL];
+            expect([fileWriter writeMeasurement:&measurement context:NULL]).to.beTruthy();
+        }
+        
+        // no more than the fixed size buffer is held back before the flush
+        NSUInteger numberOfBytesWrittenBeforeFlush = fileWriter.numberOfBytesWritten;
+        [dataWriter flush];
+        expect([fileWriter flush]).to.beTruthy();
+        expect(fileWriter.numberOfBytesWritten - numberOfBytesWrittenBeforeFlush).to.beLessThanOrEqualTo(4096);
+        close(fileDescriptor);
+        
+        expect(fileWriter.numberOfRecordsWritten).to.equal(5000);
+        expect([NSData dataWithContentsOfFile:path]).to.equal(output);
+        expect(BGMJSONObjectsFromLines(output).count).to.equal(5000);
+        [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+    });
+    
+    it(@"should pair measurements with their contexts as a record sink", ^{
+        BGMRecordingDelegate *delegate = [[BGMRecordingDelegate alloc] init];
+        UHNBGMController *controller = [[UHNBGMController alloc] initWithDelegate:delegate];
+        BGMSimulatedMeter *meter = [[BGMSimulatedMeter alloc] initWithController:controller];
+        [meter addStoredRecordsWithSequenceNumbers:NSMakeRange(1, 4)];
+        [meter addStoredRecordWithSequenceNumber:5 glucoseConcentration:120 mealContext:GlucoseMeasurementContextMealPreprandial];
+        [meter addStoredRecordsWithSequenceNumbers:NSMakeRange(6, 2)];
+        
+        NSMutableData *output = [NSMutableData data];
+        UHNBGMRecordJSONWriter *writer = [[UHNBGMRecordJSONWriter alloc] initWithMutableData:output format:UHNBGMRecordJSONFormatJSONLines];
+        [controller enableLazyRecordParsing:YES];
+        [controller addRecordSink:writer];
+        
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"transferComplete"])
+                {
+                    [controller waitForPendingCallbacksWithCompletion:^{
+                        done();
+                    }];
+                }
+            };
+            
+            [controller getAllStoredRecords];
+        });
+        
+        NSArray *lines = BGMJSONObjectsFromLines(output);
+        expect(lines.count).to.equal(7);
+        expect([lines valueForKey:@"sequenceNumber"]).to.equal(@[@1, @2, @3, @4, @5, @6, @7]);
+        expect(lines[4][@"glucose"]).to.equal(@120);
+        expect(lines[4][@"meal"]).to.equal(@(GlucoseMeasurementContextMealPreprandial));
+        expect(lines[5][@"meal"]).to.beNil();
+    });
+    
+    it(@"should write the same lines from records that are decoded eagerly", ^{
+        NSMutableArray *outputs = [NSMutableArray array];
+        
+        for (NSNumber *lazyRecordParsing in @[@YES, @NO])
+        {
+            BGMRecordingDelegate *delegate = [[BGMRecordingDelegate alloc] init];
+            UHNBGMController *controller = [[UHNBGMController alloc] initWithDelegate:delegate];
+            BGMSimulatedMeter *meter = [[BGMSimulatedMeter alloc] initWithController:controller];
+            [meter addStoredRecordsWithSequenceNumbers:NSMakeRange(1, 2)];
+            [meter addStoredRecordWithSequenceNumber:3 glucoseConcentration:120 mealContext:GlucoseMeasurementContextMealPreprandial];
+            [meter addStoredRecordsWithSequenceNumbers:NSMakeRange(4, 2)];
+            
+            NSMutableData *output = [NSMutableData data];
+            UHNBGMRecordJSONWriter *writer = [[UHNBGMRecordJSONWriter alloc] initWithMutableData:output format:UHNBGMRecordJSONFormatJSONLines];
+            [controller enableLazyRecordParsing:[lazyRecordParsing boolValue]];
+            [controller addRecordSink:writer];
+            
+            waitUntil(^(DoneCallback done) {
+                delegate.eventHandler = ^(NSString *event) {
+                    if ([event isEqualToString:@"transferComplete"])
+                    {
+                        [controller waitForPendingCallbacksWithCompletion:^{
+                            done();
+                        }];
+                    }
+                };
+                
+                [controller getAllStoredRecords];
+            });
+            
+            [outputs addObject:output];
+        }
+        
+        NSArray *lines = BGMJSONObjectsFromLines(outputs[1]);
+        expect(lines.count).to.equal(5);
+        expect(lines[2][@"meal"]).to.equal(@(GlucoseMeasurementContextMealPreprandial));
+        expect(outputs[1]).to.equal(outputs[0]);
+    });
+});
+
+SpecEnd
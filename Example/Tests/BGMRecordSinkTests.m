@@ -0,0 +1,133 @@
+//
+//  BGMRecordSinkTests.m
+//  UHNBGMControllerTests
+//
+//  Created by agent on 2026-10-19.
+//  Copyright © 2026 University Health Network. All rights reserved.
+//
+
+#import <UHNBGMController/UHNBGMController.h>
+#import <UHNBGMController/UHNBGMCharacteristicTable.h>
+#import "BGMSimulatedMeter.h"
+
+@interface BGMCollectingSink : NSObject <UHNBGMRecordSink>
+@property (nonatomic, assign) UHNBGMRecordSinkInterest interests;
+@property (nonatomic, strong) NSMutableArray *measurements;
+@property (nonatomic, strong) NSMutableArray *measurementContexts;
+@property (nonatomic, assign) NSUInteger numberOfCompletedTransfers;
+@end
+
+@implementation BGMCollectingSink
+
+- (instancetype) initWithInterests:(UHNBGMRecordSinkInterest) interests;
+{
+    if ((self = [super init]))
+    {
+        self.interests = interests;
+        self.measurements = [NSMutableArray array];
+        self.measurementContexts = [NSMutableArray array];
+    }
+    
+    return self;
+}
+
+- (UHNBGMRecordSinkInterest) recordSinkInterests;
+{
+    return self.interests;
+}
+
+- (void) bgmController:(UHNBGMController *) controller didReceiveGlucoseMeasurement:(NSDictionary *) measurementDetails;
+{
+    [self.measurements addObject:measurementDetails];
+}
+
+- (void) bgmController:(UHNBGMController *) controller didReceiveGlucoseMeasurementContext:(NSDictionary *) measurementContextDetails;
+{
+    [self.measurementContexts addObject:measurementContextDetails];
+}
+
+- (void) bgmController:(UHNBGMController *) controller didCompleteTransferWithNumberOfRecords:(NSUInteger) numberOfRecords;
+{
+    self.numberOfCompletedTransfers += 1;
+}
+
+@end
+
+SpecBegin(BGMRecordSinkSpecs)
+
+describe(@"Record sinks", ^{
+    it(@"should map characteristic UUIDs to identifiers", ^{
+        expect(UHNBGMGlucoseServiceCharacteristicForUUID(kGlucoseServiceCharacteristicUUIDMeasurement)).to.equal(GlucoseServiceCharacteristicMeasurement);
+        expect(UHNBGMGlucoseServiceCharacteristicForUUID(kGlucoseServiceCharacteristicUUIDRecordAccessControlPoint)).to.equal(GlucoseServiceCharacteristicRecordAccessControlPoint);
+        expect(UHNBGMGlucoseServiceCharacteristicForUUID(@"2A19")).to.equal(GlucoseServiceCharacteristicUnknown);
+        expect(UHNBGMUUIDForGlucoseServiceCharacteristic(GlucoseServiceCharacteristicMeasurementContext)).to.equal(kGlucoseServiceCharacteristicUUIDMeasurementContext);
+    });
+    
+    it(@"should fan the same records out to the interested sinks", ^{
+        BGMRecordingDelegate *delegate = [[BGMRecordingDelegate alloc] init];
+        UHNBGMController *controller = [[UHNBGMController alloc] initWithDelegate:delegate];
+        BGMSimulatedMeter *meter = [[BGMSimulatedMeter alloc] initWithController:controller];
+        [meter addStoredRecordsWithSequenceNumbers:NSMakeRange(1, 5)];
+        [meter addStoredRecordWithSequenceNumber:6 glucoseConcentration:120 mealContext:GlucoseMeasurementContextMealPreprandial];
+        
+        BGMCollectingSink *allSink = [[BGMCollectingSink alloc] initWithInterests:(UHNBGMRecordSinkInterestMeasurements | UHNBGMRecordSinkInterestMeasurementContexts | UHNBGMRecordSinkInterestTransferEvents)];
+        BGMCollectingSink *measurementSink = [[BGMCollectingSink alloc] initWithInterests:UHNBGMRecordSinkInterestMeasurements];
+        BGMCollectingSink *removedSink = [[BGMCollectingSink alloc] initWithInterests:UHNBGMRecordSinkInterestMeasurements];
+        [controller addRecordSink:allSink];
+        [controller addRecordSink:measurementSink];
+        [controller addRecordSink:removedSink];
+        [controller removeRecordSink:removedSink];
+        
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"transferComplete"])
+                {
+                    done();
+                }
+            };
+            
+            [controller getAllStoredRecords];
+        });
+        
+        expect(allSink.measurements.count).to.equal(6);
+        expect(allSink.measurementContexts.count).to.equal(1);
+        expect(allSink.numberOfCompletedTransfers).to.equal(1);
+        expect(measurementSink.measurements.count).to.equal(6);
+        expect(measurementSink.measurementContexts.count).to.equal(0);
+        expect(measurementSink.numberOfCompletedTransfers).to.equal(0);
+        expect(removedSink.measurements.count).to.equal(0);
+        
+        for (NSUInteger index = 0; index < 6; index++)
+        {
+            expect(measurementSink.measurements[index]).to.beIdenticalTo(allSink.measurements[index]);
+            expect(delegate.measurements[index]).to.beIdenticalTo(allSink.measurements[index]);
+        }
+    });
+    
+    it(@"should hand out mutable details when the records are decoded eagerly", ^{
+        BGMRecordingDelegate *delegate = [[BGMRecordingDelegate alloc] init];
+        UHNBGMController *controller = [[UHNBGMController alloc] initWithDelegate:delegate];
+        BGMSimulatedMeter *meter = [[BGMSimulatedMeter alloc] initWithController:controller];
+        [meter addStoredRecordsWithSequenceNumbers:NSMakeRange(1, 2)];
+        
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"transferComplete"])
+                {
+                    done();
+                }
+            };
+            
+            [controller getAllStoredRecords];
+        });
+        
+        expect(delegate.measurements.count).to.equal(2);
+        expect(delegate.measurements[0]).to.beKindOf([NSMutableDictionary class]);
+        
+        // delegates written before lazy decoding annotate the details they receive
+        delegate.measurements[0][@"note"] = @"checked";
+        expect(delegate.measurements[0][@"note"]).to.equal(@"checked");
+    });
+});
+
+SpecEnd
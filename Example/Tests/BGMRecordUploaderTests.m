@@ -0,0 +1,533 @@
+//
+//  BGMRecordUploaderTests.m
+//  UHNBGMControllerTests
+//
+//  Created by agent on 2026-10-19.
+//  Copyright © 2026 University Health Network. All rights reserved.
+//
+
+#import <zlib.h>
+#import <UHNBGMController/UHNBGMController.h>
+#import <UHNBGMController/UHNBGMLazyRecordDictionary.h>
+#import <UHNBGMController/UHNBGMRecordUploader.h>
+#import "BGMSimulatedMeter.h"
+
+static NSData *BGMGunzipData(NSData *data)
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    inflateInit2(&stream, 15 + 16);
+    
+    NSMutableData *inflatedData = [NSMutableData data];
+    uint8_t buffer[4096];
+    stream.next_in = (Bytef *) [data bytes];
+    stream.avail_in = (uInt) [data length];
+    
+    int status;
+    do
+    {
+        stream.next_out = buffer;
+        stream.avail_out = sizeof(buffer);
+        status = inflate(&stream, Z_NO_FLUSH);
+        [inflatedData appendBytes:buffer length:sizeof(buffer) - stream.avail_out];
+    } while (Z_OK == status);
+    
+    inflateEnd(&stream);
+    
+    return (Z_STREAM_END == status ? inflatedData : nil);
+}
+
+/**
+ A stand-in for the upload server, answering the requests of the session it is registered with after a delay, with the scripted statuses
+ */
+@interface BGMStandInServer : NSURLProtocol
+@end
+
+static NSMutableArray *standInStatusCodes;
+static NSInteger standInDefaultStatusCode;
+static NSTimeInterval standInLatency;
+static NSMutableArray *standInBatches;
+static NSMutableArray *standInAuthorizations;
+static NSUInteger standInNumberOfRequestsInFlight;
+static NSUInteger standInMaximumNumberOfRequestsInFlight;
+
+@implementation BGMStandInServer
+
++ (void) resetWithLatency:(NSTimeInterval) latency statusCodes:(NSArray *) statusCodes defaultStatusCode:(NSInteger) defaultStatusCode;
+{
+    @synchronized (self)
+    {
+        standInLatency = latency;
+        standInStatusCodes = [statusCodes mutableCopy];
+        standInDefaultStatusCode = defaultStatusCode;
+        standInBatches = [NSMutableArray array];
+        standInAuthorizations = [NSMutableArray array];
+        standInNumberOfRequestsInFlight = 0;
+        standInMaximumNumberOfRequestsInFlight = 0;
+    }
+}
+
++ (void) setDefaultStatusCode:(NSInteger) defaultStatusCode;
+{
+    @synchronized (self)
+    {
+        standInDefaultStatusCode = defaultStatusCode;
+    }
+}
+
++ (NSArray *) batches;
+{
+    @synchronized (self)
+    {
+        return [standInBatches copy];
+    }
+}
+
++ (NSArray *) authorizations;
+{
+    @synchronized (self)
+    {
+        return [standInAuthorizations copy];
+    }
+}
+
++ (NSUInteger) maximumNumberOfRequestsInFlight;
+{
+    @synchronized (self)
+    {
+        return standInMaximumNumberOfRequestsInFlight;
+    }
+}
+
++ (NSURLSessionConfiguration *) sessionConfiguration;
+{
+    NSURLSessionConfiguration *configuration = [NSURLSessionConfiguration ephemeralSessionConfiguration];
+    configuration.protocolClasses = @[[BGMStandInServer class]];
+    
+    return configuration;
+}
+
++ (BOOL) canInitWithRequest:(NSURLRequest *) request;
+{
+    return YES;
+}
+
++ (NSURLRequest *) canonicalRequestForRequest:(NSURLRequest *) request;
+{
+    return request;
+}
+
+- (void) startLoading;
+{
+    // the session hands the body over as a stream
+    NSData *body = self.request.HTTPBody;
+    if (!body && self.request.HTTPBodyStream)
+    {
+        NSMutableData *streamedBody = [NSMutableData data];
+        NSInputStream *stream = self.request.HTTPBodyStream;
+        uint8_t buffer[4096];
+        NSInteger length;
+        [stream open];
+        while ((length = [stream read:buffer maxLength:sizeof(buffer)]) > 0)
+        {
+            [streamedBody appendBytes:buffer length:length];
+        }
+        [stream close];
+        body = streamedBody;
+    }
+    
+    NSInteger statusCode;
+    NSTimeInterval latency;
+    @synchronized ([BGMStandInServer class])
+    {
+        statusCode = ([standInStatusCodes count] > 0 ? [standInStatusCodes[0] integerValue] : standInDefaultStatusCode);
+        if ([standInStatusCodes count] > 0)
+        {
+            [standInStatusCodes removeObjectAtIndex:0];
+        }
+        latency = standInLatency;
+        [standInAuthorizations addObject:([self.request valueForHTTPHeaderField:@"Authorization"] ?: [NSNull null])];
+        standInNumberOfRequestsInFlight += 1;
+        standInMaximumNumberOfRequestsInFlight = MAX(standInMaximumNumberOfRequestsInFlight, standInNumberOfRequestsInFlight);
+    }
+    
+    NSURLRequest *request = self.request;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t) (latency * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        @synchronized ([BGMStandInServer class])
+        {
+            standInNumberOfRequestsInFlight -= 1;
+            if (200 == statusCode)
+            {
+                BOOL isCompressed = [[request valueForHTTPHeaderField:@"Content-Encoding"] isEqualToString:@"gzip"];
+                [standInBatches addObject:(isCompressed ? BGMGunzipData(body) : body)];
+            }
+        }
+        
+        NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:request.URL statusCode:statusCode HTTPVersion:@"HTTP/1.1" headerFields:nil];
+        [self.client URLProtocol:self didReceiveResponse:response cacheStoragePolicy:NSURLCacheStorageNotAllowed];
+        [self.client URLProtocolDidFinishLoading:self];
+    });
+}
+
+- (void) stopLoading;
+{
+}
+
+@end
+
+@interface BGMUploadRecorder : NSObject <UHNBGMRecordUploaderDelegate>
+@property (nonatomic, assign) NSUInteger numberOfRecordsUploaded;
+@property (nonatomic, assign) NSUInteger numberOfRecordsRejected;
+@property (nonatomic, assign) NSUInteger numberOfRetries;
+@property (nonatomic, assign) NSUInteger numberOfPauses;
+@property (nonatomic, assign) NSUInteger numberOfRecordsNotSaved;
+@property (nonatomic, strong) NSMutableArray *backpressureChanges;
+@property (nonatomic, copy) void (^eventHandler)(NSString *event);
+@end
+
+@implementation BGMUploadRecorder
+
+- (instancetype) init;
+{
+    if ((self = [super init]))
+    {
+        self.backpressureChanges = [NSMutableArray array];
+    }
+    
+    return self;
+}
+
+- (void) recordUploader:(UHNBGMRecordUploader *) uploader didUploadBatchWithNumberOfRecords:(NSUInteger) numberOfRecords;
+{
+    self.numberOfRecordsUploaded += numberOfRecords;
+    [self notifyEvent:@"upload"];
+}
+
+- (void) recordUploader:(UHNBGMRecordUploader *) uploader didRejectBatchWithNumberOfRecords:(NSUInteger) numberOfRecords statusCode:(NSInteger) statusCode;
+{
+    self.numberOfRecordsRejected += numberOfRecords;
+    [self notifyEvent:@"reject"];
+}
+
+- (void) recordUploader:(UHNBGMRecordUploader *) uploader willRetryBatchAfterError:(NSError *) error retryInterval:(NSTimeInterval) retryInterval;
+{
+    self.numberOfRetries += 1;
+    [self notifyEvent:@"retry"];
+}
+
+- (void) recordUploader:(UHNBGMRecordUploader *) uploader didPauseUploadsWithStatusCode:(NSInteger) statusCode;
+{
+    self.numberOfPauses += 1;
+    [self notifyEvent:@"pause"];
+}
+
+- (void) recordUploader:(UHNBGMRecordUploader *) uploader didFailToSaveBatchWithNumberOfRecords:(NSUInteger) numberOfRecords error:(NSError *) error;
+{
+    self.numberOfRecordsNotSaved += numberOfRecords;
+    [self notifyEvent:@"saveFailure"];
+}
+
+- (void) recordUploader:(UHNBGMRecordUploader *) uploader didChangeBackpressure:(BOOL) backpressured;
+{
+    [self.backpressureChanges addObject:@(backpressured)];
+    [self notifyEvent:@"backpressure"];
+}
+
+- (void) notifyEvent:(NSString *) event;
+{
+    if (self.eventHandler)
+    {
+        self.eventHandler(event);
+    }
+}
+
+@end
+
+static NSURL *BGMUploadURL(void)
+{
+    return [NSURL URLWithString:@"http://uploads.example.test/observations"];
+}
+
+static NSString *BGMOutboxPath(void)
+{
+    return [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+}
+
+static void BGMSendRecords(UHNBGMRecordUploader *uploader, NSRange sequenceNumbers)
+{
+    for (NSUInteger sequenceNumber = sequenceNumbers.location; sequenceNumber < NSMaxRange(sequenceNumbers); sequenceNumber++)
+    {
+        NSData *measurementData = [BGMSimulatedMeter measurementWithSequenceNumber:sequenceNumber glucoseConcentration:100 hasContext:NO];
+        [uploader bgmController:nil didReceiveGlucoseMeasurement:[[UHNBGMLazyMeasurementDictionary alloc] initWithGlucoseMeasurementData:measurementData crcPresent:NO]];
+    }
+}
+
+static NSUInteger BGMNumberOfLines(NSArray *batches)
+{
+    NSUInteger numberOfLines = 0;
+    for (NSData *batch in batches)
+    {
+        NSString *text = [[NSString alloc] initWithData:batch encoding:NSUTF8StringEncoding];
+        numberOfLines += [[text componentsSeparatedByString:@"\n"] count] - 1;
+    }
+    
+    return numberOfLines;
+}
+
+SpecBegin(BGMRecordUploaderSpecs)
+
+describe(@"Batched record uploads", ^{
+    it(@"should upload a transfer in compressed batches with bounded requests in flight", ^{
+        [BGMStandInServer resetWithLatency:0.05 statusCodes:nil defaultStatusCode:200];
+        
+        BGMRecordingDelegate *delegate = [[BGMRecordingDelegate alloc] init];
+        UHNBGMController *controller = [[UHNBGMController alloc] initWithDelegate:delegate];
+        BGMSimulatedMeter *meter = [[BGMSimulatedMeter alloc] initWithController:controller];
+        [meter addStoredRecordsWithSequenceNumbers:NSMakeRange(1, 600)];
+        
+        BGMUploadRecorder *recorder = [[BGMUploadRecorder alloc] init];
+        NSString *outboxPath = BGMOutboxPath();
+        UHNBGMRecordUploader *uploader = [[UHNBGMRecordUploader alloc] initWithUploadURL:BGMUploadURL() outboxPath:outboxPath format:UHNBGMRecordJSONFormatFHIRObservation sessionConfiguration:[BGMStandInServer sessionConfiguration]];
+        uploader.delegate = recorder;
+        uploader.maximumNumberOfRecordsPerBatch = 100;
+        uploader.maximumNumberOfConcurrentUploads = 2;
+        [controller enableLazyRecordParsing:YES];
+        [controller addRecordSink:uploader];
+        
+        waitUntilTimeout(10, ^(DoneCallback done) {
+            recorder.eventHandler = ^(NSString *event) {
+                if (600 == recorder.numberOfRecordsUploaded)
+                {
+                    done();
+                }
+            };
+            
+            [controller getAllStoredRecords];
+        });
+        
+        NSArray *batches = [BGMStandInServer batches];
+        expect(batches.count).to.equal(6);
+        expect(BGMNumberOfLines(batches)).to.equal(600);
+        expect([BGMStandInServer maximumNumberOfRequestsInFlight]).to.beLessThanOrEqualTo(2);
+        expect([uploader numberOfPendingBatches]).to.equal(0);
+        expect([[NSFileManager defaultManager] contentsOfDirectoryAtPath:outboxPath error:nil]).to.haveCountOf(0);
+    });
+    
+    it(@"should seal a batch once it gets too old", ^{
+        [BGMStandInServer resetWithLatency:0 statusCodes:nil defaultStatusCode:200];
+        
+        BGMUploadRecorder *recorder = [[BGMUploadRecorder alloc] init];
+        UHNBGMRecordUploader *uploader = [[UHNBGMRecordUploader alloc] initWithUploadURL:BGMUploadURL() outboxPath:BGMOutboxPath() format:UHNBGMRecordJSONFormatJSONLines sessionConfiguration:[BGMStandInServer sessionConfiguration]];
+        uploader.delegate = recorder;
+        uploader.maximumBatchInterval = 0.1;
+        
+        waitUntil(^(DoneCallback done) {
+            recorder.eventHandler = ^(NSString *event) {
+                done();
+            };
+            
+            BGMSendRecords(uploader, NSMakeRange(1, 3));
+        });
+        
+        expect(recorder.numberOfRecordsUploaded).to.equal(3);
+        expect([BGMStandInServer batches]).to.haveCountOf(1);
+    });
+    
+    it(@"should retry failed uploads and drop rejected batches", ^{
+        [BGMStandInServer resetWithLatency:0 statusCodes:@[@503, @429, @200, @400] defaultStatusCode:200];
+        
+        BGMUploadRecorder *recorder = [[BGMUploadRecorder alloc] init];
+        NSString *outboxPath = BGMOutboxPath();
+        UHNBGMRecordUploader *uploader = [[UHNBGMRecordUploader alloc] initWithUploadURL:BGMUploadURL() outboxPath:outboxPath format:UHNBGMRecordJSONFormatJSONLines sessionConfiguration:[BGMStandInServer sessionConfiguration]];
+        uploader.delegate = recorder;
+        uploader.initialRetryInterval = 0.05;
+        uploader.maximumNumberOfConcurrentUploads = 1;
+        
+        waitUntil(^(DoneCallback done) {
+            recorder.eventHandler = ^(NSString *event) {
+                if (1 == recorder.numberOfRecordsUploaded)
+                {
+                    done();
+                }
+            };
+            
+            BGMSendRecords(uploader, NSMakeRange(1, 1));
+            [uploader flush];
+        });
+        
+        expect(recorder.numberOfRetries).to.equal(2);
+        
+        waitUntil(^(DoneCallback done) {
+            recorder.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"reject"])
+                {
+                    done();
+                }
+            };
+            
+            BGMSendRecords(uploader, NSMakeRange(2, 2));
+            [uploader flush];
+        });
+        
+        expect(recorder.numberOfRecordsRejected).to.equal(2);
+        expect([[NSFileManager defaultManager] contentsOfDirectoryAtPath:outboxPath error:nil]).to.haveCountOf(0);
+    });
+    
+    it(@"should keep the batch and pause uploads when the credentials are refused", ^{
+        [BGMStandInServer resetWithLatency:0 statusCodes:@[@401] defaultStatusCode:200];
+        
+        BGMUploadRecorder *recorder = [[BGMUploadRecorder alloc] init];
+        NSString *outboxPath = BGMOutboxPath();
+        UHNBGMRecordUploader *uploader = [[UHNBGMRecordUploader alloc] initWithUploadURL:BGMUploadURL() outboxPath:outboxPath format:UHNBGMRecordJSONFormatJSONLines sessionConfiguration:[BGMStandInServer sessionConfiguration]];
+        uploader.delegate = recorder;
+        uploader.authorization = @"Bearer expired";
+        
+        waitUntil(^(DoneCallback done) {
+            recorder.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"pause"])
+                {
+                    done();
+                }
+            };
+            
+            BGMSendRecords(uploader, NSMakeRange(1, 2));
+            [uploader flush];
+        });
+        
+        // a new batch waits behind the refused one
+        BGMSendRecords(uploader, NSMakeRange(3, 1));
+        [uploader flush];
+        
+        expect([uploader areUploadsPaused]).to.beTruthy();
+        expect([uploader numberOfPendingBatches]).to.equal(2);
+        expect(recorder.numberOfRecordsRejected).to.equal(0);
+        expect([[NSFileManager defaultManager] contentsOfDirectoryAtPath:outboxPath error:nil]).to.haveCountOf(2);
+        
+        waitUntil(^(DoneCallback done) {
+            recorder.eventHandler = ^(NSString *event) {
+                if (3 == recorder.numberOfRecordsUploaded)
+                {
+                    done();
+                }
+            };
+            
+            uploader.authorization = @"Bearer renewed";
+            [uploader resumeUploads];
+        });
+        
+        expect(recorder.numberOfPauses).to.equal(1);
+        expect([BGMStandInServer authorizations]).to.equal(@[@"Bearer expired", @"Bearer renewed", @"Bearer renewed"]);
+        expect(BGMNumberOfLines([BGMStandInServer batches])).to.equal(3);
+        expect([[NSFileManager defaultManager] contentsOfDirectoryAtPath:outboxPath error:nil]).to.haveCountOf(0);
+    });
+    
+    it(@"should keep a batch that could not be written to the outbox", ^{
+        [BGMStandInServer resetWithLatency:0 statusCodes:nil defaultStatusCode:200];
+        
+        BGMUploadRecorder *recorder = [[BGMUploadRecorder alloc] init];
+        NSString *outboxPath = BGMOutboxPath();
+        UHNBGMRecordUploader *uploader = [[UHNBGMRecordUploader alloc] initWithUploadURL:BGMUploadURL() outboxPath:outboxPath format:UHNBGMRecordJSONFormatJSONLines sessionConfiguration:[BGMStandInServer sessionConfiguration]];
+        uploader.delegate = recorder;
+        uploader.initialRetryInterval = 0.2;
+        
+        // a file in place of the outbox makes the write fail
+        [[NSFileManager defaultManager] removeItemAtPath:outboxPath error:nil];
+        [[NSData data] writeToFile:outboxPath atomically:NO];
+        
+        waitUntil(^(DoneCallback done) {
+            recorder.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"saveFailure"])
+                {
+                    done();
+                }
+            };
+            
+            BGMSendRecords(uploader, NSMakeRange(1, 2));
+            [uploader flush];
+        });
+        
+        expect(recorder.numberOfRecordsNotSaved).to.equal(2);
+        expect([uploader numberOfPendingBatches]).to.equal(1);
+        
+        waitUntil(^(DoneCallback done) {
+            recorder.eventHandler = ^(NSString *event) {
+                if (2 == recorder.numberOfRecordsUploaded)
+                {
+                    done();
+                }
+            };
+            
+            [[NSFileManager defaultManager] removeItemAtPath:outboxPath error:nil];
+        });
+        
+        expect(BGMNumberOfLines([BGMStandInServer batches])).to.equal(2);
+        expect([uploader numberOfPendingBatches]).to.equal(0);
+    });
+    
+    it(@"should upload the batches left in the outbox by an earlier uploader", ^{
+        [BGMStandInServer resetWithLatency:0 statusCodes:nil defaultStatusCode:503];
+        
+        BGMUploadRecorder *recorder = [[BGMUploadRecorder alloc] init];
+        NSString *outboxPath = BGMOutboxPath();
+        UHNBGMRecordUploader *uploader = [[UHNBGMRecordUploader alloc] initWithUploadURL:BGMUploadURL() outboxPath:outboxPath format:UHNBGMRecordJSONFormatJSONLines sessionConfiguration:[BGMStandInServer sessionConfiguration]];
+        uploader.delegate = recorder;
+        uploader.initialRetryInterval = 60;
+        
+        waitUntil(^(DoneCallback done) {
+            recorder.eventHandler = ^(NSString *event) {
+                done();
+            };
+            
+            BGMSendRecords(uploader, NSMakeRange(1, 3));
+            [uploader flush];
+        });
+        
+        // the app is terminated while the batch waits for its retry
+        uploader = nil;
+        expect([[NSFileManager defaultManager] contentsOfDirectoryAtPath:outboxPath error:nil]).to.haveCountOf(1);
+        
+        [BGMStandInServer setDefaultStatusCode:200];
+        BGMUploadRecorder *nextRecorder = [[BGMUploadRecorder alloc] init];
+        __block UHNBGMRecordUploader *nextUploader = nil;
+        
+        waitUntil(^(DoneCallback done) {
+            nextRecorder.eventHandler = ^(NSString *event) {
+                done();
+            };
+            
+            nextUploader = [[UHNBGMRecordUploader alloc] initWithUploadURL:BGMUploadURL() outboxPath:outboxPath format:UHNBGMRecordJSONFormatJSONLines sessionConfiguration:[BGMStandInServer sessionConfiguration]];
+            nextUploader.delegate = nextRecorder;
+        });
+        
+        expect(nextRecorder.numberOfRecordsUploaded).to.equal(3);
+        expect(BGMNumberOfLines([BGMStandInServer batches])).to.equal(3);
+    });
+    
+    it(@"should report backpressure while too many batches are waiting", ^{
+        [BGMStandInServer resetWithLatency:0.1 statusCodes:nil defaultStatusCode:200];
+        
+        BGMUploadRecorder *recorder = [[BGMUploadRecorder alloc] init];
+        UHNBGMRecordUploader *uploader = [[UHNBGMRecordUploader alloc] initWithUploadURL:BGMUploadURL() outboxPath:BGMOutboxPath() format:UHNBGMRecordJSONFormatJSONLines sessionConfiguration:[BGMStandInServer sessionConfiguration]];
+        uploader.delegate = recorder;
+        uploader.maximumNumberOfRecordsPerBatch = 1;
+        uploader.maximumNumberOfConcurrentUploads = 1;
+        uploader.maximumNumberOfQueuedBatches = 4;
+        
+        waitUntilTimeout(5, ^(DoneCallback done) {
+            recorder.eventHandler = ^(NSString *event) {
+                if (8 == recorder.numberOfRecordsUploaded)
+                {
+                    done();
+                }
+            };
+            
+            BGMSendRecords(uploader, NSMakeRange(1, 8));
+            [uploader flush];
+        });
+        
+        expect(recorder.backpressureChanges).to.equal(@[@YES, @NO]);
+        expect([uploader isBackpressured]).to.beFalsy();
+    });
+});
+
+SpecEnd
@@ -0,0 +1,67 @@
+//
+//  BGMSimulatedMeter.h
+//  UHNBGMControllerTests
+//
+//  Created by agent on 2026-10-19.
+//  Copyright © 2026 University Health Network. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <UHNBGMController/UHNBGMController.h>
+
+/**
+ Simulates a glucose meter behind the `UHNBLEController` used by a `UHNBGMController`. Written values are handled as
+ the meter would handle them and the responses are delivered asynchronously on the main queue. The meter is connected
+ once it is created.
+ */
+@interface BGMSimulatedMeter : NSObject
+
+@property (atomic, assign, getter=isPeripheralConnected) BOOL peripheralConnected;
+@property (nonatomic, assign) NSUInteger disconnectAfterNumberOfRecords;
+@property (nonatomic, strong) NSSet *lostSequenceNumbers;
+@property (nonatomic, strong, readonly) NSMutableArray *writtenCommands;
+@property (nonatomic, strong, readonly) NSMutableArray *readCharacteristicUUIDs;
+@property (nonatomic, assign) NSTimeInterval readLatency;
+@property (nonatomic, assign, readonly) NSUInteger maximumNumberOfOutstandingReads;
+@property (atomic, assign, readonly) NSUInteger numberOfCallsOffMainQueue;
+
+- (instancetype) initWithController:(UHNBGMController *) controller;
+
+- (void) addStoredRecordsWithSequenceNumbers:(NSRange) sequenceNumbers;
+- (void) addStoredRecordWithSequenceNumber:(uint16_t) sequenceNumber glucoseConcentration:(uint16_t) glucoseConcentration mealContext:(GlucoseMeasurementContextMeal) meal;
+- (NSArray *) storedSequenceNumbers;
+- (void) reconnect;
+- (void) takeMeasurementWithSequenceNumber:(uint16_t) sequenceNumber glucoseConcentration:(uint16_t) glucoseConcentration;
+- (void) discoverDeviceInformationServiceWithPeripheralIdentifier:(NSUUID *) peripheralIdentifier;
+
++ (NSData *) measurementWithSequenceNumber:(uint16_t) sequenceNumber glucoseConcentration:(uint16_t) glucoseConcentration hasContext:(BOOL) hasContext;
++ (NSData *) measurementContextWithSequenceNumber:(uint16_t) sequenceNumber meal:(GlucoseMeasurementContextMeal) meal;
+
+// UHNBLEController interface used by the UHNBGMController
+- (void) writeValue:(NSData *) value toCharacteristicUUID:(NSString *) characteristicUUID withServiceUUID:(NSString *) serviceUUID;
+- (void) readValueFromCharacteristicUUID:(NSString *) characteristicUUID withServiceUUID:(NSString *) serviceUUID;
+- (void) setNotificationState:(BOOL) enabled forCharacteristicUUID:(NSString *) characteristicUUID withServiceUUID:(NSString *) serviceUUID;
+- (void) cancelConnection;
+- (void) reconnectToPeripheralWithUUID:(NSUUID *) peripheralUUID;
+- (void) startConnection;
+
+@end
+
+/**
+ Records the notifications of a `UHNBGMController` so they can be checked by the specs
+ */
+@interface BGMRecordingDelegate : NSObject <UHNBGMControllerDelegate>
+
+@property (nonatomic, strong) NSMutableArray *measurements;
+@property (nonatomic, strong) NSMutableArray *measurementContexts;
+@property (nonatomic, strong) NSMutableArray *liveMeasurements;
+@property (nonatomic, strong) NSMutableArray *liveAlerts;
+@property (nonatomic, strong) NSMutableArray *chunkedTransferProgress;
+@property (nonatomic, strong) UHNBGMDeviceProfile *deviceProfile;
+@property (nonatomic, assign) BOOL didCompleteSync;
+@property (nonatomic, assign) BOOL didFailSync;
+@property (nonatomic, assign) BOOL didFailSyncWithRecordsCommitted;
+@property (nonatomic, assign) NSUInteger numberOfSyncedRecords;
+@property (nonatomic, copy) void (^eventHandler)(NSString *event);
+
+@end
@@ -0,0 +1,413 @@
+//
+//  BGMSimulatedMeter.m
+//  UHNBGMControllerTests
+//
+//  Created by agent on 2026-10-19.
+//  Copyright © 2026 University Health Network. All rights reserved.
+//
+
+#import "BGMSimulatedMeter.h"
+#import <UHNBLEController/UHNBLEController.h>
+
+// the BLE delegate methods of the controller are private, so expose them to drive the controller
+@interface UHNBGMController (SimulatedMeter) <UHNBLEControllerDelegate>
+@end
+
+@interface BGMSimulatedMeter ()
+@property (nonatomic, weak) UHNBGMController *controller;
+@property (nonatomic, strong) NSMutableDictionary *storedRecords;
+@property (nonatomic, strong, readwrite) NSMutableArray *writtenCommands;
+@property (nonatomic, assign) NSUInteger numberOfRecordsSent;
+@property (nonatomic, strong, readwrite) NSMutableArray *readCharacteristicUUIDs;
+@property (nonatomic, assign) NSUInteger numberOfOutstandingReads;
+@property (nonatomic, assign, readwrite) NSUInteger maximumNumberOfOutstandingReads;
+@property (atomic, assign, readwrite) NSUInteger numberOfCallsOffMainQueue;
+@property (nonatomic, strong) NSUUID *peripheralIdentifier;
+@end
+
+@implementation BGMSimulatedMeter
+
+- (instancetype) initWithController:(UHNBGMController *) controller;
+{
+    if ((self = [super init]))
+    {
+        self.controller = controller;
+        self.storedRecords = [NSMutableDictionary dictionary];
+        self.writtenCommands = [NSMutableArray array];
+        self.readCharacteristicUUIDs = [NSMutableArray array];
+        self.disconnectAfterNumberOfRecords = NSNotFound;
+        
+        // take the place of the BLE controller, already connected to the meter
+        [controller setValue:self forKey:@"bleController"];
+        [self reconnect];
+    }
+    
+    return self;
+}
+
+#pragma mark - Stored Records
+
+- (void) addStoredRecordsWithSequenceNumbers:(NSRange) sequenceNumbers;
+{
+    for (NSUInteger sequenceNumber = sequenceNumbers.location; sequenceNumber < NSMaxRange(sequenceNumbers); sequenceNumber++)
+    {
+        [self addStoredRecordWithSequenceNumber:sequenceNumber glucoseConcentration:(80 + sequenceNumber % 120) mealContext:GlucoseMeasurementContextMealReserved];
+    }
+}
+
+- (void) addStoredRecordWithSequenceNumber:(uint16_t) sequenceNumber glucoseConcentration:(uint16_t) glucoseConcentration mealContext:(GlucoseMeasurementContextMeal) meal;
+{
+    BOOL hasContext = (GlucoseMeasurementContextMealReserved != meal);
+    NSMutableArray *notifications = [NSMutableArray arrayWithObject:@[kGlucoseServiceCharacteristicUUIDMeasurement, [BGMSimulatedMeter measurementWithSequenceNumber:sequenceNumber glucoseConcentration:glucoseConcentration hasContext:hasContext]]];
+    
+    if (hasContext)
+    {
+        [notifications addObject:@[kGlucoseServiceCharacteristicUUIDMeasurementContext, [BGMSimulatedMeter measurementContextWithSequenceNumber:sequenceNumber meal:meal]]];
+    }
+    
+    self.storedRecords[@(sequenceNumber)] = notifications;
+}
+
+- (void) takeMeasurementWithSequenceNumber:(uint16_t) sequenceNumber glucoseConcentration:(uint16_t) glucoseConcentration;
+{
+    // a new measurement is stored and notified straight away
+    [self addStoredRecordWithSequenceNumber:sequenceNumber glucoseConcentration:glucoseConcentration mealContext:GlucoseMeasurementContextMealReserved];
+    [self notifyValue:[BGMSimulatedMeter measurementWithSequenceNumber:sequenceNumber glucoseConcentration:glucoseConcentration hasContext:NO] forCharacteristic:kGlucoseServiceCharacteristicUUIDMeasurement];
+}
+
+- (void) reconnect;
+{
+    self.peripheralConnected = YES;
+    [self.controller bleController:nil didConnectWithPeripheral:@"Simulated Meter" withServices:@[kGlucoseServiceUUID] andUUID:self.peripheralIdentifier];
+}
+
+- (void) discoverDeviceInformationServiceWithPeripheralIdentifier:(NSUUID *) peripheralIdentifier;
+{
+    self.peripheralIdentifier = peripheralIdentifier;
+    [self reconnect];
+    [self.controller bleController:nil didDiscoverCharacteristics:@[kDeviceInformationCharacteristicUUIDModelNumber, kDeviceInformationCharacteristicUUIDSerialNumber, kDeviceInformationCharacteristicUUIDFirmwareRevision, kDeviceInformationCharacteristicUUIDSystemID] forService:kDeviceInformationServiceUUID];
+}
+
+- (NSArray *) storedSequenceNumbers;
+{
+    return [[self.storedRecords allKeys] sortedArrayUsingSelector:@selector(compare:)];
+}
+
++ (NSData *) measurementWithSequenceNumber:(uint16_t) sequenceNumber glucoseConcentration:(uint16_t) glucoseConcentration hasContext:(BOOL) hasContext;
+{
+    uint8_t flag = 0x02 | (hasContext ? 0x10 : 0x00); // Glucose Concentration, Type and Sample Location Present, Kg/L
+    uint16_t year = 2016;
+    uint16_t minutes = 8 * 60 + sequenceNumber;
+    uint8_t day = 1 + (minutes / (24 * 60)) % 28;
+    uint8_t hour = (minutes / 60) % 24;
+    uint8_t minute = minutes % 60;
+    uint16_t concentration = 0xB000 | (glucoseConcentration & 0x0FFF); // mg/dL is exponent -5 in kg/L
+    uint8_t jointValue = 0x11; // capillary whole blood from the finger
+    
+    return [NSData dataWithBytes:(uint8_t[]){flag, sequenceNumber, (sequenceNumber >> 8), year, (year >> 8), 2, day, hour, minute, 0, concentration, (concentration >> 8), jointValue} length:13];
+}
+
++ (NSData *) measurementContextWithSequenceNumber:(uint16_t) sequenceNumber meal:(GlucoseMeasurementContextMeal) meal;
+{
+    uint8_t flag = 0x02; // meal present
+    
+    return [NSData dataWithBytes:(uint8_t[]){flag, sequenceNumber, (sequenceNumber >> 8), meal} length:4];
+}
+
+#pragma mark - BLE Controller Interface
+
+- (void) writeValue:(NSData *) value toCharacteristicUUID:(NSString *) characteristicUUID withServiceUUID:(NSString *) serviceUUID;
+{
+    [self checkMainQueue];
+    [self.writtenCommands addObject:value];
+    
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [self.controller bleController:nil didWriteValue:value toCharacteristic:characteristicUUID];
+    });
+    
+    if ([characteristicUUID isEqualToString:kGlucoseServiceCharacteristicUUIDRecordAccessControlPoint])
+    {
+        [self handleRACPCommand:value];
+    }
+}
+
+- (void) readValueFromCharacteristicUUID:(NSString *) characteristicUUID withServiceUUID:(NSString *) serviceUUID;
+{
+    [self checkMainQueue];
+    
+    NSData *value = nil;
+    
+    if ([characteristicUUID isEqualToString:kGlucoseServiceCharacteristicUUIDSupportedFeatures])
+    {
+        uint16_t features = GlucoseFeatureSupportedLowBattery | GlucoseFeatureSupportedFaultTime;
+        value = [NSData dataWithBytes:(uint8_t[]){features, (features >> 8)} length:2];
+    }
+    else if ([characteristicUUID isEqualToString:kDeviceInformationCharacteristicUUIDModelNumber])
+    {
+        value = [@"BGM-1" dataUsingEncoding:NSUTF8StringEncoding];
+    }
+    else if ([characteristicUUID isEqualToString:kDeviceInformationCharacteristicUUIDSerialNumber])
+    {
+        value = [NSData dataWithBytes:"SN0042\0\0" length:8];
+    }
+    else if ([characteristicUUID isEqualToString:kDeviceInformationCharacteristicUUIDFirmwareRevision])
+    {
+        value = [@"1.2.3" dataUsingEncoding:NSUTF8StringEncoding];
+    }
+    else if ([characteristicUUID isEqualToString:kDeviceInformationCharacteristicUUIDSystemID])
+    {
+        value = [NSData dataWithBytes:(uint8_t[]){1, 2, 3, 4, 5, 6, 7, 8} length:8];
+    }
+    
+    if (nil == value)
+    {
+        return;
+    }
+    
+    [self.readCharacteristicUUIDs addObject:characteristicUUID];
+    self.numberOfOutstandingReads += 1;
+    self.maximumNumberOfOutstandingReads = MAX(self.maximumNumberOfOutstandingReads, self.numberOfOutstandingReads);
+    
+    // each read takes one round trip
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t) (self.readLatency * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        self.numberOfOutstandingReads -= 1;
+        
+        if (self.isPeripheralConnected)
+        {
+            [self.controller bleController:nil didUpdateValue:value forCharacteristic:characteristicUUID];
+        }
+    });
+}
+
+- (void) setNotificationState:(BOOL) enabled forCharacteristicUUID:(NSString *) characteristicUUID withServiceUUID:(NSString *) serviceUUID;
+{
+    [self checkMainQueue];
+    
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [self.controller bleController:nil didUpdateNotificationState:enabled forCharacteristic:characteristicUUID];
+    });
+}
+
+- (void) cancelConnection;
+{
+    [self checkMainQueue];
+    [self disconnect];
+}
+
+- (void) reconnectToPeripheralWithUUID:(NSUUID *) peripheralUUID;
+{
+    // reconnecting is left to the specs, which call reconnect
+    [self checkMainQueue];
+}
+
+- (void) startConnection;
+{
+    [self checkMainQueue];
+}
+
+#pragma mark - Private Methods
+
+- (void) checkMainQueue;
+{
+    // like CoreBluetooth, the BLE controller must only be called on the main queue
+    if (![NSThread isMainThread])
+    {
+        self.numberOfCallsOffMainQueue += 1;
+    }
+}
+
+- (void) handleRACPCommand:(NSData *) command;
+{
+    const uint8_t *bytes = command.bytes;
+    uint8_t opCode = bytes[0];
+    NSArray *selectedSequenceNumbers = [self sequenceNumbersForCommand:command];
+    
+    switch (opCode)
+    {
+        case 0x01:
+        {
+            // report the stored records
+            for (NSNumber *sequenceNumber in selectedSequenceNumbers)
+            {
+                if (self.numberOfRecordsSent == self.disconnectAfterNumberOfRecords)
+                {
+                    [self disconnect];
+                    return;
+                }
+                
+                // a lost record stays stored, but its notifications never reach the controller
+                for (NSArray *notification in ([self.lostSequenceNumbers containsObject:sequenceNumber] ? nil : self.storedRecords[sequenceNumber]))
+                {
+                    [self notifyValue:notification[1] forCharacteristic:notification[0]];
+                }
+                
+                self.numberOfRecordsSent += 1;
+            }
+            
+            [self respondToOpCode:opCode withResponseCode:([selectedSequenceNumbers count] ? RACPSuccess : kGlucoseRACPResponseCodeNoRecordsFound)];
+            break;
+        }
+        case kGlucoseRACPOpCodeDeleteStoredRecords:
+        {
+            [self.storedRecords removeObjectsForKeys:selectedSequenceNumbers];
+            [self respondToOpCode:opCode withResponseCode:RACPSuccess];
+            break;
+        }
+        case 0x04:
+        {
+            uint16_t numberOfRecords = [selectedSequenceNumbers count];
+            [self notifyValue:[NSData dataWithBytes:(uint8_t[]){0x05, 0x00, numberOfRecords, (numberOfRecords >> 8)} length:4] forCharacteristic:kGlucoseServiceCharacteristicUUIDRecordAccessControlPoint];
+            break;
+        }
+        default:
+        {
+            // abort and unsupported operators are not simulated
+            [self respondToOpCode:opCode withResponseCode:0x02];
+            break;
+        }
+    }
+}
+
+- (NSArray *) sequenceNumbersForCommand:(NSData *) command;
+{
+    const uint8_t *bytes = command.bytes;
+    NSUInteger first = 0;
+    NSUInteger last = UINT16_MAX;
+    
+    if (GlucoseRACPOperatorGreaterThanOrEqualTo == bytes[1] || GlucoseRACPOperatorWithinRange == bytes[1])
+    {
+        first = bytes[3] | (bytes[4] << 8);
+    }
+    
+    if (GlucoseRACPOperatorLessThanOrEqualTo == bytes[1])
+    {
+        last = bytes[3] | (bytes[4] << 8);
+    }
+    else if (GlucoseRACPOperatorWithinRange == bytes[1])
+    {
+        last = bytes[5] | (bytes[6] << 8);
+    }
+    
+    NSIndexSet *indexes = [[self storedSequenceNumbers] indexesOfObjectsPassingTest:^BOOL(NSNumber *sequenceNumber, NSUInteger idx, BOOL *stop) {
+        return ([sequenceNumber unsignedIntegerValue] >= first && [sequenceNumber unsignedIntegerValue] <= last);
+    }];
+    
+    return [[self storedSequenceNumbers] objectsAtIndexes:indexes];
+}
+
+- (void) respondToOpCode:(uint8_t) opCode withResponseCode:(uint8_t) responseCode;
+{
+    [self notifyValue:[NSData dataWithBytes:(uint8_t[]){0x06, 0x00, opCode, responseCode} length:4] forCharacteristic:kGlucoseServiceCharacteristicUUIDRecordAccessControlPoint];
+}
+
+- (void) notifyValue:(NSData *) value forCharacteristic:(NSString *) characteristicUUID;
+{
+    dispatch_async(dispatch_get_main_queue(), ^{
+        if (self.isPeripheralConnected)
+        {
+            [self.controller bleController:nil didUpdateValue:value forCharacteristic:characteristicUUID];
+        }
+    });
+}
+
+- (void) disconnect;
+{
+    dispatch_async(dispatch_get_main_queue(), ^{
+        self.peripheralConnected = NO;
+        [self.controller bleController:nil didDisconnectFromPeripheral:@"Simulated Meter"];
+    });
+}
+
+@end
+
+@implementation BGMRecordingDelegate
+
+- (instancetype) init;
+{
+    if ((self = [super init]))
+    {
+        self.measurements = [NSMutableArray array];
+        self.measurementContexts = [NSMutableArray array];
+        self.liveMeasurements = [NSMutableArray array];
+        self.liveAlerts = [NSMutableArray array];
+        self.chunkedTransferProgress = [NSMutableArray array];
+    }
+    
+    return self;
+}
+
+- (void) notifyEvent:(NSString *) event;
+{
+    if (self.eventHandler)
+    {
+        self.eventHandler(event);
+    }
+}
+
+- (void) bgmController:(UHNBGMController *) controller didDiscoverGlucoseMeterWithName:(NSString *) bgmDeviceName services:(NSArray *) serviceUUIDs RSSI:(NSNumber *) RSSI;
+{
+}
+
+- (void) bgmController:(UHNBGMController *) controller didConnectToGlucoseMeterWithName:(NSString *) bgmDeviceName;
+{
+}
+
+- (void) bgmController:(UHNBGMController *) controller didDisconnectFromGlucoseMeter:(NSString *) bgmDeviceName;
+{
+    [self notifyEvent:@"disconnect"];
+}
+
+- (void) bgmController:(UHNBGMController *) controller didGetNumberOfRecords:(NSNumber *) numberOfRecords;
+{
+    [self notifyEvent:@"numberOfRecords"];
+}
+
+- (void) bgmController:(UHNBGMController *) controller didGetGlucoseMeasurementAtIndex:(NSUInteger) index withDetails:(NSDictionary *) measurementDetails;
+{
+    [self.measurements addObject:measurementDetails];
+}
+
+- (void) bgmController:(UHNBGMController *) controller didGetGlucoseMeasurementContextAtIndex:(NSUInteger) index withDetails:(NSDictionary *) measurementContextDetails;
+{
+    [self.measurementContexts addObject:measurementContextDetails];
+}
+
+- (void) bgmController:(UHNBGMController *) controller didCompleteTransferWithNumberOfRecords:(NSUInteger) numberOfRecords;
+{
+    [self notifyEvent:@"transferComplete"];
+}
+
+- (void) bgmController:(UHNBGMController *) controller didCompleteSyncOfRecordsFromSequenceNumber:(NSUInteger) firstSequenceNumber toSequenceNumber:(NSUInteger) lastSequenceNumber numberOfRecords:(NSUInteger) numberOfRecords;
+{
+    self.didCompleteSync = YES;
+    self.numberOfSyncedRecords = numberOfRecords;
+    [self notifyEvent:@"syncComplete"];
+}
+
+- (void) bgmController:(UHNBGMController *) controller didFailSyncWithRecordsCommitted:(BOOL) committed;
+{
+    self.didFailSync = YES;
+    self.didFailSyncWithRecordsCommitted = committed;
+    [self notifyEvent:@"syncFailed"];
+}
+
+- (void) bgmController:(UHNBGMController *) controller didGetLiveGlucoseMeasurement:(NSDictionary *) measurementDetails alert:(UHNBGMGlucoseAlert) alert;
+{
+    [self.liveMeasurements addObject:measurementDetails];
+    [self.liveAlerts addObject:@(alert)];
+    [self notifyEvent:@"liveMeasurement"];
+}
+
+- (void) bgmController:(UHNBGMController *) controller didTransferRecordsUpToSequenceNumber:(NSUInteger) sequenceNumber progress:(float) progress;
+{
+    [self.chunkedTransferProgress addObject:@(progress)];
+    [self notifyEvent:@"chunkComplete"];
+}
+
+- (void) bgmController:(UHNBGMController *) controller didGetDeviceProfile:(UHNBGMDeviceProfile *) deviceProfile;
+{
+    self.deviceProfile = deviceProfile;
+    [self notifyEvent:@"deviceProfile"];
+}
+
+@end
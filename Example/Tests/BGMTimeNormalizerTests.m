@@ -0,0 +1,218 @@
+//
+//  BGMTimeNormalizerTests.m
+//  UHNBGMControllerTests
+//
+//  Created by agent on 2026-10-19.
+//  Copyright © 2026 University Health Network. All rights reserved.
+//
+
+#import <UHNBGMController/UHNBGMTimeNormalizer.h>
+#import <UHNBGMController/UHNBGMConstants.h>
+
+// 2016-03-23 08:00:00 UTC
+#define kBGMNormalizerStartTime         1458720000
+#define kBGMNormalizerMeterUTCOffset    (-5 * 3600)
+
+// the base time of the glucose sensor, its local time taken as UTC
+static void BGMNormalizerDateTime(int64_t meterTimestamp, uint8_t *bytes)
+{
+    NSCalendar *calendar = [[NSCalendar alloc] initWithCalendarIdentifier:NSGregorianCalendar];
+    calendar.timeZone = [NSTimeZone timeZoneForSecondsFromGMT:0];
+    NSDateComponents *components = [calendar components:(NSYearCalendarUnit | NSMonthCalendarUnit | NSDayCalendarUnit | NSHourCalendarUnit | NSMinuteCalendarUnit | NSSecondCalendarUnit) fromDate:[NSDate dateWithTimeIntervalSince1970:meterTimestamp]];
+    
+    bytes[0] = components.year;
+    bytes[1] = components.year >> 8;
+    bytes[2] = components.month;
+    bytes[3] = components.day;
+    bytes[4] = components.hour;
+    bytes[5] = components.minute;
+    bytes[6] = components.second;
+}
+
+static NSData *BGMNormalizerMeasurementData(uint16_t sequenceNumber, int64_t meterTimestamp, uint16_t sensorStatusAnnunciation)
+{
+    // glucose concentration, type and sample location and status present, 100 mg/dL
+    uint8_t bytes[15] = {0x0A, sequenceNumber, (sequenceNumber >> 8), 0, 0, 0, 0, 0, 0, 0, 0x64, 0xB0, 0x11, sensorStatusAnnunciation, (sensorStatusAnnunciation >> 8)};
+    BGMNormalizerDateTime(meterTimestamp, bytes + 3);
+    
+    return [NSData dataWithBytes:bytes length:sizeof(bytes)];
+}
+
+SpecBegin(BGMTimeNormalizerSpecs)
+
+describe(@"Time normalizer", ^{
+    it(@"should correct a drifting meter with the clock references of the session", ^{
+        // the meter was set 10 minutes fast in UTC-5 and gains a second an hour, over ten days of readings
+        NSUInteger count = 1440;
+        int64_t localTimestamps[1440];
+        uint8_t measurementFlags[1440];
+        uint16_t sensorStatusAnnunciations[1440];
+        NSTimeInterval trueTimestamps[1440];
+        
+        for (NSUInteger index = 0; index < count; index++)
+        {
+            trueTimestamps[index] = kBGMNormalizerStartTime + index * 600;
+            localTimestamps[index] = (int64_t) llround(trueTimestamps[index] + kBGMNormalizerMeterUTCOffset + 600 + (trueTimestamps[index] - kBGMNormalizerStartTime) / 3600);
+            measurementFlags[index] = GlucoseMeasurementFlagPresentGlucoseConcentrationTypeAndSampleLocation;
+            sensorStatusAnnunciations[index] = 0;
+        }
+        
+        // the session starts after the last reading, and the references arrive 3 and 1 seconds late
+        NSTimeInterval sessionTime = trueTimestamps[count - 1] + 600;
+        int64_t meterTimestamp = (int64_t) llround(sessionTime + kBGMNormalizerMeterUTCOffset + 600 + (sessionTime - kBGMNormalizerStartTime) / 3600);
+        uint8_t dateTime[7];
+        BGMNormalizerDateTime(meterTimestamp, dateTime);
+        
+        UHNBGMTimeNormalizer *normalizer = [[UHNBGMTimeNormalizer alloc] init];
+        expect([normalizer addClockReferenceWithDateTimeData:[NSData dataWithBytes:dateTime length:7] receivedAtDate:[NSDate dateWithTimeIntervalSince1970:sessionTime + 3]]).to.beTruthy();
+        expect([normalizer addClockReferenceWithMeasurementData:BGMNormalizerMeasurementData(1441, meterTimestamp + 60, 0) receivedAtDate:[NSDate dateWithTimeIntervalSince1970:sessionTime + 61]]).to.beTruthy();
+        expect([normalizer addClockReferenceWithMeasurementData:BGMNormalizerMeasurementData(1442, meterTimestamp, GlucoseMeasurementStatusFaultTime) receivedAtDate:[NSDate dateWithTimeIntervalSince1970:sessionTime]]).to.beFalsy();
+        expect(normalizer.hasClockReference).to.beTruthy();
+        
+        NSTimeInterval timestamps[1440];
+        uint8_t timeFlags[1440];
+        [normalizer normalizeLocalTimestamps:localTimestamps measurementFlags:measurementFlags sensorStatusAnnunciations:sensorStatusAnnunciations valid:NULL count:count timestamps:timestamps timeFlags:timeFlags];
+        
+        // the offset is right at the time of the session, and the drift since a reading is left
+        expect(fabs(timestamps[count - 1] - trueTimestamps[count - 1])).to.beLessThanOrEqualTo(2);
+        for (NSUInteger index = 0; index < count; index++)
+        {
+            NSTimeInterval faceValueError = fabs(localTimestamps[index] - kBGMNormalizerMeterUTCOffset - trueTimestamps[index]);
+            NSTimeInterval error = fabs(timestamps[index] - trueTimestamps[index]);
+            
+            expect(error).to.beLessThanOrEqualTo(245);
+            expect(error).to.beLessThan(faceValueError);
+            expect(timeFlags[index]).to.equal(UHNBGMTimeNormalizationFlagClockCorrected);
+            if (index > 0)
+            {
+                expect(timestamps[index]).to.beGreaterThan(timestamps[index - 1]);
+            }
+        }
+    });
+    
+    it(@"should take the clock at face value without a reference", ^{
+        UHNBGMTimeNormalizer *normalizer = [[UHNBGMTimeNormalizer alloc] init];
+        normalizer.meterTimeZone = [NSTimeZone timeZoneForSecondsFromGMT:kBGMNormalizerMeterUTCOffset];
+        
+        int64_t localTimestamps[3] = {kBGMNormalizerStartTime + kBGMNormalizerMeterUTCOffset, kBGMNormalizerStartTime + kBGMNormalizerMeterUTCOffset + 60, kBGMNormalizerStartTime + kBGMNormalizerMeterUTCOffset + 120};
+        uint8_t measurementFlags[3] = {0};
+        uint16_t sensorStatusAnnunciations[3] = {0};
+        NSTimeInterval timestamps[3];
+        uint8_t timeFlags[3];
+        [normalizer normalizeLocalTimestamps:localTimestamps measurementFlags:measurementFlags sensorStatusAnnunciations:sensorStatusAnnunciations valid:NULL count:3 timestamps:timestamps timeFlags:timeFlags];
+        
+        expect(normalizer.hasClockReference).to.beFalsy();
+        expect(timestamps[0]).to.equal(kBGMNormalizerStartTime);
+        expect(timestamps[2]).to.equal(kBGMNormalizerStartTime + 120);
+        expect(timeFlags[2]).to.equal(0);
+        
+        // a meter two hours ahead would have taken its latest reading in the future
+        NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
+        for (NSUInteger index = 0; index < 3; index++)
+        {
+            localTimestamps[index] = (int64_t) now + kBGMNormalizerMeterUTCOffset + 7200 - 600 + index * 60;
+        }
+        
+        [normalizer beginSession];
+        [normalizer normalizeLocalTimestamps:localTimestamps measurementFlags:measurementFlags sensorStatusAnnunciations:sensorStatusAnnunciations valid:NULL count:3 timestamps:timestamps timeFlags:timeFlags];
+        expect(timestamps[2]).to.beLessThanOrEqualTo([[NSDate date] timeIntervalSince1970]);
+        expect(timestamps[2]).to.beGreaterThan(now - 5);
+        expect(timestamps[2] - timestamps[0]).to.equal(120);
+    });
+    
+    it(@"should convert each time with the offset of the meter time zone at that time", ^{
+        UHNBGMTimeNormalizer *normalizer = [[UHNBGMTimeNormalizer alloc] init];
+        normalizer.meterTimeZone = [NSTimeZone timeZoneWithName:@"America/Toronto"];
+        
+        // 2016-07-01 12:00 and 2016-12-01 12:00 on the clock of the glucose sensor
+        int64_t localTimestamps[2] = {1467374400, 1480593600};
+        uint8_t measurementFlags[2] = {0};
+        uint16_t sensorStatusAnnunciations[2] = {0};
+        NSTimeInterval timestamps[2];
+        uint8_t timeFlags[2];
+        [normalizer normalizeLocalTimestamps:localTimestamps measurementFlags:measurementFlags sensorStatusAnnunciations:sensorStatusAnnunciations valid:NULL count:2 timestamps:timestamps timeFlags:timeFlags];
+        
+        // 16:00 UTC in daylight saving time, 17:00 UTC in standard time
+        expect(timestamps[0]).to.equal(1467374400 + 4 * 3600);
+        expect(timestamps[1]).to.equal(1480593600 + 5 * 3600);
+        expect(timeFlags[1]).to.equal(0);
+    });
+    
+    it(@"should flag time faults and keep timestamps in order", ^{
+        UHNBGMTimeNormalizer *normalizer = [[UHNBGMTimeNormalizer alloc] init];
+        [normalizer addClockReferenceWithMeterTimestamp:kBGMNormalizerStartTime receivedAtDate:[NSDate dateWithTimeIntervalSince1970:kBGMNormalizerStartTime]];
+        
+        // a time fault, two readings, a time fault, a reading after the clock was set back, a reading that was not decoded, a reading
+        int64_t localTimestamps[7] = {kBGMNormalizerStartTime - 3600, kBGMNormalizerStartTime, kBGMNormalizerStartTime + 60, kBGMNormalizerStartTime + 90, kBGMNormalizerStartTime + 30, 0, kBGMNormalizerStartTime + 120};
+        uint8_t measurementFlags[7] = {GlucoseMeasurementFlagPresentSensorStatusAnnunciation, 0, 0, GlucoseMeasurementFlagPresentSensorStatusAnnunciation, 0, 0, 0};
+        uint16_t sensorStatusAnnunciations[7] = {GlucoseMeasurementStatusFaultTime, 0, 0, GlucoseMeasurementStatusFaultTime, 0, 0, 0};
+        uint8_t valid[7] = {1, 1, 1, 1, 1, 0, 1};
+        NSTimeInterval timestamps[7];
+        uint8_t timeFlags[7];
+        [normalizer normalizeLocalTimestamps:localTimestamps measurementFlags:measurementFlags sensorStatusAnnunciations:sensorStatusAnnunciations valid:valid count:7 timestamps:timestamps timeFlags:timeFlags];
+        
+        NSTimeInterval expectedOffsets[7] = {0, 0, 60, 60, 60, 60, 120};
+        uint8_t expectedFlags[7] = {UHNBGMTimeNormalizationFlagTimeFault, 0, 0, UHNBGMTimeNormalizationFlagTimeFault, UHNBGMTimeNormalizationFlagReordered, UHNBGMTimeNormalizationFlagTimeFault, 0};
+        for (NSUInteger index = 0; index < 7; index++)
+        {
+            expect(timestamps[index]).to.equal(kBGMNormalizerStartTime + expectedOffsets[index]);
+            expect(timeFlags[index]).to.equal(UHNBGMTimeNormalizationFlagClockCorrected | expectedFlags[index]);
+        }
+        
+        // the next batch of the session carries on from the last timestamp
+        [normalizer normalizeLocalTimestamps:localTimestamps + 4 measurementFlags:measurementFlags + 4 sensorStatusAnnunciations:sensorStatusAnnunciations + 4 valid:valid + 4 count:1 timestamps:timestamps timeFlags:timeFlags];
+        expect(timestamps[0]).to.equal(kBGMNormalizerStartTime + 120);
+        expect(timeFlags[0] & UHNBGMTimeNormalizationFlagReordered).to.beTruthy();
+        
+        // a new session starts over, and a time fault with no usable time before it keeps its own time
+        [normalizer beginSession];
+        normalizer.meterTimeZone = [NSTimeZone timeZoneForSecondsFromGMT:kBGMNormalizerMeterUTCOffset];
+        expect(normalizer.hasClockReference).to.beFalsy();
+        [normalizer normalizeLocalTimestamps:localTimestamps + 3 measurementFlags:measurementFlags + 3 sensorStatusAnnunciations:sensorStatusAnnunciations + 3 valid:valid + 3 count:1 timestamps:timestamps timeFlags:timeFlags];
+        expect(timestamps[0]).to.equal(kBGMNormalizerStartTime + 90 - kBGMNormalizerMeterUTCOffset);
+        expect(timeFlags[0]).to.equal(UHNBGMTimeNormalizationFlagTimeFault);
+    });
+    
+    it(@"should normalize a decoded batch of a session", ^{
+        NSMutableArray *payloads = [NSMutableArray array];
+        for (uint16_t sequenceNumber = 0; sequenceNumber < 2000; sequenceNumber++)
+        {
+            uint16_t sensorStatusAnnunciation = (0 == sequenceNumber % 100 ? GlucoseMeasurementStatusFaultTime : 0);
+            [payloads addObject:BGMNormalizerMeasurementData(sequenceNumber, kBGMNormalizerStartTime + kBGMNormalizerMeterUTCOffset + sequenceNumber * 300, sensorStatusAnnunciation)];
+        }
+        
+        UHNBGMMeasurementColumns *columns = [[[UHNBGMBulkDecoder alloc] init] decodeMeasurementPayloads:payloads];
+        UHNBGMTimeNormalizer *normalizer = [[UHNBGMTimeNormalizer alloc] init];
+        normalizer.meterTimeZone = [NSTimeZone timeZoneForSecondsFromGMT:kBGMNormalizerMeterUTCOffset];
+        UHNBGMNormalizedTimeColumns *normalizedColumns = [normalizer normalizeMeasurementColumns:columns];
+        
+        expect(normalizedColumns.count).to.equal(2000);
+        const NSTimeInterval *timestamps = [normalizedColumns.timestamps bytes];
+        const uint8_t *timeFlags = [normalizedColumns.flags bytes];
+        NSUInteger numberOfTimeFaults = 0;
+        
+        for (NSUInteger index = 0; index < 2000; index++)
+        {
+            if (timeFlags[index] & UHNBGMTimeNormalizationFlagTimeFault)
+            {
+                numberOfTimeFaults++;
+            }
+            else
+            {
+                expect(timestamps[index]).to.equal(kBGMNormalizerStartTime + index * 300);
+            }
+            
+            if (index > 0)
+            {
+                expect(timestamps[index]).to.beGreaterThanOrEqualTo(timestamps[index - 1]);
+            }
+        }
+        
+        expect(numberOfTimeFaults).to.equal(20);
+        
+        // the first reading has a time fault, and takes the time of the next one
+        expect(timestamps[0]).to.equal(kBGMNormalizerStartTime + 300);
+    });
+});
+
+SpecEnd
@@ -0,0 +1,87 @@
+//
+//  BGMTrafficCaptureTests.m
+//  UHNBGMControllerTests
+//
+//  Created by agent on 2026-10-19.
+//  Copyright © 2026 University Health Network. All rights reserved.
+//
+
+#import <UHNBGMController/UHNBGMController.h>
+#import <UHNBGMController/UHNBGMTrafficCapture.h>
+#import "BGMSimulatedMeter.h"
+
+SpecBegin(BGMTrafficCaptureSpecs)
+
+describe(@"Traffic capture and replay", ^{
+    __block NSString *capturePath;
+    __block BGMRecordingDelegate *delegate;
+    __block UHNBGMController *controller;
+    __block BGMSimulatedMeter *meter;
+    
+    beforeEach(^{
+        capturePath = [NSTemporaryDirectory() stringByAppendingPathComponent:@"BGMTrafficCaptureSpecs.bgmc"];
+        delegate = [[BGMRecordingDelegate alloc] init];
+        controller = [[UHNBGMController alloc] initWithDelegate:delegate];
+        meter = [[BGMSimulatedMeter alloc] initWithController:controller];
+        [meter addStoredRecordsWithSequenceNumbers:NSMakeRange(1, 50)];
+        [meter addStoredRecordWithSequenceNumber:51 glucoseConcentration:110 mealContext:GlucoseMeasurementContextMealPostprandial];
+        
+        expect([controller startCapturingTrafficToFileAtPath:capturePath]).to.beTruthy();
+        
+        waitUntil(^(DoneCallback done) {
+            delegate.eventHandler = ^(NSString *event) {
+                if ([event isEqualToString:@"transferComplete"])
+                {
+                    done();
+                }
+            };
+            
+            [controller getAllStoredRecords];
+        });
+        
+        [controller stopCapturingTraffic];
+    });
+    
+    afterEach(^{
+        [[NSFileManager defaultManager] removeItemAtPath:capturePath error:nil];
+    });
+    
+    it(@"should capture every received value", ^{
+        UHNBGMTrafficReplayer *replayer = [[UHNBGMTrafficReplayer alloc] initWithContentsOfFile:capturePath];
+        
+        // 51 measurements, 1 context and the RACP response
+        expect(replayer).notTo.beNil();
+        expect(replayer.numberOfEntries).to.equal(53);
+    });
+    
+    it(@"should reproduce the transfer when replayed as fast as possible", ^{
+        BGMRecordingDelegate *replayDelegate = [[BGMRecordingDelegate alloc] init];
+        UHNBGMController *replayController = [[UHNBGMController alloc] initWithDelegate:replayDelegate];
+        UHNBGMTrafficReplayer *replayer = [[UHNBGMTrafficReplayer alloc] initWithContentsOfFile:capturePath];
+        
+        waitUntil(^(DoneCallback done) {
+            [replayer replayThroughController:replayController atRecordedTiming:NO completion:^(NSTimeInterval elapsedTime) {
+                done();
+            }];
+        });
+        
+        expect(replayDelegate.measurements).to.equal(delegate.measurements);
+        expect(replayDelegate.measurementContexts).to.equal(delegate.measurementContexts);
+    });
+    
+    it(@"should reproduce the transfer when replayed at the recorded timing", ^{
+        BGMRecordingDelegate *replayDelegate = [[BGMRecordingDelegate alloc] init];
+        UHNBGMController *replayController = [[UHNBGMController alloc] initWithDelegate:replayDelegate];
+        UHNBGMTrafficReplayer *replayer = [[UHNBGMTrafficReplayer alloc] initWithContentsOfFile:capturePath];
+        
+        waitUntil(^(DoneCallback done) {
+            [replayer replayThroughController:replayController atRecordedTiming:YES completion:^(NSTimeInterval elapsedTime) {
+                done();
+            }];
+        });
+        
+        expect(replayDelegate.measurements).to.equal(delegate.measurements);
+    });
+});
+
+SpecEnd
@@ -8,11 +8,12 @@
 
 #import "ViewController.h"
 #import "UHNBGMController.h"
+#import "UHNBGMReadingFormatter.h"
 #import "UHNDebug.h"
 
 @interface ViewController ()<UHNBGMControllerDelegate, UITableViewDataSource>
 @property (nonatomic, strong) UHNBGMController *bgmController;
-@property (nonatomic, strong) NSDateFormatter *dateFormatter;
+@property (nonatomic, strong) UHNBGMReadingFormatter *readingFormatter;
 @property (nonatomic, strong) IBOutlet UIButton *startSessionButton;
 @property (nonatomic, strong) IBOutlet UIButton *connectButton;
 @property (nonatomic, strong) IBOutlet UILabel *deviceNameLabel;
@@ -30,9 +31,7 @@
     [super viewDidLoad];
     
     self.bgmController = [[UHNBGMController alloc] initWithDelegate: self];
-    self.dateFormatter = [[NSDateFormatter alloc] init];
-    self.dateFormatter.dateStyle = NSDateFormatterShortStyle;
-    self.dateFormatter.timeStyle = NSDateFormatterShortStyle;
+    self.readingFormatter = [[UHNBGMReadingFormatter alloc] init];
     self.bgReadings = [NSMutableArray array];
     self.currentBgReadingIndex = 0;
 }
@@ -75,71 +74,11 @@
     if (indexPath.row < [self.bgReadings count])
     {
         NSDictionary *bgReadingDetails = [self.bgReadings objectAtIndex:[self.bgReadings count] - (indexPath.row + 1)];
-        NSNumber *value = (NSNumber *) bgReadingDetails[kGlucoseMeasurementKeyGlucoseConcentration];
-        NSNumber *unitsNumber = (NSNumber *) bgReadingDetails[kGlucoseMeasurementKeyGlucoseConcentrationUnits];
         
-        GlucoseMeasurementGlucoseConcentrationUnits units = (GlucoseMeasurementGlucoseConcentrationUnits)[unitsNumber integerValue];
-        
-        // convert the value into standard units
-        if (GlucoseMeasurementGlucoseConcentrationUnitsMmolPerL != units)
-        {
-            value = [value convertGlucoseConcentrationFromUnits:units toUnits:GlucoseMeasurementGlucoseConcentrationUnitsMmolPerL];
-        }
-        
-        NSDate *creationDate = (NSDate *) bgReadingDetails[kGlucoseMeasurementKeyCreationDate];
-        NSNumber *context = (NSNumber *) bgReadingDetails[kGlucoseMeasurementContextKeyCarbohydrateID];
-        NSNumber *prePost = (NSNumber *) bgReadingDetails[kGlucoseMeasurementContextKeyMeal];
-        NSString *contextString = @"";
-        NSString *prePostString = @"";
-        
-        if (nil != prePost)
-        {
-            // set the pre/post string
-            if (GlucoseMeasurementContextMealPreprandial == [prePost unsignedIntegerValue])
-            {
-                prePostString = NSLocalizedString(@"Pre ", nil);
-            }
-            else if (GlucoseMeasurementContextMealPostprandial == [prePost unsignedIntegerValue])
-            {
-                prePostString = NSLocalizedString(@"Post ", nil);
-            }
-        }
-        
-        if (nil != context)
-        {
-            // set the context string
-            if (GlucoseMeasurementContextCarbohydrateIDBreakfast == [context unsignedIntegerValue])
-            {
-                contextString = NSLocalizedString(@"Breakfast ", nil);
-            }
-            else if (GlucoseMeasurementContextCarbohydrateIDLunch == [context unsignedIntegerValue])
-            {
-                contextString = NSLocalizedString(@"Lunch ", nil);
-            }
-            else if (GlucoseMeasurementContextCarbohydrateIDDinner == [context unsignedIntegerValue])
-            {
-                contextString = NSLocalizedString(@"Dinner ", nil);
-            }
-            else if (GlucoseMeasurementContextCarbohydrateIDSnack == [context unsignedIntegerValue])
-            {
-                contextString = NSLocalizedString(@"Snack ", nil);
-            }
-            else if (GlucoseMeasurementContextCarbohydrateIDDrink == [context unsignedIntegerValue])
-            {
-                contextString = NSLocalizedString(@"Drink ", nil);
-            }
-            else if (GlucoseMeasurementContextCarbohydrateIDSupper == [context unsignedIntegerValue])
-            {
-                contextString = NSLocalizedString(@"Supper ", nil);
-            }
-            else if (GlucoseMeasurementContextCarbohydrateIDBrunch == [context unsignedIntegerValue])
-            {
-                contextString = NSLocalizedString(@"Brunch ", nil);
-            }
-        }
-        
-        NSString *dateString = [self.dateFormatter stringFromDate:creationDate];
-        cell.textLabel.text = [NSString stringWithFormat:@"%ld: %@%@Reading %.2f mmol/L taken at %@", [self.bgReadings count] - indexPath.row, prePostString, contextString, [value doubleValue], dateString];
+        // the formatter renders the reading straight into a buffer, caching the date of each day
+        unichar characters[kReadingFormatterMaximumLength];
+        NSUInteger length = [self.readingFormatter getCharacters:characters maxLength:kReadingFormatterMaximumLength forMeasurementDetails:bgReadingDetails];
+        cell.textLabel.text = [NSString stringWithCharacters:characters length:length];
         cell.textLabel.font = [UIFont fontWithName:@"Helvetica" size:8];
         
         self.numberOfBGReadingsLabel.text = [NSString stringWithFormat:@"%ld", (long)[self.bgReadings count]];
@@ -57,4 +57,14 @@
  */
 - (NSDictionary *) parseGlucoseMeasurementContextCharacteristicDetails:(BOOL) crcPresent;
 
+/**
+ Returns a dictionary with the same keys and values as `parseGlucoseMeasurementContextCharacteristicDetails:`, that only decodes the value of a key the first time it is read
+ 
+ @param crcPresent Indicates whether the characteristic includes the E2E-CRC field
+ 
+ @return  All the data of the glucose measurement context characteristic as a `NSDictionary` that is decoded on demand
+ 
+ */
+- (NSDictionary *) lazilyParseGlucoseMeasurementContextCharacteristicDetails:(BOOL) crcPresent;
+
 @end
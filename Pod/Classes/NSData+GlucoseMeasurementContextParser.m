@@ -7,23 +7,10 @@
 
 #import "NSData+GlucoseMeasurementContextParser.h"
 #import "NSData+ConversionExtensions.h"
+#import "UHNBGMGlucoseFieldLayout.h"
+#import "UHNBGMLazyRecordDictionary.h"
 #import "UHNDebug.h"
 
-// Glucose Measurement Context Flag Bits
-typedef NS_ENUM (NSUInteger, GlucoseMeasurementContextField)
-{
-    GlucoseMeasurementContextFieldCarbohydrateID           = 1,
-    GlucoseMeasurementContextFieldCarbohydrate,
-    GlucoseMeasurementContextFieldMeal,
-    GlucoseMeasurementContextFieldTesterHealth,
-    GlucoseMeasurementContextFieldExerciseDuration,
-    GlucoseMeasurementContextFieldExerciseIntensity,
-    GlucoseMeasurementContextFieldMedicationID,
-    GlucoseMeasurementContextFieldMedicationValue,
-    GlucoseMeasurementContextFieldHbA1c,
-    GlucoseMeasurementContextFieldExtendedFlags,
-};
-
 @implementation NSData (GlucoseMeasurementContextParser)
 
 - (NSDictionary *) parseGlucoseMeasurementContextCharacteristicDetails:(BOOL) crcPresent;
@@ -113,6 +100,11 @@ typedef NS_ENUM (NSUInteger, GlucoseMeasurementContextField)
     return measurementContextDetails;
 }
 
+- (NSDictionary *) lazilyParseGlucoseMeasurementContextCharacteristicDetails:(BOOL) crcPresent;
+{
+    return [[UHNBGMLazyMeasurementContextDictionary alloc] initWithGlucoseMeasurementContextData:self crcPresent:crcPresent];
+}
+
 #pragma mark Glucose Measurement Context Parsing Methods
 
 - (NSUInteger) parseGlucoseMeasurementContextFlags;
@@ -188,7 +180,7 @@ typedef NS_ENUM (NSUInteger, GlucoseMeasurementContextField)
 - (NSNumber *) parseGlucoseMeasurementContextTester;
 {
     NSNumber *valueNumber = nil;
-    NSRange dataRange = [self glucoseMeasurementContextFieldDataRange:GlucoseMeasurementContextFieldTesterHealth];
+    NSRange dataRange = [self glucoseMeasurementContextFieldDataRange:GlucoseMeasurementContextFieldTester];
     
     // check if tester is present
     if (dataRange.location != NSNotFound)
@@ -203,7 +195,7 @@ typedef NS_ENUM (NSUInteger, GlucoseMeasurementContextField)
 - (NSNumber *) parseGlucoseMeasurementContextHealth;
 {
     NSNumber *valueNumber = nil;
-    NSRange dataRange = [self glucoseMeasurementContextFieldDataRange:GlucoseMeasurementContextFieldTesterHealth];
+    NSRange dataRange = [self glucoseMeasurementContextFieldDataRange:GlucoseMeasurementContextFieldHealth];
     
     // check if health is present
     if (dataRange.location != NSNotFound)
@@ -318,221 +310,26 @@ typedef NS_ENUM (NSUInteger, GlucoseMeasurementContextField)
 {
     // this method parses data based on the spec found here:
     // https://developer.bluetooth.org/gatt/characteristics/Pages/CharacteristicViewer.aspx?u=org.bluetooth.characteristic.glucose_measurement_context.xml
+    // the offset of each field for every combination of flags is compiled once from the schema in UHNBGMFieldSchema.c
     
-    NSUInteger measurementContextFlags = [self parseGlucoseMeasurementContextFlags];
-    NSUInteger startPosition = 3;
-    NSUInteger sizeOfField = 0;
+    const UHNBGMFieldLayout *layout = UHNBGMMeasurementContextFieldLayout();
     NSRange defaultRange = NSMakeRange(NSNotFound, 0);
-    GlucoseMeasurementContextFlagOption flagForField = [self glucoseMeasurementContextFlagForField:field];
-    GlucoseMeasurementContextField currentField;
-
-    // only return a valid range if the flag for the field we want exists in the glucose measurement context
-    if (flagForField & measurementContextFlags)
-    {
-        // now iterate through all the fields of the data until we get to the one we are looking for
-        
-        // extended flags (8 bit)
-        currentField = GlucoseMeasurementContextFieldExtendedFlags;
-        
-        if (([self glucoseMeasurementContextFlagForField:currentField]) & measurementContextFlags)
-        {
-            sizeOfField = 1;
-            
-            if (field == currentField)
-            {
-                return NSMakeRange(startPosition, sizeOfField);
-            }
-            
-            startPosition += sizeOfField;
-        }
     
-        // carbohydrateID (uint8)
-        currentField = GlucoseMeasurementContextFieldCarbohydrateID;
-        
-        if (([self glucoseMeasurementContextFlagForField:currentField]) & measurementContextFlags)
-        {
-            sizeOfField = 1;
-            
-            if (field == currentField)
-            {
-                return NSMakeRange(startPosition, sizeOfField);
-            }
-            
-            startPosition += sizeOfField;
-        }
-        
-        // carbohydrate (SFLOAT)
-        currentField = GlucoseMeasurementContextFieldCarbohydrate;
-        
-        if (([self glucoseMeasurementContextFlagForField:currentField]) & measurementContextFlags)
-        {
-            sizeOfField = 2;
-            
-            if (field == currentField)
-            {
-                return NSMakeRange(startPosition, sizeOfField);
-            }
-            
-            startPosition += sizeOfField;
-        }
-        
-        // meal (uint8)
-        currentField = GlucoseMeasurementContextFieldMeal;
-        
-        if (([self glucoseMeasurementContextFlagForField:currentField]) & measurementContextFlags)
-        {
-            sizeOfField = 1;
-            
-            if (field == currentField)
-            {
-                return NSMakeRange(startPosition, sizeOfField);
-            }
-            
-            startPosition += sizeOfField;
-        }
-        
-        // tester / health (tester is first nibble and health is second nibble of 8 bit field)
-        currentField = GlucoseMeasurementContextFieldTesterHealth;
-        
-        if (([self glucoseMeasurementContextFlagForField:currentField]) & measurementContextFlags)
-        {
-            sizeOfField = 1;
-            
-            if (field == currentField)
-            {
-                return NSMakeRange(startPosition, sizeOfField);
-            }
-            
-            startPosition += sizeOfField;
-        }
-        
-        // exercise duration (uint16)
-        currentField = GlucoseMeasurementContextFieldExerciseDuration;
-        
-        if (([self glucoseMeasurementContextFlagForField:currentField]) & measurementContextFlags)
-        {
-            sizeOfField = 2;
-            
-            if (field == currentField)
-            {
-                return NSMakeRange(startPosition, sizeOfField);
-            }
-            
-            startPosition += sizeOfField;
-        }
-        
-        // exercise intensity (uint8)
-        currentField = GlucoseMeasurementContextFieldExerciseIntensity;
-        
-        if (([self glucoseMeasurementContextFlagForField:currentField]) & measurementContextFlags)
-        {
-            sizeOfField = 1;
-            
-            if (field == currentField)
-            {
-                return NSMakeRange(startPosition, sizeOfField);
-            }
-            
-            startPosition += sizeOfField;
-        }
-        
-        // medication ID (uint8)
-        currentField = GlucoseMeasurementContextFieldMedicationID;
-        
-        if (([self glucoseMeasurementContextFlagForField:currentField]) & measurementContextFlags)
-        {
-            sizeOfField = 1;
-            
-            if (field == currentField)
-            {
-                return NSMakeRange(startPosition, sizeOfField);
-            }
-            
-            startPosition += sizeOfField;
-        }
-        
-        // medication (SFLOAT)
-        currentField = GlucoseMeasurementContextFieldMedicationValue;
-        
-        if (([self glucoseMeasurementContextFlagForField:currentField]) & measurementContextFlags)
-        {
-            sizeOfField = 2;
-            
-            if (field == currentField)
-            {
-                return NSMakeRange(startPosition, sizeOfField);
-            }
-            
-            startPosition += sizeOfField;
-        }
-        
-        // HbA1c (SFLOAT)
-        currentField = GlucoseMeasurementContextFieldHbA1c;
-        
-        if (([self glucoseMeasurementContextFlagForField:currentField]) & measurementContextFlags)
-        {
-            sizeOfField = 2;
-            
-            if (field == currentField)
-            {
-                return NSMakeRange(startPosition, sizeOfField);
-            }
-            
-            startPosition += sizeOfField;
-        }
+    if ([self length] < layout->fixedLength)
+    {
+        return defaultRange;
     }
     
-    return defaultRange;
-}
-
-// map the glucose context field type to a flag for it in the flags portion of the glucose measurement context data
-- (GlucoseMeasurementContextFlagOption) glucoseMeasurementContextFlagForField:(GlucoseMeasurementContextField) field;
-{
-    GlucoseMeasurementContextFlagOption option;
+    uint8_t offset = UHNBGMFieldOffset(layout, ((const uint8_t *) [self bytes])[0], field);
+    NSUInteger sizeOfField = UHNBGMFieldTypeSize(layout->fieldTypes[field]);
     
-    switch (field)
+    // only return a valid range if the field exists in the glucose measurement context
+    if (kUHNBGMFieldAbsent == offset || offset + sizeOfField > [self length])
     {
-        case GlucoseMeasurementContextFieldCarbohydrateID:
-        case GlucoseMeasurementContextFieldCarbohydrate:
-        {
-            option = GlucoseMeasurementContextFlagPresentCarbohydrateIDAndCarbohydrate;
-            break;
-        }
-        case GlucoseMeasurementContextFieldMeal:
-        {
-            option = GlucoseMeasurementContextFlagPresentMeal;
-            break;
-        }
-        case GlucoseMeasurementContextFieldTesterHealth:
-        {
-            option = GlucoseMeasurementContextFlagPresentTesterHealth;
-            break;
-        }
-        case GlucoseMeasurementContextFieldExerciseDuration:
-        case GlucoseMeasurementContextFieldExerciseIntensity:
-        {
-            option = GlucoseMeasurementContextFlagPresentExerciseDurationAndExerciseIntensity;
-            break;
-        }
-        case GlucoseMeasurementContextFieldMedicationID:
-        case GlucoseMeasurementContextFieldMedicationValue:
-        {
-            option = GlucoseMeasurementContextFlagPresentMedicationIDAndMedication;
-            break;
-        }
-        case GlucoseMeasurementContextFieldHbA1c:
-        {
-            option = GlucoseMeasurementContextFlagPresentHbA1c;
-            break;
-        }
-        case GlucoseMeasurementContextFieldExtendedFlags:
-        {
-            option = GlucoseMeasurementContextFlagPresentExtendedFlags;
-            break;
-        }
+        return defaultRange;
     }
     
-    return option;
+    return NSMakeRange(offset, sizeOfField);
 }
 
 @end
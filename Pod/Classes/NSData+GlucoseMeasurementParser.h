@@ -53,4 +53,14 @@
  */
 - (NSDictionary *) parseGlucoseMeasurementCharacteristicDetails:(BOOL) crcPresent;
 
+/**
+ Returns a dictionary with the same keys and values as `parseGlucoseMeasurementCharacteristicDetails:`, that only decodes the value of a key the first time it is read
+ 
+ @param crcPresent Indicates whether the characteristic includes the E2E-CRC field
+ 
+ @return  All the data of the glucose measurement characteristic as a `NSDictionary` that is decoded on demand
+ 
+ */
+- (NSDictionary *) lazilyParseGlucoseMeasurementCharacteristicDetails:(BOOL) crcPresent;
+
 @end
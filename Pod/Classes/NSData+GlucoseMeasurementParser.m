@@ -8,20 +8,13 @@
 #import "NSData+GlucoseMeasurementParser.h"
 #import "NSData+ConversionExtensions.h"
 #import "UHNBLETypes.h"
+#import "UHNBGMGlucoseFieldLayout.h"
+#import "UHNBGMLazyRecordDictionary.h"
 #import "UHNDebug.h"
 
 // TODO this should probably be put in the UHNBLETypes.h file so it can be shared between the NSData+GlucoseMeasurementParser and NSData+CGMParser instead of being redefined
 #define kFluidTypeBitMask 0xF
 
-// Glucose Measurement Context Flag Bits
-typedef NS_ENUM (NSUInteger, GlucoseMeasurementField)
-{
-    GlucoseMeasurementFieldTimeOffset           = 1,
-    GlucoseMeasurementFieldGlucoseConcentration,
-    GlucoseMeasurementFieldGlucoseTypeSampleLocation,
-    GlucoseMeasurementFieldSensorStatusAnnunciation,
-};
-
 @implementation NSData (GlucoseMeasurementParser)
 
 - (NSDictionary *) parseGlucoseMeasurementCharacteristicDetails:(BOOL) crcPresent;
@@ -73,6 +66,11 @@ typedef NS_ENUM (NSUInteger, GlucoseMeasurementField)
     return measurementDetails;
 }
 
+- (NSDictionary *) lazilyParseGlucoseMeasurementCharacteristicDetails:(BOOL) crcPresent;
+{
+    return [[UHNBGMLazyMeasurementDictionary alloc] initWithGlucoseMeasurementData:self crcPresent:crcPresent];
+}
+
 #pragma mark - Glucose Measurement Parsing Methods
 
 - (NSUInteger) parseGlucoseMeasurementFlags;
@@ -140,7 +138,7 @@ typedef NS_ENUM (NSUInteger, GlucoseMeasurementField)
 - (NSNumber *) parseGlucoseMeasurementType;
 {
     NSNumber *valueNumber = nil;
-    NSRange dataRange = [self glucoseMeasurementFieldDataRange:GlucoseMeasurementFieldGlucoseTypeSampleLocation];
+    NSRange dataRange = [self glucoseMeasurementFieldDataRange:GlucoseMeasurementFieldType];
     
     // check if type is present
     if (dataRange.location != NSNotFound)
@@ -155,7 +153,7 @@ typedef NS_ENUM (NSUInteger, GlucoseMeasurementField)
 - (NSNumber *) parseGlucoseMeasurementSampleLocation;
 {
     NSNumber *valueNumber = nil;
-    NSRange dataRange = [self glucoseMeasurementFieldDataRange:GlucoseMeasurementFieldGlucoseTypeSampleLocation];
+    NSRange dataRange = [self glucoseMeasurementFieldDataRange:GlucoseMeasurementFieldSampleLocation];
     
     // check if sample location is present
     if (dataRange.location != NSNotFound)
@@ -188,109 +186,26 @@ typedef NS_ENUM (NSUInteger, GlucoseMeasurementField)
 {
     // this method parses data based on the spec found here:
     // https://developer.bluetooth.org/gatt/characteristics/Pages/CharacteristicViewer.aspx?u=org.bluetooth.characteristic.glucose_measurement.xml
+    // the offset of each field for every combination of flags is compiled once from the schema in UHNBGMFieldSchema.c
     
-    NSUInteger measurementFlags = [self parseGlucoseMeasurementFlags];
-    NSUInteger startPosition = 10;
-    NSUInteger sizeOfField = 0;
+    const UHNBGMFieldLayout *layout = UHNBGMMeasurementFieldLayout();
     NSRange defaultRange = NSMakeRange(NSNotFound, 0);
-    GlucoseMeasurementFlagOption flagForField = [self glucoseMeasurementFlagForField:field];
-    GlucoseMeasurementField currentField;
     
-    // only return a valid range if the flag for the field we want exists in the glucose measurement
-    if (flagForField & measurementFlags)
+    if ([self length] < layout->fixedLength)
     {
-        // now iterate through all the fields of the data until we get to the one we are looking for
-        
-        // time offset (sint16)
-        currentField = GlucoseMeasurementFieldTimeOffset;
-        
-        if (([self glucoseMeasurementFlagForField:currentField]) & measurementFlags)
-        {
-            sizeOfField = 2;
-            
-            if (field == currentField)
-            {
-                return NSMakeRange(startPosition, sizeOfField);
-            }
-            
-            startPosition += sizeOfField;
-        }
-        
-        // glucose concentration (SFLOAT)
-        currentField = GlucoseMeasurementFieldGlucoseConcentration;
-        
-        if (([self glucoseMeasurementFlagForField:currentField]) & measurementFlags)
-        {
-            sizeOfField = 2;
-            
-            if (field == currentField)
-            {
-                return NSMakeRange(startPosition, sizeOfField);
-            }
-            
-            startPosition += sizeOfField;
-        }
-        
-        // type / sample location (type is first nibble and sample location is second nibble of 8 bit field)
-        currentField = GlucoseMeasurementFieldGlucoseTypeSampleLocation;
-        
-        if (([self glucoseMeasurementFlagForField:currentField]) & measurementFlags)
-        {
-            sizeOfField = 1;
-            
-            if (field == currentField)
-            {
-                return NSMakeRange(startPosition, sizeOfField);
-            }
-            
-            startPosition += sizeOfField;
-        }
-        
-        // sensor status annunciation (16bit)
-        currentField = GlucoseMeasurementFieldSensorStatusAnnunciation;
-        
-        if (([self glucoseMeasurementFlagForField:currentField]) & measurementFlags)
-        {
-            sizeOfField = 2;
-            
-            if (field == currentField)
-            {
-                return NSMakeRange(startPosition, sizeOfField);
-            }
-            
-            startPosition += sizeOfField;
-        }
+        return defaultRange;
     }
     
-    return defaultRange;
-}
-
-// map the glucose context field type to a flag for it in the flags portion of the glucose measurement context data
-- (GlucoseMeasurementFlagOption) glucoseMeasurementFlagForField:(GlucoseMeasurementField) field;
-{
-    GlucoseMeasurementFlagOption option;
+    uint8_t offset = UHNBGMFieldOffset(layout, ((const uint8_t *) [self bytes])[0], field);
+    NSUInteger sizeOfField = UHNBGMFieldTypeSize(layout->fieldTypes[field]);
     
-    switch (field)
+    // only return a valid range if the field exists in the glucose measurement
+    if (kUHNBGMFieldAbsent == offset || offset + sizeOfField > [self length])
     {
-        case GlucoseMeasurementFieldTimeOffset:
-        {
-            option = GlucoseMeasurementFlagPresentTimeOffset;
-            break;
-        }
-        case GlucoseMeasurementFieldGlucoseConcentration:
-        case GlucoseMeasurementFieldGlucoseTypeSampleLocation:
-        {
-            option = GlucoseMeasurementFlagPresentGlucoseConcentrationTypeAndSampleLocation;
-            break;
-        }
-        case GlucoseMeasurementFieldSensorStatusAnnunciation:
-        {
-            option = GlucoseMeasurementFlagPresentSensorStatusAnnunciation;
-            break;
-        }
+        return defaultRange;
     }
     
-    return option;
+    return NSMakeRange(offset, sizeOfField);
 }
 
 @end
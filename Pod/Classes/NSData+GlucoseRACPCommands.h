@@ -0,0 +1,76 @@
+//
+//  NSData+GlucoseRACPCommands.h
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "UHNBGMConstants.h"
+
+/**
+ `NSData+GlucoseRACPCommands` provides the record access control point commands filtered by sequence number that are used by the glucose sensor procedures
+ */
+@interface NSData (GlucoseRACPCommands)
+
+/**
+ Returns the command to report the stored records within the inclusive range of sequence numbers
+ 
+ @param firstSequenceNumber The sequence number of the first record to report
+ @param lastSequenceNumber The sequence number of the last record to report
+ 
+ @return The RACP command as a `NSData`
+ 
+ */
++ (NSData *) reportStoredRecordsFromSequenceNumber:(uint16_t) firstSequenceNumber toSequenceNumber:(uint16_t) lastSequenceNumber;
+
+/**
+ Returns the command to report the stored records with a sequence number greater than or equal to the provided sequence number
+ 
+ @param sequenceNumber The sequence number of the first record to report
+ 
+ @return The RACP command as a `NSData`
+ 
+ */
++ (NSData *) reportStoredRecordsGreaterThanOrEqualToSequenceNumber:(uint16_t) sequenceNumber;
+
+/**
+ Returns the command to report the number of stored records with a sequence number greater than or equal to the provided sequence number
+ 
+ @param sequenceNumber The sequence number of the first record to count
+ 
+ @return The RACP command as a `NSData`
+ 
+ */
++ (NSData *) reportNumberOfStoredRecordsGreaterThanOrEqualToSequenceNumber:(uint16_t) sequenceNumber;
+
+/**
+ Returns the command to delete the stored records within the inclusive range of sequence numbers
+ 
+ @param firstSequenceNumber The sequence number of the first record to delete
+ @param lastSequenceNumber The sequence number of the last record to delete
+ 
+ @return The RACP command as a `NSData`
+ 
+ */
++ (NSData *) deleteStoredRecordsFromSequenceNumber:(uint16_t) firstSequenceNumber toSequenceNumber:(uint16_t) lastSequenceNumber;
+
+@end
@@ -0,0 +1,59 @@
+//
+//  NSData+GlucoseRACPCommands.m
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+
+#import "NSData+GlucoseRACPCommands.h"
+
+// RACP op codes as defined by the record access control point characteristic
+#define kGlucoseRACPOpCodeReportStoredRecords           0x01
+#define kGlucoseRACPOpCodeReportNumberOfStoredRecords   0x04
+
+@implementation NSData (GlucoseRACPCommands)
+
++ (NSData *) reportStoredRecordsFromSequenceNumber:(uint16_t) firstSequenceNumber toSequenceNumber:(uint16_t) lastSequenceNumber;
+{
+    return [self glucoseRACPCommandWithOpCode:kGlucoseRACPOpCodeReportStoredRecords
+                                     operator:GlucoseRACPOperatorWithinRange
+                          firstSequenceNumber:firstSequenceNumber
+                           lastSequenceNumber:lastSequenceNumber];
+}
+
++ (NSData *) reportStoredRecordsGreaterThanOrEqualToSequenceNumber:(uint16_t) sequenceNumber;
+{
+    return [self glucoseRACPCommandWithOpCode:kGlucoseRACPOpCodeReportStoredRecords
+                                     operator:GlucoseRACPOperatorGreaterThanOrEqualTo
+                          firstSequenceNumber:sequenceNumber
+                           lastSequenceNumber:sequenceNumber];
+}
+
++ (NSData *) reportNumberOfStoredRecordsGreaterThanOrEqualToSequenceNumber:(uint16_t) sequenceNumber;
+{
+    return [self glucoseRACPCommandWithOpCode:kGlucoseRACPOpCodeReportNumberOfStoredRecords
+                                     operator:GlucoseRACPOperatorGreaterThanOrEqualTo
+                          firstSequenceNumber:sequenceNumber
+                           lastSequenceNumber:sequenceNumber];
+}
+
++ (NSData *) deleteStoredRecordsFromSequenceNumber:(uint16_t) firstSequenceNumber toSequenceNumber:(uint16_t) lastSequenceNumber;
+{
+    return [self glucoseRACPCommandWithOpCode:kGlucoseRACPOpCodeDeleteStoredRecords
+                                     operator:GlucoseRACPOperatorWithinRange
+                          firstSequenceNumber:firstSequenceNumber
+                           lastSequenceNumber:lastSequenceNumber];
+}
+
+#pragma mark - Private Methods
+
++ (NSData *) glucoseRACPCommandWithOpCode:(uint8_t) opCode operator:(GlucoseRACPOperator) racpOperator firstSequenceNumber:(uint16_t) firstSequenceNumber lastSequenceNumber:(uint16_t) lastSequenceNumber;
+{
+    // op code, operator, filter type, followed by one (greater/less than) or two (within range) little endian sequence numbers
+    uint8_t command[7] = {opCode, racpOperator, GlucoseRACPFilterTypeSequenceNumber, (firstSequenceNumber & 0xFF), (firstSequenceNumber >> 8), (lastSequenceNumber & 0xFF), (lastSequenceNumber >> 8)};
+    NSUInteger length = (racpOperator == GlucoseRACPOperatorWithinRange) ? 7 : 5;
+    
+    return [NSData dataWithBytes:command length:length];
+}
+
+@end
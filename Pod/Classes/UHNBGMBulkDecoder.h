@@ -0,0 +1,121 @@
+//
+//  UHNBGMBulkDecoder.h
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "UHNBGMRecordDecoder.h"
+
+/**
+ Decoded glucose measurements stored column by column. Each column is a `NSData` holding one C value per measurement, in the order of the decoded payloads.
+ */
+@interface UHNBGMMeasurementColumns : NSObject
+
+/** The number of decoded payloads, including the invalid ones */
+@property (nonatomic, assign, readonly) NSUInteger count;
+/** `uint8_t`, 1 if the payload was decoded, 0 if it was too short */
+@property (nonatomic, strong, readonly) NSData *valid;
+/** `uint8_t`, the glucose measurement flags */
+@property (nonatomic, strong, readonly) NSData *flags;
+/** `uint16_t`, the sequence numbers */
+@property (nonatomic, strong, readonly) NSData *sequenceNumbers;
+/** `int64_t`, the creation times in the local wall clock time of the glucose sensor, as returned by `UHNBGMMeasurementLocalTimestamp` (not UNIX timestamps) */
+@property (nonatomic, strong, readonly) NSData *localTimestamps;
+/** `float`, the glucose concentrations in the units given by the flags */
+@property (nonatomic, strong, readonly) NSData *glucoseConcentrations;
+/** `uint8_t`, the fluid types */
+@property (nonatomic, strong, readonly) NSData *types;
+/** `uint8_t`, the sample locations */
+@property (nonatomic, strong, readonly) NSData *sampleLocations;
+/** `uint16_t`, the sensor status annunciations */
+@property (nonatomic, strong, readonly) NSData *sensorStatusAnnunciations;
+
+@end
+
+/**
+ Decoded glucose measurement contexts stored column by column. Each column is a `NSData` holding one C value per measurement context, in the order of the decoded payloads.
+ */
+@interface UHNBGMMeasurementContextColumns : NSObject
+
+/** The number of decoded payloads, including the invalid ones */
+@property (nonatomic, assign, readonly) NSUInteger count;
+/** `uint8_t`, 1 if the payload was decoded, 0 if it was too short */
+@property (nonatomic, strong, readonly) NSData *valid;
+/** `uint8_t`, the glucose measurement context flags */
+@property (nonatomic, strong, readonly) NSData *flags;
+/** `uint16_t`, the sequence numbers */
+@property (nonatomic, strong, readonly) NSData *sequenceNumbers;
+/** `uint8_t`, the carbohydrate IDs */
+@property (nonatomic, strong, readonly) NSData *carbohydrateIDs;
+/** `float`, the carbohydrates in kg */
+@property (nonatomic, strong, readonly) NSData *carbohydrates;
+/** `uint8_t`, the meals */
+@property (nonatomic, strong, readonly) NSData *meals;
+/** `uint8_t`, the tester (low nibble) and health (high nibble) */
+@property (nonatomic, strong, readonly) NSData *testerHealths;
+/** `uint16_t`, the exercise durations in seconds */
+@property (nonatomic, strong, readonly) NSData *exerciseDurations;
+/** `uint8_t`, the exercise intensities in percent */
+@property (nonatomic, strong, readonly) NSData *exerciseIntensities;
+/** `uint8_t`, the medication IDs */
+@property (nonatomic, strong, readonly) NSData *medicationIDs;
+/** `float`, the medications in the units given by the flags */
+@property (nonatomic, strong, readonly) NSData *medications;
+/** `float`, the HbA1c in percent */
+@property (nonatomic, strong, readonly) NSData *hbA1cs;
+
+@end
+
+/**
+ `UHNBGMBulkDecoder` decodes large numbers of raw glucose measurement and glucose measurement context payloads in parallel, using the Foundation free decoder of `UHNBGMRecordDecoder.h`.
+ 
+ @discussion The payloads are split into chunks that are handed out to all the available cores as they become free, so a slow chunk does not hold back the others.
+ */
+@interface UHNBGMBulkDecoder : NSObject
+
+/**
+ The number of payloads decoded by a single unit of work. Defaults to 4096.
+ */
+@property (nonatomic, assign) NSUInteger chunkSize;
+
+/**
+ Decodes glucose measurement payloads
+ 
+ @param payloads An array of `NSData`, each holding a glucose measurement characteristic value
+ 
+ @return The decoded measurements
+ 
+ */
+- (UHNBGMMeasurementColumns *) decodeMeasurementPayloads:(NSArray *) payloads;
+
+/**
+ Decodes glucose measurement context payloads
+ 
+ @param payloads An array of `NSData`, each holding a glucose measurement context characteristic value
+ 
+ @return The decoded measurement contexts
+ 
+ */
+- (UHNBGMMeasurementContextColumns *) decodeMeasurementContextPayloads:(NSArray *) payloads;
+
+@end
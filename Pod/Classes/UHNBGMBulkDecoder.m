@@ -0,0 +1,205 @@
+//
+//  UHNBGMBulkDecoder.m
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+
+#import "UHNBGMBulkDecoder.h"
+
+#define kBulkDecoderDefaultChunkSize 4096
+
+@interface UHNBGMMeasurementColumns ()
+@property (nonatomic, assign, readwrite) NSUInteger count;
+@property (nonatomic, strong, readwrite) NSData *valid;
+@property (nonatomic, strong, readwrite) NSData *flags;
+@property (nonatomic, strong, readwrite) NSData *sequenceNumbers;
+@property (nonatomic, strong, readwrite) NSData *localTimestamps;
+@property (nonatomic, strong, readwrite) NSData *glucoseConcentrations;
+@property (nonatomic, strong, readwrite) NSData *types;
+@property (nonatomic, strong, readwrite) NSData *sampleLocations;
+@property (nonatomic, strong, readwrite) NSData *sensorStatusAnnunciations;
+@end
+
+@implementation UHNBGMMeasurementColumns
+@end
+
+@interface UHNBGMMeasurementContextColumns ()
+@property (nonatomic, assign, readwrite) NSUInteger count;
+@property (nonatomic, strong, readwrite) NSData *valid;
+@property (nonatomic, strong, readwrite) NSData *flags;
+@property (nonatomic, strong, readwrite) NSData *sequenceNumbers;
+@property (nonatomic, strong, readwrite) NSData *carbohydrateIDs;
+@property (nonatomic, strong, readwrite) NSData *carbohydrates;
+@property (nonatomic, strong, readwrite) NSData *meals;
+@property (nonatomic, strong, readwrite) NSData *testerHealths;
+@property (nonatomic, strong, readwrite) NSData *exerciseDurations;
+@property (nonatomic, strong, readwrite) NSData *exerciseIntensities;
+@property (nonatomic, strong, readwrite) NSData *medicationIDs;
+@property (nonatomic, strong, readwrite) NSData *medications;
+@property (nonatomic, strong, readwrite) NSData *hbA1cs;
+@end
+
+@implementation UHNBGMMeasurementContextColumns
+@end
+
+@implementation UHNBGMBulkDecoder
+
+- (instancetype) init;
+{
+    if ((self = [super init]))
+    {
+        self.chunkSize = kBulkDecoderDefaultChunkSize;
+    }
+    
+    return self;
+}
+
+- (UHNBGMMeasurementColumns *) decodeMeasurementPayloads:(NSArray *) payloads;
+{
+    NSUInteger count = [payloads count];
+    NSMutableData *valid = [NSMutableData dataWithLength:count * sizeof(uint8_t)];
+    NSMutableData *flags = [NSMutableData dataWithLength:count * sizeof(uint8_t)];
+    NSMutableData *sequenceNumbers = [NSMutableData dataWithLength:count * sizeof(uint16_t)];
+    NSMutableData *localTimestamps = [NSMutableData dataWithLength:count * sizeof(int64_t)];
+    NSMutableData *glucoseConcentrations = [NSMutableData dataWithLength:count * sizeof(float)];
+    NSMutableData *types = [NSMutableData dataWithLength:count * sizeof(uint8_t)];
+    NSMutableData *sampleLocations = [NSMutableData dataWithLength:count * sizeof(uint8_t)];
+    NSMutableData *sensorStatusAnnunciations = [NSMutableData dataWithLength:count * sizeof(uint16_t)];
+    
+    // every chunk writes its own slice of the columns, so no locking is needed
+    uint8_t *validColumn = [valid mutableBytes];
+    uint8_t *flagsColumn = [flags mutableBytes];
+    uint16_t *sequenceNumbersColumn = [sequenceNumbers mutableBytes];
+    int64_t *localTimestampsColumn = [localTimestamps mutableBytes];
+    float *glucoseConcentrationsColumn = [glucoseConcentrations mutableBytes];
+    uint8_t *typesColumn = [types mutableBytes];
+    uint8_t *sampleLocationsColumn = [sampleLocations mutableBytes];
+    uint16_t *sensorStatusAnnunciationsColumn = [sensorStatusAnnunciations mutableBytes];
+    
+    [self applyToChunksOfCount:count block:^(NSUInteger start, NSUInteger end) {
+        UHNBGMMeasurementRecord record;
+        
+        for (NSUInteger index = start; index < end; index++)
+        {
+            NSData *payload = payloads[index];
+            
+            if (!UHNBGMDecodeMeasurement([payload bytes], [payload length], &record))
+            {
+                continue;
+            }
+            
+            validColumn[index] = 1;
+            flagsColumn[index] = record.flags;
+            sequenceNumbersColumn[index] = record.sequenceNumber;
+            localTimestampsColumn[index] = UHNBGMMeasurementLocalTimestamp(&record);
+            glucoseConcentrationsColumn[index] = record.glucoseConcentration;
+            typesColumn[index] = record.type;
+            sampleLocationsColumn[index] = record.sampleLocation;
+            sensorStatusAnnunciationsColumn[index] = record.sensorStatusAnnunciation;
+        }
+    }];
+    
+    UHNBGMMeasurementColumns *columns = [[UHNBGMMeasurementColumns alloc] init];
+    columns.count = count;
+    columns.valid = valid;
+    columns.flags = flags;
+    columns.sequenceNumbers = sequenceNumbers;
+    columns.localTimestamps = localTimestamps;
+    columns.glucoseConcentrations = glucoseConcentrations;
+    columns.types = types;
+    columns.sampleLocations = sampleLocations;
+    columns.sensorStatusAnnunciations = sensorStatusAnnunciations;
+    
+    return columns;
+}
+
+- (UHNBGMMeasurementContextColumns *) decodeMeasurementContextPayloads:(NSArray *) payloads;
+{
+    NSUInteger count = [payloads count];
+    NSMutableData *valid = [NSMutableData dataWithLength:count * sizeof(uint8_t)];
+    NSMutableData *flags = [NSMutableData dataWithLength:count * sizeof(uint8_t)];
+    NSMutableData *sequenceNumbers = [NSMutableData dataWithLength:count * sizeof(uint16_t)];
+    NSMutableData *carbohydrateIDs = [NSMutableData dataWithLength:count * sizeof(uint8_t)];
+    NSMutableData *carbohydrates = [NSMutableData dataWithLength:count * sizeof(float)];
+    NSMutableData *meals = [NSMutableData dataWithLength:count * sizeof(uint8_t)];
+    NSMutableData *testerHealths = [NSMutableData dataWithLength:count * sizeof(uint8_t)];
+    NSMutableData *exerciseDurations = [NSMutableData dataWithLength:count * sizeof(uint16_t)];
+    NSMutableData *exerciseIntensities = [NSMutableData dataWithLength:count * sizeof(uint8_t)];
+    NSMutableData *medicationIDs = [NSMutableData dataWithLength:count * sizeof(uint8_t)];
+    NSMutableData *medications = [NSMutableData dataWithLength:count * sizeof(float)];
+    NSMutableData *hbA1cs = [NSMutableData dataWithLength:count * sizeof(float)];
+    
+    uint8_t *validColumn = [valid mutableBytes];
+    uint8_t *flagsColumn = [flags mutableBytes];
+    uint16_t *sequenceNumbersColumn = [sequenceNumbers mutableBytes];
+    uint8_t *carbohydrateIDsColumn = [carbohydrateIDs mutableBytes];
+    float *carbohydratesColumn = [carbohydrates mutableBytes];
+    uint8_t *mealsColumn = [meals mutableBytes];
+    uint8_t *testerHealthsColumn = [testerHealths mutableBytes];
+    uint16_t *exerciseDurationsColumn = [exerciseDurations mutableBytes];
+    uint8_t *exerciseIntensitiesColumn = [exerciseIntensities mutableBytes];
+    uint8_t *medicationIDsColumn = [medicationIDs mutableBytes];
+    float *medicationsColumn = [medications mutableBytes];
+    float *hbA1csColumn = [hbA1cs mutableBytes];
+    
+    [self applyToChunksOfCount:count block:^(NSUInteger start, NSUInteger end) {
+        UHNBGMMeasurementContextRecord record;
+        
+        for (NSUInteger index = start; index < end; index++)
+        {
+            NSData *payload = payloads[index];
+            
+            if (!UHNBGMDecodeMeasurementContext([payload bytes], [payload length], &record))
+            {
+                continue;
+            }
+            
+            validColumn[index] = 1;
+            flagsColumn[index] = record.flags;
+            sequenceNumbersColumn[index] = record.sequenceNumber;
+            carbohydrateIDsColumn[index] = record.carbohydrateID;
+            carbohydratesColumn[index] = record.carbohydrate;
+            mealsColumn[index] = record.meal;
+            testerHealthsColumn[index] = record.tester | (record.health << 4);
+            exerciseDurationsColumn[index] = record.exerciseDuration;
+            exerciseIntensitiesColumn[index] = record.exerciseIntensity;
+            medicationIDsColumn[index] = record.medicationID;
+            medicationsColumn[index] = record.medication;
+            hbA1csColumn[index] = record.hbA1c;
+        }
+    }];
+    
+    UHNBGMMeasurementContextColumns *columns = [[UHNBGMMeasurementContextColumns alloc] init];
+    columns.count = count;
+    columns.valid = valid;
+    columns.flags = flags;
+    columns.sequenceNumbers = sequenceNumbers;
+    columns.carbohydrateIDs = carbohydrateIDs;
+    columns.carbohydrates = carbohydrates;
+    columns.meals = meals;
+    columns.testerHealths = testerHealths;
+    columns.exerciseDurations = exerciseDurations;
+    columns.exerciseIntensities = exerciseIntensities;
+    columns.medicationIDs = medicationIDs;
+    columns.medications = medications;
+    columns.hbA1cs = hbA1cs;
+    
+    return columns;
+}
+
+#pragma mark - Private Methods
+
+- (void) applyToChunksOfCount:(NSUInteger) count block:(void (^)(NSUInteger start, NSUInteger end)) block;
+{
+    NSUInteger chunkSize = MAX(self.chunkSize, 1);
+    NSUInteger numberOfChunks = (count + chunkSize - 1) / chunkSize;
+    
+    // dispatch_apply hands the next chunk to whichever worker thread is free
+    dispatch_apply(numberOfChunks, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t chunk) {
+        NSUInteger start = chunk * chunkSize;
+        block(start, MIN(start + chunkSize, count));
+    });
+}
+
+@end
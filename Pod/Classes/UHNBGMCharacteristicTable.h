@@ -0,0 +1,47 @@
+//
+//  UHNBGMCharacteristicTable.h
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "UHNBGMConstants.h"
+
+/**
+ Returns the identifier of a glucose service characteristic. The lookup is a single hash of the UUID string instead of a chain of string comparisons
+ 
+ @param characteristicUUID The UUID string of the characteristic
+ 
+ @return The identifier of the characteristic, or `GlucoseServiceCharacteristicUnknown` if it is not part of the glucose service
+ 
+ */
+GlucoseServiceCharacteristic UHNBGMGlucoseServiceCharacteristicForUUID(NSString *characteristicUUID);
+
+/**
+ Returns the UUID string of a glucose service characteristic
+ 
+ @param characteristic The identifier of the characteristic
+ 
+ @return The UUID string of the characteristic, or `nil` for `GlucoseServiceCharacteristicUnknown`
+ 
+ */
+NSString *UHNBGMUUIDForGlucoseServiceCharacteristic(GlucoseServiceCharacteristic characteristic);
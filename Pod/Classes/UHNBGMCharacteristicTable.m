@@ -0,0 +1,45 @@
+//
+//  UHNBGMCharacteristicTable.m
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+
+#import "UHNBGMCharacteristicTable.h"
+
+GlucoseServiceCharacteristic UHNBGMGlucoseServiceCharacteristicForUUID(NSString *characteristicUUID)
+{
+    static NSDictionary *characteristicTable = nil;
+    static dispatch_once_t onceToken;
+    
+    dispatch_once(&onceToken, ^{
+        characteristicTable = @{kGlucoseServiceCharacteristicUUIDMeasurement: @(GlucoseServiceCharacteristicMeasurement),
+                                kGlucoseServiceCharacteristicUUIDMeasurementContext: @(GlucoseServiceCharacteristicMeasurementContext),
+                                kGlucoseServiceCharacteristicUUIDSupportedFeatures: @(GlucoseServiceCharacteristicSupportedFeatures),
+                                kGlucoseServiceCharacteristicUUIDRecordAccessControlPoint: @(GlucoseServiceCharacteristicRecordAccessControlPoint)};
+    });
+    
+    if (nil == characteristicUUID)
+    {
+        return GlucoseServiceCharacteristicUnknown;
+    }
+    
+    return (GlucoseServiceCharacteristic) [characteristicTable[characteristicUUID] unsignedCharValue];
+}
+
+NSString *UHNBGMUUIDForGlucoseServiceCharacteristic(GlucoseServiceCharacteristic characteristic)
+{
+    switch (characteristic)
+    {
+        case GlucoseServiceCharacteristicMeasurement:
+            return kGlucoseServiceCharacteristicUUIDMeasurement;
+        case GlucoseServiceCharacteristicMeasurementContext:
+            return kGlucoseServiceCharacteristicUUIDMeasurementContext;
+        case GlucoseServiceCharacteristicSupportedFeatures:
+            return kGlucoseServiceCharacteristicUUIDSupportedFeatures;
+        case GlucoseServiceCharacteristicRecordAccessControlPoint:
+            return kGlucoseServiceCharacteristicUUIDRecordAccessControlPoint;
+        default:
+            return nil;
+    }
+}
@@ -43,6 +43,33 @@
 #define kGlucoseServiceCharacteristicUUIDSupportedFeatures          @"2A51"
 #define kGlucoseServiceCharacteristicUUIDRecordAccessControlPoint   @"2A52"
 
+///----------------------------------------------
+/// @name Device Information Service UUIDs
+///----------------------------------------------
+#pragma mark - Device Information Service UUIDs
+#define kDeviceInformationServiceUUID                               @"180A"
+#define kDeviceInformationCharacteristicUUIDSystemID                @"2A23"
+#define kDeviceInformationCharacteristicUUIDModelNumber             @"2A24"
+#define kDeviceInformationCharacteristicUUIDSerialNumber            @"2A25"
+#define kDeviceInformationCharacteristicUUIDFirmwareRevision        @"2A26"
+
+/**
+ Compact identifiers of the Glucose Service characteristics, used where a characteristic UUID string is too costly to store or compare
+ */
+typedef NS_ENUM (uint8_t, GlucoseServiceCharacteristic)
+{
+    /** Identifier of a characteristic that is not part of the Glucose Service */
+    GlucoseServiceCharacteristicUnknown                             = 0,
+    /** Identifier of the glucose measurement characteristic */
+    GlucoseServiceCharacteristicMeasurement,
+    /** Identifier of the glucose measurement context characteristic */
+    GlucoseServiceCharacteristicMeasurementContext,
+    /** Identifier of the glucose feature characteristic */
+    GlucoseServiceCharacteristicSupportedFeatures,
+    /** Identifier of the record access control point characteristic */
+    GlucoseServiceCharacteristicRecordAccessControlPoint,
+};
+
 ///----------------------------------
 /// @name Glucose Service Error Codes
 ///----------------------------------
@@ -50,6 +77,15 @@
 #define kGlucoseServiceErrorCodeProcedureInProgress 0x80
 #define kGlucoseServiceErrorCodeClientCharacteristicConfigDescriptorImproperlyConfigured 0x81
 
+///--------------------------------
+/// @name Glucose Concentration Units
+///--------------------------------
+#pragma mark - Units
+/**
+ The molar mass of glucose in mg/mmol, to convert between mg/dL and mol/L
+ */
+#define kGlucoseMolarMass                                           180.156
+
 ///---------------------------
 /// @name Glucose Service Keys
 ///---------------------------
@@ -534,6 +570,74 @@ typedef NS_ENUM (uint16_t, GlucoseFeatureOption)
 };
 
 
+///--------------------------------------------------------------
+/// @name Record Access Control Point Procedures
+///--------------------------------------------------------------
+#pragma mark - Record Access Control Point Procedures
+/**********  Record Access Control Point (Mandatory) ***************
+ Op Code - uint8 (Mandatory)
+    - 1 = Report stored records
+    - 2 = Delete stored records
+    - 3 = Abort operation
+    - 4 = Report number of stored records
+    - 5 = Number of stored records response
+    - 6 = Response code
+
+ Operator - uint8 (Mandatory)
+    - 0 = Null
+    - 1 = All records
+    - 2 = Less than or equal to
+    - 3 = Greater than or equal to
+    - 4 = Within range of (inclusive)
+    - 5 = First record (i.e. oldest record)
+    - 6 = Last record (i.e. most recent record)
+
+ Operand - variable (Filter type uint8 followed by the filter parameters)
+    - 1 = Sequence number (uint16 parameters)
+    - 2 = User facing time (org.bluetooth.characteristic.date_time parameters)
+
+ **********************************************/
+
+/**
+ Record access control point op codes used by the glucose sensor procedures that are not provided by `NSData+RACPCommands`
+ */
+#define kGlucoseRACPOpCodeDeleteStoredRecords                       0x02
+#define kGlucoseRACPOpCodeAbortOperation                            0x03
+#define kGlucoseRACPResponseCodeNoRecordsFound                      0x06
+
+/**
+ All possible Record Access Control Point operators
+ */
+typedef NS_ENUM (uint8_t, GlucoseRACPOperator)
+{
+    /** Operator for a request without an operand */
+    GlucoseRACPOperatorNull                                         = 0,
+    /** Operator selecting all the stored records */
+    GlucoseRACPOperatorAllRecords,
+    /** Operator selecting the stored records less than or equal to the operand */
+    GlucoseRACPOperatorLessThanOrEqualTo,
+    /** Operator selecting the stored records greater than or equal to the operand */
+    GlucoseRACPOperatorGreaterThanOrEqualTo,
+    /** Operator selecting the stored records within the inclusive range of the operands */
+    GlucoseRACPOperatorWithinRange,
+    /** Operator selecting the oldest stored record */
+    GlucoseRACPOperatorFirstRecord,
+    /** Operator selecting the most recent stored record */
+    GlucoseRACPOperatorLastRecord,
+};
+
+/**
+ All possible Record Access Control Point filter types
+ */
+typedef NS_ENUM (uint8_t, GlucoseRACPFilterType)
+{
+    /** Filter the stored records by their sequence number */
+    GlucoseRACPFilterTypeSequenceNumber                             = 1,
+    /** Filter the stored records by their user facing time */
+    GlucoseRACPFilterTypeUserFacingTime,
+};
+
+
 ///--------------------------------------------------------------
 /// @name Special Float Values
 ///--------------------------------------------------------------
@@ -26,15 +26,50 @@
 #import <Foundation/Foundation.h>
 #import "UHNRACPControllerDelegate.h"
 #import "UHNBGMConstants.h"
+#import "UHNBGMDeviceProfile.h"
+#import "UHNBGMIngestLedger.h"
+#import "UHNBGMRecordFilter.h"
+#import "UHNBGMRecordSink.h"
 #import "UHNRACPConstants.h"
 #import "NSNumber+GlucoseConcentrationConversion.h"
 
 @protocol UHNBGMControllerDelegate;
 
+/**
+ Block invoked by the owner of a confirmed sync once the transferred records have been durably stored (or failed to be)
+ 
+ @param committed `YES` if the records were durably stored and may be deleted from the glucose sensor, otherwise `NO`
+ */
+typedef void (^UHNBGMSyncCommitCompletion)(BOOL committed);
+
+/**
+ Block invoked with the records transferred by a confirmed sync so they can be committed to the caller's store
+ 
+ @param measurements An array of `NSDictionary` with the glucose measurement details, in the order they were received
+ @param measurementContexts An array of `NSDictionary` with the glucose measurement context details, in the order they were received
+ @param completion The block that must be called once the commit has completed. The stored records are only deleted from the glucose sensor if `completion` is called with `YES`
+ */
+typedef void (^UHNBGMSyncCommitHandler)(NSArray *measurements, NSArray *measurementContexts, UHNBGMSyncCommitCompletion completion);
+
+/**
+ The glucose concentration alerts evaluated for live measurements
+ */
+typedef NS_ENUM (NSUInteger, UHNBGMGlucoseAlert)
+{
+    /** The glucose concentration is within the thresholds, or no thresholds are set */
+    UHNBGMGlucoseAlertNone                  = 0,
+    /** The glucose concentration is at or below the hypoglycemia threshold */
+    UHNBGMGlucoseAlertHypoglycemia,
+    /** The glucose concentration is at or above the hyperglycemia threshold */
+    UHNBGMGlucoseAlertHyperglycemia,
+};
+
 /**
  The UHNBGMController provides an interface to a BLE peripheral that implements the Glucose Service and Device Information services. Through the inteface and delegate protocol, one should be able to easily make requests of a Glucose meter sensor.
  
- @warning Support for Device Information services will be included in a future release.
+ @warning The Device Information Service is only read by `getDeviceProfile` when it is discovered, so its UUID must be included in the required services (see `initWithDelegate:requiredServices:`).
+ 
+ @discussion Concurrency: the state of the controller is only touched on its own serial queue. Every method may be called from any thread; requests are queued in the order they are made and return straight away, while the methods that return a value wait for the requests queued before them. The BLE events are handled on the same queue, while the requests to the `UHNBLEController` are sent from the main queue, which it shares with CoreBluetooth. The delegate, the record sinks and the sync commit handler are called on the delegate queue (the main queue by default, see `setDelegateQueue:`), one callback at a time and in the order of the events.
  
  */
 
@@ -65,6 +100,28 @@
  */
 - (instancetype)initWithDelegate:(id<UHNBGMControllerDelegate>)delegate requiredServices:(NSArray*)serviceUUIDs;
 
+///-------------------
+/// @name Delegate Queue
+///-------------------
+
+/**
+ Set the queue on which the delegate, the record sinks and the sync commit handler are called
+ 
+ @param delegateQueue A serial queue, or `nil` for the main queue
+ 
+ @discussion Calling back on a background queue keeps the processing of the records off the main thread. The callbacks already queued are still delivered on the previous queue. The callbacks are delivered in the order they were made, except for `bgmController:didGetLiveGlucoseMeasurement:alert:`, which is delivered ahead of the callbacks still waiting.
+ 
+ */
+- (void) setDelegateQueue:(dispatch_queue_t) delegateQueue;
+
+/**
+ Invoke a block on the delegate queue once every request made so far has been handled and its callbacks delivered
+ 
+ @param completion The block to invoke. This parameter is mandatory.
+ 
+ */
+- (void) waitForPendingCallbacksWithCompletion:(dispatch_block_t) completion;
+
 ///-------------------------
 /// @name Connection Methods
 ///-------------------------
@@ -213,6 +270,36 @@
  */
 - (BOOL) isGlucoseMeasurementContextSupported;
 
+///---------------------
+/// @name Device Profile
+///---------------------
+
+/**
+ Get the profile of the connected glucose sensor, consolidating its supported features and Device Information Service values
+ 
+ @discussion If a profile was already read from the connected peripheral, the cached profile is delivered without any reads. Otherwise the glucose feature characteristic and the model number, serial number, firmware revision and system ID characteristics that the glucose sensor provides are read as one batch, with several reads outstanding at a time instead of one read per round trip.
+ 
+ @discussion Once the profile is available, the delegate will receive the `bgmController:didGetDeviceProfile:` notification and the supported features can be checked. A read that is not answered within 10 seconds is left out of the profile, and such a partial profile is not cached, so the next `getDeviceProfile` reads the glucose sensor again.
+ 
+ */
+- (void) getDeviceProfile;
+
+/**
+ Read the profile of the connected glucose sensor again, replacing any cached profile
+ 
+ @discussion See `getDeviceProfile`
+ 
+ */
+- (void) refreshDeviceProfile;
+
+/**
+ The profile of the connected glucose sensor
+ 
+ @return The profile delivered by the last `getDeviceProfile` or `refreshDeviceProfile`, or `nil` if none was delivered yet
+ 
+ */
+- (UHNBGMDeviceProfile *) deviceProfile;
+
 ///----------------------------------
 /// @name Glucose Service Characteristics
 ///----------------------------------
@@ -258,6 +345,62 @@
  */
 - (void) enableNotificationRACP:(BOOL) enable;
 
+///---------------------
+/// @name Record Parsing
+///---------------------
+
+/**
+ Request that the glucose measurement and glucose measurement context details passed to the delegate are decoded lazily. Disabled by default
+ 
+ @param enable If `YES` the details are dictionaries that only decode the value of a key the first time it is read. `NO` indicates that all the values are decoded as soon as a record is received
+ 
+ @discussion Lazily decoded details have the same keys and values as eagerly decoded ones, but are immutable, so only enable lazy decoding if the delegate and the record sinks do not mutate the details
+ 
+ */
+- (void) enableLazyRecordParsing:(BOOL) enable;
+
+/**
+ Sets the filter that decides which glucose measurements and glucose measurement contexts are delivered to the delegate
+ 
+ @param recordFilter The filter, or `nil` to deliver all records
+ 
+ @discussion The filter is evaluated on the raw characteristic values before they are parsed. Its sequence number bounds are also sent to the glucose sensor by `getAllStoredRecords`. Records transferred by a confirmed sync are never filtered, since they are all deleted once committed
+ 
+ */
+- (void) setRecordFilter:(UHNBGMRecordFilter *) recordFilter;
+
+/**
+ Sets the ledger that drops the glucose measurements and glucose measurement contexts already delivered
+ 
+ @param ingestLedger The ledger, or `nil` to deliver records received again
+ 
+ @discussion The ledger is evaluated on the raw characteristic values after the record filter, with the identifier of the connected glucose sensor. A glucose measurement is entered in the ledger once the delegate and the record sinks have returned from `bgmController:didCompleteTransferWithNumberOfRecords:` for the transfer it was delivered in, so they should persist the records they buffered by then, as `UHNBGMEncryptedRecordStore` does with `flush`. A live measurement, or one of an interrupted transfer, is entered with the next completed transfer, so the ledger is never saved ahead of the sinks. A measurement delivered but not entered, e.g. because the app was stopped, is delivered again by a retry. As with the filter, records transferred by a confirmed sync are never dropped
+ 
+ */
+- (void) setIngestLedger:(UHNBGMIngestLedger *) ingestLedger;
+
+///-------------------
+/// @name Record Sinks
+///-------------------
+
+/**
+ Adds a consumer of the records received by the controller, in addition to the delegate
+ 
+ @param recordSink The record sink. It is not retained by the controller
+ 
+ @discussion The interests of the sink and the methods it implements are read once, when it is added. Adding a sink again updates them
+ 
+ */
+- (void) addRecordSink:(id<UHNBGMRecordSink>) recordSink;
+
+/**
+ Removes a record sink
+ 
+ @param recordSink The record sink to remove
+ 
+ */
+- (void) removeRecordSink:(id<UHNBGMRecordSink>) recordSink;
+
 ///----------------------------------
 /// @name Record Access Control Point
 ///----------------------------------
@@ -282,6 +425,123 @@
  */
 - (void) getAllStoredRecords;
 
+///------------------
+/// @name Confirmed Sync
+///------------------
+
+/**
+ Request to transfer the stored records within a range of sequence numbers, commit them to the caller's store and then delete them from the glucose sensor
+ 
+ @param firstSequenceNumber The sequence number of the first record to transfer
+ @param lastSequenceNumber The sequence number of the last record to transfer
+ @param commitHandler The block that commits the transferred records. This parameter is mandatory.
+ 
+ @discussion The records are reported to the delegate as they are received, as is done for `getAllStoredRecords`. Once the transfer completes, `commitHandler` is invoked with all the transferred records. Only after the commit completion is called with `YES` does the glucose sensor receive the RACP delete stored records request, and only for the sequence numbers that were actually committed. A record missing from the transfer is not deleted; each contiguous run of committed records is deleted with its own request. If the transfer, the commit or the delete fails, nothing more is deleted and the delegate will receive the `bgmController:didFailSyncWithRecordsCommitted:` notification.
+ 
+ @discussion If the sync is completed successfully, the delegate will receive the `bgmController:didCompleteSyncOfRecordsFromSequenceNumber:toSequenceNumber:numberOfRecords:` notification
+ 
+ @discussion A sync in progress is abandoned without deleting any records if the glucose sensor disconnects
+ 
+ */
+- (void) syncStoredRecordsFromSequenceNumber:(NSUInteger) firstSequenceNumber toSequenceNumber:(NSUInteger) lastSequenceNumber commitHandler:(UHNBGMSyncCommitHandler) commitHandler;
+
+/**
+ Determine if a confirmed sync is in progress
+ 
+ @return `YES` if a confirmed sync is in progress, otherwise `NO`
+ 
+ */
+- (BOOL) isSyncInProgress;
+
+///----------------------
+/// @name Chunked Transfer
+///----------------------
+
+/**
+ Request to transfer the stored records in ranges of sequence numbers, checkpointing after each range
+ 
+ @param chunkSize The number of sequence numbers requested at a time. A range following one without records spans more sequence numbers
+ @param firstSequenceNumber The sequence number of the first record to transfer
+ 
+ @discussion The number of stored records from `firstSequenceNumber` is requested first, then the records are requested one range of `chunkSize` sequence numbers at a time. The records are reported to the delegate as they are received, as is done for `getAllStoredRecords`. After each range the delegate will receive the `bgmController:didTransferRecordsUpToSequenceNumber:progress:` notification, and once all the records are transferred the `bgmController:didCompleteTransferWithNumberOfRecords:` notification.
+ 
+ @discussion When a range holds no records, the number of stored records from the checkpoint is requested again. The transfer completes if there are none left, e.g. because the notifications of some records were lost; otherwise the next range spans twice as many sequence numbers, so a gap in the sequence numbers is crossed in a few requests.
+ 
+ @discussion If the glucose sensor disconnects or a request fails, the transfer is interrupted and can be continued from the last completed range with `resumeChunkedTransfer`. The records of the interrupted range are transferred again.
+ 
+ @discussion While a chunked transfer is in progress, `getAllStoredRecords` and `syncStoredRecordsFromSequenceNumber:toSequenceNumber:commitHandler:` are ignored, so their records cannot be mixed into the chunks. Records discarded by the record filter still count towards the progress.
+ 
+ */
+- (void) getStoredRecordsInChunksOfSize:(NSUInteger) chunkSize fromSequenceNumber:(NSUInteger) firstSequenceNumber;
+
+/**
+ Resume an interrupted chunked transfer from its last completed range
+ 
+ @return `YES` if the transfer was resumed, otherwise `NO`
+ 
+ */
+- (BOOL) resumeChunkedTransfer;
+
+/**
+ The sequence number of the first record not yet transferred by the current or last chunked transfer. It may be persisted to continue the transfer with `getStoredRecordsInChunksOfSize:fromSequenceNumber:` in a later session
+ 
+ @return The checkpointed sequence number
+ 
+ */
+- (NSUInteger) chunkedTransferCheckpoint;
+
+/**
+ Determine if a chunked transfer is in progress
+ 
+ @return `YES` if a chunked transfer is in progress, otherwise `NO`
+ 
+ */
+- (BOOL) isChunkedTransferInProgress;
+
+///------------------------
+/// @name Live Measurements
+///------------------------
+
+/**
+ Sets the thresholds of the alerts evaluated for live measurements
+ 
+ @param hypoglycemiaThreshold The glucose concentration in mg/dL at or below which a live measurement raises a hypoglycemia alert, or 0 for no hypoglycemia alert
+ @param hyperglycemiaThreshold The glucose concentration in mg/dL at or above which a live measurement raises a hyperglycemia alert, or 0 for no hyperglycemia alert
+ 
+ @discussion The thresholds are converted once to the units of the glucose measurement characteristic, so the alerts are evaluated on the raw glucose concentration before the measurement is parsed
+ 
+ */
+- (void) setHypoglycemiaThreshold:(double) hypoglycemiaThreshold hyperglycemiaThreshold:(double) hyperglycemiaThreshold;
+
+/**
+ Indicates if stored records are being transferred, by `getAllStoredRecords` or a confirmed sync. Measurements received while no transfer is in progress are live measurements
+ 
+ @return `YES` if a transfer is in progress, otherwise `NO`
+ 
+ */
+- (BOOL) isRecordTransferInProgress;
+
+///----------------------
+/// @name Traffic Capture
+///----------------------
+
+/**
+ Start capturing the raw values exchanged with the glucose sensor to a capture file
+ 
+ @param path The path of the capture file. An existing file is replaced.
+ 
+ @return `YES` if the capture was started, otherwise `NO`
+ 
+ @discussion Every value received from or written to the glucose service characteristics is appended with a timestamp. The capture can be replayed with a `UHNBGMTrafficReplayer`. Capturing stops when `stopCapturingTraffic` is called or a new capture is started.
+ 
+ */
+- (BOOL) startCapturingTrafficToFileAtPath:(NSString *) path;
+
+/**
+ Stop capturing the values exchanged with the glucose sensor and close the capture file
+ */
+- (void) stopCapturingTraffic;
+
 @end
 
 /**
@@ -422,4 +682,61 @@
  */
 - (void) bgmController:(UHNBGMController *) controller didSetNotificationStateForAllNotifications:(BOOL) enabled;
 
+/**
+ Notifies the delegate that a confirmed sync has been completed successfully
+ 
+ @param controller The `UHNBGMController` which with the sync was executed
+ @param firstSequenceNumber The sequence number of the first record that was committed and deleted from the glucose sensor
+ @param lastSequenceNumber The sequence number of the last record that was committed and deleted from the glucose sensor
+ @param numberOfRecords The number of glucose measurements that were committed
+ 
+ @discussion This method is invoked once the committed records have been deleted from the glucose sensor. If no records were found in the requested range, `numberOfRecords` is 0 and nothing was deleted
+ 
+ */
+- (void) bgmController:(UHNBGMController *) controller didCompleteSyncOfRecordsFromSequenceNumber:(NSUInteger) firstSequenceNumber toSequenceNumber:(NSUInteger) lastSequenceNumber numberOfRecords:(NSUInteger) numberOfRecords;
+
+/**
+ Notifies the delegate that a confirmed sync has failed
+ 
+ @param controller The `UHNBGMController` which with the sync was executed
+ @param committed If `YES` the records were committed but could not be deleted from the glucose sensor, and will be transferred again by the next sync. `NO` indicates that the records were not committed and none were deleted
+ 
+ @discussion This method is invoked when the transfer, the commit or the delete of a confirmed sync fails
+ 
+ */
+- (void) bgmController:(UHNBGMController *) controller didFailSyncWithRecordsCommitted:(BOOL) committed;
+
+/**
+ Notifies the delegate of a live glucose measurement, taken while no stored records were being transferred
+ 
+ @param controller The `UHNBGMController` which received the glucose measurement
+ @param measurementDetails The glucose measurement details, see `bgmController:didGetGlucoseMeasurementAtIndex:withDetails:`
+ @param alert The alert raised by the glucose concentration (see `setHypoglycemiaThreshold:hyperglycemiaThreshold:`)
+ 
+ @discussion This method is invoked ahead of every callback still waiting for the delegate queue, such as the stored records of a transfer that were received but not yet delivered. The measurement is then reported as usual by `bgmController:didGetGlucoseMeasurementAtIndex:withDetails:`, in its place among the other records
+ 
+ */
+- (void) bgmController:(UHNBGMController *) controller didGetLiveGlucoseMeasurement:(NSDictionary *) measurementDetails alert:(UHNBGMGlucoseAlert) alert;
+
+/**
+ Notifies the delegate that a range of a chunked transfer has been completed
+ 
+ @param controller The `UHNBGMController` which with the chunked transfer was executed
+ @param sequenceNumber The last sequence number of the completed range
+ @param progress The fraction of the records counted at the start of the transfer which have been transferred
+ 
+ */
+- (void) bgmController:(UHNBGMController *) controller didTransferRecordsUpToSequenceNumber:(NSUInteger) sequenceNumber progress:(float) progress;
+
+/**
+ Notifies the delegate that the profile of the glucose sensor is available
+ 
+ @param controller The `UHNBGMController` that is managing the Glucose sensor
+ @param deviceProfile The profile of the glucose sensor
+ 
+ @discussion This method is invoked once all the reads requested by `getDeviceProfile` or `refreshDeviceProfile` have completed, or straight away for a cached profile
+ 
+ */
+- (void) bgmController:(UHNBGMController *) controller didGetDeviceProfile:(UHNBGMDeviceProfile *) deviceProfile;
+
 @end
\ No newline at end of file
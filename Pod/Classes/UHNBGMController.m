@@ -13,19 +13,168 @@
 #import "NSData+GlucoseMeasurementContextParser.h"
 #import "NSData+RACPCommands.h"
 #import "NSData+RACPParser.h"
+#import "NSData+GlucoseRACPCommands.h"
+#import "UHNBGMTrafficCapture.h"
+#import "UHNBGMCharacteristicTable.h"
+#import "UHNBGMGlucoseFieldLayout.h"
+#import "UHNBGMRecordDecoder.h"
 #import "UHNDebug.h"
+#import <pthread.h>
+
+// Confirmed sync procedure states
+typedef NS_ENUM (NSUInteger, UHNBGMSyncState)
+{
+    UHNBGMSyncStateIdle                 = 0,
+    UHNBGMSyncStateTransferring,
+    UHNBGMSyncStateCommitting,
+    UHNBGMSyncStateDeleting,
+};
+
+// Delegate and record sink methods on the record path, cached as bits so each record does not need respondsToSelector:
+typedef NS_OPTIONS (NSUInteger, UHNBGMRecordCapability)
+{
+    UHNBGMRecordCapabilityMeasurement           = (1 << 0),
+    UHNBGMRecordCapabilityMeasurementContext    = (1 << 1),
+    UHNBGMRecordCapabilityTransferComplete      = (1 << 2),
+    UHNBGMRecordCapabilityLiveMeasurement       = (1 << 3),
+};
+
+// identifies the controller queue, so calls made on it run straight away
+static void *kUHNBGMControllerQueueKey = &kUHNBGMControllerQueueKey;
+
+// the number of device profile reads sent before their responses are received, and how long to wait for them
+#define kDeviceProfileMaximumOutstandingReads       4
+#define kDeviceProfileReadTimeout                   10.0
+
+// Chunked transfer states
+typedef NS_ENUM (NSUInteger, UHNBGMChunkedTransferState)
+{
+    UHNBGMChunkedTransferStateIdle              = 0,
+    UHNBGMChunkedTransferStateCounting,
+    UHNBGMChunkedTransferStateTransferring,
+    UHNBGMChunkedTransferStateInterrupted,
+};
+
+@interface UHNBGMRecordSinkEntry : NSObject
+@property (nonatomic, weak) id<UHNBGMRecordSink> sink;
+@property (nonatomic, assign) UHNBGMRecordCapability capabilities;
+@end
+
+@implementation UHNBGMRecordSinkEntry
+@end
+
+// Callbacks waiting for the delegate queue; live measurements are taken ahead of the others
+@interface UHNBGMDeliveryLane : NSObject
+{
+    pthread_mutex_t _lock;
+}
+@property (nonatomic, strong) dispatch_queue_t queue;
+@property (nonatomic, strong) NSMutableArray *pendingLiveDeliveries;
+@property (nonatomic, strong) NSMutableArray *pendingDeliveries;
+- (instancetype) initWithQueue:(dispatch_queue_t) queue;
+- (void) deliver:(dispatch_block_t) delivery isLive:(BOOL) isLive;
+@end
+
+@implementation UHNBGMDeliveryLane
+
+- (instancetype) initWithQueue:(dispatch_queue_t) queue;
+{
+    if ((self = [super init]))
+    {
+        pthread_mutex_init(&_lock, NULL);
+        self.queue = queue;
+        self.pendingLiveDeliveries = [NSMutableArray array];
+        self.pendingDeliveries = [NSMutableArray array];
+    }
+    
+    return self;
+}
+
+- (void) dealloc;
+{
+    pthread_mutex_destroy(&_lock);
+}
+
+- (void) deliver:(dispatch_block_t) delivery isLive:(BOOL) isLive;
+{
+    pthread_mutex_lock(&_lock);
+    [(isLive ? self.pendingLiveDeliveries : self.pendingDeliveries) addObject:[delivery copy]];
+    pthread_mutex_unlock(&_lock);
+    
+    // every queued block runs the next pending callback rather than its own, so a live measurement overtakes the backlog queued before it
+    dispatch_async(self.queue, ^{
+        dispatch_block_t nextDelivery = nil;
+        
+        pthread_mutex_lock(&_lock);
+        NSMutableArray *pending = ([self.pendingLiveDeliveries count] ? self.pendingLiveDeliveries : self.pendingDeliveries);
+        nextDelivery = [pending firstObject];
+        if (nextDelivery)
+        {
+            [pending removeObjectAtIndex:0];
+        }
+        pthread_mutex_unlock(&_lock);
+        
+        if (nextDelivery)
+        {
+            nextDelivery();
+        }
+    });
+}
+
+@end
 
 @interface UHNBGMController() <UHNBLEControllerDelegate>
+@property (nonatomic, strong) dispatch_queue_t controllerQueue;
+@property (nonatomic, strong) dispatch_queue_t delegateQueue;
+@property (nonatomic, strong) UHNBGMDeliveryLane *deliveryLane;
 @property (nonatomic, strong) UHNBLEController *bleController;
 @property (nonatomic, strong) NSUUID *deviceIdentifier;
 @property (nonatomic, strong) NSString *bgmDeviceName;
+@property (nonatomic, assign) BOOL peripheralConnected;
 @property (nonatomic, assign) BOOL shouldBlockReconnect;
 @property (nonatomic, assign) NSUInteger features;
 @property (nonatomic, assign) BOOL enableAllNotifications;
 @property (nonatomic, assign) BOOL isGlucoseMeasurementContextSupportedBySensor;
 @property (nonatomic, assign) BOOL crcCheckingEnabled;
+@property (nonatomic, assign) BOOL lazyRecordParsingEnabled;
+@property (nonatomic, strong) UHNBGMRecordFilter *recordFilter;
+@property (nonatomic, strong) UHNBGMIngestLedger *ingestLedger;
+@property (nonatomic, strong) NSMutableArray *pendingIngestCommits;
 @property (nonatomic, assign) NSUInteger numberOfRecordsReceived;
+@property (nonatomic, assign) UHNBGMSyncState syncState;
+@property (nonatomic, assign) NSUInteger syncIdentifier;
+@property (nonatomic, assign) NSUInteger syncRequestedFirstSequenceNumber;
+@property (nonatomic, assign) NSUInteger syncRequestedLastSequenceNumber;
+@property (nonatomic, assign) NSUInteger syncCommittedFirstSequenceNumber;
+@property (nonatomic, assign) NSUInteger syncCommittedLastSequenceNumber;
+@property (nonatomic, strong) NSMutableArray *syncPendingDeleteRanges;
+@property (nonatomic, strong) NSMutableArray *syncMeasurements;
+@property (nonatomic, strong) NSMutableArray *syncMeasurementContexts;
+@property (nonatomic, copy) UHNBGMSyncCommitHandler syncCommitHandler;
+@property (nonatomic, strong) UHNBGMTrafficRecorder *trafficRecorder;
 @property (nonatomic, weak) id<UHNBGMControllerDelegate> delegate;
+@property (nonatomic, assign) UHNBGMRecordCapability delegateCapabilities;
+@property (nonatomic, strong) NSArray *recordSinkEntries;
+@property (nonatomic, assign) UHNBGMRecordCapability recordSinkCapabilities;
+@property (nonatomic, assign) BOOL recordTransferInProgress;
+@property (nonatomic, assign) UHNBGMChunkedTransferState chunkedTransferState;
+@property (nonatomic, assign) NSUInteger chunkedTransferChunkSize;
+@property (nonatomic, assign) NSUInteger chunkedTransferRangeSize;
+@property (nonatomic, assign) NSUInteger chunkedTransferCheckpoint;
+@property (nonatomic, assign) NSUInteger chunkedTransferNumberOfRecords;
+@property (nonatomic, assign) NSUInteger chunkedTransferNumberOfRecordsReceived;
+@property (nonatomic, assign) NSUInteger chunkedTransferNumberOfRecordsCheckpointed;
+@property (nonatomic, assign) BOOL glucoseAlertsEnabled;
+@property (nonatomic, assign) float hypoglycemiaThresholdKgPerL;
+@property (nonatomic, assign) float hyperglycemiaThresholdKgPerL;
+@property (nonatomic, assign) float hypoglycemiaThresholdMolPerL;
+@property (nonatomic, assign) float hyperglycemiaThresholdMolPerL;
+@property (nonatomic, strong) NSArray *deviceInformationCharacteristicUUIDs;
+@property (nonatomic, strong) UHNBGMDeviceProfile *deviceProfile;
+@property (nonatomic, strong) NSMutableArray *pendingDeviceProfileReads;
+@property (nonatomic, strong) NSMutableSet *outstandingDeviceProfileReads;
+@property (nonatomic, strong) NSMutableDictionary *deviceProfileValues;
+@property (nonatomic, assign) NSUInteger deviceProfileReadIdentifier;
 @end
 
 @implementation UHNBGMController
@@ -73,6 +222,10 @@
 
     if ((self = [super init]))
     {
+        self.controllerQueue = dispatch_queue_create("org.uhn.bgmcontroller", DISPATCH_QUEUE_SERIAL);
+        dispatch_queue_set_specific(self.controllerQueue, kUHNBGMControllerQueueKey, (__bridge void *) self, NULL);
+        _delegateQueue = dispatch_get_main_queue();
+        self.deliveryLane = [[UHNBGMDeliveryLane alloc] initWithQueue:_delegateQueue];
         self.delegate = delegate;
         self.bleController = [[UHNBLEController alloc] initWithDelegate:self
                                                        requiredServices:requiredServices];
@@ -80,139 +233,397 @@
         self.enableAllNotifications = NO;
         self.isGlucoseMeasurementContextSupportedBySensor = NO;
         self.crcCheckingEnabled = NO;
+        self.lazyRecordParsingEnabled = NO;
         self.features = 0;
         self.numberOfRecordsReceived = 0;
+        self.syncState = UHNBGMSyncStateIdle;
+        self.syncIdentifier = 0;
+        self.recordSinkEntries = @[];
+        self.pendingIngestCommits = [NSMutableArray array];
+        self.recordSinkCapabilities = 0;
+        self.chunkedTransferState = UHNBGMChunkedTransferStateIdle;
+        self.deviceInformationCharacteristicUUIDs = @[];
     }
     
     return self;
 }
 
-#pragma mark - Connection Methods
+#pragma mark - Queue Methods
 
-- (BOOL) isConnected;
+- (void) setDelegateQueue:(dispatch_queue_t) delegateQueue;
 {
-    DLog(@"%s", __PRETTY_FUNCTION__);
-    return self.bleController.isPeripheralConnected;
+    // the delegate queue is read on the controller queue
+    if ([self isOnControllerQueue])
+    {
+        _delegateQueue = (delegateQueue ?: dispatch_get_main_queue());
+        
+        // the callbacks already queued stay in the lane of the previous queue
+        self.deliveryLane = [[UHNBGMDeliveryLane alloc] initWithQueue:_delegateQueue];
+        return;
+    }
+    
+    [self performOnControllerQueue:^{
+        self.delegateQueue = delegateQueue;
+    }];
 }
 
-- (void) tryToReconnect;
+- (void) waitForPendingCallbacksWithCompletion:(dispatch_block_t) completion;
 {
-    DLog(@"%s", __PRETTY_FUNCTION__);
+    NSParameterAssert(completion);
     
-    if (self.deviceIdentifier)
+    [self performOnControllerQueue:^{
+        [self.deliveryLane deliver:completion isLive:NO];
+    }];
+}
+
+- (BOOL) isOnControllerQueue;
+{
+    // each controller tags its queue with itself, so the queue of another controller does not count
+    return (dispatch_get_specific(kUHNBGMControllerQueueKey) == (__bridge void *) self);
+}
+
+- (void) performOnControllerQueue:(dispatch_block_t) block;
+{
+    if ([self isOnControllerQueue])
     {
-        DLog(@"trying to reconnect");
-        [self.bleController reconnectToPeripheralWithUUID:self.deviceIdentifier];
+        block();
     }
     else
     {
-        // note: BTLE will automatically start scanning when manager BT is available.
-        [self.bleController startConnection];
+        dispatch_async(self.controllerQueue, block);
     }
 }
 
-- (void) connectToDevice:(NSString *) deviceName;
+- (void) performOnControllerQueueAndWait:(dispatch_block_t) block;
 {
-    [self.bleController connectToDiscoveredPeripheral:deviceName];
+    if ([self isOnControllerQueue])
+    {
+        block();
+    }
+    else
+    {
+        dispatch_sync(self.controllerQueue, block);
+    }
 }
 
-- (void) disconnect;
+- (void) performOnBLEControllerQueue:(dispatch_block_t) block;
 {
-    DLog(@"%s", __PRETTY_FUNCTION__);
+    // the BLE controller and CoreBluetooth run on the main queue, so the requests are sent from there in the order they were made
+    dispatch_async(dispatch_get_main_queue(), block);
+}
+
+- (void) notifyDelegate:(void (^)(id<UHNBGMControllerDelegate> delegate)) notification;
+{
+    // the delegate is resolved on the controller queue, then called on the delegate queue
+    id<UHNBGMControllerDelegate> delegate = self.delegate;
     
-    if ([self.bleController isPeripheralConnected])
+    if (delegate)
     {
-        DLog(@"going to cancel BTLE connection");
-        self.shouldBlockReconnect = YES;
-        [self.bleController cancelConnection];
+        [self.deliveryLane deliver:^{
+            notification(delegate);
+        } isLive:NO];
     }
 }
 
+#pragma mark - Connection Methods
+
+- (BOOL) isConnected;
+{
+    DLog(@"%s", __PRETTY_FUNCTION__);
+    
+    __block BOOL isConnected = NO;
+    [self performOnControllerQueueAndWait:^{
+        isConnected = self.peripheralConnected;
+    }];
+    
+    return isConnected;
+}
+
+- (void) tryToReconnect;
+{
+    [self performOnControllerQueue:^{
+        DLog(@"%s", __PRETTY_FUNCTION__);
+        
+        NSUUID *deviceIdentifier = self.deviceIdentifier;
+        
+        if (deviceIdentifier)
+        {
+            DLog(@"trying to reconnect");
+            [self performOnBLEControllerQueue:^{
+                [self.bleController reconnectToPeripheralWithUUID:deviceIdentifier];
+            }];
+        }
+        else
+        {
+            // note: BTLE will automatically start scanning when manager BT is available.
+            [self performOnBLEControllerQueue:^{
+                [self.bleController startConnection];
+            }];
+        }
+    }];
+}
+
+- (void) connectToDevice:(NSString *) deviceName;
+{
+    [self performOnControllerQueue:^{
+        [self performOnBLEControllerQueue:^{
+            [self.bleController connectToDiscoveredPeripheral:deviceName];
+        }];
+    }];
+}
+
+- (void) disconnect;
+{
+    [self performOnControllerQueue:^{
+        DLog(@"%s", __PRETTY_FUNCTION__);
+        
+        if (self.peripheralConnected)
+        {
+            DLog(@"going to cancel BTLE connection");
+            self.shouldBlockReconnect = YES;
+            
+            [self performOnBLEControllerQueue:^{
+                [self.bleController cancelConnection];
+            }];
+        }
+    }];
+}
+
 #pragma mark - Feature characteristic methods
 
+- (BOOL) isFeatureSupported:(NSUInteger) feature;
+{
+    __block NSUInteger features = 0;
+    [self performOnControllerQueueAndWait:^{
+        features = self.features;
+    }];
+    
+    return (features & feature);
+}
+
 - (BOOL) isLowBatterySupported;
 {
-    return (self.features & GlucoseFeatureSupportedLowBattery);
+    return [self isFeatureSupported:GlucoseFeatureSupportedLowBattery];
 }
 
 - (BOOL) isMultipleBondSupporter;
 {
-    return (self.features & GlucoseFeatureSupportedMultipleBonds);
+    return [self isFeatureSupported:GlucoseFeatureSupportedMultipleBonds];
 }
 
 - (BOOL) isGeneralDeviceFaultSupported;
 {
-    return (self.features & GlucoseFeatureSupportedFaultDevice);
+    return [self isFeatureSupported:GlucoseFeatureSupportedFaultDevice];
 }
 
 - (BOOL) isSensorMalfunctionDetectionSupported;
 {
-    return (self.features & GlucoseFeatureSupportedDetectionSensorMalfunction);
+    return [self isFeatureSupported:GlucoseFeatureSupportedDetectionSensorMalfunction];
 }
 
 - (BOOL) isSensorReadInterruptDetectionSupported;
 {
-    return (self.features & GlucoseFeatureSupportedDetectionSensorReadInterrupt);
+    return [self isFeatureSupported:GlucoseFeatureSupportedDetectionSensorReadInterrupt];
 }
 
 - (BOOL) isSensorResultHighLowDetectionSupported;
 {
-    return (self.features & GlucoseFeatureSupportedDetectionResultExceedsSensorLimit);
+    return [self isFeatureSupported:GlucoseFeatureSupportedDetectionResultExceedsSensorLimit];
 }
 
 - (BOOL) isSensorSampleSizeSupported;
 {
-    return (self.features & GlucoseFeatureSupportedSensorSampleSize);
+    return [self isFeatureSupported:GlucoseFeatureSupportedSensorSampleSize];
 }
 
 - (BOOL) isSensorStripInsertionErrorDetectionSupported;
 {
-    return (self.features & GlucoseFeatureSupportedDetectionStripErrorInsertion);
+    return [self isFeatureSupported:GlucoseFeatureSupportedDetectionStripErrorInsertion];
 }
 
 - (BOOL) isSensorStripTypeErrorDetectionSupported;
 {
-    return (self.features & GlucoseFeatureSupportedDetectionStripErrorType);
+    return [self isFeatureSupported:GlucoseFeatureSupportedDetectionStripErrorType];
 }
 
 - (BOOL) isSensorTemperatureHighLogDetectionSupported;
 {
-    return (self.features & GlucoseFeatureSupportedDetectionSensorTemperatureTooLowHigh);
+    return [self isFeatureSupported:GlucoseFeatureSupportedDetectionSensorTemperatureTooLowHigh];
 }
 
 - (BOOL) isTimeFaultSupported;
 {
-    return (self.features & GlucoseFeatureSupportedFaultTime);
+    return [self isFeatureSupported:GlucoseFeatureSupportedFaultTime];
 }
 
 - (BOOL) isGlucoseMeasurementContextSupported;
 {
-    return (self.isGlucoseMeasurementContextSupportedBySensor);
+    __block BOOL isSupported = NO;
+    [self performOnControllerQueueAndWait:^{
+        isSupported = self.isGlucoseMeasurementContextSupportedBySensor;
+    }];
+    
+    return isSupported;
 }
 
 #pragma mark - Enable Notification State Methods
 
 - (void) enableAllNotifications:(BOOL) enable;
 {
-    self.enableAllNotifications = YES;
-    
-    // enable all the notifications starting with the glucose measurement notification
-    [self.bleController setNotificationState:enable forCharacteristicUUID:kGlucoseServiceCharacteristicUUIDMeasurement withServiceUUID:kGlucoseServiceUUID];
+    [self performOnControllerQueue:^{
+        self.enableAllNotifications = YES;
+        
+        // enable all the notifications starting with the glucose measurement notification
+        [self performOnBLEControllerQueue:^{
+            [self.bleController setNotificationState:enable forCharacteristicUUID:kGlucoseServiceCharacteristicUUIDMeasurement withServiceUUID:kGlucoseServiceUUID];
+        }];
+    }];
 }
 
 - (void) enableNotificationGlucoseMeasurement:(BOOL) enable;
 {
-    [self.bleController setNotificationState:enable forCharacteristicUUID:kGlucoseServiceCharacteristicUUIDMeasurement withServiceUUID:kGlucoseServiceUUID];
+    [self performOnControllerQueue:^{
+        [self performOnBLEControllerQueue:^{
+            [self.bleController setNotificationState:enable forCharacteristicUUID:kGlucoseServiceCharacteristicUUIDMeasurement withServiceUUID:kGlucoseServiceUUID];
+        }];
+    }];
 }
 
 - (void) enableNotificationGlucoseMeasurementContext:(BOOL) enable;
 {
-    [self.bleController setNotificationState:enable forCharacteristicUUID:kGlucoseServiceCharacteristicUUIDMeasurementContext withServiceUUID:kGlucoseServiceUUID];
+    [self performOnControllerQueue:^{
+        [self performOnBLEControllerQueue:^{
+            [self.bleController setNotificationState:enable forCharacteristicUUID:kGlucoseServiceCharacteristicUUIDMeasurementContext withServiceUUID:kGlucoseServiceUUID];
+        }];
+    }];
 }
 
 - (void) enableNotificationRACP:(BOOL) enable;
 {
-    [self.bleController setNotificationState:enable forCharacteristicUUID:kGlucoseServiceCharacteristicUUIDRecordAccessControlPoint withServiceUUID:kGlucoseServiceUUID];
+    [self performOnControllerQueue:^{
+        [self performOnBLEControllerQueue:^{
+            [self.bleController setNotificationState:enable forCharacteristicUUID:kGlucoseServiceCharacteristicUUIDRecordAccessControlPoint withServiceUUID:kGlucoseServiceUUID];
+        }];
+    }];
+}
+
+#pragma mark - Accessor Methods
+
+- (void) setDelegate:(id<UHNBGMControllerDelegate>) delegate;
+{
+    _delegate = delegate;
+    
+    UHNBGMRecordCapability capabilities = 0;
+    
+    if ([delegate respondsToSelector:@selector(bgmController:didGetGlucoseMeasurementAtIndex:withDetails:)])
+    {
+        capabilities |= UHNBGMRecordCapabilityMeasurement;
+    }
+    
+    if ([delegate respondsToSelector:@selector(bgmController:didGetGlucoseMeasurementContextAtIndex:withDetails:)])
+    {
+        capabilities |= UHNBGMRecordCapabilityMeasurementContext;
+    }
+    
+    if ([delegate respondsToSelector:@selector(bgmController:didCompleteTransferWithNumberOfRecords:)])
+    {
+        capabilities |= UHNBGMRecordCapabilityTransferComplete;
+    }
+    
+    if ([delegate respondsToSelector:@selector(bgmController:didGetLiveGlucoseMeasurement:alert:)])
+    {
+        capabilities |= UHNBGMRecordCapabilityLiveMeasurement;
+    }
+    
+    self.delegateCapabilities = capabilities;
+}
+
+#pragma mark - Record Sink Methods
+
+- (void) addRecordSink:(id<UHNBGMRecordSink>) recordSink;
+{
+    [self performOnControllerQueue:^{
+        NSParameterAssert(recordSink);
+        
+        UHNBGMRecordSinkInterest interests = [recordSink recordSinkInterests];
+        UHNBGMRecordSinkEntry *entry = [[UHNBGMRecordSinkEntry alloc] init];
+        entry.sink = recordSink;
+        
+        if ((interests & UHNBGMRecordSinkInterestMeasurements) && [recordSink respondsToSelector:@selector(bgmController:didReceiveGlucoseMeasurement:)])
+        {
+            entry.capabilities |= UHNBGMRecordCapabilityMeasurement;
+        }
+        
+        if ((interests & UHNBGMRecordSinkInterestMeasurementContexts) && [recordSink respondsToSelector:@selector(bgmController:didReceiveGlucoseMeasurementContext:)])
+        {
+            entry.capabilities |= UHNBGMRecordCapabilityMeasurementContext;
+        }
+        
+        if ((interests & UHNBGMRecordSinkInterestTransferEvents) && [recordSink respondsToSelector:@selector(bgmController:didCompleteTransferWithNumberOfRecords:)])
+        {
+            entry.capabilities |= UHNBGMRecordCapabilityTransferComplete;
+        }
+        
+        [self removeRecordSink:recordSink];
+        self.recordSinkEntries = [self.recordSinkEntries arrayByAddingObject:entry];
+        [self updateRecordSinkCapabilities];
+    }];
+}
+
+- (void) removeRecordSink:(id<UHNBGMRecordSink>) recordSink;
+{
+    [self performOnControllerQueue:^{
+        // the entries are replaced rather than mutated, so a sink can be removed while the records are being dispatched
+        NSIndexSet *remainingIndexes = [self.recordSinkEntries indexesOfObjectsPassingTest:^BOOL(UHNBGMRecordSinkEntry *entry, NSUInteger idx, BOOL *stop) {
+            return (nil != entry.sink && entry.sink != recordSink);
+        }];
+        
+        self.recordSinkEntries = [self.recordSinkEntries objectsAtIndexes:remainingIndexes];
+        [self updateRecordSinkCapabilities];
+    }];
+}
+
+- (void) updateRecordSinkCapabilities;
+{
+    UHNBGMRecordCapability capabilities = 0;
+    
+    for (UHNBGMRecordSinkEntry *entry in self.recordSinkEntries)
+    {
+        capabilities |= entry.capabilities;
+    }
+    
+    self.recordSinkCapabilities = capabilities;
+}
+
+#pragma mark - Record Filter Methods
+
+- (void) setRecordFilter:(UHNBGMRecordFilter *) recordFilter;
+{
+    [self performOnControllerQueue:^{
+        _recordFilter = recordFilter;
+    }];
+}
+
+- (void) setIngestLedger:(UHNBGMIngestLedger *) ingestLedger;
+{
+    [self performOnControllerQueue:^{
+        // the measurements delivered but not yet committed were evaluated by the previous ledger
+        if (ingestLedger != _ingestLedger)
+        {
+            [self.pendingIngestCommits removeAllObjects];
+        }
+        
+        _ingestLedger = ingestLedger;
+    }];
+}
+
+#pragma mark - Record Parsing Methods
+
+- (void) enableLazyRecordParsing:(BOOL) enable;
+{
+    [self performOnControllerQueue:^{
+        self.lazyRecordParsingEnabled = enable;
+    }];
 }
 
 #pragma mark - Record Access Control Point (RACP) Methods
@@ -223,7 +634,9 @@
     
     if ([self isConnected])
     {
-        [self.bleController writeValue:command toCharacteristicUUID:kGlucoseServiceCharacteristicUUIDRecordAccessControlPoint withServiceUUID:kGlucoseServiceUUID];
+        [self performOnBLEControllerQueue:^{
+            [self.bleController writeValue:command toCharacteristicUUID:kGlucoseServiceCharacteristicUUIDRecordAccessControlPoint withServiceUUID:kGlucoseServiceUUID];
+        }];
     }
     else
     {
@@ -233,151 +646,818 @@
 
 - (void) getGlucoseFeatures;
 {
-     // get the supported features
-     [self.bleController readValueFromCharacteristicUUID:kGlucoseServiceCharacteristicUUIDSupportedFeatures withServiceUUID:kGlucoseServiceUUID];
+    [self performOnControllerQueue:^{
+        // get the supported features
+        [self performOnBLEControllerQueue:^{
+            [self.bleController readValueFromCharacteristicUUID:kGlucoseServiceCharacteristicUUIDSupportedFeatures withServiceUUID:kGlucoseServiceUUID];
+        }];
+    }];
 }
 
 - (void) getNumberOfStoredRecords;
 {
-    NSData *command = [NSData reportNumberOfAllStoredRecords];
-    [self sendRACPCommand:command];
+    [self performOnControllerQueue:^{
+        NSData *command = [NSData reportNumberOfAllStoredRecords];
+        [self sendRACPCommand:command];
+    }];
 }
 
 - (void) getAllStoredRecords;
 {
-    self.numberOfRecordsReceived = 0;
-    NSData *command = [NSData reportAllStoredRecords];
-    [self sendRACPCommand:command];
+    [self performOnControllerQueue:^{
+        if ([self isChunkedTransferInProgress])
+        {
+            DLog(@"A chunked transfer is already in progress");
+            return;
+        }
+        
+        self.numberOfRecordsReceived = 0;
+        NSData *command = [NSData reportAllStoredRecords];
+        
+        // push the sequence number bounds of the filter down to the glucose sensor, so the records outside them are not transferred
+        if (self.recordFilter && self.recordFilter.lastSequenceNumber < UINT16_MAX)
+        {
+            command = [NSData reportStoredRecordsFromSequenceNumber:self.recordFilter.firstSequenceNumber toSequenceNumber:self.recordFilter.lastSequenceNumber];
+        }
+        else if (self.recordFilter && self.recordFilter.firstSequenceNumber > 0)
+        {
+            command = [NSData reportStoredRecordsGreaterThanOrEqualToSequenceNumber:self.recordFilter.firstSequenceNumber];
+        }
+        
+        // measurements received until the procedure completes are stored records
+        self.recordTransferInProgress = [self isConnected];
+        [self sendRACPCommand:command];
+    }];
 }
 
-#pragma mark - BLE Controller Delegate Methods
+#pragma mark - Device Profile Methods
 
-- (void) bleController:(UHNBLEController *) controller didDiscoverPeripheral:(NSString *) deviceName services:(NSArray *) serviceUUIDs RSSI:(NSNumber *) RSSI;
+- (void) getDeviceProfile;
 {
-    DLog(@"Did discover glucose meter %@ (%@)", deviceName, RSSI);
-    
-    if ([self.delegate respondsToSelector: @selector(bgmController:didDiscoverGlucoseMeterWithName:services:RSSI:)])
-    {
-        [self.delegate bgmController:self didDiscoverGlucoseMeterWithName:deviceName services:serviceUUIDs RSSI:RSSI];
-    }
+    [self performOnControllerQueue:^{
+        DLog(@"%s", __PRETTY_FUNCTION__);
+        
+        UHNBGMDeviceProfile *cachedProfile = [UHNBGMDeviceProfile cachedProfileForPeripheralIdentifier:self.deviceIdentifier];
+        
+        if (cachedProfile)
+        {
+            self.deviceProfile = cachedProfile;
+            self.features = cachedProfile.features;
+            [self notifyDelegateOfDeviceProfile];
+        }
+        else
+        {
+            [self refreshDeviceProfile];
+        }
+    }];
 }
 
-- (void) bleController:(UHNBLEController *) controller didDiscoverServices:(NSArray *) serviceUUIDs;
+- (UHNBGMDeviceProfile *) deviceProfile;
 {
-    DLog(@"Did discover glucose meter services %@", serviceUUIDs);
+    __block UHNBGMDeviceProfile *deviceProfile = nil;
+    [self performOnControllerQueueAndWait:^{
+        deviceProfile = _deviceProfile;
+    }];
+    
+    return deviceProfile;
 }
 
-- (void) bleController:(UHNBLEController *) controller didConnectWithPeripheral:(NSString *) deviceName withServices:(NSArray *) services andUUID:(NSUUID *) uuid;
+- (void) refreshDeviceProfile;
 {
-    self.deviceIdentifier = uuid;
-    self.bgmDeviceName = deviceName;
-    self.shouldBlockReconnect = NO;
-    
-    DLog(@"Did connect with %@ with services: %@ and UUID: %@", deviceName, services, uuid.UUIDString);
+    [self performOnControllerQueue:^{
+        DLog(@"%s", __PRETTY_FUNCTION__);
+        
+        // a batch is already being read
+        if (self.outstandingDeviceProfileReads)
+        {
+            return;
+        }
+        
+        self.pendingDeviceProfileReads = [NSMutableArray arrayWithObject:kGlucoseServiceCharacteristicUUIDSupportedFeatures];
+        [self.pendingDeviceProfileReads addObjectsFromArray:self.deviceInformationCharacteristicUUIDs];
+        self.outstandingDeviceProfileReads = [NSMutableSet set];
+        self.deviceProfileValues = [NSMutableDictionary dictionary];
+        self.deviceProfileReadIdentifier += 1;
+        
+        // the glucose sensor may never answer a read, so deliver what was read once the batch times out
+        NSUInteger readIdentifier = self.deviceProfileReadIdentifier;
+        __weak UHNBGMController *weakSelf = self;
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t) (kDeviceProfileReadTimeout * NSEC_PER_SEC)), self.controllerQueue, ^{
+            if (readIdentifier == weakSelf.deviceProfileReadIdentifier && weakSelf.outstandingDeviceProfileReads)
+            {
+                DLog(@"Device profile reads timed out: %@", weakSelf.outstandingDeviceProfileReads);
+                [weakSelf completeDeviceProfile];
+            }
+        });
+        
+        [self sendPendingDeviceProfileReads];
+    }];
 }
 
-- (void) bleController:(UHNBLEController *) controller didDisconnectFromPeripheral:(NSString *) deviceName;
+- (void) sendPendingDeviceProfileReads;
 {
-    DLog(@"Did cancel connection or disconnect with %@", deviceName);
-    
-    // try to reconnect
-    if (!self.shouldBlockReconnect)
+    // keep the window of reads full, so the round trips overlap
+    while ([self.pendingDeviceProfileReads count] && [self.outstandingDeviceProfileReads count] < kDeviceProfileMaximumOutstandingReads)
     {
-        [self tryToReconnect];
+        NSString *characteristicUUID = self.pendingDeviceProfileReads[0];
+        [self.pendingDeviceProfileReads removeObjectAtIndex:0];
+        [self.outstandingDeviceProfileReads addObject:characteristicUUID];
+        
+        NSString *serviceUUID = ([characteristicUUID isEqualToString:kGlucoseServiceCharacteristicUUIDSupportedFeatures] ? kGlucoseServiceUUID : kDeviceInformationServiceUUID);
+        [self performOnBLEControllerQueue:^{
+            [self.bleController readValueFromCharacteristicUUID:characteristicUUID withServiceUUID:serviceUUID];
+        }];
     }
+}
+
+- (void) completeDeviceProfile;
+{
+    self.deviceProfile = [[UHNBGMDeviceProfile alloc] initWithPeripheralIdentifier:self.deviceIdentifier characteristicValues:self.deviceProfileValues];
     
-    self.shouldBlockReconnect = NO;
-    
-    if ([self.delegate respondsToSelector:@selector(bgmController:didDisconnectFromGlucoseMeter:)])
+    // a profile missing reads that timed out is delivered, but only a complete profile is served from the cache
+    if (0 == [self.outstandingDeviceProfileReads count] && 0 == [self.pendingDeviceProfileReads count])
     {
-        [self.delegate bgmController:self didDisconnectFromGlucoseMeter:self.bgmDeviceName];
+        [UHNBGMDeviceProfile cacheProfile:self.deviceProfile];
     }
+    
+    [self resetDeviceProfileReads];
+    [self notifyDelegateOfDeviceProfile];
 }
 
-- (void) bleController:(UHNBLEController *) controller failedToConnectWithPeripheral:(NSString *) deviceName;
+- (void) resetDeviceProfileReads;
 {
-    DLog(@"Failed to connect with %@", deviceName);
+    self.pendingDeviceProfileReads = nil;
+    self.outstandingDeviceProfileReads = nil;
+    self.deviceProfileValues = nil;
 }
 
-
-- (void) bleController:(UHNBLEController *) controller didDiscoverCharacteristics:(NSArray *) characteristicUUIDs forService:(NSString *) serviceUUID;
+- (void) notifyDelegateOfDeviceProfile;
 {
-    DLog(@"Characteristics %@ discovered for service %@", characteristicUUIDs, serviceUUID);
+    UHNBGMDeviceProfile *deviceProfile = self.deviceProfile;
     
-    if ([serviceUUID isEqualToString:kGlucoseServiceUUID])
-    {
-        // look for the "Glucose Measurement Context" characteristic
-        for (NSString *characteristicUUID in characteristicUUIDs)
+    [self notifyDelegate:^(id<UHNBGMControllerDelegate> delegate) {
+        if ([delegate respondsToSelector:@selector(bgmController:didGetDeviceProfile:)])
         {
-            if ([characteristicUUID isEqualToString:kGlucoseServiceCharacteristicUUIDMeasurementContext])
-            {
-                self.isGlucoseMeasurementContextSupportedBySensor = YES;
-                break;
-            }
+            [delegate bgmController:self didGetDeviceProfile:deviceProfile];
         }
+    }];
+}
+
+#pragma mark - Chunked Transfer Methods
 
-        // notify the delegate that the meter was connected
-        if ([self.delegate respondsToSelector:@selector(bgmController:didConnectToGlucoseMeterWithName:)])
+- (void) getStoredRecordsInChunksOfSize:(NSUInteger) chunkSize fromSequenceNumber:(NSUInteger) firstSequenceNumber;
+{
+    [self performOnControllerQueue:^{
+        DLog(@"%s", __PRETTY_FUNCTION__);
+        NSParameterAssert(chunkSize > 0);
+        
+        if ([self isChunkedTransferInProgress] || [self isSyncInProgress])
         {
-            [self.delegate bgmController:self didConnectToGlucoseMeterWithName:self.bgmDeviceName];
+            DLog(@"A transfer is already in progress");
+            return;
         }
-    }
+        
+        self.numberOfRecordsReceived = 0;
+        self.chunkedTransferChunkSize = MAX(chunkSize, 1);
+        self.chunkedTransferRangeSize = self.chunkedTransferChunkSize;
+        self.chunkedTransferCheckpoint = MIN(firstSequenceNumber, UINT16_MAX);
+        self.chunkedTransferNumberOfRecords = 0;
+        self.chunkedTransferNumberOfRecordsReceived = 0;
+        self.chunkedTransferNumberOfRecordsCheckpointed = 0;
+        
+        [self countRemainingChunkedTransferRecords];
+    }];
 }
 
-- (void) bleController:(UHNBLEController *) controller didUpdateNotificationState:(BOOL) notify forCharacteristic:(NSString *) characteristicUUID;
+- (BOOL) resumeChunkedTransfer;
 {
-    DLog(@"Characteristic %@ notification state is %d", characteristicUUID, notify);
+    DLog(@"%s", __PRETTY_FUNCTION__);
+    
+    __block BOOL didResume = NO;
+    [self performOnControllerQueueAndWait:^{
+        if (UHNBGMChunkedTransferStateInterrupted != self.chunkedTransferState || [self isSyncInProgress])
+        {
+            return;
+        }
+        
+        // the records of the interrupted chunk are transferred again
+        self.chunkedTransferNumberOfRecordsReceived = self.chunkedTransferNumberOfRecordsCheckpointed;
+        self.chunkedTransferRangeSize = self.chunkedTransferChunkSize;
+        [self countRemainingChunkedTransferRecords];
+        didResume = YES;
+    }];
+    
+    return didResume;
+}
 
-    // once glucose measurement notifications are set, either set glucose measurement context notifications (if they are supported) or set RACP notifications
-    if ([characteristicUUID isEqualToString:kGlucoseServiceCharacteristicUUIDMeasurement])
-    {
-        [self handleNotificationStateUpdateToGlucoseMeasurement:notify];
-    }
-    // once glucose measurement context notifications are set, set the RACP notifications
-    else if ([characteristicUUID isEqualToString:kGlucoseServiceCharacteristicUUIDMeasurementContext])
-    {
-        [self handleNotificationStateUpdateToGlucoseMeasurementContext:notify];
-    }
-    // once RACP notification is set, set notifications for GlucoseMeasurement
-    if ([characteristicUUID isEqualToString:kGlucoseServiceCharacteristicUUIDRecordAccessControlPoint])
-    {
-        [self handleNotificationStateUpdateToRACP:notify];
-    }
+- (NSUInteger) chunkedTransferCheckpoint;
+{
+    __block NSUInteger checkpoint = 0;
+    [self performOnControllerQueueAndWait:^{
+        checkpoint = _chunkedTransferCheckpoint;
+    }];
+    
+    return checkpoint;
 }
 
-- (void) bleController:(UHNBLEController *) controller didWriteValue:(NSData *) value toCharacteristic:(NSString *) charUUID;
+- (BOOL) isChunkedTransferInProgress;
 {
-    DLog(@"Characteristic %@ was written %@", charUUID, value);
+    __block BOOL isInProgress = NO;
+    [self performOnControllerQueueAndWait:^{
+        isInProgress = (UHNBGMChunkedTransferStateCounting == self.chunkedTransferState || UHNBGMChunkedTransferStateTransferring == self.chunkedTransferState);
+    }];
     
-    if ([charUUID isEqualToString:kGlucoseServiceCharacteristicUUIDRecordAccessControlPoint])
+    return isInProgress;
+}
+
+- (void) countRemainingChunkedTransferRecords;
+{
+    if (![self isConnected])
     {
-        DLog(@"RACP Characteristic was written");
+        self.chunkedTransferState = UHNBGMChunkedTransferStateInterrupted;
+        return;
     }
+    
+    self.chunkedTransferState = UHNBGMChunkedTransferStateCounting;
+    [self sendRACPCommand:[NSData reportNumberOfStoredRecordsGreaterThanOrEqualToSequenceNumber:self.chunkedTransferCheckpoint]];
 }
 
-- (void) bleController:(UHNBLEController *) controller didUpdateValue:(NSData *) value forCharacteristic:(NSString *) charUUID;
+- (void) transferNextChunk;
 {
-    DLog(@"Characteristic %@ did update %@", charUUID, value);
+    NSUInteger lastSequenceNumber = MIN(self.chunkedTransferCheckpoint + self.chunkedTransferRangeSize - 1, UINT16_MAX);
+    
+    self.chunkedTransferState = UHNBGMChunkedTransferStateTransferring;
+    self.recordTransferInProgress = YES;
+    [self sendRACPCommand:[NSData reportStoredRecordsFromSequenceNumber:self.chunkedTransferCheckpoint toSequenceNumber:lastSequenceNumber]];
+}
 
-    if ([charUUID isEqualToString:kGlucoseServiceCharacteristicUUIDSupportedFeatures])
-    {
-        [self handleCharacteristicUpdateToSupportedFeatures:value];
-    }
-    else if ([charUUID isEqualToString:kGlucoseServiceCharacteristicUUIDMeasurement])
-    {
-        [self handleCharacteristicUpdateToGlucoseMeasurement:value];
-    }
-    else if ([charUUID isEqualToString:kGlucoseServiceCharacteristicUUIDMeasurementContext])
+- (void) handleChunkedTransferNumberOfRecords:(NSUInteger) numberOfRecords;
+{
+    // the total includes the records checkpointed before an interruption
+    self.chunkedTransferNumberOfRecords = self.chunkedTransferNumberOfRecordsCheckpointed + numberOfRecords;
+    
+    if (0 == numberOfRecords)
     {
-        [self handleCharacteristicUpdateToGlucoseMeasurementContext:value];
+        [self completeChunkedTransfer];
     }
-    else if ([charUUID isEqualToString:kGlucoseServiceCharacteristicUUIDRecordAccessControlPoint])
+    else
     {
-        [self handleCharacteristicUpdateToRACP:value];
+        [self transferNextChunk];
     }
 }
 
-#pragma mark - BLE Notification State Update Handlers
+- (void) handleChunkedTransferRACPResponse:(RACPResponseCode) responseCode forRequestOpCode:(RACPOpCode) requestOpCode;
+{
+    if (UHNBGMChunkedTransferStateTransferring != self.chunkedTransferState || RACPOpCodeStoredRecordsReport != requestOpCode)
+    {
+        // the count was refused, so the chunks cannot be tracked
+        self.chunkedTransferState = UHNBGMChunkedTransferStateInterrupted;
+        
+        [self notifyDelegate:^(id<UHNBGMControllerDelegate> delegate) {
+            if ([delegate respondsToSelector:@selector(racpController:RACPOperation:failed:)])
+            {
+                [delegate racpController:self RACPOperation:requestOpCode failed:responseCode];
+            }
+        }];
+        
+        return;
+    }
+    
+    if (RACPSuccess != responseCode && kGlucoseRACPResponseCodeNoRecordsFound != responseCode)
+    {
+        self.chunkedTransferState = UHNBGMChunkedTransferStateInterrupted;
+        
+        [self notifyDelegate:^(id<UHNBGMControllerDelegate> delegate) {
+            if ([delegate respondsToSelector:@selector(racpController:RACPOperation:failed:)])
+            {
+                [delegate racpController:self RACPOperation:requestOpCode failed:responseCode];
+            }
+        }];
+        
+        return;
+    }
+    
+    // the chunk is complete, even if there was a gap in the sequence numbers
+    NSUInteger lastSequenceNumber = MIN(self.chunkedTransferCheckpoint + self.chunkedTransferRangeSize - 1, UINT16_MAX);
+    self.chunkedTransferCheckpoint = lastSequenceNumber + 1;
+    self.chunkedTransferNumberOfRecordsCheckpointed = self.chunkedTransferNumberOfRecordsReceived;
+    
+    float progress = MIN((float) self.chunkedTransferNumberOfRecordsCheckpointed / MAX(self.chunkedTransferNumberOfRecords, 1), 1.f);
+    
+    [self notifyDelegate:^(id<UHNBGMControllerDelegate> delegate) {
+        if ([delegate respondsToSelector:@selector(bgmController:didTransferRecordsUpToSequenceNumber:progress:)])
+        {
+            [delegate bgmController:self didTransferRecordsUpToSequenceNumber:lastSequenceNumber progress:progress];
+        }
+    }];
+    
+    if (self.chunkedTransferNumberOfRecordsCheckpointed >= self.chunkedTransferNumberOfRecords || lastSequenceNumber >= UINT16_MAX)
+    {
+        [self completeChunkedTransfer];
+    }
+    else if (kGlucoseRACPResponseCodeNoRecordsFound == responseCode)
+    {
+        // the records counted were lost, or lie past a gap in the sequence numbers: count again, so the transfer completes if none are left,
+        // and widen the next range, so a gap takes a few requests rather than one per chunk
+        self.chunkedTransferRangeSize = MIN(self.chunkedTransferRangeSize * 2, UINT16_MAX);
+        [self countRemainingChunkedTransferRecords];
+    }
+    else
+    {
+        self.chunkedTransferRangeSize = self.chunkedTransferChunkSize;
+        [self transferNextChunk];
+    }
+}
+
+- (void) completeChunkedTransfer;
+{
+    self.chunkedTransferState = UHNBGMChunkedTransferStateIdle;
+    self.recordTransferInProgress = NO;
+    [self notifyTransferCompleteWithNumberOfRecords:self.numberOfRecordsReceived];
+}
+
+#pragma mark - Confirmed Sync Methods
+
+- (void) syncStoredRecordsFromSequenceNumber:(NSUInteger) firstSequenceNumber toSequenceNumber:(NSUInteger) lastSequenceNumber commitHandler:(UHNBGMSyncCommitHandler) commitHandler;
+{
+    [self performOnControllerQueue:^{
+        DLog(@"%s", __PRETTY_FUNCTION__);
+        NSParameterAssert(commitHandler);
+        
+        if (UHNBGMSyncStateIdle != self.syncState || [self isChunkedTransferInProgress])
+        {
+            DLog(@"A sync or a chunked transfer is already in progress");
+            return;
+        }
+        
+        self.syncIdentifier += 1;
+        self.syncRequestedFirstSequenceNumber = MIN(firstSequenceNumber, UINT16_MAX);
+        self.syncRequestedLastSequenceNumber = MIN(lastSequenceNumber, UINT16_MAX);
+        self.syncMeasurements = [NSMutableArray array];
+        self.syncMeasurementContexts = [NSMutableArray array];
+        self.syncCommitHandler = commitHandler;
+        self.syncState = UHNBGMSyncStateTransferring;
+        
+        if (![self isConnected])
+        {
+            [self failSyncWithRecordsCommitted:NO];
+            return;
+        }
+        
+        self.numberOfRecordsReceived = 0;
+        NSData *command = [NSData reportStoredRecordsFromSequenceNumber:self.syncRequestedFirstSequenceNumber
+                                                       toSequenceNumber:self.syncRequestedLastSequenceNumber];
+        [self sendRACPCommand:command];
+    }];
+}
+
+- (BOOL) isSyncInProgress;
+{
+    __block BOOL isInProgress = NO;
+    [self performOnControllerQueueAndWait:^{
+        isInProgress = (UHNBGMSyncStateIdle != self.syncState);
+    }];
+    
+    return isInProgress;
+}
+
+- (void) commitSyncedRecords;
+{
+    // the committed records are what was actually received, limited to what was requested
+    NSMutableIndexSet *sequenceNumbers = [NSMutableIndexSet indexSet];
+    
+    for (NSDictionary *measurementDetails in self.syncMeasurements)
+    {
+        NSUInteger sequenceNumber = [measurementDetails[kGlucoseMeasurementKeySequenceNumber] unsignedIntegerValue];
+        
+        if (sequenceNumber < self.syncRequestedFirstSequenceNumber || sequenceNumber > self.syncRequestedLastSequenceNumber)
+        {
+            continue;
+        }
+        
+        [sequenceNumbers addIndex:sequenceNumber];
+    }
+    
+    if (0 == [sequenceNumbers count])
+    {
+        [self completeSyncWithNumberOfRecords:0];
+        return;
+    }
+    
+    // a record lost in the transfer was never committed, so each contiguous run is deleted on its own
+    self.syncPendingDeleteRanges = [NSMutableArray array];
+    [sequenceNumbers enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+        [self.syncPendingDeleteRanges addObject:[NSValue valueWithRange:range]];
+    }];
+    
+    self.syncCommittedFirstSequenceNumber = [sequenceNumbers firstIndex];
+    self.syncCommittedLastSequenceNumber = [sequenceNumbers lastIndex];
+    self.syncState = UHNBGMSyncStateCommitting;
+    
+    // the commit completion may be called at any time, so make sure it still belongs to this sync
+    __weak UHNBGMController *weakSelf = self;
+    NSUInteger syncIdentifier = self.syncIdentifier;
+    UHNBGMSyncCommitCompletion completion = ^(BOOL committed) {
+        [weakSelf performOnControllerQueue:^{
+            [weakSelf handleSyncCommit:committed forSyncIdentifier:syncIdentifier];
+        }];
+    };
+    
+    // the records are committed on the delegate queue, like every other callback
+    UHNBGMSyncCommitHandler commitHandler = self.syncCommitHandler;
+    NSArray *measurements = [self.syncMeasurements copy];
+    NSArray *measurementContexts = [self.syncMeasurementContexts copy];
+    [self.deliveryLane deliver:^{
+        commitHandler(measurements, measurementContexts, completion);
+    } isLive:NO];
+}
+
+- (void) handleSyncCommit:(BOOL) committed forSyncIdentifier:(NSUInteger) syncIdentifier;
+{
+    if (syncIdentifier != self.syncIdentifier || UHNBGMSyncStateCommitting != self.syncState)
+    {
+        DLog(@"Ignoring the commit of a sync that is no longer in progress");
+        return;
+    }
+    
+    if (!committed || ![self isConnected])
+    {
+        [self failSyncWithRecordsCommitted:committed];
+        return;
+    }
+    
+    // only now that the records are safe, delete exactly the committed records
+    self.syncState = UHNBGMSyncStateDeleting;
+    [self deleteNextCommittedRange];
+}
+
+- (void) deleteNextCommittedRange;
+{
+    NSRange range = [self.syncPendingDeleteRanges[0] rangeValue];
+    [self.syncPendingDeleteRanges removeObjectAtIndex:0];
+    
+    NSData *command = [NSData deleteStoredRecordsFromSequenceNumber:range.location
+                                                   toSequenceNumber:(NSMaxRange(range) - 1)];
+    [self sendRACPCommand:command];
+}
+
+- (void) handleSyncRACPResponse:(RACPResponseCode) responseCode forRequestOpCode:(RACPOpCode) requestOpCode;
+{
+    if (UHNBGMSyncStateTransferring == self.syncState && RACPOpCodeStoredRecordsReport == requestOpCode)
+    {
+        if (RACPSuccess == responseCode)
+        {
+            [self commitSyncedRecords];
+        }
+        else if (kGlucoseRACPResponseCodeNoRecordsFound == responseCode)
+        {
+            [self completeSyncWithNumberOfRecords:0];
+        }
+        else
+        {
+            [self failSyncWithRecordsCommitted:NO];
+        }
+    }
+    else if (UHNBGMSyncStateDeleting == self.syncState && kGlucoseRACPOpCodeDeleteStoredRecords == requestOpCode)
+    {
+        if (RACPSuccess == responseCode && [self.syncPendingDeleteRanges count])
+        {
+            [self deleteNextCommittedRange];
+        }
+        else if (RACPSuccess == responseCode)
+        {
+            [self completeSyncWithNumberOfRecords:[self.syncMeasurements count]];
+        }
+        else
+        {
+            [self failSyncWithRecordsCommitted:YES];
+        }
+    }
+}
+
+- (void) completeSyncWithNumberOfRecords:(NSUInteger) numberOfRecords;
+{
+    NSUInteger firstSequenceNumber = self.syncCommittedFirstSequenceNumber;
+    NSUInteger lastSequenceNumber = self.syncCommittedLastSequenceNumber;
+    
+    if (0 == numberOfRecords)
+    {
+        firstSequenceNumber = self.syncRequestedFirstSequenceNumber;
+        lastSequenceNumber = self.syncRequestedLastSequenceNumber;
+    }
+    
+    [self resetSync];
+    
+    [self notifyDelegate:^(id<UHNBGMControllerDelegate> delegate) {
+        if ([delegate respondsToSelector:@selector(bgmController:didCompleteSyncOfRecordsFromSequenceNumber:toSequenceNumber:numberOfRecords:)])
+        {
+            [delegate bgmController:self didCompleteSyncOfRecordsFromSequenceNumber:firstSequenceNumber toSequenceNumber:lastSequenceNumber numberOfRecords:numberOfRecords];
+        }
+    }];
+}
+
+- (void) failSyncWithRecordsCommitted:(BOOL) committed;
+{
+    DLog(@"Sync failed, records committed: %d", committed);
+    
+    [self resetSync];
+    
+    [self notifyDelegate:^(id<UHNBGMControllerDelegate> delegate) {
+        if ([delegate respondsToSelector:@selector(bgmController:didFailSyncWithRecordsCommitted:)])
+        {
+            [delegate bgmController:self didFailSyncWithRecordsCommitted:committed];
+        }
+    }];
+}
+
+- (void) resetSync;
+{
+    self.syncState = UHNBGMSyncStateIdle;
+    self.syncMeasurements = nil;
+    self.syncMeasurementContexts = nil;
+    self.syncCommitHandler = nil;
+    self.syncCommittedFirstSequenceNumber = 0;
+    self.syncCommittedLastSequenceNumber = 0;
+    self.syncPendingDeleteRanges = nil;
+}
+
+#pragma mark - Live Measurement Methods
+
+- (void) setHypoglycemiaThreshold:(double) hypoglycemiaThreshold hyperglycemiaThreshold:(double) hyperglycemiaThreshold;
+{
+    [self performOnControllerQueue:^{
+        // mg/dL to kg/L is 1e-5, mg/dL to mol/L is 10 / molar mass in mg/mol
+        self.hypoglycemiaThresholdKgPerL = (hypoglycemiaThreshold > 0 ? hypoglycemiaThreshold * 1e-5 : -INFINITY);
+        self.hyperglycemiaThresholdKgPerL = (hyperglycemiaThreshold > 0 ? hyperglycemiaThreshold * 1e-5 : INFINITY);
+        self.hypoglycemiaThresholdMolPerL = (hypoglycemiaThreshold > 0 ? hypoglycemiaThreshold * 10. / (kGlucoseMolarMass * 1000.) : -INFINITY);
+        self.hyperglycemiaThresholdMolPerL = (hyperglycemiaThreshold > 0 ? hyperglycemiaThreshold * 10. / (kGlucoseMolarMass * 1000.) : INFINITY);
+        self.glucoseAlertsEnabled = (hypoglycemiaThreshold > 0 || hyperglycemiaThreshold > 0);
+    }];
+}
+
+- (BOOL) isRecordTransferInProgress;
+{
+    __block BOOL isInProgress = NO;
+    [self performOnControllerQueueAndWait:^{
+        isInProgress = (self.recordTransferInProgress || [self isChunkedTransferInProgress] || UHNBGMSyncStateTransferring == self.syncState);
+    }];
+    
+    return isInProgress;
+}
+
+- (UHNBGMGlucoseAlert) glucoseAlertForMeasurementData:(NSData *) value;
+{
+    if (!self.glucoseAlertsEnabled)
+    {
+        return UHNBGMGlucoseAlertNone;
+    }
+    
+    // read only the glucose concentration from the raw value
+    const UHNBGMFieldLayout *layout = UHNBGMMeasurementFieldLayout();
+    const uint8_t *bytes = [value bytes];
+    
+    if ([value length] < layout->fixedLength || [value length] < layout->requiredLengths[bytes[0]])
+    {
+        return UHNBGMGlucoseAlertNone;
+    }
+    
+    uint8_t offset = UHNBGMFieldOffset(layout, bytes[0], GlucoseMeasurementFieldGlucoseConcentration);
+    
+    if (kUHNBGMFieldAbsent == offset)
+    {
+        return UHNBGMGlucoseAlertNone;
+    }
+    
+    float glucoseConcentration = UHNBGMShortFloatValue(UHNBGMFieldIntegerValue(layout, bytes, offset, GlucoseMeasurementFieldGlucoseConcentration));
+    BOOL isMolPerL = (bytes[0] & GlucoseMeasurementFlagGlucoseConcentrationUnits);
+    
+    if (glucoseConcentration <= (isMolPerL ? self.hypoglycemiaThresholdMolPerL : self.hypoglycemiaThresholdKgPerL))
+    {
+        return UHNBGMGlucoseAlertHypoglycemia;
+    }
+    
+    if (glucoseConcentration >= (isMolPerL ? self.hyperglycemiaThresholdMolPerL : self.hyperglycemiaThresholdKgPerL))
+    {
+        return UHNBGMGlucoseAlertHyperglycemia;
+    }
+    
+    return UHNBGMGlucoseAlertNone;
+}
+
+#pragma mark - Traffic Capture Methods
+
+- (BOOL) startCapturingTrafficToFileAtPath:(NSString *) path;
+{
+    __block BOOL didStart = NO;
+    [self performOnControllerQueueAndWait:^{
+        [self stopCapturingTraffic];
+        self.trafficRecorder = [[UHNBGMTrafficRecorder alloc] initWithPath:path];
+        didStart = (nil != self.trafficRecorder);
+    }];
+    
+    return didStart;
+}
+
+- (void) stopCapturingTraffic;
+{
+    [self performOnControllerQueue:^{
+        [self.trafficRecorder close];
+        self.trafficRecorder = nil;
+    }];
+}
+
+#pragma mark - BLE Controller Delegate Methods
+
+- (void) bleController:(UHNBLEController *) controller didDiscoverPeripheral:(NSString *) deviceName services:(NSArray *) serviceUUIDs RSSI:(NSNumber *) RSSI;
+{
+    [self performOnControllerQueue:^{
+        DLog(@"Did discover glucose meter %@ (%@)", deviceName, RSSI);
+        
+        [self notifyDelegate:^(id<UHNBGMControllerDelegate> delegate) {
+            if ([delegate respondsToSelector:@selector(bgmController:didDiscoverGlucoseMeterWithName:services:RSSI:)])
+            {
+                [delegate bgmController:self didDiscoverGlucoseMeterWithName:deviceName services:serviceUUIDs RSSI:RSSI];
+            }
+        }];
+    }];
+}
+
+- (void) bleController:(UHNBLEController *) controller didDiscoverServices:(NSArray *) serviceUUIDs;
+{
+    DLog(@"Did discover glucose meter services %@", serviceUUIDs);
+}
+
+- (void) bleController:(UHNBLEController *) controller didConnectWithPeripheral:(NSString *) deviceName withServices:(NSArray *) services andUUID:(NSUUID *) uuid;
+{
+    [self performOnControllerQueue:^{
+        self.deviceIdentifier = uuid;
+        self.bgmDeviceName = deviceName;
+        self.peripheralConnected = YES;
+        self.shouldBlockReconnect = NO;
+        
+        DLog(@"Did connect with %@ with services: %@ and UUID: %@", deviceName, services, uuid.UUIDString);
+    }];
+}
+
+- (void) bleController:(UHNBLEController *) controller didDisconnectFromPeripheral:(NSString *) deviceName;
+{
+    [self performOnControllerQueue:^{
+        DLog(@"Did cancel connection or disconnect with %@", deviceName);
+        
+        // the connection state is mirrored from the BLE controller callbacks, so it can be read without leaving the controller queue
+        self.peripheralConnected = NO;
+        
+        // try to reconnect
+        if (!self.shouldBlockReconnect)
+        {
+            [self tryToReconnect];
+        }
+        
+        self.shouldBlockReconnect = NO;
+        self.recordTransferInProgress = NO;
+        
+        // the reads of a device profile batch will not complete
+        [self resetDeviceProfileReads];
+        
+        // a chunked transfer can be resumed from its last checkpoint once reconnected
+        if ([self isChunkedTransferInProgress])
+        {
+            self.chunkedTransferState = UHNBGMChunkedTransferStateInterrupted;
+        }
+        
+        // a sync waiting on a commit will fail once the commit completes, as the delete can no longer be sent
+        if (UHNBGMSyncStateTransferring == self.syncState || UHNBGMSyncStateDeleting == self.syncState)
+        {
+            [self failSyncWithRecordsCommitted:(UHNBGMSyncStateDeleting == self.syncState)];
+        }
+        
+        NSString *bgmDeviceName = self.bgmDeviceName;
+        
+        [self notifyDelegate:^(id<UHNBGMControllerDelegate> delegate) {
+            if ([delegate respondsToSelector:@selector(bgmController:didDisconnectFromGlucoseMeter:)])
+            {
+                [delegate bgmController:self didDisconnectFromGlucoseMeter:bgmDeviceName];
+            }
+        }];
+    }];
+}
+
+- (void) bleController:(UHNBLEController *) controller failedToConnectWithPeripheral:(NSString *) deviceName;
+{
+    [self performOnControllerQueue:^{
+        DLog(@"Failed to connect with %@", deviceName);
+        
+        self.peripheralConnected = NO;
+    }];
+}
+
+
+- (void) bleController:(UHNBLEController *) controller didDiscoverCharacteristics:(NSArray *) characteristicUUIDs forService:(NSString *) serviceUUID;
+{
+    [self performOnControllerQueue:^{
+        DLog(@"Characteristics %@ discovered for service %@", characteristicUUIDs, serviceUUID);
+        
+        if ([serviceUUID isEqualToString:kDeviceInformationServiceUUID])
+        {
+            // only read the device information the glucose sensor provides
+            NSArray *profileCharacteristicUUIDs = @[kDeviceInformationCharacteristicUUIDModelNumber, kDeviceInformationCharacteristicUUIDSerialNumber, kDeviceInformationCharacteristicUUIDFirmwareRevision, kDeviceInformationCharacteristicUUIDSystemID];
+            self.deviceInformationCharacteristicUUIDs = [profileCharacteristicUUIDs filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"SELF IN %@", characteristicUUIDs]];
+        }
+        else if ([serviceUUID isEqualToString:kGlucoseServiceUUID])
+        {
+            // look for the "Glucose Measurement Context" characteristic
+            for (NSString *characteristicUUID in characteristicUUIDs)
+            {
+                if ([characteristicUUID isEqualToString:kGlucoseServiceCharacteristicUUIDMeasurementContext])
+                {
+                    self.isGlucoseMeasurementContextSupportedBySensor = YES;
+                    break;
+                }
+            }
+
+            // notify the delegate that the meter was connected
+            NSString *bgmDeviceName = self.bgmDeviceName;
+            
+            [self notifyDelegate:^(id<UHNBGMControllerDelegate> delegate) {
+                if ([delegate respondsToSelector:@selector(bgmController:didConnectToGlucoseMeterWithName:)])
+                {
+                    [delegate bgmController:self didConnectToGlucoseMeterWithName:bgmDeviceName];
+                }
+            }];
+        }
+    }];
+}
+
+- (void) bleController:(UHNBLEController *) controller didUpdateNotificationState:(BOOL) notify forCharacteristic:(NSString *) characteristicUUID;
+{
+    [self performOnControllerQueue:^{
+        DLog(@"Characteristic %@ notification state is %d", characteristicUUID, notify);
+
+        // once glucose measurement notifications are set, either set glucose measurement context notifications (if they are supported) or set RACP notifications
+        if ([characteristicUUID isEqualToString:kGlucoseServiceCharacteristicUUIDMeasurement])
+        {
+            [self handleNotificationStateUpdateToGlucoseMeasurement:notify];
+        }
+        // once glucose measurement context notifications are set, set the RACP notifications
+        else if ([characteristicUUID isEqualToString:kGlucoseServiceCharacteristicUUIDMeasurementContext])
+        {
+            [self handleNotificationStateUpdateToGlucoseMeasurementContext:notify];
+        }
+        // once RACP notification is set, set notifications for GlucoseMeasurement
+        if ([characteristicUUID isEqualToString:kGlucoseServiceCharacteristicUUIDRecordAccessControlPoint])
+        {
+            [self handleNotificationStateUpdateToRACP:notify];
+        }
+    }];
+}
+
+- (void) bleController:(UHNBLEController *) controller didWriteValue:(NSData *) value toCharacteristic:(NSString *) charUUID;
+{
+    [self performOnControllerQueue:^{
+        DLog(@"Characteristic %@ was written %@", charUUID, value);
+        
+        [self.trafficRecorder recordValue:value forCharacteristic:charUUID written:YES];
+        
+        if ([charUUID isEqualToString:kGlucoseServiceCharacteristicUUIDRecordAccessControlPoint])
+        {
+            DLog(@"RACP Characteristic was written");
+        }
+    }];
+}
+
+- (void) bleController:(UHNBLEController *) controller didUpdateValue:(NSData *) value forCharacteristic:(NSString *) charUUID;
+{
+    [self performOnControllerQueue:^{
+        DLog(@"Characteristic %@ did update %@", charUUID, value);
+        
+        [self.trafficRecorder recordValue:value forCharacteristic:charUUID written:NO];
+
+        if ([self.outstandingDeviceProfileReads containsObject:charUUID])
+        {
+            [self handleCharacteristicUpdateToDeviceProfile:value forCharacteristic:charUUID];
+        }
+        
+        switch (UHNBGMGlucoseServiceCharacteristicForUUID(charUUID))
+        {
+            case GlucoseServiceCharacteristicSupportedFeatures:
+                [self handleCharacteristicUpdateToSupportedFeatures:value];
+                break;
+            case GlucoseServiceCharacteristicMeasurement:
+                [self handleCharacteristicUpdateToGlucoseMeasurement:value];
+                break;
+            case GlucoseServiceCharacteristicMeasurementContext:
+                [self handleCharacteristicUpdateToGlucoseMeasurementContext:value];
+                break;
+            case GlucoseServiceCharacteristicRecordAccessControlPoint:
+                [self handleCharacteristicUpdateToRACP:value];
+                break;
+            default:
+                break;
+        }
+    }];
+}
+
+#pragma mark - BLE Notification State Update Handlers
 
 - (void) handleNotificationStateUpdateToGlucoseMeasurement:(BOOL) notify;
 {
@@ -387,21 +1467,27 @@
         // if glucose measurement context is supported, then set the notifications for it
         if (self.isGlucoseMeasurementContextSupportedBySensor)
         {
-            [self.bleController setNotificationState:notify forCharacteristicUUID:kGlucoseServiceCharacteristicUUIDMeasurementContext withServiceUUID:kGlucoseServiceUUID];
+            [self performOnBLEControllerQueue:^{
+                [self.bleController setNotificationState:notify forCharacteristicUUID:kGlucoseServiceCharacteristicUUIDMeasurementContext withServiceUUID:kGlucoseServiceUUID];
+            }];
         }
         // otherwise go straight to setting the RACP notifications
         else
         {
-            [self.bleController setNotificationState:notify forCharacteristicUUID:kGlucoseServiceCharacteristicUUIDRecordAccessControlPoint withServiceUUID:kGlucoseServiceUUID];
+            [self performOnBLEControllerQueue:^{
+                [self.bleController setNotificationState:notify forCharacteristicUUID:kGlucoseServiceCharacteristicUUIDRecordAccessControlPoint withServiceUUID:kGlucoseServiceUUID];
+            }];
         }
     }
     // otherwise enable one at a time and inform the delegate as they are enabled
     else
     {
-        if ([self.delegate respondsToSelector:@selector(bgmController:didSetNotificationStateGlucoseMeasurement:)])
-        {
-            [self.delegate bgmController:self didSetNotificationStateGlucoseMeasurement:notify];
-        }
+        [self notifyDelegate:^(id<UHNBGMControllerDelegate> delegate) {
+            if ([delegate respondsToSelector:@selector(bgmController:didSetNotificationStateGlucoseMeasurement:)])
+            {
+                [delegate bgmController:self didSetNotificationStateGlucoseMeasurement:notify];
+            }
+        }];
     }
 }
 
@@ -410,15 +1496,19 @@
     // if we need to enable all notifications, then enable them all
     if (self.enableAllNotifications)
     {
-        [self.bleController setNotificationState:notify forCharacteristicUUID:kGlucoseServiceCharacteristicUUIDRecordAccessControlPoint withServiceUUID:kGlucoseServiceUUID];
+        [self performOnBLEControllerQueue:^{
+            [self.bleController setNotificationState:notify forCharacteristicUUID:kGlucoseServiceCharacteristicUUIDRecordAccessControlPoint withServiceUUID:kGlucoseServiceUUID];
+        }];
     }
     // otherwise enable one at a time and inform the delegate as they are enabled
     else
     {
-        if ([self.delegate respondsToSelector:@selector(bgmController:didSetNotificationStateGlucoseMeasurementContext:)])
-        {
-            [self.delegate bgmController:self didSetNotificationStateGlucoseMeasurementContext:notify];
-        }
+        [self notifyDelegate:^(id<UHNBGMControllerDelegate> delegate) {
+            if ([delegate respondsToSelector:@selector(bgmController:didSetNotificationStateGlucoseMeasurementContext:)])
+            {
+                [delegate bgmController:self didSetNotificationStateGlucoseMeasurementContext:notify];
+            }
+        }];
     }
 }
 
@@ -429,56 +1519,213 @@
         // turn off enable all notifications
         self.enableAllNotifications = NO;
         
-        if ([self.delegate respondsToSelector:@selector(bgmController:didSetNotificationStateForAllNotifications:)])
-        {
-            [self.delegate bgmController:self didSetNotificationStateForAllNotifications:notify];
-        }
+        [self notifyDelegate:^(id<UHNBGMControllerDelegate> delegate) {
+            if ([delegate respondsToSelector:@selector(bgmController:didSetNotificationStateForAllNotifications:)])
+            {
+                [delegate bgmController:self didSetNotificationStateForAllNotifications:notify];
+            }
+        }];
     }
     else
     {
-        if ([self.delegate respondsToSelector:@selector(racpController:didSetNotificationStateRACP:)])
-        {
-            [self.delegate racpController:self didSetNotificationStateRACP:notify];
-        }
+        [self notifyDelegate:^(id<UHNBGMControllerDelegate> delegate) {
+            if ([delegate respondsToSelector:@selector(racpController:didSetNotificationStateRACP:)])
+            {
+                [delegate racpController:self didSetNotificationStateRACP:notify];
+            }
+        }];
     }
 }
 
 #pragma mark - BLE Characteristic Update Handlers
 
+- (void) handleCharacteristicUpdateToDeviceProfile:(NSData *) value forCharacteristic:(NSString *) characteristicUUID;
+{
+    [self.outstandingDeviceProfileReads removeObject:characteristicUUID];
+    self.deviceProfileValues[characteristicUUID] = value;
+    
+    if ([self.outstandingDeviceProfileReads count] || [self.pendingDeviceProfileReads count])
+    {
+        [self sendPendingDeviceProfileReads];
+    }
+    else
+    {
+        [self completeDeviceProfile];
+    }
+}
+
 - (void) handleCharacteristicUpdateToSupportedFeatures:(NSData *) value;
 {
     // store the enabled features
     self.features = [value unsignedIntegerAtRange:NSMakeRange(0, 2)];
     
     // once the delegate gets this response, it can check the supported features
-    if ([self.delegate respondsToSelector:@selector(bgmControllerDidGetSupportedFeatures:)])
-    {
-        [self.delegate bgmControllerDidGetSupportedFeatures:self];
-    }
+    [self notifyDelegate:^(id<UHNBGMControllerDelegate> delegate) {
+        if ([delegate respondsToSelector:@selector(bgmControllerDidGetSupportedFeatures:)])
+        {
+            [delegate bgmControllerDidGetSupportedFeatures:self];
+        }
+    }];
 }
 
 - (void) handleCharacteristicUpdateToGlucoseMeasurement:(NSData *) value;
 {
-    if ([self.delegate respondsToSelector:@selector(bgmController:didGetGlucoseMeasurementAtIndex:withDetails:)])
+    BOOL isSyncTransferring = (UHNBGMSyncStateTransferring == self.syncState);
+    
+    // a record that is filtered out or received again still counts towards its chunk, but is not delivered
+    if (UHNBGMChunkedTransferStateTransferring == self.chunkedTransferState)
+    {
+        self.chunkedTransferNumberOfRecordsReceived += 1;
+    }
+    
+    // discard the records the app does not want before parsing them
+    if (!isSyncTransferring && self.recordFilter && ![self.recordFilter shouldDeliverMeasurementData:value])
+    {
+        return;
+    }
+    
+    if (!isSyncTransferring && self.ingestLedger && ![self.ingestLedger shouldIngestMeasurementData:value fromPeripheralWithIdentifier:self.deviceIdentifier])
+    {
+        return;
+    }
+    
+    BOOL isDelegateInterested = (self.delegateCapabilities & UHNBGMRecordCapabilityMeasurement);
+    BOOL areSinksInterested = (self.recordSinkCapabilities & UHNBGMRecordCapabilityMeasurement);
+    
+    // a measurement received outside of a transfer of stored records was just taken
+    BOOL isLiveDelegateInterested = (![self isRecordTransferInProgress] && (self.delegateCapabilities & UHNBGMRecordCapabilityLiveMeasurement));
+    
+    if (isSyncTransferring || isDelegateInterested || areSinksInterested || isLiveDelegateInterested)
     {
         DLog(@"Did get data %@", value);
         
         self.numberOfRecordsReceived += 1;
-        NSDictionary *glucoseMeasurementDetails = [value parseGlucoseMeasurementCharacteristicDetails:self.crcCheckingEnabled];
+        NSDictionary *glucoseMeasurementDetails = nil;
+        
+        if (self.lazyRecordParsingEnabled)
+        {
+            glucoseMeasurementDetails = [value lazilyParseGlucoseMeasurementCharacteristicDetails:self.crcCheckingEnabled];
+        }
+        else
+        {
+            glucoseMeasurementDetails = [value parseGlucoseMeasurementCharacteristicDetails:self.crcCheckingEnabled];
+        }
+        
         NSNumber *sequenceNumber = (NSNumber *) glucoseMeasurementDetails[kGlucoseMeasurementKeySequenceNumber];
-        [self.delegate bgmController:self didGetGlucoseMeasurementAtIndex:[sequenceNumber integerValue] withDetails:glucoseMeasurementDetails];
+        
+        if (isSyncTransferring)
+        {
+            [self.syncMeasurements addObject:glucoseMeasurementDetails];
+        }
+        
+        if (!isDelegateInterested && !areSinksInterested && !isLiveDelegateInterested)
+        {
+            return;
+        }
+        
+        // the record is handed to the delegate and the sinks with a single hop to the delegate queue
+        id<UHNBGMControllerDelegate> delegate = self.delegate;
+        NSArray *recordSinkEntries = (areSinksInterested ? self.recordSinkEntries : nil);
+        
+        // the measurement is committed to the ledger with the next transfer complete notification, once the sinks persisted it
+        if (!isSyncTransferring && self.ingestLedger)
+        {
+            [self.pendingIngestCommits addObject:@[value, (self.deviceIdentifier ?: [NSNull null])]];
+        }
+        
+        // live measurements are reported ahead of any callbacks still waiting for the delegate queue
+        if (isLiveDelegateInterested)
+        {
+            UHNBGMGlucoseAlert alert = [self glucoseAlertForMeasurementData:value];
+            [self.deliveryLane deliver:^{
+                [delegate bgmController:self didGetLiveGlucoseMeasurement:glucoseMeasurementDetails alert:alert];
+            } isLive:YES];
+        }
+        
+        if (!isDelegateInterested && !areSinksInterested)
+        {
+            return;
+        }
+        
+        [self.deliveryLane deliver:^{
+            if (isDelegateInterested)
+            {
+                [delegate bgmController:self didGetGlucoseMeasurementAtIndex:[sequenceNumber integerValue] withDetails:glucoseMeasurementDetails];
+            }
+            
+            // every sink gets the same record
+            for (UHNBGMRecordSinkEntry *entry in recordSinkEntries)
+            {
+                if (entry.capabilities & UHNBGMRecordCapabilityMeasurement)
+                {
+                    [entry.sink bgmController:self didReceiveGlucoseMeasurement:glucoseMeasurementDetails];
+                }
+            }
+        } isLive:NO];
     }
 }
 
 - (void) handleCharacteristicUpdateToGlucoseMeasurementContext:(NSData *) value;
 {
-    if ([self.delegate respondsToSelector:@selector(bgmController:didGetGlucoseMeasurementContextAtIndex:withDetails:)])
+    BOOL isSyncTransferring = (UHNBGMSyncStateTransferring == self.syncState);
+    
+    if (!isSyncTransferring && self.recordFilter && ![self.recordFilter shouldDeliverMeasurementContextData:value])
+    {
+        return;
+    }
+    
+    if (!isSyncTransferring && self.ingestLedger && ![self.ingestLedger shouldIngestMeasurementContextData:value fromPeripheralWithIdentifier:self.deviceIdentifier])
+    {
+        return;
+    }
+    
+    BOOL isDelegateInterested = (self.delegateCapabilities & UHNBGMRecordCapabilityMeasurementContext);
+    BOOL areSinksInterested = (self.recordSinkCapabilities & UHNBGMRecordCapabilityMeasurementContext);
+    
+    if (isSyncTransferring || isDelegateInterested || areSinksInterested)
     {
         DLog(@"Did get data %@", value);
         
-        NSDictionary *glucoseMeasurementContextDetails = [value parseGlucoseMeasurementContextCharacteristicDetails:self.crcCheckingEnabled];
+        NSDictionary *glucoseMeasurementContextDetails = nil;
+        
+        if (self.lazyRecordParsingEnabled)
+        {
+            glucoseMeasurementContextDetails = [value lazilyParseGlucoseMeasurementContextCharacteristicDetails:self.crcCheckingEnabled];
+        }
+        else
+        {
+            glucoseMeasurementContextDetails = [value parseGlucoseMeasurementContextCharacteristicDetails:self.crcCheckingEnabled];
+        }
+        
         NSNumber *sequenceNumber = (NSNumber *) glucoseMeasurementContextDetails[kGlucoseMeasurementContextKeySequenceNumber];
-        [self.delegate bgmController:self didGetGlucoseMeasurementContextAtIndex:[sequenceNumber integerValue] withDetails:glucoseMeasurementContextDetails];
+        
+        if (isSyncTransferring)
+        {
+            [self.syncMeasurementContexts addObject:glucoseMeasurementContextDetails];
+        }
+        
+        if (!isDelegateInterested && !areSinksInterested)
+        {
+            return;
+        }
+        
+        id<UHNBGMControllerDelegate> delegate = self.delegate;
+        NSArray *recordSinkEntries = (areSinksInterested ? self.recordSinkEntries : nil);
+        
+        [self.deliveryLane deliver:^{
+            if (isDelegateInterested)
+            {
+                [delegate bgmController:self didGetGlucoseMeasurementContextAtIndex:[sequenceNumber integerValue] withDetails:glucoseMeasurementContextDetails];
+            }
+            
+            for (UHNBGMRecordSinkEntry *entry in recordSinkEntries)
+            {
+                if (entry.capabilities & UHNBGMRecordCapabilityMeasurementContext)
+                {
+                    [entry.sink bgmController:self didReceiveGlucoseMeasurementContext:glucoseMeasurementContextDetails];
+                }
+            }
+        } isLive:NO];
     }
 }
 
@@ -495,42 +1742,76 @@
             RACPResponseCode responseCode = [responseDetails[kRACPKeyResponseCode] unsignedIntegerValue];
             RACPOpCode requestOpCode = [responseDetails[kRACPKeyRequestOpCode] unsignedIntegerValue];
             
+            // the response ends the report (or its abort), successful or not
+            if (RACPOpCodeStoredRecordsReport == requestOpCode || kGlucoseRACPOpCodeAbortOperation == requestOpCode)
+            {
+                self.recordTransferInProgress = NO;
+            }
+            
+            // the responses to the requests of a chunked transfer only drive the next chunk
+            if ([self isChunkedTransferInProgress])
+            {
+                [self handleChunkedTransferRACPResponse:responseCode forRequestOpCode:requestOpCode];
+                break;
+            }
+            
             if (responseCode == RACPSuccess)
             {
-                if ([self.delegate respondsToSelector:@selector(racpController:RACPOperationSuccessful:)])
-                {
-                    [self.delegate racpController:self RACPOperationSuccessful:requestOpCode];
-                }
+                [self notifyDelegate:^(id<UHNBGMControllerDelegate> delegate) {
+                    if ([delegate respondsToSelector:@selector(racpController:RACPOperationSuccessful:)])
+                    {
+                        [delegate racpController:self RACPOperationSuccessful:requestOpCode];
+                    }
+                }];
                 
                 [self notifyDelegateRACPOpCodeSuccess:requestOpCode];
             }
             else
             {
-                if ([self.delegate respondsToSelector:@selector(racpController:RACPOperation:failed:)])
-                {
-                    [self.delegate racpController:self RACPOperation:requestOpCode failed:responseCode];
-                }
+                [self notifyDelegate:^(id<UHNBGMControllerDelegate> delegate) {
+                    if ([delegate respondsToSelector:@selector(racpController:RACPOperation:failed:)])
+                    {
+                        [delegate racpController:self RACPOperation:requestOpCode failed:responseCode];
+                    }
+                }];
+            }
+            
+            if (UHNBGMSyncStateIdle != self.syncState)
+            {
+                [self handleSyncRACPResponse:responseCode forRequestOpCode:requestOpCode];
             }
             
             break;
         }
         case RACPOpCodeResponseStoredRecordsReportNumber:
         {
-            if ([self.delegate respondsToSelector: @selector(bgmController:didGetNumberOfRecords:)])
+            if (UHNBGMChunkedTransferStateCounting == self.chunkedTransferState)
             {
-                NSNumber *value = responseDict[kRACPKeyNumberOfRecords];
-                [self.delegate bgmController:self didGetNumberOfRecords:value];
+                [self handleChunkedTransferNumberOfRecords:[responseDict[kRACPKeyNumberOfRecords] unsignedIntegerValue]];
+                break;
             }
             
+            NSNumber *value = responseDict[kRACPKeyNumberOfRecords];
+            
+            [self notifyDelegate:^(id<UHNBGMControllerDelegate> delegate) {
+                if ([delegate respondsToSelector:@selector(bgmController:didGetNumberOfRecords:)])
+                {
+                    [delegate bgmController:self didGetNumberOfRecords:value];
+                }
+            }];
+            
             break;
         }
         case RACPOpCodeStoredRecordsReport:
         {
-            if ([self.delegate respondsToSelector: @selector(bgmController:didGetNumberOfRecords:)])
-            {
-                NSNumber *value = responseDict[kRACPKeyNumberOfRecords];
-                [self.delegate bgmController:self didGetNumberOfRecords:value];
-            }
+            NSNumber *value = responseDict[kRACPKeyNumberOfRecords];
+            
+            [self notifyDelegate:^(id<UHNBGMControllerDelegate> delegate) {
+                if ([delegate respondsToSelector:@selector(bgmController:didGetNumberOfRecords:)])
+                {
+                    [delegate bgmController:self didGetNumberOfRecords:value];
+                }
+            }];
             
             break;
         }
@@ -541,17 +1822,45 @@
     }
 }
 
+- (void) notifyTransferCompleteWithNumberOfRecords:(NSUInteger) numberOfRecords;
+{
+    id<UHNBGMControllerDelegate> delegate = self.delegate;
+    BOOL isDelegateInterested = (self.delegateCapabilities & UHNBGMRecordCapabilityTransferComplete);
+    NSArray *recordSinkEntries = self.recordSinkEntries;
+    UHNBGMIngestLedger *ingestLedger = self.ingestLedger;
+    NSArray *pendingIngestCommits = [self.pendingIngestCommits copy];
+    [self.pendingIngestCommits removeAllObjects];
+    
+    [self.deliveryLane deliver:^{
+        if (isDelegateInterested)
+        {
+            [delegate bgmController:self didCompleteTransferWithNumberOfRecords:numberOfRecords];
+        }
+        
+        for (UHNBGMRecordSinkEntry *entry in recordSinkEntries)
+        {
+            if (entry.capabilities & UHNBGMRecordCapabilityTransferComplete)
+            {
+                [entry.sink bgmController:self didCompleteTransferWithNumberOfRecords:numberOfRecords];
+            }
+        }
+        
+        // the sinks persist what they buffered when the transfer completes, so the ledger is never ahead of them
+        for (NSArray *pendingIngestCommit in pendingIngestCommits)
+        {
+            NSUUID *deviceIdentifier = ([pendingIngestCommit[1] isKindOfClass:[NSUUID class]] ? pendingIngestCommit[1] : nil);
+            [ingestLedger commitMeasurementData:pendingIngestCommit[0] fromPeripheralWithIdentifier:deviceIdentifier];
+        }
+    } isLive:NO];
+}
+
 - (void) notifyDelegateRACPOpCodeSuccess:(RACPOpCode) requestOpCode;
 {
     switch (requestOpCode)
     {
         case RACPOpCodeStoredRecordsReport:
         {
-            if ([self.delegate respondsToSelector:@selector(bgmController:didCompleteTransferWithNumberOfRecords:)])
-            {
-                [self.delegate bgmController:self didCompleteTransferWithNumberOfRecords:self.numberOfRecordsReceived];
-            }
-            
+            [self notifyTransferCompleteWithNumberOfRecords:self.numberOfRecordsReceived];
             break;
         }
         default:
@@ -568,12 +1877,14 @@
 {
     DLog(@"%s", __PRETTY_FUNCTION__);
 #ifdef DEBUG
-    UIAlertView *alert = [[UIAlertView alloc] initWithTitle:NSLocalizedString(@"Data Transmission Error",@"Error title")
-                                                    message:message
-                                                   delegate:nil
-                                          cancelButtonTitle:NSLocalizedString(@"OK",nil)
-                                          otherButtonTitles:nil];
-    [alert show];
+    dispatch_async(dispatch_get_main_queue(), ^{
+        UIAlertView *alert = [[UIAlertView alloc] initWithTitle:NSLocalizedString(@"Data Transmission Error",@"Error title")
+                                                        message:message
+                                                       delegate:nil
+                                              cancelButtonTitle:NSLocalizedString(@"OK",nil)
+                                              otherButtonTitles:nil];
+        [alert show];
+    });
 #endif
 }
 
@@ -0,0 +1,102 @@
+//
+//  UHNBGMDeviceProfile.h
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+/**
+ `UHNBGMDeviceProfile` consolidates the glucose features and the Device Information Service values of a glucose sensor, as read by `getDeviceProfile` of the `UHNBGMController`
+ 
+ @discussion Profiles are cached per peripheral identifier for the lifetime of the application, so reconnecting to a known glucose sensor does not read its profile again
+ */
+@interface UHNBGMDeviceProfile : NSObject
+
+/**
+ The identifier of the peripheral the profile was read from
+ */
+@property (nonatomic, strong, readonly) NSUUID *peripheralIdentifier;
+
+/**
+ The supported features of the glucose sensor (see GlucoseFeatureSupported), or 0 if they were not read
+ */
+@property (nonatomic, assign, readonly) NSUInteger features;
+
+/**
+ The model number string, or `nil` if it is not provided by the glucose sensor
+ */
+@property (nonatomic, copy, readonly) NSString *modelNumber;
+
+/**
+ The serial number string, or `nil` if it is not provided by the glucose sensor
+ */
+@property (nonatomic, copy, readonly) NSString *serialNumber;
+
+/**
+ The firmware revision string, or `nil` if it is not provided by the glucose sensor
+ */
+@property (nonatomic, copy, readonly) NSString *firmwareRevision;
+
+/**
+ The raw system ID, or `nil` if it is not provided by the glucose sensor
+ */
+@property (nonatomic, copy, readonly) NSData *systemID;
+
+/**
+ Initialize a profile with the raw characteristic values read from a glucose sensor
+ 
+ @param peripheralIdentifier The identifier of the peripheral the values were read from
+ @param characteristicValues The raw values keyed by characteristic UUID. Values of unknown characteristics are ignored.
+ 
+ @return The device profile
+ */
+- (instancetype) initWithPeripheralIdentifier:(NSUUID *) peripheralIdentifier characteristicValues:(NSDictionary *) characteristicValues;
+
+///------------
+/// @name Cache
+///------------
+
+/**
+ Get the cached profile of a peripheral
+ 
+ @param peripheralIdentifier The identifier of the peripheral
+ 
+ @return The cached profile, or `nil` if there is none
+ */
++ (UHNBGMDeviceProfile *) cachedProfileForPeripheralIdentifier:(NSUUID *) peripheralIdentifier;
+
+/**
+ Cache a profile under its peripheral identifier, replacing any previously cached profile. Profiles without a peripheral identifier are not cached
+ 
+ @param profile The profile to cache
+ */
++ (void) cacheProfile:(UHNBGMDeviceProfile *) profile;
+
+/**
+ Remove the cached profile of a peripheral, for instance after a firmware update
+ 
+ @param peripheralIdentifier The identifier of the peripheral
+ */
++ (void) removeCachedProfileForPeripheralIdentifier:(NSUUID *) peripheralIdentifier;
+
+@end
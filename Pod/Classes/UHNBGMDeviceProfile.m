@@ -0,0 +1,124 @@
+//
+//  UHNBGMDeviceProfile.m
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+
+#import "UHNBGMDeviceProfile.h"
+#import "UHNBGMConstants.h"
+
+@interface UHNBGMDeviceProfile ()
+@property (nonatomic, strong, readwrite) NSUUID *peripheralIdentifier;
+@property (nonatomic, assign, readwrite) NSUInteger features;
+@property (nonatomic, copy, readwrite) NSString *modelNumber;
+@property (nonatomic, copy, readwrite) NSString *serialNumber;
+@property (nonatomic, copy, readwrite) NSString *firmwareRevision;
+@property (nonatomic, copy, readwrite) NSData *systemID;
+@end
+
+@implementation UHNBGMDeviceProfile
+
+#pragma mark - Initialization Methods
+
+- (instancetype) initWithPeripheralIdentifier:(NSUUID *) peripheralIdentifier characteristicValues:(NSDictionary *) characteristicValues;
+{
+    if ((self = [super init]))
+    {
+        self.peripheralIdentifier = peripheralIdentifier;
+        
+        NSData *featuresValue = characteristicValues[kGlucoseServiceCharacteristicUUIDSupportedFeatures];
+        if ([featuresValue length] >= 2)
+        {
+            const uint8_t *bytes = featuresValue.bytes;
+            self.features = bytes[0] | (bytes[1] << 8);
+        }
+        
+        self.modelNumber = [UHNBGMDeviceProfile stringFromValue:characteristicValues[kDeviceInformationCharacteristicUUIDModelNumber]];
+        self.serialNumber = [UHNBGMDeviceProfile stringFromValue:characteristicValues[kDeviceInformationCharacteristicUUIDSerialNumber]];
+        self.firmwareRevision = [UHNBGMDeviceProfile stringFromValue:characteristicValues[kDeviceInformationCharacteristicUUIDFirmwareRevision]];
+        self.systemID = characteristicValues[kDeviceInformationCharacteristicUUIDSystemID];
+    }
+    
+    return self;
+}
+
++ (NSString *) stringFromValue:(NSData *) value;
+{
+    if (nil == value)
+    {
+        return nil;
+    }
+    
+    // some sensors pad the UTF-8 strings with null characters
+    const char *bytes = value.bytes;
+    NSUInteger length = value.length;
+    while (length > 0 && '\0' == bytes[length - 1])
+    {
+        length -= 1;
+    }
+    
+    return [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
+}
+
+- (NSString *) description;
+{
+    return [NSString stringWithFormat:@"<%@: %p; model = %@; serial = %@; firmware = %@; features = 0x%04lx>", NSStringFromClass([self class]), self, self.modelNumber, self.serialNumber, self.firmwareRevision, (unsigned long) self.features];
+}
+
+#pragma mark - Cache Methods
+
++ (NSMutableDictionary *) profileCache;
+{
+    static NSMutableDictionary *profileCache = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        profileCache = [NSMutableDictionary dictionary];
+    });
+    
+    return profileCache;
+}
+
++ (UHNBGMDeviceProfile *) cachedProfileForPeripheralIdentifier:(NSUUID *) peripheralIdentifier;
+{
+    if (nil == peripheralIdentifier)
+    {
+        return nil;
+    }
+    
+    NSMutableDictionary *profileCache = [self profileCache];
+    @synchronized (profileCache)
+    {
+        return profileCache[peripheralIdentifier];
+    }
+}
+
++ (void) cacheProfile:(UHNBGMDeviceProfile *) profile;
+{
+    if (nil == profile.peripheralIdentifier)
+    {
+        return;
+    }
+    
+    NSMutableDictionary *profileCache = [self profileCache];
+    @synchronized (profileCache)
+    {
+        profileCache[profile.peripheralIdentifier] = profile;
+    }
+}
+
++ (void) removeCachedProfileForPeripheralIdentifier:(NSUUID *) peripheralIdentifier;
+{
+    if (nil == peripheralIdentifier)
+    {
+        return;
+    }
+    
+    NSMutableDictionary *profileCache = [self profileCache];
+    @synchronized (profileCache)
+    {
+        [profileCache removeObjectForKey:peripheralIdentifier];
+    }
+}
+
+@end
@@ -0,0 +1,210 @@
+//
+//  UHNBGMEncryptedRecordStore.h
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "UHNBGMRecordSink.h"
+
+/**
+ The length of the keys of a `UHNBGMEncryptedRecordStore`, in bytes
+ */
+#define kEncryptedRecordStoreKeyLength      32
+
+/**
+ A block called with each record of a `UHNBGMEncryptedRecordStore`
+ 
+ @param measurementData The glucose measurement characteristic value
+ @param measurementContextData The glucose measurement context characteristic value, or `nil` if the measurement has none
+ @param stop Set to `YES` to stop the enumeration
+ 
+ */
+typedef void (^UHNBGMEncryptedRecordBlock)(NSData *measurementData, NSData *measurementContextData, BOOL *stop);
+
+/**
+ `UHNBGMEncryptedRecordStore` persists glucose measurements and glucose measurement contexts encrypted in a single append-only file, as raw characteristic values.
+ 
+ @discussion Records are packed into segments of up to `maximumSegmentLength` bytes, and each segment is encrypted as a whole with AES-256 in counter mode under a random nonce, then authenticated with HMAC-SHA256 over its header and ciphertext (encrypt-then-MAC), so the cost of the encryption does not grow with the number of records. CommonCrypto uses the AES instructions of the processor where it has them. Segments are sealed in chunks as they are written, and each segment can be authenticated and decrypted on its own, which gives random access to the history without reading the rest of the file. The authenticated header holds the index of the segment in the file, so a store with segments reordered, duplicated or removed before its last segment is not opened, and a segment does not authenticate in another place. Segments removed from the end of the file cannot be detected, the file as a whole is not authenticated.
+ 
+ Each segment header names the key it was sealed with. Rotating the key seals new segments with the new key while older segments stay readable with the keys added with `addKey:forIdentifier:`, until `reencryptSegmentsWithCurrentKey` seals them again with the current key. The encryption and authentication keys of a segment are derived from the key with HMAC-SHA256.
+ 
+ A segment that was not completely written, after a crash, is truncated when the store is opened. A file damaged before its last segment is not opened, so the segments after the damage are not lost. The records waiting for a segment are only kept in memory until `flush`. The file is created with complete data protection. The store is thread safe.
+ 
+ The store can be added to a `UHNBGMController` as a record sink. It pairs each measurement with the context that follows it through a `UHNBGMRecordPairer`, so records parsed eagerly are stored too, encoded again from their details.
+ */
+@interface UHNBGMEncryptedRecordStore : NSObject <UHNBGMRecordSink>
+
+/**
+ The path of the file of the store
+ */
+@property (nonatomic, copy, readonly) NSString *path;
+
+/**
+ The identifier of the key new segments are sealed with
+ */
+@property (nonatomic, assign, readonly) uint32_t currentKeyIdentifier;
+
+/**
+ The largest number of record bytes sealed in one segment. Defaults to 65536
+ 
+ @discussion Larger segments cost less per record to seal, smaller segments cost less to read one of them
+ */
+@property (nonatomic, assign) NSUInteger maximumSegmentLength;
+
+/**
+ The number of segments written to the file
+ */
+@property (nonatomic, assign, readonly) NSUInteger numberOfSegments;
+
+/**
+ The number of records written to the file, not counting those waiting for a segment
+ */
+@property (nonatomic, assign, readonly) NSUInteger numberOfRecords;
+
+/**
+ Initializes a store, opening or creating its file
+ 
+ @param path The path of the file of the store
+ @param key The key new segments are sealed with, `kEncryptedRecordStoreKeyLength` bytes long
+ @param keyIdentifier The identifier of the key, written in the header of each segment
+ 
+ @return The initialized store, or `nil` if the key has the wrong length, or the file could not be opened, is not a store, is damaged before its last segment or has its segments out of order
+ 
+ */
+- (instancetype) initWithPath:(NSString *) path key:(NSData *) key keyIdentifier:(uint32_t) keyIdentifier;
+
+///-------------------
+/// @name Key Rotation
+///-------------------
+
+/**
+ Adds a key to read the segments sealed with it
+ 
+ @param key The key, `kEncryptedRecordStoreKeyLength` bytes long
+ @param keyIdentifier The identifier of the key
+ 
+ @return `YES` if the key was added, `NO` if it has the wrong length
+ 
+ */
+- (BOOL) addKey:(NSData *) key forIdentifier:(uint32_t) keyIdentifier;
+
+/**
+ Seals new segments with another key. The current key is kept to read the segments sealed with it
+ 
+ @param key The key, `kEncryptedRecordStoreKeyLength` bytes long
+ @param keyIdentifier The identifier of the key
+ 
+ @return `YES` if the key was rotated, `NO` if it has the wrong length
+ 
+ @discussion The records waiting for a segment are sealed with the previous key first
+ 
+ */
+- (BOOL) rotateToKey:(NSData *) key identifier:(uint32_t) keyIdentifier;
+
+/**
+ Seals the segments sealed with other keys again with the current key, rewriting the file
+ 
+ @return `YES` if all the segments are sealed with the current key, `NO` if a segment could not be read or the file could not be rewritten. The file is left as it was on failure
+ 
+ @discussion Once done, the previous keys can be removed with `removeKeyForIdentifier:`
+ 
+ */
+- (BOOL) reencryptSegmentsWithCurrentKey;
+
+/**
+ Removes a key added with `addKey:forIdentifier:` or rotated from. The current key cannot be removed
+ 
+ @param keyIdentifier The identifier of the key
+ 
+ */
+- (void) removeKeyForIdentifier:(uint32_t) keyIdentifier;
+
+///--------------
+/// @name Writing
+///--------------
+
+/**
+ Adds a record, sealing the pending segment first if the record does not fit in it
+ 
+ @param measurementData The glucose measurement characteristic value
+ @param measurementContextData The glucose measurement context characteristic value, or `nil`
+ 
+ @return `YES` if the record was added, `NO` if a value is longer than 255 bytes or a segment could not be written
+ 
+ */
+- (BOOL) addMeasurementData:(NSData *) measurementData contextData:(NSData *) measurementContextData;
+
+/**
+ Seals the records waiting for a segment and writes them to the file
+ 
+ @return `YES` if the records were written, otherwise `NO`
+ 
+ */
+- (BOOL) flush;
+
+///--------------
+/// @name Reading
+///--------------
+
+/**
+ The number of records of a segment
+ 
+ @param segmentIndex The index of the segment, the oldest first
+ 
+ @return The number of records, 0 if there is no such segment
+ 
+ */
+- (NSUInteger) numberOfRecordsInSegmentAtIndex:(NSUInteger) segmentIndex;
+
+/**
+ The identifier of the key a segment was sealed with
+ 
+ @param segmentIndex The index of the segment, the oldest first
+ 
+ @return The key identifier, 0 if there is no such segment
+ 
+ */
+- (uint32_t) keyIdentifierOfSegmentAtIndex:(NSUInteger) segmentIndex;
+
+/**
+ Authenticates and decrypts one segment, calling a block with each of its records in the order they were added
+ 
+ @param segmentIndex The index of the segment, the oldest first
+ @param block The block called with each record
+ 
+ @return `YES` if the segment was read, `NO` if there is no such segment, its key is unknown or it failed authentication
+ 
+ */
+- (BOOL) enumerateRecordsInSegmentAtIndex:(NSUInteger) segmentIndex usingBlock:(UHNBGMEncryptedRecordBlock) block;
+
+/**
+ Authenticates and decrypts all the segments, calling a block with each record in the order they were added
+ 
+ @param block The block called with each record
+ 
+ @return `YES` if all the segments were read, `NO` if a segment could not be read. The records of the segments before it were enumerated
+ 
+ */
+- (BOOL) enumerateRecordsUsingBlock:(UHNBGMEncryptedRecordBlock) block;
+
+@end
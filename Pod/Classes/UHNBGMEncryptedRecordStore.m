@@ -0,0 +1,727 @@
+//
+//  UHNBGMEncryptedRecordStore.m
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+
+#import <CommonCrypto/CommonCrypto.h>
+#import <fcntl.h>
+#import <pthread.h>
+#import <sys/stat.h>
+#import <unistd.h>
+#import "UHNBGMEncryptedRecordStore.h"
+#import "UHNBGMConstants.h"
+#import "UHNBGMRecordPairer.h"
+#import "UHNDebug.h"
+
+#define kEncryptedRecordStoreFileMagic              0x454E4855 // "UHNE"
+#define kEncryptedRecordStoreFileVersion            2
+#define kEncryptedRecordStoreFileHeaderLength       8
+#define kEncryptedRecordStoreSegmentMagic           0x534E4855 // "UHNS"
+#define kEncryptedRecordStoreSegmentHeaderLength    36
+#define kEncryptedRecordStoreOrdinalOffset          16
+#define kEncryptedRecordStoreNonceOffset            20
+#define kEncryptedRecordStoreTagLength              CC_SHA256_DIGEST_LENGTH
+#define kEncryptedRecordStoreChunkLength            16384
+#define kEncryptedRecordStoreDefaultSegmentLength   65536
+// a length prefixed measurement and a length prefixed context
+#define kEncryptedRecordStoreMaximumRecordLength    (2 + 2 * 255)
+
+/**
+ A segment of the file
+ */
+typedef struct
+{
+    off_t offset;
+    uint32_t keyIdentifier;
+    uint32_t numberOfRecords;
+    uint32_t ciphertextLength;
+    uint32_t ordinal;
+} UHNBGMEncryptedSegment;
+
+static inline size_t UHNBGMEncryptedSegmentLength(const UHNBGMEncryptedSegment *segment)
+{
+    return kEncryptedRecordStoreSegmentHeaderLength + segment->ciphertextLength + kEncryptedRecordStoreTagLength;
+}
+
+static inline void UHNBGMStorePutUInt32(uint8_t *bytes, uint32_t value)
+{
+    bytes[0] = value;
+    bytes[1] = value >> 8;
+    bytes[2] = value >> 16;
+    bytes[3] = value >> 24;
+}
+
+static inline uint32_t UHNBGMStoreGetUInt32(const uint8_t *bytes)
+{
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t) bytes[3] << 24);
+}
+
+// stores through a volatile pointer, which the compiler cannot drop as dead stores
+static void UHNBGMSecureZero(void *bytes, size_t length)
+{
+    volatile uint8_t *byte = bytes;
+    while (length--)
+    {
+        *byte++ = 0;
+    }
+}
+
+// compares in a time that does not depend on where the tags differ
+static BOOL UHNBGMTagsMatch(const uint8_t *tag, const uint8_t *expectedTag)
+{
+    uint8_t difference = 0;
+    for (NSUInteger index = 0; index < kEncryptedRecordStoreTagLength; index++)
+    {
+        difference |= tag[index] ^ expectedTag[index];
+    }
+    
+    return (0 == difference);
+}
+
+static BOOL UHNBGMStoreWrite(int fileDescriptor, const void *bytes, size_t length, off_t offset)
+{
+    size_t written = 0;
+    while (written < length)
+    {
+        ssize_t result = pwrite(fileDescriptor, (const uint8_t *) bytes + written, length - written, offset + written);
+        if (result < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            return NO;
+        }
+        written += result;
+    }
+    
+    return YES;
+}
+
+static BOOL UHNBGMStoreRead(int fileDescriptor, void *bytes, size_t length, off_t offset)
+{
+    size_t bytesRead = 0;
+    while (bytesRead < length)
+    {
+        ssize_t result = pread(fileDescriptor, (uint8_t *) bytes + bytesRead, length - bytesRead, offset + bytesRead);
+        if (result <= 0)
+        {
+            if (result < 0 && EINTR == errno)
+            {
+                continue;
+            }
+            return NO;
+        }
+        bytesRead += result;
+    }
+    
+    return YES;
+}
+
+// the encryption key followed by the authentication key, so neither is used for both
+static NSData *UHNBGMDeriveSegmentKeys(NSData *key)
+{
+    static const char encryptionLabel[] = "UHNBGM record encryption";
+    static const char authenticationLabel[] = "UHNBGM record authentication";
+    NSMutableData *segmentKeys = [NSMutableData dataWithLength:2 * CC_SHA256_DIGEST_LENGTH];
+    
+    CCHmac(kCCHmacAlgSHA256, [key bytes], [key length], encryptionLabel, strlen(encryptionLabel), [segmentKeys mutableBytes]);
+    CCHmac(kCCHmacAlgSHA256, [key bytes], [key length], authenticationLabel, strlen(authenticationLabel), (uint8_t *) [segmentKeys mutableBytes] + CC_SHA256_DIGEST_LENGTH);
+    
+    return segmentKeys;
+}
+
+@interface UHNBGMEncryptedRecordStore ()
+{
+    pthread_mutex_t _lock;
+    int _fileDescriptor;
+    off_t _endOffset;
+    NSUInteger _numberOfPendingRecords;
+}
+@property (nonatomic, copy, readwrite) NSString *path;
+@property (nonatomic, assign, readwrite) uint32_t currentKeyIdentifier;
+@property (nonatomic, assign, readwrite) NSUInteger numberOfRecords;
+// the derived segment keys by key identifier
+@property (nonatomic, strong) NSMutableDictionary *segmentKeysByIdentifier;
+// the segments of the file, a UHNBGMEncryptedSegment each
+@property (nonatomic, strong) NSMutableData *segments;
+// the records waiting for a segment, each a length prefixed measurement then a length prefixed context
+@property (nonatomic, strong) NSMutableData *pendingRecords;
+// a sink store holds a measurement with context information until its context arrives
+@property (nonatomic, strong) UHNBGMRecordPairer *recordPairer;
+@end
+
+@implementation UHNBGMEncryptedRecordStore
+
+#pragma mark - Initialization Methods
+
+- (instancetype) initWithPath:(NSString *) path key:(NSData *) key keyIdentifier:(uint32_t) keyIdentifier;
+{
+    if ((self = [super init]))
+    {
+        pthread_mutex_init(&_lock, NULL);
+        _fileDescriptor = -1;
+        
+        if (kEncryptedRecordStoreKeyLength != [key length])
+        {
+            return nil;
+        }
+        
+        self.path = path;
+        self.currentKeyIdentifier = keyIdentifier;
+        self.maximumSegmentLength = kEncryptedRecordStoreDefaultSegmentLength;
+        self.segmentKeysByIdentifier = [NSMutableDictionary dictionaryWithObject:UHNBGMDeriveSegmentKeys(key) forKey:@(keyIdentifier)];
+        self.segments = [NSMutableData data];
+        self.pendingRecords = [NSMutableData data];
+        self.recordPairer = [[UHNBGMRecordPairer alloc] init];
+        
+        _fileDescriptor = [self openFileAtPath:path truncate:NO];
+        if (_fileDescriptor < 0 || ![self loadSegments])
+        {
+            DLog(@"Could not open the encrypted record store at %@", path);
+            return nil;
+        }
+    }
+    
+    return self;
+}
+
+- (void) dealloc;
+{
+    if (_fileDescriptor >= 0)
+    {
+        [_recordPairer flushUsingBlock:^(NSData *measurementData, NSData *measurementContextData) {
+            [self addMeasurementData:measurementData contextData:measurementContextData];
+        }];
+        [self flush];
+        close(_fileDescriptor);
+    }
+    
+    UHNBGMSecureZero([_pendingRecords mutableBytes], [_pendingRecords length]);
+    pthread_mutex_destroy(&_lock);
+}
+
+- (int) openFileAtPath:(NSString *) path truncate:(BOOL) truncate;
+{
+    int fileDescriptor = open([path fileSystemRepresentation], O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0), S_IRUSR | S_IWUSR);
+    if (fileDescriptor >= 0)
+    {
+        // an open store can still be written while the device is locked, for a transfer in the background
+        [[NSFileManager defaultManager] setAttributes:@{NSFileProtectionKey: NSFileProtectionCompleteUnlessOpen} ofItemAtPath:path error:nil];
+    }
+    
+    return fileDescriptor;
+}
+
+- (BOOL) loadSegments;
+{
+    struct stat status;
+    if (0 != fstat(_fileDescriptor, &status))
+    {
+        return NO;
+    }
+    
+    uint8_t fileHeader[kEncryptedRecordStoreFileHeaderLength];
+    if (0 == status.st_size)
+    {
+        UHNBGMStorePutUInt32(fileHeader, kEncryptedRecordStoreFileMagic);
+        UHNBGMStorePutUInt32(fileHeader + 4, kEncryptedRecordStoreFileVersion);
+        _endOffset = sizeof(fileHeader);
+        return UHNBGMStoreWrite(_fileDescriptor, fileHeader, sizeof(fileHeader), 0);
+    }
+    
+    if (!UHNBGMStoreRead(_fileDescriptor, fileHeader, sizeof(fileHeader), 0) || kEncryptedRecordStoreFileMagic != UHNBGMStoreGetUInt32(fileHeader) || kEncryptedRecordStoreFileVersion != UHNBGMStoreGetUInt32(fileHeader + 4))
+    {
+        return NO;
+    }
+    
+    // only the segment headers are read, the ciphertext is skipped over
+    off_t offset = sizeof(fileHeader);
+    uint8_t header[kEncryptedRecordStoreSegmentHeaderLength];
+    while (offset + kEncryptedRecordStoreSegmentHeaderLength <= status.st_size && UHNBGMStoreRead(_fileDescriptor, header, sizeof(header), offset))
+    {
+        uint32_t ordinal = (uint32_t) ([self.segments length] / sizeof(UHNBGMEncryptedSegment));
+        UHNBGMEncryptedSegment segment = {offset, UHNBGMStoreGetUInt32(header + 4), UHNBGMStoreGetUInt32(header + 8), UHNBGMStoreGetUInt32(header + 12), ordinal};
+        if (kEncryptedRecordStoreSegmentMagic != UHNBGMStoreGetUInt32(header) || offset + (off_t) UHNBGMEncryptedSegmentLength(&segment) > status.st_size)
+        {
+            break;
+        }
+        
+        // a complete segment out of place was moved, copied or had segments removed before it, which is damage rather than a crash
+        if (ordinal != UHNBGMStoreGetUInt32(header + kEncryptedRecordStoreOrdinalOffset))
+        {
+            DLog(@"The segment at offset %lld of the encrypted record store is out of order", (long long) offset);
+            return NO;
+        }
+        
+        [self.segments appendBytes:&segment length:sizeof(segment)];
+        self.numberOfRecords += segment.numberOfRecords;
+        offset += UHNBGMEncryptedSegmentLength(&segment);
+    }
+    
+    // only the segment being written when the app stopped can be incomplete, more than that is damage that truncating would lose
+    off_t maximumSegmentLength = kEncryptedRecordStoreSegmentHeaderLength + MAX(self.maximumSegmentLength, kEncryptedRecordStoreMaximumRecordLength) + kEncryptedRecordStoreTagLength;
+    if (status.st_size - offset >= maximumSegmentLength)
+    {
+        DLog(@"The encrypted record store is damaged at offset %lld", (long long) offset);
+        return NO;
+    }
+    
+    if (offset != status.st_size)
+    {
+        DLog(@"Truncating an incomplete segment of the encrypted record store at offset %lld", (long long) offset);
+        if (0 != ftruncate(_fileDescriptor, offset))
+        {
+            return NO;
+        }
+    }
+    
+    _endOffset = offset;
+    
+    return YES;
+}
+
+#pragma mark - Key Rotation Methods
+
+- (BOOL) addKey:(NSData *) key forIdentifier:(uint32_t) keyIdentifier;
+{
+    if (kEncryptedRecordStoreKeyLength != [key length])
+    {
+        return NO;
+    }
+    
+    NSData *segmentKeys = UHNBGMDeriveSegmentKeys(key);
+    pthread_mutex_lock(&_lock);
+    self.segmentKeysByIdentifier[@(keyIdentifier)] = segmentKeys;
+    pthread_mutex_unlock(&_lock);
+    
+    return YES;
+}
+
+- (BOOL) rotateToKey:(NSData *) key identifier:(uint32_t) keyIdentifier;
+{
+    if (kEncryptedRecordStoreKeyLength != [key length])
+    {
+        return NO;
+    }
+    
+    NSData *segmentKeys = UHNBGMDeriveSegmentKeys(key);
+    pthread_mutex_lock(&_lock);
+    
+    // if this fails the pending records stay in memory and are sealed with the new key instead
+    [self sealPendingRecords];
+    self.segmentKeysByIdentifier[@(keyIdentifier)] = segmentKeys;
+    self.currentKeyIdentifier = keyIdentifier;
+    
+    pthread_mutex_unlock(&_lock);
+    
+    return YES;
+}
+
+- (BOOL) reencryptSegmentsWithCurrentKey;
+{
+    pthread_mutex_lock(&_lock);
+    BOOL reencrypted = ([self sealPendingRecords] && [self reencryptSegments]);
+    pthread_mutex_unlock(&_lock);
+    
+    return reencrypted;
+}
+
+- (BOOL) reencryptSegments;
+{
+    const UHNBGMEncryptedSegment *segments = [self.segments bytes];
+    NSUInteger numberOfSegments = [self.segments length] / sizeof(UHNBGMEncryptedSegment);
+    BOOL needsReencryption = NO;
+    
+    for (NSUInteger index = 0; index < numberOfSegments; index++)
+    {
+        needsReencryption |= (segments[index].keyIdentifier != self.currentKeyIdentifier);
+    }
+    
+    if (!needsReencryption)
+    {
+        return YES;
+    }
+    
+    // the segments are written to a new file that replaces the store once complete
+    NSString *temporaryPath = [self.path stringByAppendingString:@".rekey"];
+    int fileDescriptor = [self openFileAtPath:temporaryPath truncate:YES];
+    if (fileDescriptor < 0)
+    {
+        return NO;
+    }
+    
+    NSMutableData *newSegments = [NSMutableData dataWithCapacity:[self.segments length]];
+    uint8_t fileHeader[kEncryptedRecordStoreFileHeaderLength];
+    UHNBGMStorePutUInt32(fileHeader, kEncryptedRecordStoreFileMagic);
+    UHNBGMStorePutUInt32(fileHeader + 4, kEncryptedRecordStoreFileVersion);
+    off_t offset = sizeof(fileHeader);
+    BOOL succeeded = UHNBGMStoreWrite(fileDescriptor, fileHeader, sizeof(fileHeader), 0);
+    
+    for (NSUInteger index = 0; succeeded && index < numberOfSegments; index++)
+    {
+        UHNBGMEncryptedSegment segment = segments[index];
+        NSMutableData *segmentData = [self readSegment:&segment decrypt:(segment.keyIdentifier != self.currentKeyIdentifier)];
+        
+        if (!segmentData)
+        {
+            succeeded = NO;
+        }
+        else if (segment.keyIdentifier == self.currentKeyIdentifier)
+        {
+            succeeded = UHNBGMStoreWrite(fileDescriptor, [segmentData bytes], [segmentData length], offset);
+        }
+        else
+        {
+            uint8_t *plaintext = (uint8_t *) [segmentData mutableBytes] + kEncryptedRecordStoreSegmentHeaderLength;
+            succeeded = [self sealSegmentWithRecords:plaintext length:segment.ciphertextLength numberOfRecords:segment.numberOfRecords ordinal:segment.ordinal toFileDescriptor:fileDescriptor offset:offset];
+            UHNBGMSecureZero(plaintext, segment.ciphertextLength);
+            segment.keyIdentifier = self.currentKeyIdentifier;
+        }
+        
+        segment.offset = offset;
+        offset += UHNBGMEncryptedSegmentLength(&segment);
+        [newSegments appendBytes:&segment length:sizeof(segment)];
+    }
+    
+    if (!succeeded || 0 != fsync(fileDescriptor) || 0 != rename([temporaryPath fileSystemRepresentation], [self.path fileSystemRepresentation]))
+    {
+        close(fileDescriptor);
+        unlink([temporaryPath fileSystemRepresentation]);
+        return NO;
+    }
+    
+    close(_fileDescriptor);
+    _fileDescriptor = fileDescriptor;
+    _endOffset = offset;
+    self.segments = newSegments;
+    
+    return YES;
+}
+
+- (void) removeKeyForIdentifier:(uint32_t) keyIdentifier;
+{
+    pthread_mutex_lock(&_lock);
+    if (keyIdentifier != self.currentKeyIdentifier)
+    {
+        [self.segmentKeysByIdentifier removeObjectForKey:@(keyIdentifier)];
+    }
+    pthread_mutex_unlock(&_lock);
+}
+
+#pragma mark - Writing Methods
+
+- (BOOL) addMeasurementData:(NSData *) measurementData contextData:(NSData *) measurementContextData;
+{
+    if ([measurementData length] > UINT8_MAX || [measurementContextData length] > UINT8_MAX)
+    {
+        return NO;
+    }
+    
+    BOOL added = YES;
+    NSUInteger recordLength = 2 + [measurementData length] + [measurementContextData length];
+    pthread_mutex_lock(&_lock);
+    
+    // a record larger than a segment still gets a segment of its own
+    if (_numberOfPendingRecords > 0 && [self.pendingRecords length] + recordLength > self.maximumSegmentLength)
+    {
+        added = [self sealPendingRecords];
+    }
+    
+    if (added)
+    {
+        uint8_t measurementLength = [measurementData length];
+        uint8_t contextLength = [measurementContextData length];
+        [self.pendingRecords appendBytes:&measurementLength length:1];
+        [self.pendingRecords appendData:measurementData];
+        [self.pendingRecords appendBytes:&contextLength length:1];
+        [self.pendingRecords appendData:measurementContextData];
+        _numberOfPendingRecords += 1;
+    }
+    
+    pthread_mutex_unlock(&_lock);
+    
+    return added;
+}
+
+- (BOOL) flush;
+{
+    pthread_mutex_lock(&_lock);
+    BOOL flushed = [self sealPendingRecords];
+    pthread_mutex_unlock(&_lock);
+    
+    return flushed;
+}
+
+- (BOOL) sealPendingRecords;
+{
+    if (0 == _numberOfPendingRecords)
+    {
+        return YES;
+    }
+    
+    NSUInteger length = [self.pendingRecords length];
+    uint32_t ordinal = (uint32_t) ([self.segments length] / sizeof(UHNBGMEncryptedSegment));
+    if (![self sealSegmentWithRecords:[self.pendingRecords bytes] length:length numberOfRecords:_numberOfPendingRecords ordinal:ordinal toFileDescriptor:_fileDescriptor offset:_endOffset] || 0 != fsync(_fileDescriptor))
+    {
+        // the partial segment is dropped and the records are kept for the next attempt
+        ftruncate(_fileDescriptor, _endOffset);
+        return NO;
+    }
+    
+    UHNBGMEncryptedSegment segment = {_endOffset, self.currentKeyIdentifier, (uint32_t) _numberOfPendingRecords, (uint32_t) length, ordinal};
+    [self.segments appendBytes:&segment length:sizeof(segment)];
+    _endOffset += UHNBGMEncryptedSegmentLength(&segment);
+    self.numberOfRecords += _numberOfPendingRecords;
+    
+    UHNBGMSecureZero([self.pendingRecords mutableBytes], length);
+    [self.pendingRecords setLength:0];
+    _numberOfPendingRecords = 0;
+    
+    return YES;
+}
+
+/*
+ A segment, all integers little endian:
+ magic (uint32), key identifier (uint32), number of records (uint32), ciphertext length (uint32), ordinal (uint32), nonce (16 bytes),
+ then the ciphertext, then HMAC-SHA256 of the header and the ciphertext with the authentication key
+ 
+ The ordinal is the index of the segment in the file, so the tag also binds a segment to its place
+ */
+
+- (BOOL) sealSegmentWithRecords:(const uint8_t *) records length:(NSUInteger) length numberOfRecords:(NSUInteger) numberOfRecords ordinal:(uint32_t) ordinal toFileDescriptor:(int) fileDescriptor offset:(off_t) offset;
+{
+    const uint8_t *segmentKeys = [self.segmentKeysByIdentifier[@(self.currentKeyIdentifier)] bytes];
+    uint8_t header[kEncryptedRecordStoreSegmentHeaderLength];
+    UHNBGMStorePutUInt32(header, kEncryptedRecordStoreSegmentMagic);
+    UHNBGMStorePutUInt32(header + 4, self.currentKeyIdentifier);
+    UHNBGMStorePutUInt32(header + 8, (uint32_t) numberOfRecords);
+    UHNBGMStorePutUInt32(header + 12, (uint32_t) length);
+    UHNBGMStorePutUInt32(header + kEncryptedRecordStoreOrdinalOffset, ordinal);
+    arc4random_buf(header + kEncryptedRecordStoreNonceOffset, kCCBlockSizeAES128);
+    
+    CCCryptorRef cryptor;
+    if (kCCSuccess != CCCryptorCreateWithMode(kCCEncrypt, kCCModeCTR, kCCAlgorithmAES, ccNoPadding, header + kEncryptedRecordStoreNonceOffset, segmentKeys, kCCKeySizeAES256, NULL, 0, 0, kCCModeOptionCTR_BE, &cryptor))
+    {
+        return NO;
+    }
+    
+    CCHmacContext authentication;
+    CCHmacInit(&authentication, kCCHmacAlgSHA256, segmentKeys + CC_SHA256_DIGEST_LENGTH, CC_SHA256_DIGEST_LENGTH);
+    CCHmacUpdate(&authentication, header, sizeof(header));
+    BOOL sealed = UHNBGMStoreWrite(fileDescriptor, header, sizeof(header), offset);
+    offset += sizeof(header);
+    
+    // encrypted, authenticated and written a chunk at a time, so the ciphertext is never held whole
+    uint8_t chunk[kEncryptedRecordStoreChunkLength];
+    for (NSUInteger position = 0; sealed && position < length; position += kEncryptedRecordStoreChunkLength)
+    {
+        size_t chunkLength = MIN(length - position, kEncryptedRecordStoreChunkLength);
+        size_t encryptedLength = 0;
+        sealed = (kCCSuccess == CCCryptorUpdate(cryptor, records + position, chunkLength, chunk, sizeof(chunk), &encryptedLength) && encryptedLength == chunkLength);
+        if (sealed)
+        {
+            CCHmacUpdate(&authentication, chunk, chunkLength);
+            sealed = UHNBGMStoreWrite(fileDescriptor, chunk, chunkLength, offset + position);
+        }
+    }
+    
+    CCCryptorRelease(cryptor);
+    
+    uint8_t tag[kEncryptedRecordStoreTagLength];
+    CCHmacFinal(&authentication, tag);
+    
+    return (sealed && UHNBGMStoreWrite(fileDescriptor, tag, sizeof(tag), offset + length));
+}
+
+#pragma mark - Reading Methods
+
+- (NSUInteger) numberOfSegments;
+{
+    pthread_mutex_lock(&_lock);
+    NSUInteger numberOfSegments = [self.segments length] / sizeof(UHNBGMEncryptedSegment);
+    pthread_mutex_unlock(&_lock);
+    
+    return numberOfSegments;
+}
+
+- (BOOL) getSegment:(UHNBGMEncryptedSegment *) segment atIndex:(NSUInteger) segmentIndex;
+{
+    pthread_mutex_lock(&_lock);
+    BOOL exists = (segmentIndex < [self.segments length] / sizeof(UHNBGMEncryptedSegment));
+    if (exists)
+    {
+        *segment = ((const UHNBGMEncryptedSegment *) [self.segments bytes])[segmentIndex];
+    }
+    pthread_mutex_unlock(&_lock);
+    
+    return exists;
+}
+
+- (NSUInteger) numberOfRecordsInSegmentAtIndex:(NSUInteger) segmentIndex;
+{
+    UHNBGMEncryptedSegment segment;
+    return ([self getSegment:&segment atIndex:segmentIndex] ? segment.numberOfRecords : 0);
+}
+
+- (uint32_t) keyIdentifierOfSegmentAtIndex:(NSUInteger) segmentIndex;
+{
+    UHNBGMEncryptedSegment segment;
+    return ([self getSegment:&segment atIndex:segmentIndex] ? segment.keyIdentifier : 0);
+}
+
+// reads and authenticates a whole segment, decrypting its ciphertext in place if asked to
+- (NSMutableData *) readSegment:(const UHNBGMEncryptedSegment *) segment decrypt:(BOOL) decrypt;
+{
+    const uint8_t *segmentKeys = [self.segmentKeysByIdentifier[@(segment->keyIdentifier)] bytes];
+    if (!segmentKeys)
+    {
+        DLog(@"No key %u to read the segment at offset %lld", segment->keyIdentifier, (long long) segment->offset);
+        return nil;
+    }
+    
+    NSMutableData *segmentData = [NSMutableData dataWithLength:UHNBGMEncryptedSegmentLength(segment)];
+    uint8_t *bytes = [segmentData mutableBytes];
+    if (!UHNBGMStoreRead(_fileDescriptor, bytes, [segmentData length], segment->offset))
+    {
+        return nil;
+    }
+    
+    // encrypt-then-MAC: nothing is decrypted before the segment is authenticated
+    uint8_t tag[kEncryptedRecordStoreTagLength];
+    CCHmac(kCCHmacAlgSHA256, segmentKeys + CC_SHA256_DIGEST_LENGTH, CC_SHA256_DIGEST_LENGTH, bytes, kEncryptedRecordStoreSegmentHeaderLength + segment->ciphertextLength, tag);
+    if (!UHNBGMTagsMatch(tag, bytes + kEncryptedRecordStoreSegmentHeaderLength + segment->ciphertextLength))
+    {
+        DLog(@"The segment at offset %lld failed authentication", (long long) segment->offset);
+        return nil;
+    }
+    
+    if (segment->ordinal != UHNBGMStoreGetUInt32(bytes + kEncryptedRecordStoreOrdinalOffset))
+    {
+        DLog(@"The segment at offset %lld is not segment %u", (long long) segment->offset, segment->ordinal);
+        return nil;
+    }
+    
+    if (decrypt)
+    {
+        size_t decryptedLength = 0;
+        uint8_t *ciphertext = bytes + kEncryptedRecordStoreSegmentHeaderLength;
+        CCCryptorRef cryptor;
+        if (kCCSuccess != CCCryptorCreateWithMode(kCCDecrypt, kCCModeCTR, kCCAlgorithmAES, ccNoPadding, bytes + kEncryptedRecordStoreNonceOffset, segmentKeys, kCCKeySizeAES256, NULL, 0, 0, kCCModeOptionCTR_BE, &cryptor))
+        {
+            return nil;
+        }
+        
+        // counter mode decrypts in place
+        BOOL decrypted = (kCCSuccess == CCCryptorUpdate(cryptor, ciphertext, segment->ciphertextLength, ciphertext, segment->ciphertextLength, &decryptedLength) && decryptedLength == segment->ciphertextLength);
+        CCCryptorRelease(cryptor);
+        
+        if (!decrypted)
+        {
+            return nil;
+        }
+    }
+    
+    return segmentData;
+}
+
+- (BOOL) enumerateRecordsInSegmentAtIndex:(NSUInteger) segmentIndex usingBlock:(UHNBGMEncryptedRecordBlock) block;
+{
+    BOOL stop = NO;
+    return [self enumerateRecordsInSegmentAtIndex:segmentIndex stop:&stop usingBlock:block];
+}
+
+- (BOOL) enumerateRecordsUsingBlock:(UHNBGMEncryptedRecordBlock) block;
+{
+    BOOL stop = NO;
+    NSUInteger numberOfSegments = self.numberOfSegments;
+    
+    for (NSUInteger segmentIndex = 0; !stop && segmentIndex < numberOfSegments; segmentIndex++)
+    {
+        if (![self enumerateRecordsInSegmentAtIndex:segmentIndex stop:&stop usingBlock:block])
+        {
+            return NO;
+        }
+    }
+    
+    return YES;
+}
+
+- (BOOL) enumerateRecordsInSegmentAtIndex:(NSUInteger) segmentIndex stop:(BOOL *) stop usingBlock:(UHNBGMEncryptedRecordBlock) block;
+{
+    UHNBGMEncryptedSegment segment = {0};
+    NSMutableData *segmentData = nil;
+    
+    pthread_mutex_lock(&_lock);
+    if (segmentIndex < [self.segments length] / sizeof(UHNBGMEncryptedSegment))
+    {
+        segment = ((const UHNBGMEncryptedSegment *) [self.segments bytes])[segmentIndex];
+        segmentData = [self readSegment:&segment decrypt:YES];
+    }
+    pthread_mutex_unlock(&_lock);
+    
+    if (!segmentData)
+    {
+        return NO;
+    }
+    
+    // the block is called without the lock, so it can use the store
+    uint8_t *records = (uint8_t *) [segmentData mutableBytes] + kEncryptedRecordStoreSegmentHeaderLength;
+    NSUInteger position = 0;
+    BOOL wellFormed = YES;
+    
+    while (!*stop && position < segment.ciphertextLength)
+    {
+        NSUInteger measurementLength = records[position];
+        NSUInteger contextOffset = position + 1 + measurementLength;
+        if (contextOffset >= segment.ciphertextLength || contextOffset + 1 + records[contextOffset] > segment.ciphertextLength)
+        {
+            wellFormed = NO;
+            break;
+        }
+        
+        NSUInteger contextLength = records[contextOffset];
+        NSData *measurementData = [NSData dataWithBytes:records + position + 1 length:measurementLength];
+        NSData *measurementContextData = (contextLength > 0 ? [NSData dataWithBytes:records + contextOffset + 1 length:contextLength] : nil);
+        block(measurementData, measurementContextData, stop);
+        position = contextOffset + 1 + contextLength;
+    }
+    
+    UHNBGMSecureZero(records, segment.ciphertextLength);
+    
+    return wellFormed;
+}
+
+#pragma mark - Record Sink Methods
+
+- (UHNBGMRecordSinkInterest) recordSinkInterests;
+{
+    return (UHNBGMRecordSinkInterestMeasurements | UHNBGMRecordSinkInterestMeasurementContexts | UHNBGMRecordSinkInterestTransferEvents);
+}
+
+// the sink callbacks all arrive on the delegate queue of the controller, so the record pairer needs no lock
+- (void) bgmController:(UHNBGMController *) controller didReceiveGlucoseMeasurement:(NSDictionary *) measurementDetails;
+{
+    [self.recordPairer addMeasurementDetails:measurementDetails usingBlock:^(NSData *measurementData, NSData *measurementContextData) {
+        [self addMeasurementData:measurementData contextData:measurementContextData];
+    }];
+}
+
+- (void) bgmController:(UHNBGMController *) controller didReceiveGlucoseMeasurementContext:(NSDictionary *) measurementContextDetails;
+{
+    [self.recordPairer addMeasurementContextDetails:measurementContextDetails usingBlock:^(NSData *measurementData, NSData *measurementContextData) {
+        [self addMeasurementData:measurementData contextData:measurementContextData];
+    }];
+}
+
+- (void) bgmController:(UHNBGMController *) controller didCompleteTransferWithNumberOfRecords:(NSUInteger) numberOfRecords;
+{
+    [self.recordPairer flushUsingBlock:^(NSData *measurementData, NSData *measurementContextData) {
+        [self addMeasurementData:measurementData contextData:measurementContextData];
+    }];
+    [self flush];
+}
+
+@end
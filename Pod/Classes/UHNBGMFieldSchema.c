@@ -0,0 +1,154 @@
+//
+//  UHNBGMFieldSchema.c
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+
+#include "UHNBGMGlucoseFieldLayout.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <string.h>
+
+// https://developer.bluetooth.org/gatt/characteristics/Pages/CharacteristicViewer.aspx?u=org.bluetooth.characteristic.glucose_measurement.xml
+static const UHNBGMFieldSchema kGlucoseMeasurementSchema[GlucoseMeasurementFieldCount] =
+{
+    [GlucoseMeasurementFieldTimeOffset]                 = {(1 << 0), UHNBGMFieldTypeSInt16},
+    [GlucoseMeasurementFieldGlucoseConcentration]       = {(1 << 1), UHNBGMFieldTypeSFloat},
+    [GlucoseMeasurementFieldType]                       = {(1 << 1), UHNBGMFieldTypeLowNibble},
+    [GlucoseMeasurementFieldSampleLocation]             = {(1 << 1), UHNBGMFieldTypeHighNibble},
+    [GlucoseMeasurementFieldSensorStatusAnnunciation]   = {(1 << 3), UHNBGMFieldTypeUInt16},
+};
+
+// https://developer.bluetooth.org/gatt/characteristics/Pages/CharacteristicViewer.aspx?u=org.bluetooth.characteristic.glucose_measurement_context.xml
+static const UHNBGMFieldSchema kGlucoseMeasurementContextSchema[GlucoseMeasurementContextFieldCount] =
+{
+    [GlucoseMeasurementContextFieldExtendedFlags]       = {(1 << 7), UHNBGMFieldTypeUInt8},
+    [GlucoseMeasurementContextFieldCarbohydrateID]      = {(1 << 0), UHNBGMFieldTypeUInt8},
+    [GlucoseMeasurementContextFieldCarbohydrate]        = {(1 << 0), UHNBGMFieldTypeSFloat},
+    [GlucoseMeasurementContextFieldMeal]                = {(1 << 1), UHNBGMFieldTypeUInt8},
+    [GlucoseMeasurementContextFieldTester]              = {(1 << 2), UHNBGMFieldTypeLowNibble},
+    [GlucoseMeasurementContextFieldHealth]              = {(1 << 2), UHNBGMFieldTypeHighNibble},
+    [GlucoseMeasurementContextFieldExerciseDuration]    = {(1 << 3), UHNBGMFieldTypeUInt16},
+    [GlucoseMeasurementContextFieldExerciseIntensity]   = {(1 << 3), UHNBGMFieldTypeUInt8},
+    [GlucoseMeasurementContextFieldMedicationID]        = {(1 << 4), UHNBGMFieldTypeUInt8},
+    [GlucoseMeasurementContextFieldMedicationValue]     = {(1 << 4), UHNBGMFieldTypeSFloat},
+    [GlucoseMeasurementContextFieldHbA1c]               = {(1 << 6), UHNBGMFieldTypeSFloat},
+};
+
+#define kGlucoseMeasurementFixedLength          10
+#define kGlucoseMeasurementContextFixedLength   3
+
+static UHNBGMFieldLayout glucoseMeasurementLayout;
+static UHNBGMFieldLayout glucoseMeasurementContextLayout;
+static pthread_once_t glucoseLayoutsOnce = PTHREAD_ONCE_INIT;
+
+uint8_t UHNBGMFieldTypeSize(UHNBGMFieldType type)
+{
+    switch (type)
+    {
+        case UHNBGMFieldTypeUInt16:
+        case UHNBGMFieldTypeSInt16:
+        case UHNBGMFieldTypeSFloat:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+bool UHNBGMCompileFieldLayout(const UHNBGMFieldSchema *schema, uint8_t numberOfFields, uint8_t fixedLength, UHNBGMFieldLayout *layout)
+{
+    if (numberOfFields > kUHNBGMFieldSchemaMaximumNumberOfFields)
+    {
+        return false;
+    }
+    
+    memset(layout, 0, sizeof(*layout));
+    layout->numberOfFields = numberOfFields;
+    layout->fixedLength = fixedLength;
+    
+    for (unsigned int field = 0; field < numberOfFields; field++)
+    {
+        layout->fieldTypes[field] = schema[field].type;
+    }
+    
+    for (unsigned int flags = 0; flags < 256; flags++)
+    {
+        unsigned int position = fixedLength;
+        unsigned int previousOffset = kUHNBGMFieldAbsent;
+        
+        for (unsigned int field = 0; field < numberOfFields; field++)
+        {
+            layout->fieldOffsets[flags][field] = kUHNBGMFieldAbsent;
+            
+            if (!(schema[field].flagMask & flags))
+            {
+                continue;
+            }
+            
+            // a high nibble lives in the byte of the low nibble before it and does not move the position
+            if (UHNBGMFieldTypeHighNibble == schema[field].type)
+            {
+                if (0 == field || UHNBGMFieldTypeLowNibble != schema[field - 1].type || kUHNBGMFieldAbsent == previousOffset)
+                {
+                    return false;
+                }
+                
+                layout->fieldOffsets[flags][field] = previousOffset;
+                continue;
+            }
+            
+            if (position + UHNBGMFieldTypeSize(schema[field].type) >= kUHNBGMFieldAbsent)
+            {
+                return false;
+            }
+            
+            layout->fieldOffsets[flags][field] = position;
+            previousOffset = position;
+            position += UHNBGMFieldTypeSize(schema[field].type);
+        }
+        
+        layout->requiredLengths[flags] = position;
+    }
+    
+    return true;
+}
+
+// a layout that failed to compile marks every field absent and requires more bytes than a characteristic value holds, so every value is rejected rather than read at a wrong offset
+static void UHNBGMRejectAllValues(UHNBGMFieldLayout *layout)
+{
+    memset(layout->fieldOffsets, kUHNBGMFieldAbsent, sizeof(layout->fieldOffsets));
+    memset(layout->requiredLengths, kUHNBGMFieldAbsent, sizeof(layout->requiredLengths));
+    layout->fixedLength = kUHNBGMFieldAbsent;
+}
+
+static void UHNBGMCompileGlucoseLayouts(void)
+{
+    bool didCompileMeasurementLayout = UHNBGMCompileFieldLayout(kGlucoseMeasurementSchema, GlucoseMeasurementFieldCount, kGlucoseMeasurementFixedLength, &glucoseMeasurementLayout);
+    bool didCompileMeasurementContextLayout = UHNBGMCompileFieldLayout(kGlucoseMeasurementContextSchema, GlucoseMeasurementContextFieldCount, kGlucoseMeasurementContextFixedLength, &glucoseMeasurementContextLayout);
+    
+    assert(didCompileMeasurementLayout && didCompileMeasurementContextLayout);
+    
+    if (!didCompileMeasurementLayout)
+    {
+        UHNBGMRejectAllValues(&glucoseMeasurementLayout);
+    }
+    
+    if (!didCompileMeasurementContextLayout)
+    {
+        UHNBGMRejectAllValues(&glucoseMeasurementContextLayout);
+    }
+}
+
+const UHNBGMFieldLayout *UHNBGMMeasurementFieldLayout(void)
+{
+    pthread_once(&glucoseLayoutsOnce, UHNBGMCompileGlucoseLayouts);
+    return &glucoseMeasurementLayout;
+}
+
+const UHNBGMFieldLayout *UHNBGMMeasurementContextFieldLayout(void)
+{
+    pthread_once(&glucoseLayoutsOnce, UHNBGMCompileGlucoseLayouts);
+    return &glucoseMeasurementContextLayout;
+}
@@ -0,0 +1,158 @@
+//
+//  UHNBGMFieldSchema.h
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Declarative description of the optional fields of a characteristic. A schema lists the optional fields in the order
+// they appear, each with the flag that makes it present and its type. A schema is compiled once into a layout holding
+// the offset of every field for each of the 256 possible flag values, so decoding a field is a single table lookup
+// instead of a walk over the flags and the preceding fields. The glucose service layouts are in
+// UHNBGMGlucoseFieldLayout.h.
+
+#ifndef UHNBGMFieldSchema_h
+#define UHNBGMFieldSchema_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define kUHNBGMFieldSchemaMaximumNumberOfFields     12
+#define kUHNBGMFieldAbsent                          0xFF
+
+/**
+ The types of the optional fields. A high nibble shares the byte of the low nibble field that precedes it.
+ */
+typedef enum
+{
+    UHNBGMFieldTypeUInt8,
+    UHNBGMFieldTypeUInt16,
+    UHNBGMFieldTypeSInt16,
+    UHNBGMFieldTypeSFloat,
+    UHNBGMFieldTypeLowNibble,
+    UHNBGMFieldTypeHighNibble,
+} UHNBGMFieldType;
+
+/**
+ An optional field of a characteristic
+ */
+typedef struct
+{
+    /** The field is present if any of the bits of the mask are set in the flags */
+    uint8_t flagMask;
+    /** The type of the field */
+    UHNBGMFieldType type;
+} UHNBGMFieldSchema;
+
+/**
+ A compiled schema
+ */
+typedef struct
+{
+    uint8_t numberOfFields;
+    /** The length of the mandatory fields that precede the optional fields */
+    uint8_t fixedLength;
+    /** The offset of each field for each flag value, kUHNBGMFieldAbsent if the field is not present */
+    uint8_t fieldOffsets[256][kUHNBGMFieldSchemaMaximumNumberOfFields];
+    /** The length required by all the fields present for each flag value */
+    uint8_t requiredLengths[256];
+    /** The type of each field */
+    UHNBGMFieldType fieldTypes[kUHNBGMFieldSchemaMaximumNumberOfFields];
+} UHNBGMFieldLayout;
+
+/**
+ Compiles a schema into a layout. This is how the layouts of other services can be added.
+ 
+ @return `false` if the schema has too many fields or a high nibble does not follow a low nibble
+ */
+bool UHNBGMCompileFieldLayout(const UHNBGMFieldSchema *schema, uint8_t numberOfFields, uint8_t fixedLength, UHNBGMFieldLayout *layout);
+
+/**
+ The number of bytes read for a field type
+ */
+uint8_t UHNBGMFieldTypeSize(UHNBGMFieldType type);
+
+/**
+ The offset of a field for the given flags, or kUHNBGMFieldAbsent if the field is not present
+ */
+static inline uint8_t UHNBGMFieldOffset(const UHNBGMFieldLayout *layout, uint8_t flags, unsigned int field)
+{
+    return layout->fieldOffsets[flags][field];
+}
+
+/**
+ Reads a field as an unsigned integer (UInt8, UInt16 and nibbles) or a two's complement signed integer (SInt16), or as the raw bits of an SFLOAT. The field must be present.
+ */
+static inline int32_t UHNBGMFieldIntegerValue(const UHNBGMFieldLayout *layout, const uint8_t *bytes, uint8_t offset, unsigned int field)
+{
+    switch (layout->fieldTypes[field])
+    {
+        case UHNBGMFieldTypeUInt8:
+            return bytes[offset];
+        case UHNBGMFieldTypeUInt16:
+        case UHNBGMFieldTypeSFloat:
+            return (uint16_t) (bytes[offset] | (bytes[offset + 1] << 8));
+        case UHNBGMFieldTypeSInt16:
+            return (int16_t) (bytes[offset] | (bytes[offset + 1] << 8));
+        case UHNBGMFieldTypeLowNibble:
+            return bytes[offset] & 0x0F;
+        case UHNBGMFieldTypeHighNibble:
+            return bytes[offset] >> 4;
+    }
+    
+    return 0;
+}
+
+/**
+ Writes a field as `UHNBGMFieldIntegerValue` reads it. A nibble is combined with the other nibble of its byte, so the bytes must start out zeroed. The field must be present.
+ */
+static inline void UHNBGMSetFieldIntegerValue(const UHNBGMFieldLayout *layout, uint8_t *bytes, uint8_t offset, unsigned int field, int32_t value)
+{
+    switch (layout->fieldTypes[field])
+    {
+        case UHNBGMFieldTypeUInt8:
+            bytes[offset] = (uint8_t) value;
+            break;
+        case UHNBGMFieldTypeUInt16:
+        case UHNBGMFieldTypeSFloat:
+        case UHNBGMFieldTypeSInt16:
+            bytes[offset] = (uint8_t) value;
+            bytes[offset + 1] = (uint8_t) (value >> 8);
+            break;
+        case UHNBGMFieldTypeLowNibble:
+            bytes[offset] |= (uint8_t) (value & 0x0F);
+            break;
+        case UHNBGMFieldTypeHighNibble:
+            bytes[offset] |= (uint8_t) ((value & 0x0F) << 4);
+            break;
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UHNBGMFieldSchema_h */
@@ -0,0 +1,84 @@
+//
+//  UHNBGMGlucoseFieldLayout.h
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// The compiled layouts of the glucose measurement and glucose measurement context characteristics. The field numbers
+// are private to the pod; they are only meaningful for the layouts compiled in UHNBGMFieldSchema.c.
+
+#ifndef UHNBGMGlucoseFieldLayout_h
+#define UHNBGMGlucoseFieldLayout_h
+
+#include "UHNBGMFieldSchema.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ The optional fields of the glucose measurement characteristic, in the order of the glucose measurement schema
+ */
+typedef enum
+{
+    GlucoseMeasurementFieldTimeOffset           = 0,
+    GlucoseMeasurementFieldGlucoseConcentration,
+    GlucoseMeasurementFieldType,
+    GlucoseMeasurementFieldSampleLocation,
+    GlucoseMeasurementFieldSensorStatusAnnunciation,
+    GlucoseMeasurementFieldCount,
+} GlucoseMeasurementField;
+
+/**
+ The optional fields of the glucose measurement context characteristic, in the order of the glucose measurement context schema
+ */
+typedef enum
+{
+    GlucoseMeasurementContextFieldExtendedFlags = 0,
+    GlucoseMeasurementContextFieldCarbohydrateID,
+    GlucoseMeasurementContextFieldCarbohydrate,
+    GlucoseMeasurementContextFieldMeal,
+    GlucoseMeasurementContextFieldTester,
+    GlucoseMeasurementContextFieldHealth,
+    GlucoseMeasurementContextFieldExerciseDuration,
+    GlucoseMeasurementContextFieldExerciseIntensity,
+    GlucoseMeasurementContextFieldMedicationID,
+    GlucoseMeasurementContextFieldMedicationValue,
+    GlucoseMeasurementContextFieldHbA1c,
+    GlucoseMeasurementContextFieldCount,
+} GlucoseMeasurementContextField;
+
+/**
+ The compiled layout of the glucose measurement characteristic
+ */
+const UHNBGMFieldLayout *UHNBGMMeasurementFieldLayout(void);
+
+/**
+ The compiled layout of the glucose measurement context characteristic
+ */
+const UHNBGMFieldLayout *UHNBGMMeasurementContextFieldLayout(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UHNBGMGlucoseFieldLayout_h */
@@ -0,0 +1,183 @@
+//
+//  UHNBGMHistory.h
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+/**
+ A glucose reading as stored by `UHNBGMHistory`
+ */
+typedef struct
+{
+    /** The creation time of the measurement, in seconds since 1970-01-01 00:00:00 UTC */
+    NSTimeInterval timeIntervalSince1970;
+    /** The glucose concentration in the units given by the flags, NAN if not present */
+    float glucoseConcentration;
+    /** The glucose measurement flags (see GlucoseMeasurementFlagOption) */
+    uint8_t flags;
+    /** The meal of the measurement context (see GlucoseMeasurementContextMeal), 0 if unknown */
+    uint8_t meal;
+    /** The sensor status annunciation (see GlucoseMeasurementStatusOption), 0 if not present */
+    uint16_t sensorStatusAnnunciation;
+    /** The sequence number of the measurement */
+    uint16_t sequenceNumber;
+} UHNBGMHistoryReading;
+
+/**
+ `UHNBGMHistory` holds the glucose readings of an app in memory, ordered by creation time, without the object overhead of keeping a `NSDictionary` per reading.
+ 
+ @discussion Each part of a reading is stored in its own packed column (18 bytes per reading in total), so a scan over a range of times or glucose concentrations only touches the memory it needs. Once the capacity is reached the oldest reading is evicted for every new one. On a memory warning the history keeps only the latest `retainedCountOnMemoryWarning` readings.
+ 
+ The history is not thread safe and, since memory warnings are handled on the main thread, should be used from the main thread.
+ */
+@interface UHNBGMHistory : NSObject
+
+/**
+ The maximum number of readings kept. Lowering the capacity evicts the oldest readings
+ */
+@property (nonatomic, assign) NSUInteger capacity;
+
+/**
+ The number of readings kept on a memory warning. Defaults to 512
+ */
+@property (nonatomic, assign) NSUInteger retainedCountOnMemoryWarning;
+
+/**
+ The number of readings in the history
+ */
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/**
+ Initializes a history
+ 
+ @param capacity The maximum number of readings kept
+ 
+ @return The initialized history
+ 
+ */
+- (instancetype) initWithCapacity:(NSUInteger) capacity;
+
+#pragma mark - Adding Readings
+
+/**
+ Adds a reading. Readings added out of order are inserted by creation time. If the history is full the oldest reading is evicted, unless the new reading is older than all the others, in which case it is dropped
+ 
+ @param reading The reading to add
+ 
+ @return `YES` if the reading was added, otherwise `NO`, which includes the storage for more readings not being allocated
+ 
+ */
+- (BOOL) addReading:(const UHNBGMHistoryReading *) reading;
+
+/**
+ Adds a glucose measurement as returned by `parseGlucoseMeasurementCharacteristicDetails:`
+ 
+ @param measurementDetails The glucose measurement details
+ 
+ @return `YES` if the measurement was added, otherwise `NO`
+ 
+ */
+- (BOOL) addMeasurement:(NSDictionary *) measurementDetails;
+
+/**
+ Sets the meal of the latest reading with the given sequence number, which is how a glucose measurement context is linked to its measurement
+ 
+ @param meal The meal of the measurement context (see GlucoseMeasurementContextMeal)
+ @param sequenceNumber The sequence number of the measurement
+ 
+ @return `YES` if a reading with the sequence number was found, otherwise `NO`
+ 
+ */
+- (BOOL) setMeal:(uint8_t) meal forSequenceNumber:(uint16_t) sequenceNumber;
+
+/**
+ Evicts the oldest readings until at most `count` are left
+ 
+ @param count The number of readings to keep
+ 
+ */
+- (void) trimToCount:(NSUInteger) count;
+
+/**
+ Removes all readings and releases their memory
+ */
+- (void) removeAllReadings;
+
+#pragma mark - Queries
+
+/**
+ Finds the readings created between two dates. Index 0 is the oldest reading
+ 
+ @param startDate The earliest creation time, inclusive
+ @param endDate The latest creation time, inclusive
+ 
+ @return The range of indexes of the readings, with a length of 0 if there are none
+ 
+ */
+- (NSRange) rangeOfReadingsFromDate:(NSDate *) startDate toDate:(NSDate *) endDate;
+
+/**
+ Copies the latest readings, the newest first
+ 
+ @param readings A buffer for at least `count` readings
+ @param count The maximum number of readings to copy
+ 
+ @return The number of readings copied
+ 
+ */
+- (NSUInteger) getLatestReadings:(UHNBGMHistoryReading *) readings count:(NSUInteger) count;
+
+/**
+ Copies a range of readings, the oldest first
+ 
+ @param readings A buffer for at least `range.length` readings
+ @param range The range of indexes to copy. Index 0 is the oldest reading
+ 
+ @return The number of readings copied
+ 
+ */
+- (NSUInteger) getReadings:(UHNBGMHistoryReading *) readings range:(NSRange) range;
+
+/**
+ Copies the creation times and glucose concentrations of a range of readings, the oldest first. This is the fastest way to scan the history, for example to plot it
+ 
+ @param times A buffer for at least `range.length` creation times, or `NULL`
+ @param glucoseConcentrations A buffer for at least `range.length` glucose concentrations, or `NULL`
+ @param range The range of indexes to copy. Index 0 is the oldest reading
+ 
+ @return The number of readings copied
+ 
+ */
+- (NSUInteger) getTimes:(NSTimeInterval *) times glucoseConcentrations:(float *) glucoseConcentrations range:(NSRange) range;
+
+/**
+ Enumerates a range of readings, the oldest first
+ 
+ @param range The range of indexes to enumerate. Index 0 is the oldest reading
+ @param block The block called for each reading. The reading is only valid during the call
+ 
+ */
+- (void) enumerateReadingsInRange:(NSRange) range usingBlock:(void (^)(const UHNBGMHistoryReading *reading, NSUInteger index, BOOL *stop)) block;
+
+@end
@@ -0,0 +1,458 @@
+//
+//  UHNBGMHistory.m
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+
+#import <UIKit/UIKit.h>
+#import "UHNBGMHistory.h"
+#import "UHNBGMConstants.h"
+#import "UHNDebug.h"
+
+#define kHistoryDefaultCapacity                 65536
+#define kHistoryDefaultRetainedCount            512
+#define kHistoryMinimumStorageSize              64
+
+// copies a range of logical indexes out of a ring buffer column, in at most two pieces
+static void UHNBGMCopyColumnRange(void *destination, const void *column, size_t elementSize, NSUInteger storageSize, NSUInteger head, NSRange range)
+{
+    NSUInteger start = (head + range.location) % storageSize;
+    NSUInteger firstLength = MIN(range.length, storageSize - start);
+    
+    memcpy(destination, (const uint8_t *) column + start * elementSize, firstLength * elementSize);
+    memcpy((uint8_t *) destination + firstLength * elementSize, column, (range.length - firstLength) * elementSize);
+}
+
+@interface UHNBGMHistory ()
+{
+    // each part of a reading is kept in its own column so scans only touch what they need
+    NSTimeInterval *_times;
+    float *_glucoseConcentrations;
+    uint8_t *_flags;
+    uint8_t *_meals;
+    uint16_t *_sensorStatusAnnunciations;
+    uint16_t *_sequenceNumbers;
+    
+    // the columns are ring buffers of storageSize readings, the oldest at head
+    NSUInteger _storageSize;
+    NSUInteger _head;
+}
+@property (nonatomic, assign, readwrite) NSUInteger count;
+@end
+
+@implementation UHNBGMHistory
+
+#pragma mark - Object Lifecycle
+
+- (instancetype) init;
+{
+    return [self initWithCapacity:kHistoryDefaultCapacity];
+}
+
+- (instancetype) initWithCapacity:(NSUInteger) capacity;
+{
+    if ((self = [super init]))
+    {
+        _capacity = capacity;
+        _retainedCountOnMemoryWarning = kHistoryDefaultRetainedCount;
+        
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(didReceiveMemoryWarning:) name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
+    }
+    
+    return self;
+}
+
+- (void) dealloc;
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    [self freeStorage];
+}
+
+#pragma mark - Accessor Methods
+
+- (void) setCapacity:(NSUInteger) capacity;
+{
+    _capacity = capacity;
+    
+    [self trimToCount:capacity];
+    
+    if (0 == capacity)
+    {
+        [self freeStorage];
+    }
+    else if (_storageSize > capacity)
+    {
+        [self resizeStorageToSize:capacity];
+    }
+}
+
+#pragma mark - Adding Readings
+
+- (BOOL) addReading:(const UHNBGMHistoryReading *) reading;
+{
+    if (0 == self.capacity)
+    {
+        return NO;
+    }
+    
+    // readings mostly arrive in order, so start the search from the newest reading
+    NSUInteger insertIndex = self.count;
+    
+    if (insertIndex && reading->timeIntervalSince1970 < [self timeAtIndex:insertIndex - 1])
+    {
+        insertIndex = [self indexOfFirstReadingAfterTime:reading->timeIntervalSince1970];
+    }
+    
+    if (self.count == self.capacity)
+    {
+        // a reading older than all the others would be evicted straight away
+        if (0 == insertIndex)
+        {
+            return NO;
+        }
+        
+        _head = (_head + 1) % _storageSize;
+        self.count--;
+        insertIndex--;
+    }
+    else if (self.count == _storageSize)
+    {
+        // the reading is dropped if the columns cannot grow
+        if (![self resizeStorageToSize:MIN(MAX(_storageSize * 2, kHistoryMinimumStorageSize), self.capacity)])
+        {
+            return NO;
+        }
+    }
+    
+    // make room for an out of order reading
+    for (NSUInteger index = self.count; index > insertIndex; index--)
+    {
+        NSUInteger from = [self storageIndexForIndex:index - 1];
+        NSUInteger to = [self storageIndexForIndex:index];
+        
+        _times[to] = _times[from];
+        _glucoseConcentrations[to] = _glucoseConcentrations[from];
+        _flags[to] = _flags[from];
+        _meals[to] = _meals[from];
+        _sensorStatusAnnunciations[to] = _sensorStatusAnnunciations[from];
+        _sequenceNumbers[to] = _sequenceNumbers[from];
+    }
+    
+    NSUInteger storageIndex = [self storageIndexForIndex:insertIndex];
+    _times[storageIndex] = reading->timeIntervalSince1970;
+    _glucoseConcentrations[storageIndex] = reading->glucoseConcentration;
+    _flags[storageIndex] = reading->flags;
+    _meals[storageIndex] = reading->meal;
+    _sensorStatusAnnunciations[storageIndex] = reading->sensorStatusAnnunciation;
+    _sequenceNumbers[storageIndex] = reading->sequenceNumber;
+    self.count++;
+    
+    return YES;
+}
+
+- (BOOL) addMeasurement:(NSDictionary *) measurementDetails;
+{
+    NSDate *creationDate = measurementDetails[kGlucoseMeasurementKeyCreationDate];
+    
+    if (nil == creationDate)
+    {
+        return NO;
+    }
+    
+    UHNBGMHistoryReading reading = {0};
+    reading.timeIntervalSince1970 = [creationDate timeIntervalSince1970];
+    reading.sequenceNumber = [measurementDetails[kGlucoseMeasurementKeySequenceNumber] unsignedShortValue];
+    reading.glucoseConcentration = NAN;
+    
+    if (measurementDetails[kGlucoseMeasurementKeyTimeOffset])
+    {
+        reading.flags |= GlucoseMeasurementFlagPresentTimeOffset;
+    }
+    
+    NSNumber *glucoseConcentration = measurementDetails[kGlucoseMeasurementKeyGlucoseConcentration];
+    
+    if (glucoseConcentration)
+    {
+        reading.glucoseConcentration = [glucoseConcentration floatValue];
+        reading.flags |= GlucoseMeasurementFlagPresentGlucoseConcentrationTypeAndSampleLocation;
+        
+        if (GlucoseMeasurementGlucoseConcentrationUnitsMolPerL == [measurementDetails[kGlucoseMeasurementKeyGlucoseConcentrationUnits] unsignedIntegerValue])
+        {
+            reading.flags |= GlucoseMeasurementFlagGlucoseConcentrationUnits;
+        }
+    }
+    
+    NSNumber *sensorStatusAnnunciation = measurementDetails[kGlucoseMeasurementKeySensorStatusAnnunciation];
+    
+    if (sensorStatusAnnunciation)
+    {
+        reading.sensorStatusAnnunciation = [sensorStatusAnnunciation unsignedShortValue];
+        reading.flags |= GlucoseMeasurementFlagPresentSensorStatusAnnunciation;
+    }
+    
+    return [self addReading:&reading];
+}
+
+- (BOOL) setMeal:(uint8_t) meal forSequenceNumber:(uint16_t) sequenceNumber;
+{
+    // the context of a measurement follows it, so it is usually the newest reading
+    for (NSUInteger index = self.count; index > 0; index--)
+    {
+        NSUInteger storageIndex = [self storageIndexForIndex:index - 1];
+        
+        if (_sequenceNumbers[storageIndex] == sequenceNumber)
+        {
+            _meals[storageIndex] = meal;
+            return YES;
+        }
+    }
+    
+    return NO;
+}
+
+- (void) trimToCount:(NSUInteger) count;
+{
+    if (self.count > count)
+    {
+        _head = (_head + self.count - count) % _storageSize;
+        self.count = count;
+    }
+}
+
+- (void) removeAllReadings;
+{
+    [self freeStorage];
+    self.count = 0;
+}
+
+#pragma mark - Queries
+
+- (NSRange) rangeOfReadingsFromDate:(NSDate *) startDate toDate:(NSDate *) endDate;
+{
+    NSUInteger startIndex = [self indexOfFirstReadingAtOrAfterTime:[startDate timeIntervalSince1970]];
+    NSUInteger endIndex = [self indexOfFirstReadingAfterTime:[endDate timeIntervalSince1970]];
+    
+    return NSMakeRange(startIndex, endIndex > startIndex ? endIndex - startIndex : 0);
+}
+
+- (NSUInteger) getLatestReadings:(UHNBGMHistoryReading *) readings count:(NSUInteger) count;
+{
+    count = MIN(count, self.count);
+    
+    for (NSUInteger index = 0; index < count; index++)
+    {
+        [self getReading:&readings[index] atStorageIndex:[self storageIndexForIndex:self.count - (index + 1)]];
+    }
+    
+    return count;
+}
+
+- (NSUInteger) getReadings:(UHNBGMHistoryReading *) readings range:(NSRange) range;
+{
+    range = [self clampedRange:range];
+    
+    for (NSUInteger index = 0; index < range.length; index++)
+    {
+        [self getReading:&readings[index] atStorageIndex:[self storageIndexForIndex:range.location + index]];
+    }
+    
+    return range.length;
+}
+
+- (NSUInteger) getTimes:(NSTimeInterval *) times glucoseConcentrations:(float *) glucoseConcentrations range:(NSRange) range;
+{
+    range = [self clampedRange:range];
+    
+    if (0 == range.length)
+    {
+        return 0;
+    }
+    
+    if (times)
+    {
+        UHNBGMCopyColumnRange(times, _times, sizeof(NSTimeInterval), _storageSize, _head, range);
+    }
+    
+    if (glucoseConcentrations)
+    {
+        UHNBGMCopyColumnRange(glucoseConcentrations, _glucoseConcentrations, sizeof(float), _storageSize, _head, range);
+    }
+    
+    return range.length;
+}
+
+- (void) enumerateReadingsInRange:(NSRange) range usingBlock:(void (^)(const UHNBGMHistoryReading *reading, NSUInteger index, BOOL *stop)) block;
+{
+    range = [self clampedRange:range];
+    
+    UHNBGMHistoryReading reading;
+    BOOL stop = NO;
+    
+    for (NSUInteger index = range.location; index < NSMaxRange(range) && !stop; index++)
+    {
+        [self getReading:&reading atStorageIndex:[self storageIndexForIndex:index]];
+        block(&reading, index, &stop);
+    }
+}
+
+#pragma mark - Notification Methods
+
+- (void) didReceiveMemoryWarning:(NSNotification *) notification;
+{
+    [self trimToCount:self.retainedCountOnMemoryWarning];
+    
+    if (self.count)
+    {
+        [self resizeStorageToSize:self.count];
+    }
+    else
+    {
+        [self freeStorage];
+    }
+}
+
+#pragma mark - Private Methods
+
+- (NSUInteger) storageIndexForIndex:(NSUInteger) index;
+{
+    return (_head + index) % _storageSize;
+}
+
+- (NSTimeInterval) timeAtIndex:(NSUInteger) index;
+{
+    return _times[[self storageIndexForIndex:index]];
+}
+
+- (NSUInteger) indexOfFirstReadingAfterTime:(NSTimeInterval) time;
+{
+    NSUInteger low = 0;
+    NSUInteger high = self.count;
+    
+    while (low < high)
+    {
+        NSUInteger middle = low + (high - low) / 2;
+        
+        if ([self timeAtIndex:middle] <= time)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    
+    return low;
+}
+
+- (NSUInteger) indexOfFirstReadingAtOrAfterTime:(NSTimeInterval) time;
+{
+    NSUInteger low = 0;
+    NSUInteger high = self.count;
+    
+    while (low < high)
+    {
+        NSUInteger middle = low + (high - low) / 2;
+        
+        if ([self timeAtIndex:middle] < time)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    
+    return low;
+}
+
+- (NSRange) clampedRange:(NSRange) range;
+{
+    if (range.location >= self.count)
+    {
+        return NSMakeRange(self.count, 0);
+    }
+    
+    return NSMakeRange(range.location, MIN(range.length, self.count - range.location));
+}
+
+- (void) getReading:(UHNBGMHistoryReading *) reading atStorageIndex:(NSUInteger) storageIndex;
+{
+    reading->timeIntervalSince1970 = _times[storageIndex];
+    reading->glucoseConcentration = _glucoseConcentrations[storageIndex];
+    reading->flags = _flags[storageIndex];
+    reading->meal = _meals[storageIndex];
+    reading->sensorStatusAnnunciation = _sensorStatusAnnunciations[storageIndex];
+    reading->sequenceNumber = _sequenceNumbers[storageIndex];
+}
+
+- (BOOL) resizeStorageToSize:(NSUInteger) storageSize;
+{
+    // the readings are copied in order, so the oldest ends up at the start of the new columns
+    NSRange range = NSMakeRange(0, self.count);
+    NSTimeInterval *times = malloc(storageSize * sizeof(NSTimeInterval));
+    float *glucoseConcentrations = malloc(storageSize * sizeof(float));
+    uint8_t *flags = malloc(storageSize * sizeof(uint8_t));
+    uint8_t *meals = malloc(storageSize * sizeof(uint8_t));
+    uint16_t *sensorStatusAnnunciations = malloc(storageSize * sizeof(uint16_t));
+    uint16_t *sequenceNumbers = malloc(storageSize * sizeof(uint16_t));
+    
+    // if any column cannot be allocated, the readings stay in the current columns
+    if (!times || !glucoseConcentrations || !flags || !meals || !sensorStatusAnnunciations || !sequenceNumbers)
+    {
+        DLog(@"Could not allocate the storage for %lu readings", (unsigned long) storageSize);
+        
+        free(times);
+        free(glucoseConcentrations);
+        free(flags);
+        free(meals);
+        free(sensorStatusAnnunciations);
+        free(sequenceNumbers);
+        return NO;
+    }
+    
+    if (range.length)
+    {
+        UHNBGMCopyColumnRange(times, _times, sizeof(NSTimeInterval), _storageSize, _head, range);
+        UHNBGMCopyColumnRange(glucoseConcentrations, _glucoseConcentrations, sizeof(float), _storageSize, _head, range);
+        UHNBGMCopyColumnRange(flags, _flags, sizeof(uint8_t), _storageSize, _head, range);
+        UHNBGMCopyColumnRange(meals, _meals, sizeof(uint8_t), _storageSize, _head, range);
+        UHNBGMCopyColumnRange(sensorStatusAnnunciations, _sensorStatusAnnunciations, sizeof(uint16_t), _storageSize, _head, range);
+        UHNBGMCopyColumnRange(sequenceNumbers, _sequenceNumbers, sizeof(uint16_t), _storageSize, _head, range);
+    }
+    
+    [self freeStorage];
+    
+    _times = times;
+    _glucoseConcentrations = glucoseConcentrations;
+    _flags = flags;
+    _meals = meals;
+    _sensorStatusAnnunciations = sensorStatusAnnunciations;
+    _sequenceNumbers = sequenceNumbers;
+    _storageSize = storageSize;
+    
+    return YES;
+}
+
+- (void) freeStorage;
+{
+    free(_times);
+    free(_glucoseConcentrations);
+    free(_flags);
+    free(_meals);
+    free(_sensorStatusAnnunciations);
+    free(_sequenceNumbers);
+    
+    _times = NULL;
+    _glucoseConcentrations = NULL;
+    _flags = NULL;
+    _meals = NULL;
+    _sensorStatusAnnunciations = NULL;
+    _sequenceNumbers = NULL;
+    _storageSize = 0;
+    _head = 0;
+}
+
+@end
@@ -0,0 +1,182 @@
+//
+//  UHNBGMHistoryPyramid.h
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "UHNBGMHistory.h"
+#import "UHNBGMRecordSink.h"
+
+/**
+ The resolutions of a `UHNBGMHistoryPyramid`, finest first
+ */
+typedef NS_ENUM (NSUInteger, UHNBGMHistoryResolution)
+{
+    /** Buckets of one hour */
+    UHNBGMHistoryResolutionHour = 0,
+    /** Buckets of one day */
+    UHNBGMHistoryResolutionDay,
+    /** Buckets of one week, starting on Monday */
+    UHNBGMHistoryResolutionWeek,
+};
+
+/**
+ The summary of the glucose readings of a bucket or a chart column
+ */
+typedef struct
+{
+    /** The start of the bucket or column, in seconds since 1970-01-01 00:00:00 UTC */
+    NSTimeInterval startTime;
+    /** The number of readings, 0 for an empty column */
+    NSUInteger count;
+    /** The lowest glucose concentration in mg/dL, NAN if there are no readings */
+    float minimum;
+    /** The highest glucose concentration in mg/dL, NAN if there are no readings */
+    float maximum;
+    /** The mean glucose concentration in mg/dL, NAN if there are no readings */
+    float mean;
+} UHNBGMHistoryBucket;
+
+/**
+ `UHNBGMHistoryPyramid` summarizes glucose readings into hourly, daily and weekly buckets holding their minimum, maximum and mean, so a chart of any period reads a number of buckets proportional to its width in pixels rather than to the number of readings.
+ 
+ @discussion The buckets are updated as each reading is added, in constant time for readings added in order. Only buckets with readings are kept, sorted by time in one packed array per resolution. Glucose concentrations are summarized in mg/dL, whatever the units of the readings. Hours, days and weeks follow the wall clock of the time zone of the pyramid, with the UTC offset of each reading, so days start at midnight on either side of a daylight saving change; the hour repeated when the clocks go back shares its bucket.
+ 
+ The pyramid can be added to a `UHNBGMController` as a record sink, to be built as records are received. Like `UHNBGMHistory` it is not thread safe, and should be used from the delegate queue of the controller (the main queue by default).
+ */
+@interface UHNBGMHistoryPyramid : NSObject <UHNBGMRecordSink>
+
+/**
+ The time zone the buckets are aligned to
+ */
+@property (nonatomic, strong, readonly) NSTimeZone *timeZone;
+
+/**
+ The number of readings summarized
+ */
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/**
+ Initializes a pyramid aligned to the system time zone
+ 
+ @return The initialized pyramid
+ 
+ */
+- (instancetype) init;
+
+/**
+ Initializes a pyramid
+ 
+ @param timeZone The time zone the buckets are aligned to
+ 
+ @return The initialized pyramid
+ 
+ */
+- (instancetype) initWithTimeZone:(NSTimeZone *) timeZone;
+
+#pragma mark - Adding Readings
+
+/**
+ Adds a reading. Readings without a glucose concentration are ignored
+ 
+ @param reading The reading to add
+ 
+ @return `YES` if the reading was added, otherwise `NO`
+ 
+ */
+- (BOOL) addReading:(const UHNBGMHistoryReading *) reading;
+
+/**
+ Adds a glucose measurement as returned by `parseGlucoseMeasurementCharacteristicDetails:`
+ 
+ @param measurementDetails The glucose measurement details
+ 
+ @return `YES` if the measurement was added, otherwise `NO`
+ 
+ */
+- (BOOL) addMeasurement:(NSDictionary *) measurementDetails;
+
+/**
+ Adds the readings of a history
+ 
+ @param history The history to summarize
+ 
+ */
+- (void) addReadingsFromHistory:(UHNBGMHistory *) history;
+
+/**
+ Removes all the buckets and releases their memory
+ */
+- (void) removeAllBuckets;
+
+#pragma mark - Queries
+
+/**
+ The number of buckets with readings at a resolution
+ 
+ @param resolution The resolution
+ 
+ @return The number of buckets
+ 
+ */
+- (NSUInteger) numberOfBucketsAtResolution:(UHNBGMHistoryResolution) resolution;
+
+/**
+ Copies the buckets with readings of a period, the oldest first
+ 
+ @param buckets A buffer for at least `count` buckets
+ @param count The maximum number of buckets to copy
+ @param resolution The resolution of the buckets
+ @param startDate The earliest start of a bucket, inclusive
+ @param endDate The latest start of a bucket, exclusive
+ 
+ @return The number of buckets copied
+ 
+ */
+- (NSUInteger) getBuckets:(UHNBGMHistoryBucket *) buckets count:(NSUInteger) count resolution:(UHNBGMHistoryResolution) resolution fromDate:(NSDate *) startDate toDate:(NSDate *) endDate;
+
+/**
+ The coarsest resolution whose buckets are no wider than the columns of a chart, or hours if the columns are narrower than an hour
+ 
+ @param duration The period shown by the chart, in seconds
+ @param numberOfColumns The number of columns of the chart, usually its width in pixels
+ 
+ @return The resolution
+ 
+ */
+- (UHNBGMHistoryResolution) resolutionForDuration:(NSTimeInterval) duration numberOfColumns:(NSUInteger) numberOfColumns;
+
+/**
+ Summarizes a period into the columns of a chart
+ 
+ @param columns A buffer for `numberOfColumns` columns
+ @param numberOfColumns The number of columns of equal width the period is split into, usually the width of the chart in pixels
+ @param startDate The start of the period, inclusive
+ @param endDate The end of the period, exclusive
+ 
+ @discussion The buckets are read at the resolution given by `resolutionForDuration:numberOfColumns:`, so no more than a few buckets are read per column whatever the number of readings. Each bucket is summarized in the column its start falls in.
+ 
+ */
+- (void) getColumns:(UHNBGMHistoryBucket *) columns numberOfColumns:(NSUInteger) numberOfColumns fromDate:(NSDate *) startDate toDate:(NSDate *) endDate;
+
+@end
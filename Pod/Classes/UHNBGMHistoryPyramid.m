@@ -0,0 +1,308 @@
+//
+//  UHNBGMHistoryPyramid.m
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+
+#import "UHNBGMHistoryPyramid.h"
+#import "UHNBGMConstants.h"
+
+#define kHistoryPyramidNumberOfResolutions  3
+// 1970-01-05, the first Monday after the epoch, so week buckets start on Mondays
+#define kHistoryPyramidOrigin               (4 * 86400)
+
+static const int64_t kHistoryPyramidBucketWidths[kHistoryPyramidNumberOfResolutions] = {3600, 86400, 7 * 86400};
+
+/**
+ A bucket as stored, with the sum of its readings so the mean can be updated and merged
+ */
+typedef struct
+{
+    /** The number of bucket widths since the origin, in the wall clock time of the time zone of the pyramid */
+    int64_t index;
+    double sum;
+    float minimum;
+    float maximum;
+    uint32_t count;
+} UHNBGMPyramidBucket;
+
+// returns the index of the first bucket with an index of at least `index`
+static inline NSUInteger UHNBGMPyramidLowerBound(const UHNBGMPyramidBucket *buckets, NSUInteger count, int64_t index)
+{
+    NSUInteger low = 0;
+    NSUInteger high = count;
+    
+    while (low < high)
+    {
+        NSUInteger middle = low + (high - low) / 2;
+        if (buckets[middle].index < index)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    
+    return low;
+}
+
+@interface UHNBGMHistoryPyramid ()
+@property (nonatomic, strong, readwrite) NSTimeZone *timeZone;
+@property (nonatomic, assign, readwrite) NSUInteger count;
+// one NSMutableData of UHNBGMPyramidBucket per resolution, sorted by index
+@property (nonatomic, strong) NSArray *levels;
+@end
+
+@implementation UHNBGMHistoryPyramid
+
+#pragma mark - Initialization Methods
+
+- (instancetype) init;
+{
+    return [self initWithTimeZone:[NSTimeZone systemTimeZone]];
+}
+
+- (instancetype) initWithTimeZone:(NSTimeZone *) timeZone;
+{
+    if ((self = [super init]))
+    {
+        self.timeZone = timeZone;
+        self.levels = @[[NSMutableData data], [NSMutableData data], [NSMutableData data]];
+    }
+    
+    return self;
+}
+
+#pragma mark - Time Methods
+
+- (NSTimeInterval) localTimeForTime:(NSTimeInterval) time;
+{
+    // the offset of the time itself, so readings on either side of a daylight saving change fall in the right day
+    return time + CFTimeZoneGetSecondsFromGMT((__bridge CFTimeZoneRef) self.timeZone, time - kCFAbsoluteTimeIntervalSince1970);
+}
+
+- (NSTimeInterval) timeForLocalTime:(NSTimeInterval) localTime;
+{
+    // the offset is looked up again at the time found, in case a daylight saving change lies between the two
+    CFTimeZoneRef timeZone = (__bridge CFTimeZoneRef) self.timeZone;
+    CFAbsoluteTime time = localTime - kCFAbsoluteTimeIntervalSince1970;
+    CFTimeInterval utcOffset = CFTimeZoneGetSecondsFromGMT(timeZone, time);
+    utcOffset = CFTimeZoneGetSecondsFromGMT(timeZone, time - utcOffset);
+    
+    return localTime - utcOffset;
+}
+
+- (int64_t) bucketIndexForLocalTime:(NSTimeInterval) localTime resolution:(UHNBGMHistoryResolution) resolution;
+{
+    return (int64_t) floor((localTime - kHistoryPyramidOrigin) / kHistoryPyramidBucketWidths[resolution]);
+}
+
+- (NSTimeInterval) startTimeForBucketIndex:(int64_t) index resolution:(UHNBGMHistoryResolution) resolution;
+{
+    return [self timeForLocalTime:(NSTimeInterval) (index * kHistoryPyramidBucketWidths[resolution] + kHistoryPyramidOrigin)];
+}
+
+#pragma mark - Adding Readings
+
+- (BOOL) addReading:(const UHNBGMHistoryReading *) reading;
+{
+    // summarized in mg/dL: kg/L is 1e5 mg/dL, mol/L is 100 times the molar mass in mg/dL
+    float glucoseConcentration = reading->glucoseConcentration * ((reading->flags & GlucoseMeasurementFlagGlucoseConcentrationUnits) ? kGlucoseMolarMass * 100. : 1e5);
+    
+    if (!isfinite(glucoseConcentration))
+    {
+        return NO;
+    }
+    
+    NSTimeInterval localTime = [self localTimeForTime:reading->timeIntervalSince1970];
+    for (UHNBGMHistoryResolution resolution = UHNBGMHistoryResolutionHour; resolution < kHistoryPyramidNumberOfResolutions; resolution++)
+    {
+        [self addGlucoseConcentration:glucoseConcentration toBucketAtIndex:[self bucketIndexForLocalTime:localTime resolution:resolution] level:self.levels[resolution]];
+    }
+    
+    self.count += 1;
+    
+    return YES;
+}
+
+- (void) addGlucoseConcentration:(float) glucoseConcentration toBucketAtIndex:(int64_t) index level:(NSMutableData *) level;
+{
+    UHNBGMPyramidBucket *buckets = [level mutableBytes];
+    NSUInteger count = [level length] / sizeof(UHNBGMPyramidBucket);
+    
+    // readings mostly arrive in order, so the bucket is usually the last one or a new one after it
+    NSUInteger position = count;
+    if (count > 0 && buckets[count - 1].index >= index)
+    {
+        position = (buckets[count - 1].index == index ? count - 1 : UHNBGMPyramidLowerBound(buckets, count, index));
+    }
+    
+    if (position == count || buckets[position].index != index)
+    {
+        UHNBGMPyramidBucket bucket = {index, 0., INFINITY, -INFINITY, 0};
+        [level replaceBytesInRange:NSMakeRange(position * sizeof(UHNBGMPyramidBucket), 0) withBytes:&bucket length:sizeof(UHNBGMPyramidBucket)];
+        buckets = [level mutableBytes];
+    }
+    
+    UHNBGMPyramidBucket *bucket = &buckets[position];
+    bucket->sum += glucoseConcentration;
+    bucket->minimum = MIN(bucket->minimum, glucoseConcentration);
+    bucket->maximum = MAX(bucket->maximum, glucoseConcentration);
+    bucket->count += 1;
+}
+
+- (BOOL) addMeasurement:(NSDictionary *) measurementDetails;
+{
+    NSDate *creationDate = measurementDetails[kGlucoseMeasurementKeyCreationDate];
+    NSNumber *glucoseConcentration = measurementDetails[kGlucoseMeasurementKeyGlucoseConcentration];
+    
+    if (nil == creationDate || nil == glucoseConcentration)
+    {
+        return NO;
+    }
+    
+    UHNBGMHistoryReading reading = {0};
+    reading.timeIntervalSince1970 = [creationDate timeIntervalSince1970];
+    reading.glucoseConcentration = [glucoseConcentration floatValue];
+    
+    if (GlucoseMeasurementGlucoseConcentrationUnitsMolPerL == [measurementDetails[kGlucoseMeasurementKeyGlucoseConcentrationUnits] unsignedIntegerValue])
+    {
+        reading.flags |= GlucoseMeasurementFlagGlucoseConcentrationUnits;
+    }
+    
+    return [self addReading:&reading];
+}
+
+- (void) addReadingsFromHistory:(UHNBGMHistory *) history;
+{
+    [history enumerateReadingsInRange:NSMakeRange(0, history.count) usingBlock:^(const UHNBGMHistoryReading *reading, NSUInteger index, BOOL *stop) {
+        [self addReading:reading];
+    }];
+}
+
+- (void) removeAllBuckets;
+{
+    self.levels = @[[NSMutableData data], [NSMutableData data], [NSMutableData data]];
+    self.count = 0;
+}
+
+#pragma mark - Queries
+
+- (NSUInteger) numberOfBucketsAtResolution:(UHNBGMHistoryResolution) resolution;
+{
+    return [self.levels[resolution] length] / sizeof(UHNBGMPyramidBucket);
+}
+
+- (NSUInteger) getBuckets:(UHNBGMHistoryBucket *) buckets count:(NSUInteger) count resolution:(UHNBGMHistoryResolution) resolution fromDate:(NSDate *) startDate toDate:(NSDate *) endDate;
+{
+    NSData *level = self.levels[resolution];
+    const UHNBGMPyramidBucket *levelBuckets = [level bytes];
+    NSUInteger levelCount = [level length] / sizeof(UHNBGMPyramidBucket);
+    
+    // the buckets starting within the period
+    int64_t width = kHistoryPyramidBucketWidths[resolution];
+    int64_t firstIndex = (int64_t) ceil(([self localTimeForTime:[startDate timeIntervalSince1970]] - kHistoryPyramidOrigin) / width);
+    int64_t endIndex = (int64_t) ceil(([self localTimeForTime:[endDate timeIntervalSince1970]] - kHistoryPyramidOrigin) / width);
+    NSUInteger copied = 0;
+    
+    for (NSUInteger position = UHNBGMPyramidLowerBound(levelBuckets, levelCount, firstIndex); position < levelCount && levelBuckets[position].index < endIndex && copied < count; position++)
+    {
+        const UHNBGMPyramidBucket *bucket = &levelBuckets[position];
+        buckets[copied].startTime = [self startTimeForBucketIndex:bucket->index resolution:resolution];
+        buckets[copied].count = bucket->count;
+        buckets[copied].minimum = bucket->minimum;
+        buckets[copied].maximum = bucket->maximum;
+        buckets[copied].mean = (float) (bucket->sum / bucket->count);
+        copied++;
+    }
+    
+    return copied;
+}
+
+- (UHNBGMHistoryResolution) resolutionForDuration:(NSTimeInterval) duration numberOfColumns:(NSUInteger) numberOfColumns;
+{
+    NSTimeInterval columnWidth = duration / MAX(numberOfColumns, 1);
+    
+    for (NSInteger resolution = UHNBGMHistoryResolutionWeek; resolution > UHNBGMHistoryResolutionHour; resolution--)
+    {
+        if (kHistoryPyramidBucketWidths[resolution] <= columnWidth)
+        {
+            return (UHNBGMHistoryResolution) resolution;
+        }
+    }
+    
+    return UHNBGMHistoryResolutionHour;
+}
+
+- (void) getColumns:(UHNBGMHistoryBucket *) columns numberOfColumns:(NSUInteger) numberOfColumns fromDate:(NSDate *) startDate toDate:(NSDate *) endDate;
+{
+    if (0 == numberOfColumns)
+    {
+        return;
+    }
+    
+    NSTimeInterval startTime = [startDate timeIntervalSince1970];
+    NSTimeInterval endTime = [endDate timeIntervalSince1970];
+    NSTimeInterval columnWidth = (endTime - startTime) / numberOfColumns;
+    NSMutableData *sums = [NSMutableData dataWithLength:numberOfColumns * sizeof(double)];
+    double *columnSums = [sums mutableBytes];
+    
+    for (NSUInteger column = 0; column < numberOfColumns; column++)
+    {
+        columns[column] = (UHNBGMHistoryBucket) {startTime + column * columnWidth, 0, NAN, NAN, NAN};
+    }
+    
+    if (columnWidth <= 0)
+    {
+        return;
+    }
+    
+    UHNBGMHistoryResolution resolution = [self resolutionForDuration:(endTime - startTime) numberOfColumns:numberOfColumns];
+    NSData *level = self.levels[resolution];
+    const UHNBGMPyramidBucket *buckets = [level bytes];
+    NSUInteger count = [level length] / sizeof(UHNBGMPyramidBucket);
+    
+    // the bucket holding the start of the period is summarized in the first column
+    for (NSUInteger position = UHNBGMPyramidLowerBound(buckets, count, [self bucketIndexForLocalTime:[self localTimeForTime:startTime] resolution:resolution]); position < count; position++)
+    {
+        const UHNBGMPyramidBucket *bucket = &buckets[position];
+        NSTimeInterval bucketStartTime = [self startTimeForBucketIndex:bucket->index resolution:resolution];
+        
+        if (bucketStartTime >= endTime)
+        {
+            break;
+        }
+        
+        NSUInteger column = (bucketStartTime <= startTime ? 0 : MIN((NSUInteger) ((bucketStartTime - startTime) / columnWidth), numberOfColumns - 1));
+        UHNBGMHistoryBucket *summary = &columns[column];
+        summary->minimum = (summary->count > 0 ? MIN(summary->minimum, bucket->minimum) : bucket->minimum);
+        summary->maximum = (summary->count > 0 ? MAX(summary->maximum, bucket->maximum) : bucket->maximum);
+        summary->count += bucket->count;
+        columnSums[column] += bucket->sum;
+    }
+    
+    for (NSUInteger column = 0; column < numberOfColumns; column++)
+    {
+        if (columns[column].count > 0)
+        {
+            columns[column].mean = (float) (columnSums[column] / columns[column].count);
+        }
+    }
+}
+
+#pragma mark - Record Sink Methods
+
+- (UHNBGMRecordSinkInterest) recordSinkInterests;
+{
+    return UHNBGMRecordSinkInterestMeasurements;
+}
+
+- (void) bgmController:(UHNBGMController *) controller didReceiveGlucoseMeasurement:(NSDictionary *) measurementDetails;
+{
+    [self addMeasurement:measurementDetails];
+}
+
+@end
@@ -0,0 +1,149 @@
+//
+//  UHNBGMIngestLedger.h
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+/**
+ `UHNBGMIngestLedger` remembers which glucose measurements were already delivered, so the records received again by a full transfer, a retry or another bond of the same glucose sensor are dropped before they are decoded, stored or uploaded. A record is identified by the peripheral identifier of the glucose sensor, its sequence number and its base time.
+ 
+ @discussion Each record of a glucose sensor is kept as an 8 byte key made of its sequence number and its base time, sorted in its generation so it is found by bisection, and a record is a duplicate only if a generation holds that exact key. A record whose sequence number is already in the latest generation with a different base time means the sensor was reset (its sequence numbers start over), and starts a new generation. Runs of sequence numbers with a base time per run would take less memory, but could not tell a record from another with the same sequence number and a base time inside the run; a million records of a glucose sensor take 8 MB.
+ 
+ A measurement is evaluated when it is received, and only entered in the ledger once it is committed after it was persisted, so a measurement that was received but not persisted, e.g. because the app was stopped, is ingested again by a retry.
+ 
+ The ledger is evaluated on the raw characteristic values, and a glucose measurement context is dropped when the glucose measurement it belongs to was dropped. The ledger is thread safe.
+ */
+@interface UHNBGMIngestLedger : NSObject
+
+/**
+ The path the ledger is saved to, or `nil` if it is only kept in memory
+ */
+@property (nonatomic, copy, readonly) NSString *path;
+
+/**
+ The number of measurements dropped as duplicates
+ */
+@property (nonatomic, assign, readonly) NSUInteger numberOfDuplicatesDropped;
+
+/**
+ Initializes a ledger, loading the records saved at a path
+ 
+ @param path The path the ledger is loaded from and saved to, or `nil` to keep the ledger in memory. A missing or unreadable file gives an empty ledger
+ 
+ @return The initialized ledger
+ 
+ */
+- (instancetype) initWithPath:(NSString *) path;
+
+///------------------
+/// @name Evaluation
+///------------------
+
+/**
+ Evaluates a glucose measurement, without entering it in the ledger
+ 
+ @param data The glucose measurement characteristic value
+ @param peripheralIdentifier The identifier of the glucose sensor, or `nil` if it is unknown
+ 
+ @return `YES` if the measurement should be ingested, `NO` if it is a duplicate. Values that are too short to evaluate are ingested
+ 
+ @discussion A measurement that should be ingested is entered by `commitMeasurementData:fromPeripheralWithIdentifier:` once it was persisted
+ 
+ */
+- (BOOL) shouldIngestMeasurementData:(NSData *) data fromPeripheralWithIdentifier:(NSUUID *) peripheralIdentifier;
+
+/**
+ Enters a glucose measurement in the ledger, so it is dropped when it is received again
+ 
+ @param data The glucose measurement characteristic value
+ @param peripheralIdentifier The identifier of the glucose sensor, or `nil` if it is unknown
+ 
+ */
+- (void) commitMeasurementData:(NSData *) data fromPeripheralWithIdentifier:(NSUUID *) peripheralIdentifier;
+
+/**
+ Evaluates a glucose measurement context
+ 
+ @param data The glucose measurement context characteristic value
+ @param peripheralIdentifier The identifier of the glucose sensor, or `nil` if it is unknown
+ 
+ @return `YES` if the measurement context should be ingested, `NO` if its measurement was dropped
+ 
+ @discussion The latest measurement evaluated is remembered for each glucose sensor, so controllers of several glucose sensors can share the ledger
+ 
+ */
+- (BOOL) shouldIngestMeasurementContextData:(NSData *) data fromPeripheralWithIdentifier:(NSUUID *) peripheralIdentifier;
+
+/**
+ Determine if a glucose measurement was entered in the ledger, without entering it
+ 
+ @param data The glucose measurement characteristic value
+ @param peripheralIdentifier The identifier of the glucose sensor, or `nil` if it is unknown
+ 
+ @return `YES` if the measurement was entered in the ledger, otherwise `NO`
+ 
+ */
+- (BOOL) containsMeasurementData:(NSData *) data fromPeripheralWithIdentifier:(NSUUID *) peripheralIdentifier;
+
+///--------------------
+/// @name Ledger Content
+///--------------------
+
+/**
+ The number of measurements entered in the ledger for a glucose sensor. Each measurement takes 8 bytes
+ 
+ @param peripheralIdentifier The identifier of the glucose sensor, or `nil` if it is unknown
+ 
+ @return The number of measurements
+ 
+ */
+- (NSUInteger) numberOfRecordsForPeripheralWithIdentifier:(NSUUID *) peripheralIdentifier;
+
+/**
+ The number of generations of a glucose sensor, one more for every time its sequence numbers started over
+ 
+ @param peripheralIdentifier The identifier of the glucose sensor, or `nil` if it is unknown
+ 
+ @return The number of generations
+ 
+ */
+- (NSUInteger) numberOfGenerationsForPeripheralWithIdentifier:(NSUUID *) peripheralIdentifier;
+
+/**
+ Forgets the measurements of a glucose sensor
+ 
+ @param peripheralIdentifier The identifier of the glucose sensor, or `nil` if it is unknown
+ 
+ */
+- (void) removeRecordsForPeripheralWithIdentifier:(NSUUID *) peripheralIdentifier;
+
+/**
+ Saves the ledger to its path
+ 
+ @return `YES` if the ledger was saved, `NO` if it could not be written or has no path
+ 
+ */
+- (BOOL) save;
+
+@end
@@ -0,0 +1,434 @@
+//
+//  UHNBGMIngestLedger.m
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+
+#import <pthread.h>
+#import "UHNBGMIngestLedger.h"
+#import "UHNDebug.h"
+
+#define kIngestLedgerFileMagic          0x4C4E4855 // "UHNL"
+#define kIngestLedgerFileVersion        2
+#define kIngestLedgerBaseTimeBits       42
+
+// the sequence number and the base time are the first mandatory fields of a glucose measurement
+static inline BOOL UHNBGMIngestKey(NSData *data, uint16_t *sequenceNumber, uint64_t *key)
+{
+    if ([data length] < 10)
+    {
+        return NO;
+    }
+    
+    const uint8_t *bytes = [data bytes];
+    uint16_t year = bytes[3] | (bytes[4] << 8);
+    *sequenceNumber = bytes[1] | (bytes[2] << 8);
+    
+    // the base time is packed field by field, which orders base times like dates without any calendar arithmetic, and
+    // the sequence number above it keeps the records of a generation sorted by sequence number
+    uint64_t baseTime = ((uint64_t) year << 26) | ((uint64_t) (bytes[5] & 0x0F) << 22) | ((uint64_t) (bytes[6] & 0x1F) << 17) | ((uint64_t) (bytes[7] & 0x1F) << 12) | ((uint64_t) (bytes[8] & 0x3F) << 6) | (bytes[9] & 0x3F);
+    *key = ((uint64_t) *sequenceNumber << kIngestLedgerBaseTimeBits) | baseTime;
+    
+    return YES;
+}
+
+// returns the index of the first key of a generation that is not less than the key
+static inline NSUInteger UHNBGMIngestLowerBound(const uint64_t *keys, NSUInteger count, uint64_t key)
+{
+    NSUInteger low = 0;
+    NSUInteger high = count;
+    
+    while (low < high)
+    {
+        NSUInteger middle = low + (high - low) / 2;
+        if (keys[middle] < key)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    
+    return low;
+}
+
+static inline BOOL UHNBGMIngestGenerationContainsKey(NSData *generation, uint64_t key)
+{
+    const uint64_t *keys = [generation bytes];
+    NSUInteger count = [generation length] / sizeof(uint64_t);
+    NSUInteger index = UHNBGMIngestLowerBound(keys, count, key);
+    
+    return (index < count && keys[index] == key);
+}
+
+// the records of a generation with the sequence number are next to each other, from the one with the earliest base time
+static inline BOOL UHNBGMIngestGenerationHoldsSequenceNumber(NSData *generation, uint16_t sequenceNumber)
+{
+    const uint64_t *keys = [generation bytes];
+    NSUInteger count = [generation length] / sizeof(uint64_t);
+    NSUInteger index = UHNBGMIngestLowerBound(keys, count, (uint64_t) sequenceNumber << kIngestLedgerBaseTimeBits);
+    
+    return (index < count && (keys[index] >> kIngestLedgerBaseTimeBits) == sequenceNumber);
+}
+
+static void UHNBGMIngestInsert(NSMutableData *generation, uint64_t key)
+{
+    const uint64_t *keys = [generation bytes];
+    NSUInteger count = [generation length] / sizeof(uint64_t);
+    NSUInteger index = UHNBGMIngestLowerBound(keys, count, key);
+    
+    // a glucose sensor numbering its records in order only ever appends
+    if (index == count || keys[index] != key)
+    {
+        [generation replaceBytesInRange:NSMakeRange(index * sizeof(uint64_t), 0) withBytes:&key length:sizeof(uint64_t)];
+    }
+}
+
+@interface UHNBGMIngestLedger ()
+{
+    pthread_mutex_t _lock;
+}
+@property (nonatomic, copy, readwrite) NSString *path;
+@property (nonatomic, assign, readwrite) NSUInteger numberOfDuplicatesDropped;
+// the generations of each glucose sensor, oldest first, each a NSMutableData of record keys in ascending order
+@property (nonatomic, strong) NSMutableDictionary *generationsByPeripheral;
+// the sequence number of the latest measurement of each glucose sensor, if it was dropped
+@property (nonatomic, strong) NSMutableDictionary *droppedSequenceNumbersByPeripheral;
+@end
+
+@implementation UHNBGMIngestLedger
+
+#pragma mark - Initialization Methods
+
+- (instancetype) init;
+{
+    return [self initWithPath:nil];
+}
+
+- (instancetype) initWithPath:(NSString *) path;
+{
+    if ((self = [super init]))
+    {
+        pthread_mutex_init(&_lock, NULL);
+        self.path = path;
+        self.generationsByPeripheral = [NSMutableDictionary dictionary];
+        self.droppedSequenceNumbersByPeripheral = [NSMutableDictionary dictionary];
+        
+        NSData *data = (path ? [NSData dataWithContentsOfFile:path] : nil);
+        if (data && ![self loadData:data])
+        {
+            DLog(@"Ignoring the unreadable ingest ledger at %@", path);
+            [self.generationsByPeripheral removeAllObjects];
+        }
+    }
+    
+    return self;
+}
+
+- (void) dealloc;
+{
+    pthread_mutex_destroy(&_lock);
+}
+
+- (NSUUID *) keyForPeripheralIdentifier:(NSUUID *) peripheralIdentifier;
+{
+    static NSUUID *unknownPeripheralIdentifier;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        uuid_t nullBytes = {0};
+        unknownPeripheralIdentifier = [[NSUUID alloc] initWithUUIDBytes:nullBytes];
+    });
+    
+    return (peripheralIdentifier ?: unknownPeripheralIdentifier);
+}
+
+#pragma mark - Evaluation Methods
+
+- (BOOL) shouldIngestMeasurementData:(NSData *) data fromPeripheralWithIdentifier:(NSUUID *) peripheralIdentifier;
+{
+    uint16_t sequenceNumber;
+    uint64_t key;
+    if (!UHNBGMIngestKey(data, &sequenceNumber, &key))
+    {
+        return YES;
+    }
+    
+    BOOL shouldIngest = YES;
+    pthread_mutex_lock(&_lock);
+    
+    NSUUID *peripheralKey = [self keyForPeripheralIdentifier:peripheralIdentifier];
+    if ([self generations:self.generationsByPeripheral[peripheralKey] containKey:key])
+    {
+        shouldIngest = NO;
+        self.droppedSequenceNumbersByPeripheral[peripheralKey] = @(sequenceNumber);
+        self.numberOfDuplicatesDropped += 1;
+    }
+    else
+    {
+        [self.droppedSequenceNumbersByPeripheral removeObjectForKey:peripheralKey];
+    }
+    
+    pthread_mutex_unlock(&_lock);
+    
+    return shouldIngest;
+}
+
+- (void) commitMeasurementData:(NSData *) data fromPeripheralWithIdentifier:(NSUUID *) peripheralIdentifier;
+{
+    uint16_t sequenceNumber;
+    uint64_t key;
+    if (!UHNBGMIngestKey(data, &sequenceNumber, &key))
+    {
+        return;
+    }
+    
+    pthread_mutex_lock(&_lock);
+    
+    NSUUID *peripheralKey = [self keyForPeripheralIdentifier:peripheralIdentifier];
+    NSMutableArray *generations = self.generationsByPeripheral[peripheralKey];
+    if (!generations)
+    {
+        generations = [NSMutableArray arrayWithObject:[NSMutableData data]];
+        self.generationsByPeripheral[peripheralKey] = generations;
+    }
+    
+    if (![self generations:generations containKey:key])
+    {
+        // the sequence number is taken in the latest generation by another record, so the glucose sensor was reset
+        NSMutableData *latestGeneration = [generations lastObject];
+        if (UHNBGMIngestGenerationHoldsSequenceNumber(latestGeneration, sequenceNumber))
+        {
+            latestGeneration = [NSMutableData data];
+            [generations addObject:latestGeneration];
+        }
+        
+        UHNBGMIngestInsert(latestGeneration, key);
+    }
+    
+    pthread_mutex_unlock(&_lock);
+}
+
+- (BOOL) shouldIngestMeasurementContextData:(NSData *) data fromPeripheralWithIdentifier:(NSUUID *) peripheralIdentifier;
+{
+    BOOL shouldIngest = YES;
+    pthread_mutex_lock(&_lock);
+    
+    // a measurement context follows its measurement, so only the latest dropped measurement of each glucose sensor needs to be remembered
+    NSNumber *droppedSequenceNumber = self.droppedSequenceNumbersByPeripheral[[self keyForPeripheralIdentifier:peripheralIdentifier]];
+    if (droppedSequenceNumber && [data length] >= 3)
+    {
+        const uint8_t *bytes = [data bytes];
+        uint16_t sequenceNumber = bytes[1] | (bytes[2] << 8);
+        shouldIngest = (sequenceNumber != [droppedSequenceNumber unsignedShortValue]);
+    }
+    
+    pthread_mutex_unlock(&_lock);
+    
+    return shouldIngest;
+}
+
+- (BOOL) containsMeasurementData:(NSData *) data fromPeripheralWithIdentifier:(NSUUID *) peripheralIdentifier;
+{
+    uint16_t sequenceNumber;
+    uint64_t key;
+    if (!UHNBGMIngestKey(data, &sequenceNumber, &key))
+    {
+        return NO;
+    }
+    
+    pthread_mutex_lock(&_lock);
+    BOOL contains = [self generations:self.generationsByPeripheral[[self keyForPeripheralIdentifier:peripheralIdentifier]] containKey:key];
+    pthread_mutex_unlock(&_lock);
+    
+    return contains;
+}
+
+- (BOOL) generations:(NSArray *) generations containKey:(uint64_t) key;
+{
+    // the latest generation is the most likely to hold a record received again
+    for (NSData *generation in [generations reverseObjectEnumerator])
+    {
+        if (UHNBGMIngestGenerationContainsKey(generation, key))
+        {
+            return YES;
+        }
+    }
+    
+    return NO;
+}
+
+#pragma mark - Ledger Content Methods
+
+- (NSUInteger) numberOfRecordsForPeripheralWithIdentifier:(NSUUID *) peripheralIdentifier;
+{
+    NSUInteger numberOfRecords = 0;
+    pthread_mutex_lock(&_lock);
+    
+    for (NSData *generation in self.generationsByPeripheral[[self keyForPeripheralIdentifier:peripheralIdentifier]])
+    {
+        numberOfRecords += [generation length] / sizeof(uint64_t);
+    }
+    
+    pthread_mutex_unlock(&_lock);
+    
+    return numberOfRecords;
+}
+
+- (NSUInteger) numberOfGenerationsForPeripheralWithIdentifier:(NSUUID *) peripheralIdentifier;
+{
+    pthread_mutex_lock(&_lock);
+    NSUInteger numberOfGenerations = [self.generationsByPeripheral[[self keyForPeripheralIdentifier:peripheralIdentifier]] count];
+    pthread_mutex_unlock(&_lock);
+    
+    return numberOfGenerations;
+}
+
+- (void) removeRecordsForPeripheralWithIdentifier:(NSUUID *) peripheralIdentifier;
+{
+    pthread_mutex_lock(&_lock);
+    [self.generationsByPeripheral removeObjectForKey:[self keyForPeripheralIdentifier:peripheralIdentifier]];
+    [self.droppedSequenceNumbersByPeripheral removeObjectForKey:[self keyForPeripheralIdentifier:peripheralIdentifier]];
+    pthread_mutex_unlock(&_lock);
+}
+
+#pragma mark - Persistence Methods
+
+/*
+ The saved ledger, all integers little endian:
+ magic (uint32), version (uint32), number of glucose sensors (uint32), then for each glucose sensor
+ - peripheral identifier (16 bytes), number of generations (uint32), then for each generation
+   - number of records (uint32), then the key of each record (uint64) in ascending order, its sequence number above
+     its packed base time
+ */
+
+- (BOOL) save;
+{
+    if (!self.path)
+    {
+        return NO;
+    }
+    
+    NSMutableData *data = [NSMutableData data];
+    pthread_mutex_lock(&_lock);
+    
+    [self appendUInt32:kIngestLedgerFileMagic toData:data];
+    [self appendUInt32:kIngestLedgerFileVersion toData:data];
+    [self appendUInt32:(uint32_t) [self.generationsByPeripheral count] toData:data];
+    
+    [self.generationsByPeripheral enumerateKeysAndObjectsUsingBlock:^(NSUUID *peripheralIdentifier, NSArray *generations, BOOL *stop) {
+        uuid_t identifierBytes;
+        [peripheralIdentifier getUUIDBytes:identifierBytes];
+        [data appendBytes:identifierBytes length:sizeof(identifierBytes)];
+        [self appendUInt32:(uint32_t) [generations count] toData:data];
+        
+        for (NSData *generation in generations)
+        {
+            const uint64_t *keys = [generation bytes];
+            NSUInteger count = [generation length] / sizeof(uint64_t);
+            [self appendUInt32:(uint32_t) count toData:data];
+            
+            for (NSUInteger index = 0; index < count; index++)
+            {
+                uint64_t littleEndianKey = CFSwapInt64HostToLittle(keys[index]);
+                [data appendBytes:&littleEndianKey length:sizeof(littleEndianKey)];
+            }
+        }
+    }];
+    
+    pthread_mutex_unlock(&_lock);
+    
+    return [data writeToFile:self.path atomically:YES];
+}
+
+- (void) appendUInt32:(uint32_t) value toData:(NSMutableData *) data;
+{
+    uint32_t littleEndianValue = CFSwapInt32HostToLittle(value);
+    [data appendBytes:&littleEndianValue length:sizeof(littleEndianValue)];
+}
+
+- (BOOL) loadData:(NSData *) data;
+{
+    const uint8_t *bytes = [data bytes];
+    NSUInteger length = [data length];
+    NSUInteger offset = 0;
+    uint32_t magic, version, numberOfPeripherals;
+    
+    if (![self readUInt32:&magic fromBytes:bytes length:length offset:&offset] || kIngestLedgerFileMagic != magic ||
+        ![self readUInt32:&version fromBytes:bytes length:length offset:&offset] || kIngestLedgerFileVersion != version ||
+        ![self readUInt32:&numberOfPeripherals fromBytes:bytes length:length offset:&offset])
+    {
+        return NO;
+    }
+    
+    for (uint32_t peripheralIndex = 0; peripheralIndex < numberOfPeripherals; peripheralIndex++)
+    {
+        uint32_t numberOfGenerations;
+        if (length - offset < sizeof(uuid_t))
+        {
+            return NO;
+        }
+        
+        NSUUID *peripheralIdentifier = [[NSUUID alloc] initWithUUIDBytes:bytes + offset];
+        offset += sizeof(uuid_t);
+        
+        if (![self readUInt32:&numberOfGenerations fromBytes:bytes length:length offset:&offset])
+        {
+            return NO;
+        }
+        
+        NSMutableArray *generations = [NSMutableArray arrayWithCapacity:numberOfGenerations];
+        for (uint32_t generationIndex = 0; generationIndex < numberOfGenerations; generationIndex++)
+        {
+            uint32_t numberOfKeys;
+            if (![self readUInt32:&numberOfKeys fromBytes:bytes length:length offset:&offset] || (length - offset) / sizeof(uint64_t) < numberOfKeys)
+            {
+                return NO;
+            }
+            
+            NSMutableData *generation = [NSMutableData dataWithLength:numberOfKeys * sizeof(uint64_t)];
+            uint64_t *keys = [generation mutableBytes];
+            for (uint32_t keyIndex = 0; keyIndex < numberOfKeys; keyIndex++)
+            {
+                uint64_t littleEndianKey;
+                memcpy(&littleEndianKey, bytes + offset, sizeof(littleEndianKey));
+                offset += sizeof(uint64_t);
+                keys[keyIndex] = CFSwapInt64LittleToHost(littleEndianKey);
+                
+                // the keys are searched by bisection
+                if (keyIndex > 0 && keys[keyIndex] <= keys[keyIndex - 1])
+                {
+                    return NO;
+                }
+            }
+            
+            [generations addObject:generation];
+        }
+        
+        if ([generations count] > 0)
+        {
+            self.generationsByPeripheral[peripheralIdentifier] = generations;
+        }
+    }
+    
+    return YES;
+}
+
+- (BOOL) readUInt32:(uint32_t *) value fromBytes:(const uint8_t *) bytes length:(NSUInteger) length offset:(NSUInteger *) offset;
+{
+    if (length - *offset < sizeof(uint32_t))
+    {
+        return NO;
+    }
+    
+    uint32_t littleEndianValue;
+    memcpy(&littleEndianValue, bytes + *offset, sizeof(littleEndianValue));
+    *value = CFSwapInt32LittleToHost(littleEndianValue);
+    *offset += sizeof(uint32_t);
+    
+    return YES;
+}
+
+@end
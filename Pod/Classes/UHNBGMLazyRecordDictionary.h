@@ -0,0 +1,76 @@
+//
+//  UHNBGMLazyRecordDictionary.h
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+/**
+ `UHNBGMLazyRecordDictionary` is an immutable dictionary that keeps the raw value of a glucose characteristic and only decodes the value of a key the first time it is read. Decoded values are cached.
+ 
+ @discussion The key set is worked out from the flags of the characteristic when the dictionary is created, so `count`, key enumeration and equality behave exactly like the dictionaries returned by the eager parsers, without decoding any values. A lazy dictionary can be shared between threads.
+ */
+@interface UHNBGMLazyRecordDictionary : NSDictionary
+
+/**
+ The raw characteristic value the dictionary decodes from
+ */
+@property (nonatomic, strong, readonly) NSData *recordData;
+
+@end
+
+/**
+ A lazily decoded glucose measurement, with the keys of `parseGlucoseMeasurementCharacteristicDetails:`
+ */
+@interface UHNBGMLazyMeasurementDictionary : UHNBGMLazyRecordDictionary
+
+/**
+ Initializes a lazily decoded glucose measurement
+ 
+ @param data The glucose measurement characteristic value
+ @param crcPresent Indicates whether the characteristic includes the E2E-CRC field
+ 
+ @return The initialized dictionary
+ 
+ */
+- (instancetype) initWithGlucoseMeasurementData:(NSData *) data crcPresent:(BOOL) crcPresent;
+
+@end
+
+/**
+ A lazily decoded glucose measurement context, with the keys of `parseGlucoseMeasurementContextCharacteristicDetails:`
+ */
+@interface UHNBGMLazyMeasurementContextDictionary : UHNBGMLazyRecordDictionary
+
+/**
+ Initializes a lazily decoded glucose measurement context
+ 
+ @param data The glucose measurement context characteristic value
+ @param crcPresent Indicates whether the characteristic includes the E2E-CRC field
+ 
+ @return The initialized dictionary
+ 
+ */
+- (instancetype) initWithGlucoseMeasurementContextData:(NSData *) data crcPresent:(BOOL) crcPresent;
+
+@end
@@ -0,0 +1,360 @@
+//
+//  UHNBGMLazyRecordDictionary.m
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+
+#import <pthread.h>
+#import "UHNBGMLazyRecordDictionary.h"
+#import "UHNBGMConstants.h"
+#import "UHNBGMGlucoseFieldLayout.h"
+#import "NSData+ConversionExtensions.h"
+
+#define kLazyRecordDictionaryMaximumNumberOfKeys        16
+
+// the field parsing methods of the NSData+GlucoseMeasurementParser and NSData+GlucoseMeasurementContextParser categories
+@interface NSData (GlucoseRecordFieldParsing)
+- (NSUInteger) parseGlucoseMeasurementSequenceNumber;
+- (NSNumber *) parseGlucoseMeasurementTimeOffset;
+- (NSNumber *) parseGlucoseMeasurementGlucoseConcentration;
+- (NSNumber *) parseGlucoseMeasurementGlucoseConcentrationUnits;
+- (NSNumber *) parseGlucoseMeasurementType;
+- (NSNumber *) parseGlucoseMeasurementSampleLocation;
+- (NSNumber *) parseGlucoseMeasurementSensorStatusAnnunciation;
+- (NSRange) glucoseMeasurementFieldDataRange:(GlucoseMeasurementField) field;
+- (NSUInteger) parseGlucoseMeasurementContextSequenceNumber;
+- (NSNumber *) parseGlucoseMeasurementContextExtendedFlags;
+- (NSNumber *) parseGlucoseMeasurementContextCarbohydrateID;
+- (NSNumber *) parseGlucoseMeasurementContextCarbohydrate;
+- (NSNumber *) parseGlucoseMeasurementContextMeal;
+- (NSNumber *) parseGlucoseMeasurementContextTester;
+- (NSNumber *) parseGlucoseMeasurementContextHealth;
+- (NSNumber *) parseGlucoseMeasurementContextExerciseDuration;
+- (NSNumber *) parseGlucoseMeasurementContextExerciseIntensity;
+- (NSNumber *) parseGlucoseMeasurementContextMedicationID;
+- (NSNumber *) parseGlucoseMeasurementContextMedicationValue;
+- (NSNumber *) parseGlucoseMeasurementContextMedicationUnits;
+- (NSNumber *) parseGlucoseMeasurementContextHbA1c;
+- (NSRange) glucoseMeasurementContextFieldDataRange:(GlucoseMeasurementContextField) field;
+@end
+
+@interface UHNBGMLazyRecordDictionary ()
+{
+    id _values[kLazyRecordDictionaryMaximumNumberOfKeys];
+    uint32_t _presentKeys;
+    pthread_mutex_t _lock;
+}
+@property (nonatomic, strong, readwrite) NSData *recordData;
+@end
+
+@interface UHNBGMLazyRecordDictionary (Subclassing)
+// all the keys a record can have, in the order of the eager parser
++ (NSArray *) recordKeys;
+// decodes the value of a present key
+- (id) decodeValueForKeyAtIndex:(NSUInteger) keyIndex;
+@end
+
+@implementation UHNBGMLazyRecordDictionary
+
+- (instancetype) initWithRecordData:(NSData *) data presentKeys:(uint32_t) presentKeys;
+{
+    if ((self = [super init]))
+    {
+        self.recordData = [data copy];
+        _presentKeys = presentKeys;
+        pthread_mutex_init(&_lock, NULL);
+    }
+    
+    return self;
+}
+
+- (void) dealloc;
+{
+    pthread_mutex_destroy(&_lock);
+}
+
+#pragma mark - NSDictionary Primitive Methods
+
+- (NSUInteger) count;
+{
+    return __builtin_popcount(_presentKeys);
+}
+
+- (id) objectForKey:(id) key;
+{
+    NSUInteger keyIndex = [self indexOfKey:key];
+    
+    if (NSNotFound == keyIndex || !(_presentKeys & (1 << keyIndex)))
+    {
+        return nil;
+    }
+    
+    pthread_mutex_lock(&_lock);
+    
+    id value = _values[keyIndex];
+    
+    if (nil == value)
+    {
+        value = [self decodeValueForKeyAtIndex:keyIndex];
+        _values[keyIndex] = value;
+    }
+    
+    pthread_mutex_unlock(&_lock);
+    
+    return value;
+}
+
+- (NSEnumerator *) keyEnumerator;
+{
+    // enumerating the keys does not decode any values
+    NSArray *recordKeys = [[self class] recordKeys];
+    NSMutableArray *keys = [NSMutableArray arrayWithCapacity:[self count]];
+    
+    for (NSUInteger keyIndex = 0; keyIndex < [recordKeys count]; keyIndex++)
+    {
+        if (_presentKeys & (1 << keyIndex))
+        {
+            [keys addObject:recordKeys[keyIndex]];
+        }
+    }
+    
+    return [keys objectEnumerator];
+}
+
+#pragma mark - NSCopying and NSCoding Methods
+
+- (id) copyWithZone:(NSZone *) zone;
+{
+    // immutable, so a copy does not need to decode anything
+    return self;
+}
+
+- (Class) classForCoder;
+{
+    // archive as a plain dictionary so unarchiving does not depend on this class
+    return [NSDictionary class];
+}
+
+#pragma mark - Private Methods
+
+- (NSUInteger) indexOfKey:(id) key;
+{
+    NSArray *recordKeys = [[self class] recordKeys];
+    
+    // the key constants are usually passed in, so try pointer equality before comparing strings
+    for (NSUInteger keyIndex = 0; keyIndex < [recordKeys count]; keyIndex++)
+    {
+        if (recordKeys[keyIndex] == key)
+        {
+            return keyIndex;
+        }
+    }
+    
+    return [recordKeys indexOfObject:key];
+}
+
+@end
+
+#pragma mark -
+
+typedef NS_ENUM (NSUInteger, GlucoseMeasurementKeyIndex)
+{
+    GlucoseMeasurementKeyIndexSequenceNumber,
+    GlucoseMeasurementKeyIndexCreationDate,
+    GlucoseMeasurementKeyIndexGlucoseConcentration,
+    GlucoseMeasurementKeyIndexGlucoseConcentrationUnits,
+    GlucoseMeasurementKeyIndexType,
+    GlucoseMeasurementKeyIndexSampleLocation,
+    GlucoseMeasurementKeyIndexSensorStatusAnnunciation,
+};
+
+@implementation UHNBGMLazyMeasurementDictionary
+
++ (NSArray *) recordKeys;
+{
+    static NSArray *recordKeys = nil;
+    static dispatch_once_t onceToken;
+    
+    dispatch_once(&onceToken, ^{
+        recordKeys = @[kGlucoseMeasurementKeySequenceNumber,
+                       kGlucoseMeasurementKeyCreationDate,
+                       kGlucoseMeasurementKeyGlucoseConcentration,
+                       kGlucoseMeasurementKeyGlucoseConcentrationUnits,
+                       kGlucoseMeasurementKeyType,
+                       kGlucoseMeasurementKeySampleLocation,
+                       kGlucoseMeasurementKeySensorStatusAnnunciation];
+    });
+    
+    return recordKeys;
+}
+
+- (instancetype) initWithGlucoseMeasurementData:(NSData *) data crcPresent:(BOOL) crcPresent;
+{
+    // the sequence number and creation date are always present, the rest depend on the flags
+    uint32_t presentKeys = (1 << GlucoseMeasurementKeyIndexSequenceNumber) | (1 << GlucoseMeasurementKeyIndexCreationDate);
+    
+    if ([data glucoseMeasurementFieldDataRange:GlucoseMeasurementFieldGlucoseConcentration].location != NSNotFound)
+    {
+        presentKeys |= (1 << GlucoseMeasurementKeyIndexGlucoseConcentration) | (1 << GlucoseMeasurementKeyIndexGlucoseConcentrationUnits);
+    }
+    
+    if ([data glucoseMeasurementFieldDataRange:GlucoseMeasurementFieldType].location != NSNotFound)
+    {
+        presentKeys |= (1 << GlucoseMeasurementKeyIndexType);
+    }
+    
+    if ([data glucoseMeasurementFieldDataRange:GlucoseMeasurementFieldSampleLocation].location != NSNotFound)
+    {
+        presentKeys |= (1 << GlucoseMeasurementKeyIndexSampleLocation);
+    }
+    
+    if ([data glucoseMeasurementFieldDataRange:GlucoseMeasurementFieldSensorStatusAnnunciation].location != NSNotFound)
+    {
+        presentKeys |= (1 << GlucoseMeasurementKeyIndexSensorStatusAnnunciation);
+    }
+    
+    return [self initWithRecordData:data presentKeys:presentKeys];
+}
+
+- (id) decodeValueForKeyAtIndex:(NSUInteger) keyIndex;
+{
+    NSData *data = self.recordData;
+    
+    switch (keyIndex)
+    {
+        case GlucoseMeasurementKeyIndexSequenceNumber:
+            return [NSNumber numberWithInteger:[data parseGlucoseMeasurementSequenceNumber]];
+        case GlucoseMeasurementKeyIndexCreationDate:
+            return [data parseDateAtLocation:3 andTimeOffsetInMinutes:[data parseGlucoseMeasurementTimeOffset]];
+        case GlucoseMeasurementKeyIndexGlucoseConcentration:
+            return [data parseGlucoseMeasurementGlucoseConcentration];
+        case GlucoseMeasurementKeyIndexGlucoseConcentrationUnits:
+            return [data parseGlucoseMeasurementGlucoseConcentrationUnits];
+        case GlucoseMeasurementKeyIndexType:
+            return [data parseGlucoseMeasurementType];
+        case GlucoseMeasurementKeyIndexSampleLocation:
+            return [data parseGlucoseMeasurementSampleLocation];
+        case GlucoseMeasurementKeyIndexSensorStatusAnnunciation:
+            return [data parseGlucoseMeasurementSensorStatusAnnunciation];
+        default:
+            return nil;
+    }
+}
+
+@end
+
+#pragma mark -
+
+typedef NS_ENUM (NSUInteger, GlucoseMeasurementContextKeyIndex)
+{
+    GlucoseMeasurementContextKeyIndexSequenceNumber,
+    GlucoseMeasurementContextKeyIndexExtendedFlags,
+    GlucoseMeasurementContextKeyIndexCarbohydrateID,
+    GlucoseMeasurementContextKeyIndexCarbohydrate,
+    GlucoseMeasurementContextKeyIndexMeal,
+    GlucoseMeasurementContextKeyIndexTester,
+    GlucoseMeasurementContextKeyIndexHealth,
+    GlucoseMeasurementContextKeyIndexExerciseDuration,
+    GlucoseMeasurementContextKeyIndexExerciseIntensity,
+    GlucoseMeasurementContextKeyIndexMedicationID,
+    GlucoseMeasurementContextKeyIndexMedicationValue,
+    GlucoseMeasurementContextKeyIndexMedicationUnits,
+    GlucoseMeasurementContextKeyIndexHbA1c,
+};
+
+@implementation UHNBGMLazyMeasurementContextDictionary
+
++ (NSArray *) recordKeys;
+{
+    static NSArray *recordKeys = nil;
+    static dispatch_once_t onceToken;
+    
+    dispatch_once(&onceToken, ^{
+        recordKeys = @[kGlucoseMeasurementContextKeySequenceNumber,
+                       kGlucoseMeasurementContextKeyExtendedFlags,
+                       kGlucoseMeasurementContextKeyCarbohydrateID,
+                       kGlucoseMeasurementContextKeyCarbohydrate,
+                       kGlucoseMeasurementContextKeyMeal,
+                       kGlucoseMeasurementContextKeyTester,
+                       kGlucoseMeasurementContextKeyHealth,
+                       kGlucoseMeasurementContextKeyExerciseDuration,
+                       kGlucoseMeasurementContextKeyExerciseIntensity,
+                       kGlucoseMeasurementContextKeyMedicationID,
+                       kGlucoseMeasurementContextKeyMedicationValue,
+                       kGlucoseMeasurementContextKeyMedicationUnits,
+                       kGlucoseMeasurementContextKeyHbA1c];
+    });
+    
+    return recordKeys;
+}
+
+- (instancetype) initWithGlucoseMeasurementContextData:(NSData *) data crcPresent:(BOOL) crcPresent;
+{
+    // the field each key is decoded from, the sequence number is always present
+    static const NSInteger keyFields[] = {
+        -1,
+        GlucoseMeasurementContextFieldExtendedFlags,
+        GlucoseMeasurementContextFieldCarbohydrateID,
+        GlucoseMeasurementContextFieldCarbohydrate,
+        GlucoseMeasurementContextFieldMeal,
+        GlucoseMeasurementContextFieldTester,
+        GlucoseMeasurementContextFieldHealth,
+        GlucoseMeasurementContextFieldExerciseDuration,
+        GlucoseMeasurementContextFieldExerciseIntensity,
+        GlucoseMeasurementContextFieldMedicationID,
+        GlucoseMeasurementContextFieldMedicationValue,
+        GlucoseMeasurementContextFieldMedicationValue,
+        GlucoseMeasurementContextFieldHbA1c,
+    };
+    uint32_t presentKeys = 0;
+    
+    for (NSUInteger keyIndex = 0; keyIndex < sizeof(keyFields) / sizeof(keyFields[0]); keyIndex++)
+    {
+        if (keyFields[keyIndex] < 0 || [data glucoseMeasurementContextFieldDataRange:(GlucoseMeasurementContextField) keyFields[keyIndex]].location != NSNotFound)
+        {
+            presentKeys |= (1 << keyIndex);
+        }
+    }
+    
+    return [self initWithRecordData:data presentKeys:presentKeys];
+}
+
+- (id) decodeValueForKeyAtIndex:(NSUInteger) keyIndex;
+{
+    NSData *data = self.recordData;
+    
+    switch (keyIndex)
+    {
+        case GlucoseMeasurementContextKeyIndexSequenceNumber:
+            return [NSNumber numberWithInteger:[data parseGlucoseMeasurementContextSequenceNumber]];
+        case GlucoseMeasurementContextKeyIndexExtendedFlags:
+            return [data parseGlucoseMeasurementContextExtendedFlags];
+        case GlucoseMeasurementContextKeyIndexCarbohydrateID:
+            return [data parseGlucoseMeasurementContextCarbohydrateID];
+        case GlucoseMeasurementContextKeyIndexCarbohydrate:
+            return [data parseGlucoseMeasurementContextCarbohydrate];
+        case GlucoseMeasurementContextKeyIndexMeal:
+            return [data parseGlucoseMeasurementContextMeal];
+        case GlucoseMeasurementContextKeyIndexTester:
+            return [data parseGlucoseMeasurementContextTester];
+        case GlucoseMeasurementContextKeyIndexHealth:
+            return [data parseGlucoseMeasurementContextHealth];
+        case GlucoseMeasurementContextKeyIndexExerciseDuration:
+            return [data parseGlucoseMeasurementContextExerciseDuration];
+        case GlucoseMeasurementContextKeyIndexExerciseIntensity:
+            return [data parseGlucoseMeasurementContextExerciseIntensity];
+        case GlucoseMeasurementContextKeyIndexMedicationID:
+            return [data parseGlucoseMeasurementContextMedicationID];
+        case GlucoseMeasurementContextKeyIndexMedicationValue:
+            return [data parseGlucoseMeasurementContextMedicationValue];
+        case GlucoseMeasurementContextKeyIndexMedicationUnits:
+            return [data parseGlucoseMeasurementContextMedicationUnits];
+        case GlucoseMeasurementContextKeyIndexHbA1c:
+            return [data parseGlucoseMeasurementContextHbA1c];
+        default:
+            return nil;
+    }
+}
+
+@end
@@ -0,0 +1,156 @@
+//
+//  UHNBGMReadingFormatter.h
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "UHNBGMHistory.h"
+
+/**
+ A buffer length that fits any formatted reading
+ */
+#define kReadingFormatterMaximumLength      160
+
+/**
+ The units readings are formatted in
+ */
+typedef NS_ENUM (NSUInteger, UHNBGMReadingFormatterUnits)
+{
+    /** mmol/L, with one decimal */
+    UHNBGMReadingFormatterUnitsMmolPerL = 0,
+    /** mg/dL, without decimals */
+    UHNBGMReadingFormatterUnitsMgPerDl,
+};
+
+/**
+ The glucose measurement context fields with a label for each of their values
+ */
+typedef NS_ENUM (NSUInteger, UHNBGMReadingLabelField)
+{
+    /** The meal (see GlucoseMeasurementContextMeal) */
+    UHNBGMReadingLabelFieldMeal = 0,
+    /** The carbohydrate ID (see GlucoseMeasurementContextCarbohydrateID) */
+    UHNBGMReadingLabelFieldCarbohydrateID,
+    /** The tester (see GlucoseMeasurementContextTester) */
+    UHNBGMReadingLabelFieldTester,
+    /** The health (see GlucoseMeasurementContextHealth) */
+    UHNBGMReadingLabelFieldHealth,
+    /** The medication ID (see GlucoseMeasurementContextMedicationID) */
+    UHNBGMReadingLabelFieldMedicationID,
+};
+
+/**
+ `UHNBGMReadingFormatter` renders a glucose reading as a line of text, such as "5.6 mmol/L, 3/23/16 8:01 AM, Before meal, Breakfast", into a buffer provided by the caller, for table views and exports that format many readings.
+ 
+ @discussion The glucose concentration is converted and formatted in fixed point, with a high or low result shown as HI or LO. The context labels come from tables built at compile time, localized once from the main bundle. The date of a reading is formatted with a `NSDateFormatter` once per day and cached, and the time of day is formatted from integers in the 12 or 24 hour style of the locale, so formatting a reading allocates no objects once its day is cached. The caches are discarded when the current locale or the system time zone changes.
+ 
+ The formatter is not thread safe, and should be used from one thread, usually the main thread.
+ */
+@interface UHNBGMReadingFormatter : NSObject
+
+/**
+ The units glucose concentrations are shown in. Defaults to mmol/L
+ */
+@property (nonatomic, assign) UHNBGMReadingFormatterUnits units;
+
+/**
+ The locale of the dates and the decimal separator
+ */
+@property (nonatomic, strong, readonly) NSLocale *locale;
+
+/**
+ The time zone of the dates
+ */
+@property (nonatomic, strong, readonly) NSTimeZone *timeZone;
+
+/**
+ Initializes a formatter with the current locale and the local time zone
+ 
+ @return The initialized formatter
+ 
+ */
+- (instancetype) init;
+
+/**
+ Initializes a formatter
+ 
+ @param locale The locale of the dates and the decimal separator
+ @param timeZone The time zone of the dates
+ 
+ @return The initialized formatter
+ 
+ */
+- (instancetype) initWithLocale:(NSLocale *) locale timeZone:(NSTimeZone *) timeZone;
+
+/**
+ The label of a glucose measurement context value, before localization
+ 
+ @param field The glucose measurement context field
+ @param value The value of the field
+ 
+ @return The label, or `nil` for a reserved or unknown value
+ 
+ */
++ (NSString *) labelForField:(UHNBGMReadingLabelField) field value:(NSUInteger) value;
+
+/**
+ Formats a reading
+ 
+ @param buffer The buffer the characters are written to
+ @param maxLength The length of the buffer, in characters. The text is cut short if it does not fit
+ @param reading The reading to format
+ @param carbohydrateID The carbohydrate ID of the measurement context (see GlucoseMeasurementContextCarbohydrateID), 0 if unknown
+ 
+ @return The number of characters written
+ 
+ */
+- (NSUInteger) getCharacters:(unichar *) buffer maxLength:(NSUInteger) maxLength forReading:(const UHNBGMHistoryReading *) reading carbohydrateID:(uint8_t) carbohydrateID;
+
+/**
+ Formats a glucose measurement as returned by `parseGlucoseMeasurementCharacteristicDetails:`, with the meal and carbohydrate ID of its measurement context if the dictionary holds them
+ 
+ @param buffer The buffer the characters are written to
+ @param maxLength The length of the buffer, in characters. The text is cut short if it does not fit
+ @param measurementDetails The glucose measurement details
+ 
+ @return The number of characters written, 0 if the measurement has no creation date
+ 
+ */
+- (NSUInteger) getCharacters:(unichar *) buffer maxLength:(NSUInteger) maxLength forMeasurementDetails:(NSDictionary *) measurementDetails;
+
+/**
+ Formats a glucose measurement into a string
+ 
+ @param measurementDetails The glucose measurement details
+ 
+ @return The formatted measurement
+ 
+ */
+- (NSString *) stringForMeasurementDetails:(NSDictionary *) measurementDetails;
+
+/**
+ Discards the cached dates and labels, so they are formatted again with the current settings
+ */
+- (void) reset;
+
+@end
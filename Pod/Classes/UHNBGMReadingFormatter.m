@@ -0,0 +1,406 @@
+//
+//  UHNBGMReadingFormatter.m
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+
+#import "UHNBGMReadingFormatter.h"
+#import "UHNBGMConstants.h"
+
+#define kReadingFormatterLabelTableSize         16
+#define kReadingFormatterNumberOfLabelFields    5
+#define kReadingFormatterDayCacheSize           8
+#define kReadingFormatterDayLabelLength         32
+#define kReadingFormatterSecondsPerDay          86400
+
+#define UHNBGMReadingLabel(table, value)        ((value) < sizeof(table) / sizeof(table[0]) ? table[value] : nil)
+
+static NSString * const kReadingFormatterMealLabels[] =
+{
+    [GlucoseMeasurementContextMealPreprandial] = @"Before meal",
+    [GlucoseMeasurementContextMealPostprandial] = @"After meal",
+    [GlucoseMeasurementContextMealFasting] = @"Fasting",
+    [GlucoseMeasurementContextMealCasual] = @"Casual",
+    [GlucoseMeasurementContextMealBedtime] = @"Bedtime",
+};
+
+static NSString * const kReadingFormatterCarbohydrateIDLabels[] =
+{
+    [GlucoseMeasurementContextCarbohydrateIDBreakfast] = @"Breakfast",
+    [GlucoseMeasurementContextCarbohydrateIDLunch] = @"Lunch",
+    [GlucoseMeasurementContextCarbohydrateIDDinner] = @"Dinner",
+    [GlucoseMeasurementContextCarbohydrateIDSnack] = @"Snack",
+    [GlucoseMeasurementContextCarbohydrateIDDrink] = @"Drink",
+    [GlucoseMeasurementContextCarbohydrateIDSupper] = @"Supper",
+    [GlucoseMeasurementContextCarbohydrateIDBrunch] = @"Brunch",
+};
+
+static NSString * const kReadingFormatterTesterLabels[] =
+{
+    [GlucoseMeasurementContextTesterSelf] = @"Self",
+    [GlucoseMeasurementContextTesterHealthCareProfessional] = @"Health care professional",
+    [GlucoseMeasurementContextTesterLabTest] = @"Lab test",
+    [GlucoseMeasurementContextTesterValueNotAvailable] = @"Tester not available",
+};
+
+static NSString * const kReadingFormatterHealthLabels[] =
+{
+    [GlucoseMeasurementContextHealthMinorHealthIssues] = @"Minor health issues",
+    [GlucoseMeasurementContextHealthMajoreHealthIssues] = @"Major health issues",
+    [GlucoseMeasurementContextHealthDuringMenses] = @"During menses",
+    [GlucoseMeasurementContextHealthUnderStress] = @"Under stress",
+    [GlucoseMeasurementContextHealthNoHealthIssues] = @"No health issues",
+    [GlucoseMeasurementContextHealthValueNotAvailable] = @"Health not available",
+};
+
+static NSString * const kReadingFormatterMedicationIDLabels[] =
+{
+    [GlucoseMeasurementContextMedicationIDRapidActingInsulin] = @"Rapid acting insulin",
+    [GlucoseMeasurementContextMedicationIDShortActingInsulin] = @"Short acting insulin",
+    [GlucoseMeasurementContextMedicationIDIntermediateActingInsulin] = @"Intermediate acting insulin",
+    [GlucoseMeasurementContextMedicationIDLongActingInsulin] = @"Long acting insulin",
+    [GlucoseMeasurementContextMedicationIDPreMixedInsulin] = @"Pre-mixed insulin",
+};
+
+/**
+ The characters written so far to the buffer of the caller, which are cut short rather than overflow it
+ */
+typedef struct
+{
+    unichar *characters;
+    NSUInteger length;
+    NSUInteger capacity;
+} UHNBGMReadingText;
+
+/**
+ The formatted date of a local day
+ */
+typedef struct
+{
+    int64_t day;
+    BOOL isValid;
+    NSUInteger length;
+    unichar characters[kReadingFormatterDayLabelLength];
+} UHNBGMReadingDayLabel;
+
+static inline void UHNBGMReadingTextAppendCharacter(UHNBGMReadingText *text, unichar character)
+{
+    if (text->length < text->capacity)
+    {
+        text->characters[text->length++] = character;
+    }
+}
+
+static void UHNBGMReadingTextAppendASCII(UHNBGMReadingText *text, const char *string)
+{
+    while (*string)
+    {
+        UHNBGMReadingTextAppendCharacter(text, *string++);
+    }
+}
+
+static void UHNBGMReadingTextAppendCharacters(UHNBGMReadingText *text, const unichar *characters, NSUInteger length)
+{
+    length = MIN(length, text->capacity - text->length);
+    memcpy(text->characters + text->length, characters, length * sizeof(unichar));
+    text->length += length;
+}
+
+static void UHNBGMReadingTextAppendString(UHNBGMReadingText *text, NSString *string)
+{
+    NSUInteger length = MIN([string length], text->capacity - text->length);
+    [string getCharacters:text->characters + text->length range:NSMakeRange(0, length)];
+    text->length += length;
+}
+
+static void UHNBGMReadingTextAppendUnsigned(UHNBGMReadingText *text, uint64_t value, NSUInteger minimumNumberOfDigits)
+{
+    char digits[20];
+    NSUInteger numberOfDigits = 0;
+    
+    do
+    {
+        digits[numberOfDigits++] = '0' + (value % 10);
+        value /= 10;
+    } while (value > 0 || numberOfDigits < minimumNumberOfDigits);
+    
+    while (numberOfDigits > 0)
+    {
+        UHNBGMReadingTextAppendCharacter(text, digits[--numberOfDigits]);
+    }
+}
+
+@interface UHNBGMReadingFormatter ()
+{
+    // the labels of each field, localized from the main bundle
+    NSString *_localizedLabels[kReadingFormatterNumberOfLabelFields][kReadingFormatterLabelTableSize];
+    UHNBGMReadingDayLabel _dayLabels[kReadingFormatterDayCacheSize];
+    unichar _decimalSeparator;
+    BOOL _uses12HourClock;
+}
+@property (nonatomic, strong, readwrite) NSLocale *locale;
+@property (nonatomic, strong, readwrite) NSTimeZone *timeZone;
+@property (nonatomic, assign) BOOL followsSystemSettings;
+@property (nonatomic, strong) NSDateFormatter *dayFormatter;
+@property (nonatomic, copy) NSString *amSymbol;
+@property (nonatomic, copy) NSString *pmSymbol;
+@end
+
+@implementation UHNBGMReadingFormatter
+
+#pragma mark - Initialization Methods
+
+- (instancetype) init;
+{
+    if ((self = [self initWithLocale:[NSLocale autoupdatingCurrentLocale] timeZone:[NSTimeZone systemTimeZone]]))
+    {
+        self.followsSystemSettings = YES;
+    }
+    
+    return self;
+}
+
+- (instancetype) initWithLocale:(NSLocale *) locale timeZone:(NSTimeZone *) timeZone;
+{
+    if ((self = [super init]))
+    {
+        _units = UHNBGMReadingFormatterUnitsMmolPerL;
+        self.locale = locale;
+        self.timeZone = timeZone;
+        [self reset];
+        
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(systemSettingsDidChange:) name:NSCurrentLocaleDidChangeNotification object:nil];
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(systemSettingsDidChange:) name:NSSystemTimeZoneDidChangeNotification object:nil];
+    }
+    
+    return self;
+}
+
+- (void) dealloc;
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+- (void) systemSettingsDidChange:(NSNotification *) notification;
+{
+    if (self.followsSystemSettings)
+    {
+        [NSTimeZone resetSystemTimeZone];
+        self.timeZone = [NSTimeZone systemTimeZone];
+    }
+    
+    [self reset];
+}
+
+- (void) reset;
+{
+    self.dayFormatter = [[NSDateFormatter alloc] init];
+    self.dayFormatter.locale = self.locale;
+    self.dayFormatter.timeZone = self.timeZone;
+    self.dayFormatter.dateStyle = NSDateFormatterShortStyle;
+    self.dayFormatter.timeStyle = NSDateFormatterNoStyle;
+    self.amSymbol = self.dayFormatter.AMSymbol;
+    self.pmSymbol = self.dayFormatter.PMSymbol;
+    
+    // the "j" skeleton is the preferred hour of the locale, which has a day period in 12 hour locales
+    NSString *timeFormat = [NSDateFormatter dateFormatFromTemplate:@"j" options:0 locale:self.locale];
+    _uses12HourClock = (NSNotFound != [timeFormat rangeOfString:@"a"].location);
+    
+    NSString *decimalSeparator = [self.locale objectForKey:NSLocaleDecimalSeparator];
+    _decimalSeparator = ([decimalSeparator length] > 0 ? [decimalSeparator characterAtIndex:0] : '.');
+    
+    memset(_dayLabels, 0, sizeof(_dayLabels));
+    
+    NSBundle *bundle = [NSBundle mainBundle];
+    for (NSUInteger field = 0; field < kReadingFormatterNumberOfLabelFields; field++)
+    {
+        for (NSUInteger value = 0; value < kReadingFormatterLabelTableSize; value++)
+        {
+            NSString *label = [UHNBGMReadingFormatter labelForField:field value:value];
+            _localizedLabels[field][value] = (label ? [bundle localizedStringForKey:label value:label table:nil] : nil);
+        }
+    }
+}
+
+#pragma mark - Label Methods
+
++ (NSString *) labelForField:(UHNBGMReadingLabelField) field value:(NSUInteger) value;
+{
+    switch (field)
+    {
+        case UHNBGMReadingLabelFieldMeal:
+            return UHNBGMReadingLabel(kReadingFormatterMealLabels, value);
+        case UHNBGMReadingLabelFieldCarbohydrateID:
+            return UHNBGMReadingLabel(kReadingFormatterCarbohydrateIDLabels, value);
+        case UHNBGMReadingLabelFieldTester:
+            return UHNBGMReadingLabel(kReadingFormatterTesterLabels, value);
+        case UHNBGMReadingLabelFieldHealth:
+            return UHNBGMReadingLabel(kReadingFormatterHealthLabels, value);
+        case UHNBGMReadingLabelFieldMedicationID:
+            return UHNBGMReadingLabel(kReadingFormatterMedicationIDLabels, value);
+    }
+    
+    return nil;
+}
+
+- (void) appendLabelForField:(UHNBGMReadingLabelField) field value:(NSUInteger) value toText:(UHNBGMReadingText *) text;
+{
+    NSString *label = (value < kReadingFormatterLabelTableSize ? _localizedLabels[field][value] : nil);
+    
+    if (label)
+    {
+        UHNBGMReadingTextAppendASCII(text, ", ");
+        UHNBGMReadingTextAppendString(text, label);
+    }
+}
+
+#pragma mark - Formatting Methods
+
+- (NSUInteger) getCharacters:(unichar *) buffer maxLength:(NSUInteger) maxLength forReading:(const UHNBGMHistoryReading *) reading carbohydrateID:(uint8_t) carbohydrateID;
+{
+    UHNBGMReadingText text = {buffer, 0, maxLength};
+    
+    [self appendGlucoseConcentrationOfReading:reading toText:&text];
+    UHNBGMReadingTextAppendASCII(&text, ", ");
+    [self appendDateAndTime:reading->timeIntervalSince1970 toText:&text];
+    [self appendLabelForField:UHNBGMReadingLabelFieldMeal value:reading->meal toText:&text];
+    [self appendLabelForField:UHNBGMReadingLabelFieldCarbohydrateID value:carbohydrateID toText:&text];
+    
+    return text.length;
+}
+
+- (NSUInteger) getCharacters:(unichar *) buffer maxLength:(NSUInteger) maxLength forMeasurementDetails:(NSDictionary *) measurementDetails;
+{
+    NSDate *creationDate = measurementDetails[kGlucoseMeasurementKeyCreationDate];
+    
+    if (nil == creationDate)
+    {
+        return 0;
+    }
+    
+    UHNBGMHistoryReading reading = {0};
+    reading.timeIntervalSince1970 = [creationDate timeIntervalSince1970];
+    reading.glucoseConcentration = NAN;
+    reading.meal = [measurementDetails[kGlucoseMeasurementContextKeyMeal] unsignedCharValue];
+    
+    NSNumber *glucoseConcentration = measurementDetails[kGlucoseMeasurementKeyGlucoseConcentration];
+    
+    if (glucoseConcentration)
+    {
+        reading.glucoseConcentration = [glucoseConcentration floatValue];
+        reading.flags |= GlucoseMeasurementFlagPresentGlucoseConcentrationTypeAndSampleLocation;
+        
+        if (GlucoseMeasurementGlucoseConcentrationUnitsMolPerL == [measurementDetails[kGlucoseMeasurementKeyGlucoseConcentrationUnits] unsignedIntegerValue])
+        {
+            reading.flags |= GlucoseMeasurementFlagGlucoseConcentrationUnits;
+        }
+    }
+    
+    NSNumber *sensorStatusAnnunciation = measurementDetails[kGlucoseMeasurementKeySensorStatusAnnunciation];
+    
+    if (sensorStatusAnnunciation)
+    {
+        reading.sensorStatusAnnunciation = [sensorStatusAnnunciation unsignedShortValue];
+        reading.flags |= GlucoseMeasurementFlagPresentSensorStatusAnnunciation;
+    }
+    
+    return [self getCharacters:buffer maxLength:maxLength forReading:&reading carbohydrateID:[measurementDetails[kGlucoseMeasurementContextKeyCarbohydrateID] unsignedCharValue]];
+}
+
+- (NSString *) stringForMeasurementDetails:(NSDictionary *) measurementDetails;
+{
+    unichar characters[kReadingFormatterMaximumLength];
+    NSUInteger length = [self getCharacters:characters maxLength:kReadingFormatterMaximumLength forMeasurementDetails:measurementDetails];
+    
+    return [NSString stringWithCharacters:characters length:length];
+}
+
+- (void) appendGlucoseConcentrationOfReading:(const UHNBGMHistoryReading *) reading toText:(UHNBGMReadingText *) text;
+{
+    uint16_t sensorStatusAnnunciation = ((reading->flags & GlucoseMeasurementFlagPresentSensorStatusAnnunciation) ? reading->sensorStatusAnnunciation : 0);
+    
+    // a result out of the range of the glucose sensor is shown the way meters show it
+    if (sensorStatusAnnunciation & GlucoseMeasurementStatusResultExceedsSensorLimitUpper)
+    {
+        UHNBGMReadingTextAppendASCII(text, "HI");
+        return;
+    }
+    else if (sensorStatusAnnunciation & GlucoseMeasurementStatusResultExceedsSensorLimitLower)
+    {
+        UHNBGMReadingTextAppendASCII(text, "LO");
+        return;
+    }
+    
+    // kg/L is 1e5 mg/dL, mol/L is 100 times the molar mass in mg/dL
+    double milligramsPerDecilitre = reading->glucoseConcentration * ((reading->flags & GlucoseMeasurementFlagGlucoseConcentrationUnits) ? kGlucoseMolarMass * 100. : 1e5);
+    
+    if (!isfinite(milligramsPerDecilitre))
+    {
+        UHNBGMReadingTextAppendASCII(text, "--");
+        return;
+    }
+    
+    // rounded once to tenths of mmol/L or whole mg/dL, then written digit by digit
+    BOOL isMmolPerL = (UHNBGMReadingFormatterUnitsMmolPerL == self.units);
+    int64_t scale = (isMmolPerL ? 10 : 1);
+    int64_t scaledValue = llround((isMmolPerL ? milligramsPerDecilitre * 10. / kGlucoseMolarMass : milligramsPerDecilitre) * scale);
+    
+    if (scaledValue < 0)
+    {
+        UHNBGMReadingTextAppendCharacter(text, '-');
+        scaledValue = -scaledValue;
+    }
+    
+    UHNBGMReadingTextAppendUnsigned(text, scaledValue / scale, 1);
+    
+    if (isMmolPerL)
+    {
+        UHNBGMReadingTextAppendCharacter(text, _decimalSeparator);
+        UHNBGMReadingTextAppendUnsigned(text, scaledValue % scale, 1);
+    }
+    
+    UHNBGMReadingTextAppendASCII(text, (isMmolPerL ? " mmol/L" : " mg/dL"));
+}
+
+- (void) appendDateAndTime:(NSTimeInterval) time toText:(UHNBGMReadingText *) text;
+{
+    // the offset of the time itself, so the wall clock time is right on either side of a daylight saving change
+    NSInteger utcOffset = (NSInteger) CFTimeZoneGetSecondsFromGMT((__bridge CFTimeZoneRef) self.timeZone, time - kCFAbsoluteTimeIntervalSince1970);
+    int64_t localTime = (int64_t) floor(time) + utcOffset;
+    int64_t day = localTime / kReadingFormatterSecondsPerDay - (localTime % kReadingFormatterSecondsPerDay < 0 ? 1 : 0);
+    int64_t secondsIntoDay = localTime - day * kReadingFormatterSecondsPerDay;
+    
+    UHNBGMReadingDayLabel *dayLabel = &_dayLabels[(uint64_t) day % kReadingFormatterDayCacheSize];
+    if (!dayLabel->isValid || dayLabel->day != day)
+    {
+        NSString *label = [self.dayFormatter stringFromDate:[NSDate dateWithTimeIntervalSince1970:time]];
+        dayLabel->day = day;
+        dayLabel->isValid = YES;
+        dayLabel->length = MIN([label length], kReadingFormatterDayLabelLength);
+        [label getCharacters:dayLabel->characters range:NSMakeRange(0, dayLabel->length)];
+    }
+    
+    UHNBGMReadingTextAppendCharacters(text, dayLabel->characters, dayLabel->length);
+    UHNBGMReadingTextAppendCharacter(text, ' ');
+    
+    NSUInteger hours = (NSUInteger) (secondsIntoDay / 3600);
+    NSUInteger minutes = (NSUInteger) (secondsIntoDay % 3600) / 60;
+    
+    if (_uses12HourClock)
+    {
+        UHNBGMReadingTextAppendUnsigned(text, (0 == hours % 12 ? 12 : hours % 12), 1);
+        UHNBGMReadingTextAppendCharacter(text, ':');
+        UHNBGMReadingTextAppendUnsigned(text, minutes, 2);
+        UHNBGMReadingTextAppendCharacter(text, ' ');
+        UHNBGMReadingTextAppendString(text, (hours < 12 ? self.amSymbol : self.pmSymbol));
+    }
+    else
+    {
+        UHNBGMReadingTextAppendUnsigned(text, hours, 2);
+        UHNBGMReadingTextAppendCharacter(text, ':');
+        UHNBGMReadingTextAppendUnsigned(text, minutes, 2);
+    }
+}
+
+@end
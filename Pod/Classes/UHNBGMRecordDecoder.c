@@ -0,0 +1,300 @@
+//
+//  UHNBGMRecordDecoder.c
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+
+#include "UHNBGMRecordDecoder.h"
+
+#include "UHNBGMGlucoseFieldLayout.h"
+
+#include <math.h>
+#include <string.h>
+
+static inline uint16_t UHNBGMUInt16(const uint8_t *bytes)
+{
+    return (uint16_t) (bytes[0] | (bytes[1] << 8));
+}
+
+float UHNBGMShortFloatValue(uint16_t rawValue)
+{
+    int16_t mantissa = rawValue & 0x0FFF;
+    int8_t exponent = rawValue >> 12;
+    
+    switch (mantissa)
+    {
+        case 0x07FF:
+        case 0x0800:
+        case 0x0801:
+            return NAN;
+        case 0x07FE:
+            return INFINITY;
+        case 0x0802:
+            return -INFINITY;
+    }
+    
+    // both the mantissa (12 bits) and the exponent (4 bits) are two's complement
+    if (mantissa >= 0x0800)
+    {
+        mantissa = mantissa - 0x1000;
+    }
+    
+    if (exponent >= 0x08)
+    {
+        exponent = exponent - 0x10;
+    }
+    
+    return (float) (mantissa * pow(10., exponent));
+}
+
+uint16_t UHNBGMShortFloatRawValue(float value)
+{
+    if (isnan(value))
+    {
+        return 0x07FF;
+    }
+    
+    // the smallest exponent the mantissa fits with keeps the most digits, then the trailing zeros are dropped
+    int exponent = -8;
+    double mantissa = round(value * 1e8);
+    while (fabs(mantissa) > 2045 && exponent < 7)
+    {
+        exponent += 1;
+        mantissa = round(value / pow(10., exponent));
+    }
+    
+    // infinity, or too large for an SFLOAT
+    if (fabs(mantissa) > 2045)
+    {
+        return (value > 0 ? 0x07FE : 0x0802);
+    }
+    
+    while (0 != mantissa && 0 == fmod(mantissa, 10.) && exponent < 7)
+    {
+        mantissa /= 10.;
+        exponent += 1;
+    }
+    
+    if (0 == mantissa)
+    {
+        exponent = 0;
+    }
+    
+    return (uint16_t) (((exponent & 0x0F) << 12) | ((int) mantissa & 0x0FFF));
+}
+
+// reads a field of a compiled layout into a record member, if the field is present
+#define UHNBGMDecodeField(member, layout, bytes, flags, field) \
+    do { \
+        uint8_t offset = UHNBGMFieldOffset(layout, flags, field); \
+        if (kUHNBGMFieldAbsent != offset) \
+        { \
+            member = UHNBGMFieldIntegerValue(layout, bytes, offset, field); \
+        } \
+    } while (0)
+
+#define UHNBGMDecodeShortFloatField(member, layout, bytes, flags, field) \
+    do { \
+        uint8_t offset = UHNBGMFieldOffset(layout, flags, field); \
+        if (kUHNBGMFieldAbsent != offset) \
+        { \
+            member = UHNBGMShortFloatValue((uint16_t) UHNBGMFieldIntegerValue(layout, bytes, offset, field)); \
+        } \
+    } while (0)
+
+// writes a record member into a field of a compiled layout, if the field is present
+#define UHNBGMEncodeField(member, layout, bytes, flags, field) \
+    do { \
+        uint8_t offset = UHNBGMFieldOffset(layout, flags, field); \
+        if (kUHNBGMFieldAbsent != offset) \
+        { \
+            UHNBGMSetFieldIntegerValue(layout, bytes, offset, field, member); \
+        } \
+    } while (0)
+
+#define UHNBGMEncodeShortFloatField(member, layout, bytes, flags, field) \
+    UHNBGMEncodeField(UHNBGMShortFloatRawValue(member), layout, bytes, flags, field)
+
+bool UHNBGMDecodeMeasurement(const uint8_t *bytes, size_t length, UHNBGMMeasurementRecord *record)
+{
+    const UHNBGMFieldLayout *layout = UHNBGMMeasurementFieldLayout();
+    
+    memset(record, 0, sizeof(*record));
+    
+    if (length < layout->fixedLength || length < layout->requiredLengths[bytes[0]])
+    {
+        return false;
+    }
+    
+    uint8_t flags = bytes[0];
+    
+    record->flags = flags;
+    record->sequenceNumber = UHNBGMUInt16(&bytes[1]);
+    record->year = UHNBGMUInt16(&bytes[3]);
+    record->month = bytes[5];
+    record->day = bytes[6];
+    record->hours = bytes[7];
+    record->minutes = bytes[8];
+    record->seconds = bytes[9];
+    
+    UHNBGMDecodeField(record->timeOffset, layout, bytes, flags, GlucoseMeasurementFieldTimeOffset);
+    UHNBGMDecodeShortFloatField(record->glucoseConcentration, layout, bytes, flags, GlucoseMeasurementFieldGlucoseConcentration);
+    UHNBGMDecodeField(record->type, layout, bytes, flags, GlucoseMeasurementFieldType);
+    UHNBGMDecodeField(record->sampleLocation, layout, bytes, flags, GlucoseMeasurementFieldSampleLocation);
+    UHNBGMDecodeField(record->sensorStatusAnnunciation, layout, bytes, flags, GlucoseMeasurementFieldSensorStatusAnnunciation);
+    
+    return true;
+}
+
+bool UHNBGMDecodeMeasurementContext(const uint8_t *bytes, size_t length, UHNBGMMeasurementContextRecord *record)
+{
+    const UHNBGMFieldLayout *layout = UHNBGMMeasurementContextFieldLayout();
+    
+    memset(record, 0, sizeof(*record));
+    
+    if (length < layout->fixedLength || length < layout->requiredLengths[bytes[0]])
+    {
+        return false;
+    }
+    
+    uint8_t flags = bytes[0];
+    
+    record->flags = flags;
+    record->sequenceNumber = UHNBGMUInt16(&bytes[1]);
+    
+    UHNBGMDecodeField(record->extendedFlags, layout, bytes, flags, GlucoseMeasurementContextFieldExtendedFlags);
+    UHNBGMDecodeField(record->carbohydrateID, layout, bytes, flags, GlucoseMeasurementContextFieldCarbohydrateID);
+    UHNBGMDecodeShortFloatField(record->carbohydrate, layout, bytes, flags, GlucoseMeasurementContextFieldCarbohydrate);
+    UHNBGMDecodeField(record->meal, layout, bytes, flags, GlucoseMeasurementContextFieldMeal);
+    UHNBGMDecodeField(record->tester, layout, bytes, flags, GlucoseMeasurementContextFieldTester);
+    UHNBGMDecodeField(record->health, layout, bytes, flags, GlucoseMeasurementContextFieldHealth);
+    UHNBGMDecodeField(record->exerciseDuration, layout, bytes, flags, GlucoseMeasurementContextFieldExerciseDuration);
+    UHNBGMDecodeField(record->exerciseIntensity, layout, bytes, flags, GlucoseMeasurementContextFieldExerciseIntensity);
+    UHNBGMDecodeField(record->medicationID, layout, bytes, flags, GlucoseMeasurementContextFieldMedicationID);
+    UHNBGMDecodeShortFloatField(record->medication, layout, bytes, flags, GlucoseMeasurementContextFieldMedicationValue);
+    UHNBGMDecodeShortFloatField(record->hbA1c, layout, bytes, flags, GlucoseMeasurementContextFieldHbA1c);
+    
+    return true;
+}
+
+size_t UHNBGMDecodeMeasurementBatch(const uint8_t *bytes, const size_t *lengths, size_t count, UHNBGMMeasurementRecord *records, bool *valid)
+{
+    size_t numberOfDecodedRecords = 0;
+    
+    for (size_t index = 0; index < count; index++)
+    {
+        bool didDecode = UHNBGMDecodeMeasurement(bytes, lengths[index], &records[index]);
+        
+        if (valid)
+        {
+            valid[index] = didDecode;
+        }
+        
+        numberOfDecodedRecords += (didDecode ? 1 : 0);
+        bytes += lengths[index];
+    }
+    
+    return numberOfDecodedRecords;
+}
+
+size_t UHNBGMDecodeMeasurementContextBatch(const uint8_t *bytes, const size_t *lengths, size_t count, UHNBGMMeasurementContextRecord *records, bool *valid)
+{
+    size_t numberOfDecodedRecords = 0;
+    
+    for (size_t index = 0; index < count; index++)
+    {
+        bool didDecode = UHNBGMDecodeMeasurementContext(bytes, lengths[index], &records[index]);
+        
+        if (valid)
+        {
+            valid[index] = didDecode;
+        }
+        
+        numberOfDecodedRecords += (didDecode ? 1 : 0);
+        bytes += lengths[index];
+    }
+    
+    return numberOfDecodedRecords;
+}
+
+size_t UHNBGMEncodeMeasurement(const UHNBGMMeasurementRecord *record, uint8_t *bytes)
+{
+    const UHNBGMFieldLayout *layout = UHNBGMMeasurementFieldLayout();
+    uint8_t flags = record->flags;
+    size_t length = layout->requiredLengths[flags];
+    
+    // a layout that did not compile requires more than any value holds
+    if (length > kUHNBGMMaximumRecordLength)
+    {
+        return 0;
+    }
+    
+    memset(bytes, 0, length);
+    
+    bytes[0] = flags;
+    bytes[1] = (uint8_t) record->sequenceNumber;
+    bytes[2] = (uint8_t) (record->sequenceNumber >> 8);
+    bytes[3] = (uint8_t) record->year;
+    bytes[4] = (uint8_t) (record->year >> 8);
+    bytes[5] = record->month;
+    bytes[6] = record->day;
+    bytes[7] = record->hours;
+    bytes[8] = record->minutes;
+    bytes[9] = record->seconds;
+    
+    UHNBGMEncodeField(record->timeOffset, layout, bytes, flags, GlucoseMeasurementFieldTimeOffset);
+    UHNBGMEncodeShortFloatField(record->glucoseConcentration, layout, bytes, flags, GlucoseMeasurementFieldGlucoseConcentration);
+    UHNBGMEncodeField(record->type, layout, bytes, flags, GlucoseMeasurementFieldType);
+    UHNBGMEncodeField(record->sampleLocation, layout, bytes, flags, GlucoseMeasurementFieldSampleLocation);
+    UHNBGMEncodeField(record->sensorStatusAnnunciation, layout, bytes, flags, GlucoseMeasurementFieldSensorStatusAnnunciation);
+    
+    return length;
+}
+
+size_t UHNBGMEncodeMeasurementContext(const UHNBGMMeasurementContextRecord *record, uint8_t *bytes)
+{
+    const UHNBGMFieldLayout *layout = UHNBGMMeasurementContextFieldLayout();
+    uint8_t flags = record->flags;
+    size_t length = layout->requiredLengths[flags];
+    
+    // a layout that did not compile requires more than any value holds
+    if (length > kUHNBGMMaximumRecordLength)
+    {
+        return 0;
+    }
+    
+    memset(bytes, 0, length);
+    
+    bytes[0] = flags;
+    bytes[1] = (uint8_t) record->sequenceNumber;
+    bytes[2] = (uint8_t) (record->sequenceNumber >> 8);
+    
+    UHNBGMEncodeField(record->extendedFlags, layout, bytes, flags, GlucoseMeasurementContextFieldExtendedFlags);
+    UHNBGMEncodeField(record->carbohydrateID, layout, bytes, flags, GlucoseMeasurementContextFieldCarbohydrateID);
+    UHNBGMEncodeShortFloatField(record->carbohydrate, layout, bytes, flags, GlucoseMeasurementContextFieldCarbohydrate);
+    UHNBGMEncodeField(record->meal, layout, bytes, flags, GlucoseMeasurementContextFieldMeal);
+    UHNBGMEncodeField(record->tester, layout, bytes, flags, GlucoseMeasurementContextFieldTester);
+    UHNBGMEncodeField(record->health, layout, bytes, flags, GlucoseMeasurementContextFieldHealth);
+    UHNBGMEncodeField(record->exerciseDuration, layout, bytes, flags, GlucoseMeasurementContextFieldExerciseDuration);
+    UHNBGMEncodeField(record->exerciseIntensity, layout, bytes, flags, GlucoseMeasurementContextFieldExerciseIntensity);
+    UHNBGMEncodeField(record->medicationID, layout, bytes, flags, GlucoseMeasurementContextFieldMedicationID);
+    UHNBGMEncodeShortFloatField(record->medication, layout, bytes, flags, GlucoseMeasurementContextFieldMedicationValue);
+    UHNBGMEncodeShortFloatField(record->hbA1c, layout, bytes, flags, GlucoseMeasurementContextFieldHbA1c);
+    
+    return length;
+}
+
+int64_t UHNBGMMeasurementLocalTimestamp(const UHNBGMMeasurementRecord *record)
+{
+    // days from civil (proleptic Gregorian calendar)
+    int64_t year = record->year - (record->month <= 2 ? 1 : 0);
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t yearOfEra = year - era * 400;
+    int64_t month = record->month;
+    int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + record->day - 1;
+    int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    int64_t days = era * 146097 + dayOfEra - 719468;
+    
+    return days * 86400 + record->hours * 3600 + record->minutes * 60 + record->seconds + (int64_t) record->timeOffset * 60;
+}
@@ -0,0 +1,183 @@
+//
+//  UHNBGMRecordDecoder.h
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Foundation free decoding of the glucose measurement and glucose measurement context characteristics, so the
+// parsing can be shared with code that does not run on iOS. Field semantics match the `NSData+GlucoseMeasurementParser`
+// and `NSData+GlucoseMeasurementContextParser` categories; see UHNBGMConstants.h for the characteristic formats.
+
+#ifndef UHNBGMRecordDecoder_h
+#define UHNBGMRecordDecoder_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ The longest glucose measurement or glucose measurement context characteristic value, with all its optional fields
+ */
+#define kUHNBGMMaximumRecordLength      17
+
+/**
+ A decoded glucose measurement. Optional fields are only valid if their flag is set in `flags`
+ */
+typedef struct
+{
+    /** The glucose measurement flags (see GlucoseMeasurementFlagOption) */
+    uint8_t flags;
+    /** The sequence number of the measurement */
+    uint16_t sequenceNumber;
+    /** The base time of the measurement, in the local time of the glucose sensor */
+    uint16_t year;
+    uint8_t month;
+    uint8_t day;
+    uint8_t hours;
+    uint8_t minutes;
+    uint8_t seconds;
+    /** The time offset in minutes, 0 if not present */
+    int16_t timeOffset;
+    /** The glucose concentration in the units given by the flags */
+    float glucoseConcentration;
+    /** The fluid type (low nibble of the type and sample location field) */
+    uint8_t type;
+    /** The sample location (high nibble of the type and sample location field) */
+    uint8_t sampleLocation;
+    /** The sensor status annunciation (see GlucoseMeasurementStatusOption) */
+    uint16_t sensorStatusAnnunciation;
+} UHNBGMMeasurementRecord;
+
+/**
+ A decoded glucose measurement context. Optional fields are only valid if their flag is set in `flags`
+ */
+typedef struct
+{
+    /** The glucose measurement context flags (see GlucoseMeasurementContextFlagOption) */
+    uint8_t flags;
+    /** The sequence number of the related measurement */
+    uint16_t sequenceNumber;
+    uint8_t extendedFlags;
+    uint8_t carbohydrateID;
+    /** The carbohydrate in kg */
+    float carbohydrate;
+    uint8_t meal;
+    /** The tester (low nibble of the tester and health field) */
+    uint8_t tester;
+    /** The health (high nibble of the tester and health field) */
+    uint8_t health;
+    /** The exercise duration in seconds */
+    uint16_t exerciseDuration;
+    /** The exercise intensity in percent */
+    uint8_t exerciseIntensity;
+    uint8_t medicationID;
+    /** The medication in the units given by the flags */
+    float medication;
+    /** The HbA1c in percent */
+    float hbA1c;
+} UHNBGMMeasurementContextRecord;
+
+/**
+ Converts an IEEE-11073 16-bit SFLOAT. The special values (NaN, NRes, +/- infinity) are converted to NAN and +/- INFINITY
+ */
+float UHNBGMShortFloatValue(uint16_t rawValue);
+
+/**
+ Converts a value to an IEEE-11073 16-bit SFLOAT, keeping as many digits as the mantissa holds. NAN and +/- INFINITY, and
+ values too large for an SFLOAT, are converted to the special values
+ */
+uint16_t UHNBGMShortFloatRawValue(float value);
+
+/**
+ Decodes a glucose measurement characteristic value
+ 
+ @return `true` if the value was decoded, `false` if it is shorter than its flags require
+ */
+bool UHNBGMDecodeMeasurement(const uint8_t *bytes, size_t length, UHNBGMMeasurementRecord *record);
+
+/**
+ Decodes a glucose measurement context characteristic value
+ 
+ @return `true` if the value was decoded, `false` if it is shorter than its flags require
+ */
+bool UHNBGMDecodeMeasurementContext(const uint8_t *bytes, size_t length, UHNBGMMeasurementContextRecord *record);
+
+/**
+ Decodes a batch of glucose measurement characteristic values, stored back to back in `bytes` with the length of each
+ value in `lengths`. This is the entry point for decoding a capture outside of the app, for example from a command line
+ tool.
+ 
+ @param valid Set to `true` for each value that was decoded and `false` for each value that is shorter than its flags
+ require. May be NULL.
+ 
+ @return The number of values decoded
+ */
+size_t UHNBGMDecodeMeasurementBatch(const uint8_t *bytes, const size_t *lengths, size_t count, UHNBGMMeasurementRecord *records, bool *valid);
+
+/**
+ Decodes a batch of glucose measurement context characteristic values, stored back to back in `bytes` with the length of
+ each value in `lengths`
+ 
+ @param valid Set to `true` for each value that was decoded and `false` for each value that is shorter than its flags
+ require. May be NULL.
+ 
+ @return The number of values decoded
+ */
+size_t UHNBGMDecodeMeasurementContextBatch(const uint8_t *bytes, const size_t *lengths, size_t count, UHNBGMMeasurementContextRecord *records, bool *valid);
+
+/**
+ Encodes a glucose measurement as a characteristic value, with the fields present in its flags. This is the inverse of
+ `UHNBGMDecodeMeasurement`, except that SFLOAT values are written with the fewest digits that keep their value.
+ 
+ @param bytes Receives the value, at least `kUHNBGMMaximumRecordLength` bytes
+ 
+ @return The length of the value, 0 if the layout of the characteristic could not be compiled
+ */
+size_t UHNBGMEncodeMeasurement(const UHNBGMMeasurementRecord *record, uint8_t *bytes);
+
+/**
+ Encodes a glucose measurement context as a characteristic value, with the fields present in its flags
+ 
+ @param bytes Receives the value, at least `kUHNBGMMaximumRecordLength` bytes
+ 
+ @return The length of the value, 0 if the layout of the characteristic could not be compiled
+ */
+size_t UHNBGMEncodeMeasurementContext(const UHNBGMMeasurementContextRecord *record, uint8_t *bytes);
+
+/**
+ Returns the creation time of a measurement (base time plus time offset) as the local wall clock time of the glucose
+ sensor, counted in seconds from 1970-01-01 00:00:00 of that wall clock. This is NOT a UNIX timestamp: it differs from
+ `kGlucoseMeasurementKeyCreationDate`, which the parser converts with the time zone of the phone, by the UTC offset of
+ that time zone. Subtract the UTC offset in effect at the measurement (for example with `mktime` or
+ `-[NSTimeZone secondsFromGMTForDate:]`) to get a UNIX timestamp.
+ */
+int64_t UHNBGMMeasurementLocalTimestamp(const UHNBGMMeasurementRecord *record);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UHNBGMRecordDecoder_h */
@@ -0,0 +1,130 @@
+//
+//  UHNBGMRecordFilter.h
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+/**
+ `UHNBGMRecordFilter` decides which glucose measurements and glucose measurement contexts a `UHNBGMController` delivers to its delegate. The filter is evaluated on the raw characteristic values, so discarded records are never decoded into dictionaries.
+ 
+ @discussion The conditions are compiled into a flat predicate the first time the filter is evaluated after they change. A glucose measurement context is discarded when the glucose measurement it belongs to was discarded. Counters record how many records each condition discarded.
+ */
+@interface UHNBGMRecordFilter : NSObject
+
+///-----------------
+/// @name Conditions
+///-----------------
+
+/**
+ If `YES`, measurements of control solution (by fluid type or sample location) are discarded. Defaults to `NO`
+ */
+@property (nonatomic, assign) BOOL excludesControlSolution;
+
+/**
+ Measurements with any of these sensor status annunciation bits set are discarded (see GlucoseMeasurementStatusOption). Defaults to 0
+ */
+@property (nonatomic, assign) uint16_t excludedSensorStatusAnnunciationMask;
+
+/**
+ Measurements created before this date are discarded. Defaults to `nil`, for no lower bound
+ 
+ @discussion The base time of each measurement is converted with the UTC offset of the default time zone at that time, as the parser does, so the comparison holds across daylight saving changes
+ */
+@property (nonatomic, strong) NSDate *earliestDate;
+
+/**
+ Measurements created after this date are discarded. Defaults to `nil`, for no upper bound
+ */
+@property (nonatomic, strong) NSDate *latestDate;
+
+/**
+ Measurements with a lower sequence number are discarded. Defaults to 0
+ 
+ @discussion The sequence number bounds are also sent to the glucose sensor by `getAllStoredRecords`, so records outside them are not transferred at all
+ */
+@property (nonatomic, assign) uint16_t firstSequenceNumber;
+
+/**
+ Measurements with a higher sequence number are discarded. Defaults to 0xFFFF
+ 
+ @discussion Setting either bound so that `firstSequenceNumber` is greater than `lastSequenceNumber` raises an `NSInvalidArgumentException`. Use `setFirstSequenceNumber:lastSequenceNumber:` to move both bounds at once.
+ */
+@property (nonatomic, assign) uint16_t lastSequenceNumber;
+
+/**
+ Sets both sequence number bounds
+ 
+ @param firstSequenceNumber The lowest sequence number delivered
+ @param lastSequenceNumber The highest sequence number delivered. Must not be lower than `firstSequenceNumber`, otherwise an `NSInvalidArgumentException` is raised
+ 
+ */
+- (void) setFirstSequenceNumber:(uint16_t) firstSequenceNumber lastSequenceNumber:(uint16_t) lastSequenceNumber;
+
+///---------------
+/// @name Counters
+///---------------
+
+/** The number of measurements evaluated */
+@property (nonatomic, assign, readonly) NSUInteger numberOfMeasurementsEvaluated;
+/** The number of measurements discarded for their sequence number */
+@property (nonatomic, assign, readonly) NSUInteger numberOfMeasurementsFilteredBySequenceNumber;
+/** The number of measurements discarded for their creation date */
+@property (nonatomic, assign, readonly) NSUInteger numberOfMeasurementsFilteredByDate;
+/** The number of measurements discarded as control solution */
+@property (nonatomic, assign, readonly) NSUInteger numberOfMeasurementsFilteredAsControlSolution;
+/** The number of measurements discarded for their sensor status annunciation */
+@property (nonatomic, assign, readonly) NSUInteger numberOfMeasurementsFilteredBySensorStatus;
+/** The number of measurement contexts discarded with their measurement */
+@property (nonatomic, assign, readonly) NSUInteger numberOfMeasurementContextsFiltered;
+
+/**
+ Resets all the counters to 0
+ */
+- (void) resetCounters;
+
+///-----------------
+/// @name Evaluation
+///-----------------
+
+/**
+ Evaluates the filter on a glucose measurement
+ 
+ @param data The glucose measurement characteristic value
+ 
+ @return `YES` if the measurement should be delivered, `NO` if it should be discarded. Values that are too short to evaluate are delivered
+ 
+ */
+- (BOOL) shouldDeliverMeasurementData:(NSData *) data;
+
+/**
+ Evaluates the filter on a glucose measurement context
+ 
+ @param data The glucose measurement context characteristic value
+ 
+ @return `YES` if the measurement context should be delivered, `NO` if its measurement was discarded
+ 
+ */
+- (BOOL) shouldDeliverMeasurementContextData:(NSData *) data;
+
+@end
@@ -0,0 +1,303 @@
+//
+//  UHNBGMRecordFilter.m
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+
+#import "UHNBGMRecordFilter.h"
+#import "UHNBGMGlucoseFieldLayout.h"
+#import "UHNBGMRecordDecoder.h"
+#import "UHNBLETypes.h"
+
+// the UTC offset of a time zone is within a day either way, so a record further than that from a date bound is compared without looking up its offset
+#define kRecordFilterMaximumUTCOffset               86400
+
+typedef NS_OPTIONS (uint8_t, UHNBGMRecordFilterCheck)
+{
+    UHNBGMRecordFilterCheckSequenceNumber       = (1 << 0),
+    UHNBGMRecordFilterCheckDate                 = (1 << 1),
+    UHNBGMRecordFilterCheckControlSolution      = (1 << 2),
+    UHNBGMRecordFilterCheckSensorStatus         = (1 << 3),
+};
+
+// the conditions of the filter flattened into plain values compared against the raw bytes
+typedef struct
+{
+    UHNBGMRecordFilterCheck checks;
+    uint16_t firstSequenceNumber;
+    uint16_t lastSequenceNumber;
+    int64_t earliestTimestamp;
+    int64_t latestTimestamp;
+    uint16_t sensorStatusAnnunciationMask;
+} UHNBGMCompiledRecordFilter;
+
+@interface UHNBGMRecordFilter ()
+{
+    UHNBGMCompiledRecordFilter _compiledFilter;
+    NSTimeZone *_compiledTimeZone;
+    BOOL _needsCompiling;
+    BOOL _hasFilteredSequenceNumber;
+    uint16_t _filteredSequenceNumber;
+}
+@property (nonatomic, assign, readwrite) NSUInteger numberOfMeasurementsEvaluated;
+@property (nonatomic, assign, readwrite) NSUInteger numberOfMeasurementsFilteredBySequenceNumber;
+@property (nonatomic, assign, readwrite) NSUInteger numberOfMeasurementsFilteredByDate;
+@property (nonatomic, assign, readwrite) NSUInteger numberOfMeasurementsFilteredAsControlSolution;
+@property (nonatomic, assign, readwrite) NSUInteger numberOfMeasurementsFilteredBySensorStatus;
+@property (nonatomic, assign, readwrite) NSUInteger numberOfMeasurementContextsFiltered;
+@end
+
+@implementation UHNBGMRecordFilter
+
+- (instancetype) init;
+{
+    if ((self = [super init]))
+    {
+        _lastSequenceNumber = UINT16_MAX;
+        _needsCompiling = YES;
+    }
+    
+    return self;
+}
+
+#pragma mark - Accessor Methods
+
+- (void) setExcludesControlSolution:(BOOL) excludesControlSolution;
+{
+    _excludesControlSolution = excludesControlSolution;
+    _needsCompiling = YES;
+}
+
+- (void) setExcludedSensorStatusAnnunciationMask:(uint16_t) excludedSensorStatusAnnunciationMask;
+{
+    _excludedSensorStatusAnnunciationMask = excludedSensorStatusAnnunciationMask;
+    _needsCompiling = YES;
+}
+
+- (void) setEarliestDate:(NSDate *) earliestDate;
+{
+    _earliestDate = earliestDate;
+    _needsCompiling = YES;
+}
+
+- (void) setLatestDate:(NSDate *) latestDate;
+{
+    _latestDate = latestDate;
+    _needsCompiling = YES;
+}
+
+- (void) setFirstSequenceNumber:(uint16_t) firstSequenceNumber;
+{
+    [self setFirstSequenceNumber:firstSequenceNumber lastSequenceNumber:self.lastSequenceNumber];
+}
+
+- (void) setLastSequenceNumber:(uint16_t) lastSequenceNumber;
+{
+    [self setFirstSequenceNumber:self.firstSequenceNumber lastSequenceNumber:lastSequenceNumber];
+}
+
+- (void) setFirstSequenceNumber:(uint16_t) firstSequenceNumber lastSequenceNumber:(uint16_t) lastSequenceNumber;
+{
+    // the bounds are sent to the glucose sensor as a RACP range, which must not be empty
+    if (firstSequenceNumber > lastSequenceNumber)
+    {
+        [NSException raise:NSInvalidArgumentException
+                    format:@"%s: The first sequence number (%u) is greater than the last sequence number (%u)", __PRETTY_FUNCTION__, firstSequenceNumber, lastSequenceNumber];
+    }
+    
+    _firstSequenceNumber = firstSequenceNumber;
+    _lastSequenceNumber = lastSequenceNumber;
+    _needsCompiling = YES;
+}
+
+- (void) resetCounters;
+{
+    self.numberOfMeasurementsEvaluated = 0;
+    self.numberOfMeasurementsFilteredBySequenceNumber = 0;
+    self.numberOfMeasurementsFilteredByDate = 0;
+    self.numberOfMeasurementsFilteredAsControlSolution = 0;
+    self.numberOfMeasurementsFilteredBySensorStatus = 0;
+    self.numberOfMeasurementContextsFiltered = 0;
+}
+
+#pragma mark - Evaluation Methods
+
+- (BOOL) shouldDeliverMeasurementData:(NSData *) data;
+{
+    const UHNBGMFieldLayout *layout = UHNBGMMeasurementFieldLayout();
+    const uint8_t *bytes = [data bytes];
+    NSUInteger length = [data length];
+    
+    // leave values that cannot be evaluated to the parser
+    if (length < layout->fixedLength || length < layout->requiredLengths[bytes[0]])
+    {
+        return YES;
+    }
+    
+    if (_needsCompiling)
+    {
+        [self compile];
+    }
+    
+    self.numberOfMeasurementsEvaluated++;
+    
+    const UHNBGMCompiledRecordFilter *filter = &_compiledFilter;
+    uint8_t flags = bytes[0];
+    uint16_t sequenceNumber = bytes[1] | (bytes[2] << 8);
+    uint8_t offset;
+    
+    if (filter->checks & UHNBGMRecordFilterCheckSequenceNumber)
+    {
+        if (sequenceNumber < filter->firstSequenceNumber || sequenceNumber > filter->lastSequenceNumber)
+        {
+            self.numberOfMeasurementsFilteredBySequenceNumber++;
+            return [self didFilterMeasurementWithSequenceNumber:sequenceNumber];
+        }
+    }
+    
+    if (filter->checks & UHNBGMRecordFilterCheckDate)
+    {
+        UHNBGMMeasurementRecord record = {0};
+        record.year = bytes[3] | (bytes[4] << 8);
+        record.month = bytes[5];
+        record.day = bytes[6];
+        record.hours = bytes[7];
+        record.minutes = bytes[8];
+        record.seconds = bytes[9];
+        
+        if (kUHNBGMFieldAbsent != (offset = UHNBGMFieldOffset(layout, flags, GlucoseMeasurementFieldTimeOffset)))
+        {
+            record.timeOffset = UHNBGMFieldIntegerValue(layout, bytes, offset, GlucoseMeasurementFieldTimeOffset);
+        }
+        
+        if (![self isLocalTimestampWithinDates:UHNBGMMeasurementLocalTimestamp(&record)])
+        {
+            self.numberOfMeasurementsFilteredByDate++;
+            return [self didFilterMeasurementWithSequenceNumber:sequenceNumber];
+        }
+    }
+    
+    if ((filter->checks & UHNBGMRecordFilterCheckControlSolution) && kUHNBGMFieldAbsent != (offset = UHNBGMFieldOffset(layout, flags, GlucoseMeasurementFieldType)))
+    {
+        if (GlucoseFluidTypeControlSolution == UHNBGMFieldIntegerValue(layout, bytes, offset, GlucoseMeasurementFieldType) ||
+            GlucoseSampleLocationControlSolution == UHNBGMFieldIntegerValue(layout, bytes, offset, GlucoseMeasurementFieldSampleLocation))
+        {
+            self.numberOfMeasurementsFilteredAsControlSolution++;
+            return [self didFilterMeasurementWithSequenceNumber:sequenceNumber];
+        }
+    }
+    
+    if ((filter->checks & UHNBGMRecordFilterCheckSensorStatus) && kUHNBGMFieldAbsent != (offset = UHNBGMFieldOffset(layout, flags, GlucoseMeasurementFieldSensorStatusAnnunciation)))
+    {
+        if (UHNBGMFieldIntegerValue(layout, bytes, offset, GlucoseMeasurementFieldSensorStatusAnnunciation) & filter->sensorStatusAnnunciationMask)
+        {
+            self.numberOfMeasurementsFilteredBySensorStatus++;
+            return [self didFilterMeasurementWithSequenceNumber:sequenceNumber];
+        }
+    }
+    
+    _hasFilteredSequenceNumber = NO;
+    
+    return YES;
+}
+
+- (BOOL) shouldDeliverMeasurementContextData:(NSData *) data;
+{
+    // a measurement context follows its measurement, so only the latest discarded measurement needs to be remembered
+    if (_hasFilteredSequenceNumber && [data length] >= 3)
+    {
+        const uint8_t *bytes = [data bytes];
+        uint16_t sequenceNumber = bytes[1] | (bytes[2] << 8);
+        
+        if (sequenceNumber == _filteredSequenceNumber)
+        {
+            self.numberOfMeasurementContextsFiltered++;
+            return NO;
+        }
+    }
+    
+    return YES;
+}
+
+#pragma mark - Private Methods
+
+- (BOOL) isLocalTimestampWithinDates:(int64_t) localTimestamp;
+{
+    const UHNBGMCompiledRecordFilter *filter = &_compiledFilter;
+    
+    // most records are far from both bounds, so their offset does not matter
+    if (localTimestamp + kRecordFilterMaximumUTCOffset < filter->earliestTimestamp || localTimestamp - kRecordFilterMaximumUTCOffset > filter->latestTimestamp)
+    {
+        return NO;
+    }
+    
+    if (localTimestamp - kRecordFilterMaximumUTCOffset >= filter->earliestTimestamp && localTimestamp + kRecordFilterMaximumUTCOffset <= filter->latestTimestamp)
+    {
+        return YES;
+    }
+    
+    // the base time of a measurement is in the local time of the glucose sensor, which the parsers take as the local time
+    // zone, so each record is converted with the offset in effect at its own time rather than at the bound
+    CFTimeZoneRef timeZone = (__bridge CFTimeZoneRef) _compiledTimeZone;
+    CFAbsoluteTime time = localTimestamp - kCFAbsoluteTimeIntervalSince1970;
+    CFTimeInterval utcOffset = CFTimeZoneGetSecondsFromGMT(timeZone, time);
+    utcOffset = CFTimeZoneGetSecondsFromGMT(timeZone, time - utcOffset);
+    int64_t timestamp = localTimestamp - (int64_t) utcOffset;
+    
+    return (timestamp >= filter->earliestTimestamp && timestamp <= filter->latestTimestamp);
+}
+
+- (BOOL) didFilterMeasurementWithSequenceNumber:(uint16_t) sequenceNumber;
+{
+    _hasFilteredSequenceNumber = YES;
+    _filteredSequenceNumber = sequenceNumber;
+    
+    return NO;
+}
+
+- (void) compile;
+{
+    UHNBGMCompiledRecordFilter filter = {0};
+    
+    filter.firstSequenceNumber = self.firstSequenceNumber;
+    filter.lastSequenceNumber = self.lastSequenceNumber;
+    
+    if (self.firstSequenceNumber > 0 || self.lastSequenceNumber < UINT16_MAX)
+    {
+        filter.checks |= UHNBGMRecordFilterCheckSequenceNumber;
+    }
+    
+    // the bounds stay in UTC; the margin keeps them clear of the ends of the range when a record is compared against them
+    filter.earliestTimestamp = INT64_MIN + kRecordFilterMaximumUTCOffset;
+    filter.latestTimestamp = INT64_MAX - kRecordFilterMaximumUTCOffset;
+    _compiledTimeZone = [NSTimeZone defaultTimeZone];
+    
+    if (self.earliestDate)
+    {
+        filter.earliestTimestamp = (int64_t) ceil([self.earliestDate timeIntervalSince1970]);
+        filter.checks |= UHNBGMRecordFilterCheckDate;
+    }
+    
+    if (self.latestDate)
+    {
+        filter.latestTimestamp = (int64_t) floor([self.latestDate timeIntervalSince1970]);
+        filter.checks |= UHNBGMRecordFilterCheckDate;
+    }
+    
+    if (self.excludesControlSolution)
+    {
+        filter.checks |= UHNBGMRecordFilterCheckControlSolution;
+    }
+    
+    if (self.excludedSensorStatusAnnunciationMask)
+    {
+        filter.sensorStatusAnnunciationMask = self.excludedSensorStatusAnnunciationMask;
+        filter.checks |= UHNBGMRecordFilterCheckSensorStatus;
+    }
+    
+    _compiledFilter = filter;
+    _needsCompiling = NO;
+}
+
+@end
@@ -0,0 +1,144 @@
+//
+//  UHNBGMRecordJSONWriter.h
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "UHNBGMRecordDecoder.h"
+#import "UHNBGMRecordSink.h"
+
+/**
+ The output formats of a `UHNBGMRecordJSONWriter`. Both formats write one JSON object per line (newline delimited JSON)
+ */
+typedef NS_ENUM (NSUInteger, UHNBGMRecordJSONFormat)
+{
+    /** A flat JSON object per record, with only the fields that are present in the measurement and its context */
+    UHNBGMRecordJSONFormatJSONLines = 0,
+    /** A FHIR Observation resource per record */
+    UHNBGMRecordJSONFormatFHIRObservation,
+};
+
+/**
+ `UHNBGMRecordJSONWriter` streams glucose measurements, paired with their measurement context, as JSON straight from the decoded C records of `UHNBGMRecordDecoder.h`, without building a dictionary or a `NSJSONSerialization` object graph per record.
+ 
+ @discussion Records are formatted from preformatted string templates into a fixed size buffer, which is handed to the output whenever it fills up, so the memory used does not grow with the size of a transfer. The output is either a `NSMutableData` that grows with the written records, or a file descriptor.
+ 
+ Glucose concentrations are written in mg/dL (kg/L measurements) or mmol/L (mol/L measurements), and creation times as UTC in the ISO 8601 format `YYYY-MM-DDThh:mm:ssZ`.
+ 
+ The writer can also be added to a `UHNBGMController` as a record sink. A sink writer pairs each measurement with the context that follows it (see `UHNBGMRecordPairer`), and flushes at the end of every transfer. It writes straight from the raw characteristic values when lazy record parsing is enabled on the controller (see `enableLazyRecordParsing:`), and otherwise from values encoded again from the record details.
+ 
+ The writer is not thread safe. As a record sink it is only called from the delegate queue of its controller.
+ */
+@interface UHNBGMRecordJSONWriter : NSObject <UHNBGMRecordSink>
+
+/**
+ The output format
+ */
+@property (nonatomic, assign, readonly) UHNBGMRecordJSONFormat format;
+
+/**
+ The reference to the patient the observations are about, such as `Patient/123`. Only used by the FHIR Observation format
+ */
+@property (nonatomic, copy) NSString *patientReference;
+
+/**
+ The reference to the glucose meter that made the observations, such as `Device/456`. Only used by the FHIR Observation format
+ */
+@property (nonatomic, copy) NSString *deviceReference;
+
+/**
+ The time zone the clock of the glucose meter is set to. The local creation time of each measurement is converted to UTC with the offset in effect at that time. Defaults to UTC
+ */
+@property (nonatomic, strong) NSTimeZone *meterTimeZone;
+
+/**
+ The number of records written
+ */
+@property (nonatomic, assign, readonly) NSUInteger numberOfRecordsWritten;
+
+/**
+ The number of bytes handed to the output, not including the bytes still buffered
+ */
+@property (nonatomic, assign, readonly) NSUInteger numberOfBytesWritten;
+
+///-------------------------------
+/// @name Initializing the Writer
+///-------------------------------
+
+/**
+ Initializes a writer that appends to a mutable data
+ 
+ @param data The data the records are appended to
+ @param format The output format
+ 
+ @return The initialized writer
+ 
+ */
+- (instancetype) initWithMutableData:(NSMutableData *) data format:(UHNBGMRecordJSONFormat) format;
+
+/**
+ Initializes a writer that writes to a file descriptor. The writer does not close the file descriptor
+ 
+ @param fileDescriptor The file descriptor the records are written to
+ @param format The output format
+ 
+ @return The initialized writer
+ 
+ */
+- (instancetype) initWithFileDescriptor:(int) fileDescriptor format:(UHNBGMRecordJSONFormat) format;
+
+///------------------------
+/// @name Writing Records
+///------------------------
+
+/**
+ Writes a decoded glucose measurement
+ 
+ @param measurement The glucose measurement
+ @param context The glucose measurement context of the measurement, or `NULL` if there is none
+ 
+ @return `YES` if the record was written, `NO` if the output could not be written to
+ 
+ */
+- (BOOL) writeMeasurement:(const UHNBGMMeasurementRecord *) measurement context:(const UHNBGMMeasurementContextRecord *) context;
+
+/**
+ Decodes and writes a glucose measurement characteristic value
+ 
+ @param measurementData The glucose measurement characteristic value
+ @param contextData The glucose measurement context characteristic value of the measurement, or `nil` if there is none
+ 
+ @return `YES` if the record was written, `NO` if a value could not be decoded or the output could not be written to
+ 
+ */
+- (BOOL) writeMeasurementData:(NSData *) measurementData contextData:(NSData *) contextData;
+
+/**
+ Hands the buffered records to the output. A sink writer first writes the measurement still waiting for its context
+ 
+ @return `YES` if the buffered records were written, `NO` if the output could not be written to
+ 
+ */
+- (BOOL) flush;
+
+@end
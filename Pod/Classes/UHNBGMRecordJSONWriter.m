@@ -0,0 +1,581 @@
+//
+//  UHNBGMRecordJSONWriter.m
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+
+#import "UHNBGMRecordJSONWriter.h"
+#import "UHNBGMConstants.h"
+#import "UHNBGMRecordPairer.h"
+
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <unistd.h>
+
+#define kRecordJSONWriterBufferSize         4096
+// the longest number or date written in one go
+#define kRecordJSONWriterMaximumFieldLength 32
+
+/**
+ The output of a writer: a fixed size buffer and where it goes once it is full
+ */
+typedef struct
+{
+    char bytes[kRecordJSONWriterBufferSize];
+    size_t length;
+    /** The file descriptor written to, -1 if writing to `data` */
+    int fileDescriptor;
+    /** The `NSMutableData` appended to, kept alive by the writer */
+    void *data;
+    size_t numberOfBytesWritten;
+    /** Set once a write to the file descriptor fails; nothing more is written after that */
+    bool failed;
+} UHNBGMJSONOutput;
+
+#pragma mark - Output Functions
+
+static void UHNBGMJSONOutputWrite(UHNBGMJSONOutput *output, const char *bytes, size_t length)
+{
+    if (output->failed)
+    {
+        return;
+    }
+    
+    if (output->fileDescriptor < 0)
+    {
+        [(__bridge NSMutableData *) output->data appendBytes:bytes length:length];
+    }
+    else
+    {
+        // a write can be cut short by a signal or a full pipe, so keep going until everything is written
+        size_t offset = 0;
+        while (offset < length)
+        {
+            ssize_t written = write(output->fileDescriptor, bytes + offset, length - offset);
+            if (written < 0)
+            {
+                if (EINTR == errno)
+                {
+                    continue;
+                }
+                
+                output->failed = true;
+                return;
+            }
+            
+            offset += (size_t) written;
+        }
+    }
+    
+    output->numberOfBytesWritten += length;
+}
+
+static void UHNBGMJSONOutputFlush(UHNBGMJSONOutput *output)
+{
+    if (output->length > 0)
+    {
+        UHNBGMJSONOutputWrite(output, output->bytes, output->length);
+        output->length = 0;
+    }
+}
+
+// makes sure that `length` bytes can be written straight into the buffer
+static inline void UHNBGMJSONOutputReserve(UHNBGMJSONOutput *output, size_t length)
+{
+    if (output->length + length > kRecordJSONWriterBufferSize)
+    {
+        UHNBGMJSONOutputFlush(output);
+    }
+}
+
+static inline void UHNBGMJSONAppend(UHNBGMJSONOutput *output, const char *bytes, size_t length)
+{
+    if (output->length + length > kRecordJSONWriterBufferSize)
+    {
+        UHNBGMJSONOutputFlush(output);
+        
+        // only a long reference does not fit in an empty buffer
+        if (length > kRecordJSONWriterBufferSize)
+        {
+            UHNBGMJSONOutputWrite(output, bytes, length);
+            return;
+        }
+    }
+    
+    memcpy(output->bytes + output->length, bytes, length);
+    output->length += length;
+}
+
+#define UHNBGMJSONAppendLiteral(output, literal) UHNBGMJSONAppend(output, literal, sizeof(literal) - 1)
+
+#pragma mark - Formatting Functions
+
+static inline void UHNBGMJSONAppendInteger(UHNBGMJSONOutput *output, int64_t value)
+{
+    UHNBGMJSONOutputReserve(output, kRecordJSONWriterMaximumFieldLength);
+    
+    char *cursor = output->bytes + output->length;
+    uint64_t magnitude = (uint64_t) value;
+    if (value < 0)
+    {
+        *cursor++ = '-';
+        magnitude = (uint64_t) 0 - magnitude;
+    }
+    
+    // the digits come out backwards
+    char digits[20];
+    int count = 0;
+    do
+    {
+        digits[count++] = (char) ('0' + (magnitude % 10));
+        magnitude /= 10;
+    } while (magnitude > 0);
+    
+    while (count > 0)
+    {
+        *cursor++ = digits[--count];
+    }
+    
+    output->length = (size_t) (cursor - output->bytes);
+}
+
+// writes a value with a fixed number of decimals (at most 3), or null if it is not a number
+static void UHNBGMJSONAppendFixedPoint(UHNBGMJSONOutput *output, double value, unsigned int decimals)
+{
+    static const int64_t kScales[] = {1, 10, 100, 1000};
+    
+    if (!isfinite(value) || fabs(value) >= 1e15)
+    {
+        UHNBGMJSONAppendLiteral(output, "null");
+        return;
+    }
+    
+    int64_t scale = kScales[decimals];
+    int64_t scaledValue = llround(value * scale);
+    if (scaledValue < 0)
+    {
+        UHNBGMJSONAppendLiteral(output, "-");
+        scaledValue = -scaledValue;
+    }
+    
+    UHNBGMJSONAppendInteger(output, scaledValue / scale);
+    
+    if (decimals > 0)
+    {
+        UHNBGMJSONOutputReserve(output, kRecordJSONWriterMaximumFieldLength);
+        
+        char *cursor = output->bytes + output->length;
+        int64_t fraction = scaledValue % scale;
+        *cursor++ = '.';
+        for (int64_t digit = scale / 10; digit > 0; digit /= 10)
+        {
+            *cursor++ = (char) ('0' + (fraction / digit) % 10);
+        }
+        
+        output->length = (size_t) (cursor - output->bytes);
+    }
+}
+
+static inline char *UHNBGMJSONWriteDigits(char *cursor, unsigned int value, int count)
+{
+    for (int index = count - 1; index >= 0; index--)
+    {
+        cursor[index] = (char) ('0' + value % 10);
+        value /= 10;
+    }
+    
+    return cursor + count;
+}
+
+// writes seconds since 1970-01-01 00:00:00 UTC as a quoted "YYYY-MM-DDThh:mm:ssZ"
+static void UHNBGMJSONAppendDate(UHNBGMJSONOutput *output, int64_t timestamp)
+{
+    int64_t days = timestamp / 86400;
+    int64_t secondsOfDay = timestamp % 86400;
+    if (secondsOfDay < 0)
+    {
+        secondsOfDay += 86400;
+        days -= 1;
+    }
+    
+    // civil date from the days since the epoch, counted in 400 year eras starting on 0000-03-01
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned int dayOfEra = (unsigned int) (days - era * 146097);
+    unsigned int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    unsigned int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    unsigned int shiftedMonth = (5 * dayOfYear + 2) / 153;
+    unsigned int day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1;
+    unsigned int month = (shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9);
+    int64_t year = (int64_t) yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+    year = MIN(MAX(year, 0), 9999);
+    
+    UHNBGMJSONOutputReserve(output, kRecordJSONWriterMaximumFieldLength);
+    
+    char *cursor = output->bytes + output->length;
+    *cursor++ = '"';
+    cursor = UHNBGMJSONWriteDigits(cursor, (unsigned int) year, 4);
+    *cursor++ = '-';
+    cursor = UHNBGMJSONWriteDigits(cursor, month, 2);
+    *cursor++ = '-';
+    cursor = UHNBGMJSONWriteDigits(cursor, day, 2);
+    *cursor++ = 'T';
+    cursor = UHNBGMJSONWriteDigits(cursor, (unsigned int) (secondsOfDay / 3600), 2);
+    *cursor++ = ':';
+    cursor = UHNBGMJSONWriteDigits(cursor, (unsigned int) (secondsOfDay / 60 % 60), 2);
+    *cursor++ = ':';
+    cursor = UHNBGMJSONWriteDigits(cursor, (unsigned int) (secondsOfDay % 60), 2);
+    *cursor++ = 'Z';
+    *cursor++ = '"';
+    
+    output->length = (size_t) (cursor - output->bytes);
+}
+
+@interface UHNBGMRecordJSONWriter ()
+{
+    UHNBGMJSONOutput _output;
+}
+@property (nonatomic, assign, readwrite) UHNBGMRecordJSONFormat format;
+@property (nonatomic, assign, readwrite) NSUInteger numberOfRecordsWritten;
+@property (nonatomic, strong) NSMutableData *data;
+// the FHIR subject and device elements, formatted once when the references are set
+@property (nonatomic, strong) NSData *subjectElement;
+@property (nonatomic, strong) NSData *deviceElement;
+// a sink writer holds a measurement with context information until its context arrives
+@property (nonatomic, strong) UHNBGMRecordPairer *recordPairer;
+@end
+
+@implementation UHNBGMRecordJSONWriter
+
+#pragma mark - Initialization Methods
+
+- (instancetype) initWithMutableData:(NSMutableData *) data format:(UHNBGMRecordJSONFormat) format;
+{
+    if ((self = [super init]))
+    {
+        self.format = format;
+        self.data = data;
+        _output.fileDescriptor = -1;
+        _output.data = (__bridge void *) data;
+        self.meterTimeZone = [NSTimeZone timeZoneForSecondsFromGMT:0];
+        self.recordPairer = [[UHNBGMRecordPairer alloc] init];
+    }
+    
+    return self;
+}
+
+- (instancetype) initWithFileDescriptor:(int) fileDescriptor format:(UHNBGMRecordJSONFormat) format;
+{
+    if ((self = [super init]))
+    {
+        self.format = format;
+        _output.fileDescriptor = fileDescriptor;
+        self.meterTimeZone = [NSTimeZone timeZoneForSecondsFromGMT:0];
+        self.recordPairer = [[UHNBGMRecordPairer alloc] init];
+    }
+    
+    return self;
+}
+
+- (void) dealloc;
+{
+    [self flush];
+}
+
+#pragma mark - Configuration Methods
+
+- (void) setPatientReference:(NSString *) patientReference;
+{
+    _patientReference = [patientReference copy];
+    self.subjectElement = [self elementWithName:@"subject" reference:patientReference];
+}
+
+- (void) setDeviceReference:(NSString *) deviceReference;
+{
+    _deviceReference = [deviceReference copy];
+    self.deviceElement = [self elementWithName:@"device" reference:deviceReference];
+}
+
+- (NSData *) elementWithName:(NSString *) name reference:(NSString *) reference;
+{
+    if (!reference)
+    {
+        return nil;
+    }
+    
+    // let the serializer escape the reference, then drop the brackets of the array around it
+    NSData *escapedReference = [NSJSONSerialization dataWithJSONObject:@[reference] options:0 error:nil];
+    NSMutableData *element = [[[NSString stringWithFormat:@",\"%@\":{\"reference\":", name] dataUsingEncoding:NSUTF8StringEncoding] mutableCopy];
+    [element appendData:[escapedReference subdataWithRange:NSMakeRange(1, [escapedReference length] - 2)]];
+    [element appendBytes:"}" length:1];
+    
+    return element;
+}
+
+- (NSUInteger) numberOfBytesWritten;
+{
+    return _output.numberOfBytesWritten;
+}
+
+#pragma mark - Writing Methods
+
+- (BOOL) writeMeasurement:(const UHNBGMMeasurementRecord *) measurement context:(const UHNBGMMeasurementContextRecord *) context;
+{
+    int64_t timestamp = [self timestampForLocalTimestamp:UHNBGMMeasurementLocalTimestamp(measurement)];
+    
+    if (UHNBGMRecordJSONFormatFHIRObservation == self.format)
+    {
+        [self writeObservationForMeasurement:measurement context:context timestamp:timestamp];
+    }
+    else
+    {
+        [self writeLineForMeasurement:measurement context:context timestamp:timestamp];
+    }
+    
+    self.numberOfRecordsWritten += 1;
+    
+    return !_output.failed;
+}
+
+- (BOOL) writeMeasurementData:(NSData *) measurementData contextData:(NSData *) contextData;
+{
+    UHNBGMMeasurementRecord measurement;
+    UHNBGMMeasurementContextRecord context;
+    
+    if (!UHNBGMDecodeMeasurement([measurementData bytes], [measurementData length], &measurement))
+    {
+        return NO;
+    }
+    
+    if (contextData && !UHNBGMDecodeMeasurementContext([contextData bytes], [contextData length], &context))
+    {
+        return NO;
+    }
+    
+    return [self writeMeasurement:&measurement context:(contextData ? &context : NULL)];
+}
+
+- (BOOL) flush;
+{
+    [self.recordPairer flushUsingBlock:^(NSData *measurementData, NSData *measurementContextData) {
+        [self writeMeasurementData:measurementData contextData:measurementContextData];
+    }];
+    
+    UHNBGMJSONOutputFlush(&_output);
+    
+    return !_output.failed;
+}
+
+- (int64_t) timestampForLocalTimestamp:(int64_t) localTimestamp;
+{
+    // the offset is looked up at the local time, then again at the UTC time that gives, so a record just after a
+    // daylight saving time change gets the offset in effect at its own time
+    CFTimeZoneRef timeZone = (__bridge CFTimeZoneRef) self.meterTimeZone;
+    CFAbsoluteTime time = localTimestamp - kCFAbsoluteTimeIntervalSince1970;
+    CFTimeInterval utcOffset = CFTimeZoneGetSecondsFromGMT(timeZone, time);
+    utcOffset = CFTimeZoneGetSecondsFromGMT(timeZone, time - utcOffset);
+    
+    return localTimestamp - (int64_t) utcOffset;
+}
+
+#pragma mark - Formatting Methods
+
+- (void) writeLineForMeasurement:(const UHNBGMMeasurementRecord *) measurement context:(const UHNBGMMeasurementContextRecord *) context timestamp:(int64_t) timestamp;
+{
+    UHNBGMJSONOutput *output = &_output;
+    
+    UHNBGMJSONAppendLiteral(output, "{\"sequenceNumber\":");
+    UHNBGMJSONAppendInteger(output, measurement->sequenceNumber);
+    UHNBGMJSONAppendLiteral(output, ",\"time\":");
+    UHNBGMJSONAppendDate(output, timestamp);
+    
+    if (measurement->flags & GlucoseMeasurementFlagPresentGlucoseConcentrationTypeAndSampleLocation)
+    {
+        UHNBGMJSONAppendLiteral(output, ",\"glucose\":");
+        if (measurement->flags & GlucoseMeasurementFlagGlucoseConcentrationUnits)
+        {
+            UHNBGMJSONAppendFixedPoint(output, measurement->glucoseConcentration * 1e3, 1);
+            UHNBGMJSONAppendLiteral(output, ",\"unit\":\"mmol/L\",\"type\":");
+        }
+        else
+        {
+            UHNBGMJSONAppendFixedPoint(output, measurement->glucoseConcentration * 1e5, 0);
+            UHNBGMJSONAppendLiteral(output, ",\"unit\":\"mg/dL\",\"type\":");
+        }
+        UHNBGMJSONAppendInteger(output, measurement->type);
+        UHNBGMJSONAppendLiteral(output, ",\"sampleLocation\":");
+        UHNBGMJSONAppendInteger(output, measurement->sampleLocation);
+    }
+    
+    if (measurement->flags & GlucoseMeasurementFlagPresentSensorStatusAnnunciation)
+    {
+        UHNBGMJSONAppendLiteral(output, ",\"sensorStatus\":");
+        UHNBGMJSONAppendInteger(output, measurement->sensorStatusAnnunciation);
+    }
+    
+    if (context)
+    {
+        if (context->flags & GlucoseMeasurementContextFlagPresentCarbohydrateIDAndCarbohydrate)
+        {
+            UHNBGMJSONAppendLiteral(output, ",\"carbohydrateID\":");
+            UHNBGMJSONAppendInteger(output, context->carbohydrateID);
+            UHNBGMJSONAppendLiteral(output, ",\"carbohydrateGrams\":");
+            UHNBGMJSONAppendFixedPoint(output, context->carbohydrate * 1e3, 1);
+        }
+        
+        if (context->flags & GlucoseMeasurementContextFlagPresentMeal)
+        {
+            UHNBGMJSONAppendLiteral(output, ",\"meal\":");
+            UHNBGMJSONAppendInteger(output, context->meal);
+        }
+        
+        if (context->flags & GlucoseMeasurementContextFlagPresentTesterHealth)
+        {
+            UHNBGMJSONAppendLiteral(output, ",\"tester\":");
+            UHNBGMJSONAppendInteger(output, context->tester);
+            UHNBGMJSONAppendLiteral(output, ",\"health\":");
+            UHNBGMJSONAppendInteger(output, context->health);
+        }
+        
+        if (context->flags & GlucoseMeasurementContextFlagPresentExerciseDurationAndExerciseIntensity)
+        {
+            UHNBGMJSONAppendLiteral(output, ",\"exerciseDuration\":");
+            UHNBGMJSONAppendInteger(output, context->exerciseDuration);
+            UHNBGMJSONAppendLiteral(output, ",\"exerciseIntensity\":");
+            UHNBGMJSONAppendInteger(output, context->exerciseIntensity);
+        }
+        
+        if (context->flags & GlucoseMeasurementContextFlagPresentMedicationIDAndMedication)
+        {
+            UHNBGMJSONAppendLiteral(output, ",\"medicationID\":");
+            UHNBGMJSONAppendInteger(output, context->medicationID);
+            // medications are given in kg or L
+            if (context->flags & GlucoseMeasurementContextFlagPresentMedicationUnits)
+            {
+                UHNBGMJSONAppendLiteral(output, ",\"medicationMillilitres\":");
+            }
+            else
+            {
+                UHNBGMJSONAppendLiteral(output, ",\"medicationMilligrams\":");
+            }
+            UHNBGMJSONAppendFixedPoint(output, context->medication * ((context->flags & GlucoseMeasurementContextFlagPresentMedicationUnits) ? 1e3 : 1e6), 1);
+        }
+        
+        if (context->flags & GlucoseMeasurementContextFlagPresentHbA1c)
+        {
+            UHNBGMJSONAppendLiteral(output, ",\"hbA1c\":");
+            UHNBGMJSONAppendFixedPoint(output, context->hbA1c, 1);
+        }
+    }
+    
+    UHNBGMJSONAppendLiteral(output, "}\n");
+}
+
+- (void) writeObservationForMeasurement:(const UHNBGMMeasurementRecord *) measurement context:(const UHNBGMMeasurementContextRecord *) context timestamp:(int64_t) timestamp;
+{
+    UHNBGMJSONOutput *output = &_output;
+    BOOL isMolar = (measurement->flags & GlucoseMeasurementFlagGlucoseConcentrationUnits);
+    BOOL hasStatus = (measurement->flags & GlucoseMeasurementFlagPresentSensorStatusAnnunciation);
+    BOOL hasMeal = (context && (context->flags & GlucoseMeasurementContextFlagPresentMeal));
+    
+    UHNBGMJSONAppendLiteral(output, "{\"resourceType\":\"Observation\",\"identifier\":[{\"system\":\"urn:uhn:bgm:sequence-number\",\"value\":\"");
+    UHNBGMJSONAppendInteger(output, measurement->sequenceNumber);
+    UHNBGMJSONAppendLiteral(output, "\"}],\"status\":\"final\",\"code\":{\"coding\":[{\"system\":\"http://loinc.org\",");
+    if (isMolar)
+    {
+        UHNBGMJSONAppendLiteral(output, "\"code\":\"14743-9\",\"display\":\"Glucose [Moles/volume] in Capillary blood by Glucometer\"}]}");
+    }
+    else
+    {
+        UHNBGMJSONAppendLiteral(output, "\"code\":\"41653-7\",\"display\":\"Glucose [Mass/volume] in Capillary blood by Glucometer\"}]}");
+    }
+    
+    if (self.subjectElement)
+    {
+        UHNBGMJSONAppend(output, [self.subjectElement bytes], [self.subjectElement length]);
+    }
+    
+    UHNBGMJSONAppendLiteral(output, ",\"effectiveDateTime\":");
+    UHNBGMJSONAppendDate(output, timestamp);
+    
+    if (self.deviceElement)
+    {
+        UHNBGMJSONAppend(output, [self.deviceElement bytes], [self.deviceElement length]);
+    }
+    
+    double glucoseConcentration = (isMolar ? measurement->glucoseConcentration * 1e3 : measurement->glucoseConcentration * 1e5);
+    if ((measurement->flags & GlucoseMeasurementFlagPresentGlucoseConcentrationTypeAndSampleLocation) && isfinite(glucoseConcentration))
+    {
+        UHNBGMJSONAppendLiteral(output, ",\"valueQuantity\":{\"value\":");
+        if (isMolar)
+        {
+            UHNBGMJSONAppendFixedPoint(output, glucoseConcentration, 1);
+            UHNBGMJSONAppendLiteral(output, ",\"unit\":\"mmol/L\",\"system\":\"http://unitsofmeasure.org\",\"code\":\"mmol/L\"}");
+        }
+        else
+        {
+            UHNBGMJSONAppendFixedPoint(output, glucoseConcentration, 0);
+            UHNBGMJSONAppendLiteral(output, ",\"unit\":\"mg/dL\",\"system\":\"http://unitsofmeasure.org\",\"code\":\"mg/dL\"}");
+        }
+    }
+    else
+    {
+        // a missing concentration or a special value (NaN, NRes, +/- infinity) of the meter
+        UHNBGMJSONAppendLiteral(output, ",\"dataAbsentReason\":{\"coding\":[{\"system\":\"http://hl7.org/fhir/data-absent-reason\",\"code\":\"error\"}]}");
+    }
+    
+    // the meal and the sensor status have no standard element, so they are written as extensions
+    if (hasMeal || hasStatus)
+    {
+        UHNBGMJSONAppendLiteral(output, ",\"extension\":[");
+        if (hasMeal)
+        {
+            UHNBGMJSONAppendLiteral(output, "{\"url\":\"urn:uhn:bgm:meal\",\"valueInteger\":");
+            UHNBGMJSONAppendInteger(output, context->meal);
+            UHNBGMJSONAppendLiteral(output, "}");
+        }
+        if (hasMeal && hasStatus)
+        {
+            UHNBGMJSONAppendLiteral(output, ",");
+        }
+        if (hasStatus)
+        {
+            UHNBGMJSONAppendLiteral(output, "{\"url\":\"urn:uhn:bgm:sensor-status\",\"valueInteger\":");
+            UHNBGMJSONAppendInteger(output, measurement->sensorStatusAnnunciation);
+            UHNBGMJSONAppendLiteral(output, "}");
+        }
+        UHNBGMJSONAppendLiteral(output, "]");
+    }
+    
+    UHNBGMJSONAppendLiteral(output, "}\n");
+}
+
+#pragma mark - Record Sink Methods
+
+- (UHNBGMRecordSinkInterest) recordSinkInterests;
+{
+    return (UHNBGMRecordSinkInterestMeasurements | UHNBGMRecordSinkInterestMeasurementContexts | UHNBGMRecordSinkInterestTransferEvents);
+}
+
+- (void) bgmController:(UHNBGMController *) controller didReceiveGlucoseMeasurement:(NSDictionary *) measurementDetails;
+{
+    [self.recordPairer addMeasurementDetails:measurementDetails usingBlock:^(NSData *measurementData, NSData *measurementContextData) {
+        [self writeMeasurementData:measurementData contextData:measurementContextData];
+    }];
+}
+
+- (void) bgmController:(UHNBGMController *) controller didReceiveGlucoseMeasurementContext:(NSDictionary *) measurementContextDetails;
+{
+    [self.recordPairer addMeasurementContextDetails:measurementContextDetails usingBlock:^(NSData *measurementData, NSData *measurementContextData) {
+        [self writeMeasurementData:measurementData contextData:measurementContextData];
+    }];
+}
+
+- (void) bgmController:(UHNBGMController *) controller didCompleteTransferWithNumberOfRecords:(NSUInteger) numberOfRecords;
+{
+    [self flush];
+}
+
+@end
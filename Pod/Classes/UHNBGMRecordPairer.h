@@ -0,0 +1,72 @@
+//
+//  UHNBGMRecordPairer.h
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+/**
+ A block called with a glucose measurement and the glucose measurement context paired with it
+ 
+ @param measurementData The glucose measurement characteristic value
+ @param measurementContextData The glucose measurement context characteristic value, or `nil` if the measurement has none
+ 
+ */
+typedef void (^UHNBGMRecordPairBlock)(NSData *measurementData, NSData *measurementContextData);
+
+/**
+ `UHNBGMRecordPairer` pairs the glucose measurements a record sink receives with the glucose measurement contexts that follow them, as characteristic values.
+ 
+ @discussion A measurement is held until its context arrives, matched on the sequence number, or until the next measurement or `flushUsingBlock:`. The records of a controller with lazy record parsing enabled (see `enableLazyRecordParsing:`) are handed out with the characteristic values they were received as. Other records are encoded again from their details: the base time of a measurement is its creation date in the current calendar, as the parser made it, with no time offset, and its context information flag is only set once its context arrives, since the details do not tell whether one follows.
+ 
+ The pairer is not thread safe. A record sink calls it from the delegate queue of its controller.
+ */
+@interface UHNBGMRecordPairer : NSObject
+
+/**
+ Adds a glucose measurement, first handing out the measurement still waiting for its context
+ 
+ @param measurementDetails The details of the glucose measurement, as received by a record sink
+ @param block The block called with each measurement handed out
+ 
+ */
+- (void) addMeasurementDetails:(NSDictionary *) measurementDetails usingBlock:(UHNBGMRecordPairBlock) block;
+
+/**
+ Adds a glucose measurement context, handing out the measurement waiting for it if the sequence numbers match
+ 
+ @param measurementContextDetails The details of the glucose measurement context, as received by a record sink
+ @param block The block called with the measurement and the context
+ 
+ */
+- (void) addMeasurementContextDetails:(NSDictionary *) measurementContextDetails usingBlock:(UHNBGMRecordPairBlock) block;
+
+/**
+ Hands out the measurement still waiting for its context, without one
+ 
+ @param block The block called with the measurement, if there is one
+ 
+ */
+- (void) flushUsingBlock:(UHNBGMRecordPairBlock) block;
+
+@end
@@ -0,0 +1,250 @@
+//
+//  UHNBGMRecordPairer.m
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+
+#import "UHNBGMRecordPairer.h"
+#import "UHNBGMConstants.h"
+#import "UHNBGMLazyRecordDictionary.h"
+#import "UHNBGMRecordDecoder.h"
+#import "UHNDebug.h"
+
+#pragma mark - Encoding Functions
+
+static BOOL UHNBGMMeasurementRecordFromDetails(NSDictionary *measurementDetails, UHNBGMMeasurementRecord *record)
+{
+    NSNumber *sequenceNumber = measurementDetails[kGlucoseMeasurementKeySequenceNumber];
+    NSDate *creationDate = measurementDetails[kGlucoseMeasurementKeyCreationDate];
+    
+    if (nil == sequenceNumber || nil == creationDate)
+    {
+        return NO;
+    }
+    
+    memset(record, 0, sizeof(*record));
+    record->sequenceNumber = [sequenceNumber unsignedShortValue];
+    
+    // the parser makes the creation date from the base time plus the time offset in the current calendar, so the date
+    // goes back to a base time in that calendar, with the time offset folded in
+    NSUInteger const kComponentBits = (NSCalendarUnitYear | NSCalendarUnitMonth | NSCalendarUnitDay | NSCalendarUnitHour | NSCalendarUnitMinute | NSCalendarUnitSecond);
+    NSDateComponents *components = [[NSCalendar currentCalendar] components:kComponentBits fromDate:creationDate];
+    record->year = (uint16_t) components.year;
+    record->month = (uint8_t) components.month;
+    record->day = (uint8_t) components.day;
+    record->hours = (uint8_t) components.hour;
+    record->minutes = (uint8_t) components.minute;
+    record->seconds = (uint8_t) components.second;
+    
+    NSNumber *glucoseConcentration = measurementDetails[kGlucoseMeasurementKeyGlucoseConcentration];
+    if (glucoseConcentration)
+    {
+        record->flags |= GlucoseMeasurementFlagPresentGlucoseConcentrationTypeAndSampleLocation;
+        record->glucoseConcentration = [glucoseConcentration floatValue];
+        record->type = [measurementDetails[kGlucoseMeasurementKeyType] unsignedCharValue];
+        record->sampleLocation = [measurementDetails[kGlucoseMeasurementKeySampleLocation] unsignedCharValue];
+        
+        if (GlucoseMeasurementGlucoseConcentrationUnitsMolPerL == [measurementDetails[kGlucoseMeasurementKeyGlucoseConcentrationUnits] unsignedIntegerValue])
+        {
+            record->flags |= GlucoseMeasurementFlagGlucoseConcentrationUnits;
+        }
+    }
+    
+    NSNumber *sensorStatusAnnunciation = measurementDetails[kGlucoseMeasurementKeySensorStatusAnnunciation];
+    if (sensorStatusAnnunciation)
+    {
+        record->flags |= GlucoseMeasurementFlagPresentSensorStatusAnnunciation;
+        record->sensorStatusAnnunciation = [sensorStatusAnnunciation unsignedShortValue];
+    }
+    
+    return YES;
+}
+
+static BOOL UHNBGMMeasurementContextRecordFromDetails(NSDictionary *measurementContextDetails, UHNBGMMeasurementContextRecord *record)
+{
+    NSNumber *sequenceNumber = measurementContextDetails[kGlucoseMeasurementContextKeySequenceNumber];
+    
+    if (nil == sequenceNumber)
+    {
+        return NO;
+    }
+    
+    memset(record, 0, sizeof(*record));
+    record->sequenceNumber = [sequenceNumber unsignedShortValue];
+    
+    if (measurementContextDetails[kGlucoseMeasurementContextKeyExtendedFlags])
+    {
+        record->flags |= GlucoseMeasurementContextFlagPresentExtendedFlags;
+        record->extendedFlags = [measurementContextDetails[kGlucoseMeasurementContextKeyExtendedFlags] unsignedCharValue];
+    }
+    
+    if (measurementContextDetails[kGlucoseMeasurementContextKeyCarbohydrate])
+    {
+        record->flags |= GlucoseMeasurementContextFlagPresentCarbohydrateIDAndCarbohydrate;
+        record->carbohydrateID = [measurementContextDetails[kGlucoseMeasurementContextKeyCarbohydrateID] unsignedCharValue];
+        record->carbohydrate = [measurementContextDetails[kGlucoseMeasurementContextKeyCarbohydrate] floatValue];
+    }
+    
+    if (measurementContextDetails[kGlucoseMeasurementContextKeyMeal])
+    {
+        record->flags |= GlucoseMeasurementContextFlagPresentMeal;
+        record->meal = [measurementContextDetails[kGlucoseMeasurementContextKeyMeal] unsignedCharValue];
+    }
+    
+    if (measurementContextDetails[kGlucoseMeasurementContextKeyTester])
+    {
+        record->flags |= GlucoseMeasurementContextFlagPresentTesterHealth;
+        record->tester = [measurementContextDetails[kGlucoseMeasurementContextKeyTester] unsignedCharValue];
+        record->health = [measurementContextDetails[kGlucoseMeasurementContextKeyHealth] unsignedCharValue];
+    }
+    
+    if (measurementContextDetails[kGlucoseMeasurementContextKeyExerciseDuration])
+    {
+        record->flags |= GlucoseMeasurementContextFlagPresentExerciseDurationAndExerciseIntensity;
+        record->exerciseDuration = [measurementContextDetails[kGlucoseMeasurementContextKeyExerciseDuration] unsignedShortValue];
+        record->exerciseIntensity = [measurementContextDetails[kGlucoseMeasurementContextKeyExerciseIntensity] unsignedCharValue];
+    }
+    
+    if (measurementContextDetails[kGlucoseMeasurementContextKeyMedicationValue])
+    {
+        record->flags |= GlucoseMeasurementContextFlagPresentMedicationIDAndMedication;
+        record->medicationID = [measurementContextDetails[kGlucoseMeasurementContextKeyMedicationID] unsignedCharValue];
+        record->medication = [measurementContextDetails[kGlucoseMeasurementContextKeyMedicationValue] floatValue];
+        
+        if (GlucoseMeasurementContextMedicationUnitsL == [measurementContextDetails[kGlucoseMeasurementContextKeyMedicationUnits] unsignedIntegerValue])
+        {
+            record->flags |= GlucoseMeasurementContextFlagPresentMedicationUnits;
+        }
+    }
+    
+    if (measurementContextDetails[kGlucoseMeasurementContextKeyHbA1c])
+    {
+        record->flags |= GlucoseMeasurementContextFlagPresentHbA1c;
+        record->hbA1c = [measurementContextDetails[kGlucoseMeasurementContextKeyHbA1c] floatValue];
+    }
+    
+    return YES;
+}
+
+@interface UHNBGMRecordPairer ()
+{
+    // the measurement waiting for its context, kept as a record when it has to be encoded again
+    UHNBGMMeasurementRecord _pendingMeasurement;
+    BOOL _hasPendingMeasurement;
+}
+// the value of the measurement waiting for its context, nil if it is encoded from `_pendingMeasurement`
+@property (nonatomic, strong) NSData *pendingMeasurementData;
+@end
+
+@implementation UHNBGMRecordPairer
+
+#pragma mark - Pairing Methods
+
+- (void) addMeasurementDetails:(NSDictionary *) measurementDetails usingBlock:(UHNBGMRecordPairBlock) block;
+{
+    // the previous measurement is not getting a context anymore
+    [self flushUsingBlock:block];
+    
+    if ([measurementDetails isKindOfClass:[UHNBGMLazyRecordDictionary class]])
+    {
+        NSData *measurementData = [(UHNBGMLazyRecordDictionary *) measurementDetails recordData];
+        if ([measurementData length] < 3)
+        {
+            return;
+        }
+        
+        const uint8_t *bytes = [measurementData bytes];
+        if (bytes[0] & GlucoseMeasurementFlagPresentContextInfo)
+        {
+            _pendingMeasurement.sequenceNumber = (uint16_t) (bytes[1] | (bytes[2] << 8));
+            _hasPendingMeasurement = YES;
+            self.pendingMeasurementData = measurementData;
+        }
+        else
+        {
+            block(measurementData, nil);
+        }
+    }
+    else if (UHNBGMMeasurementRecordFromDetails(measurementDetails, &_pendingMeasurement))
+    {
+        _hasPendingMeasurement = YES;
+    }
+    else
+    {
+        DLog(@"Skipping a measurement without a sequence number or creation date");
+    }
+}
+
+- (void) addMeasurementContextDetails:(NSDictionary *) measurementContextDetails usingBlock:(UHNBGMRecordPairBlock) block;
+{
+    if (!_hasPendingMeasurement)
+    {
+        return;
+    }
+    
+    NSData *contextData = nil;
+    uint16_t sequenceNumber = 0;
+    
+    if ([measurementContextDetails isKindOfClass:[UHNBGMLazyRecordDictionary class]])
+    {
+        contextData = [(UHNBGMLazyRecordDictionary *) measurementContextDetails recordData];
+        if ([contextData length] < 3)
+        {
+            return;
+        }
+        
+        const uint8_t *bytes = [contextData bytes];
+        sequenceNumber = (uint16_t) (bytes[1] | (bytes[2] << 8));
+    }
+    else
+    {
+        UHNBGMMeasurementContextRecord context;
+        if (!UHNBGMMeasurementContextRecordFromDetails(measurementContextDetails, &context))
+        {
+            DLog(@"Skipping a measurement context without a sequence number");
+            return;
+        }
+        
+        uint8_t bytes[kUHNBGMMaximumRecordLength];
+        contextData = [NSData dataWithBytes:bytes length:UHNBGMEncodeMeasurementContext(&context, bytes)];
+        sequenceNumber = context.sequenceNumber;
+    }
+    
+    // a context is paired with its measurement on the sequence number
+    if (sequenceNumber == _pendingMeasurement.sequenceNumber)
+    {
+        [self handOutPendingMeasurementWithContextData:contextData usingBlock:block];
+    }
+}
+
+- (void) flushUsingBlock:(UHNBGMRecordPairBlock) block;
+{
+    if (_hasPendingMeasurement)
+    {
+        [self handOutPendingMeasurementWithContextData:nil usingBlock:block];
+    }
+}
+
+- (void) handOutPendingMeasurementWithContextData:(NSData *) contextData usingBlock:(UHNBGMRecordPairBlock) block;
+{
+    NSData *measurementData = self.pendingMeasurementData;
+    
+    if (!measurementData)
+    {
+        if (contextData)
+        {
+            _pendingMeasurement.flags |= GlucoseMeasurementFlagPresentContextInfo;
+        }
+        
+        uint8_t bytes[kUHNBGMMaximumRecordLength];
+        measurementData = [NSData dataWithBytes:bytes length:UHNBGMEncodeMeasurement(&_pendingMeasurement, bytes)];
+    }
+    
+    _hasPendingMeasurement = NO;
+    self.pendingMeasurementData = nil;
+    
+    block(measurementData, contextData);
+}
+
+@end
@@ -0,0 +1,84 @@
+//
+//  UHNBGMRecordSink.h
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+@class UHNBGMController;
+
+/**
+ The kinds of records a record sink wants to receive
+ */
+typedef NS_OPTIONS (NSUInteger, UHNBGMRecordSinkInterest)
+{
+    /** Interest in glucose measurements */
+    UHNBGMRecordSinkInterestMeasurements                = (1 << 0),
+    /** Interest in glucose measurement contexts */
+    UHNBGMRecordSinkInterestMeasurementContexts         = (1 << 1),
+    /** Interest in the end of record transfers */
+    UHNBGMRecordSinkInterestTransferEvents              = (1 << 2),
+};
+
+/**
+ The `UHNBGMRecordSink` protocol is adopted by the consumers of the records of a `UHNBGMController` other than its delegate, such as a local store, statistics or an uploader. Any number of sinks can be added to a controller.
+ 
+ @discussion A record is decoded once and every sink receives the same immutable dictionary, so sinks must not assume they are its only owner. Sinks are called on the same thread as the delegate, in the order they were added.
+ */
+@protocol UHNBGMRecordSink <NSObject>
+
+/**
+ The kinds of records the sink wants to receive. Read once when the sink is added to a controller
+ */
+- (UHNBGMRecordSinkInterest) recordSinkInterests;
+
+@optional
+
+/**
+ Called when a glucose measurement is received
+ 
+ @param controller The controller that received the measurement
+ @param measurementDetails The glucose measurement, with the keys of `parseGlucoseMeasurementCharacteristicDetails:`
+ 
+ */
+- (void) bgmController:(UHNBGMController *) controller didReceiveGlucoseMeasurement:(NSDictionary *) measurementDetails;
+
+/**
+ Called when a glucose measurement context is received
+ 
+ @param controller The controller that received the measurement context
+ @param measurementContextDetails The glucose measurement context, with the keys of `parseGlucoseMeasurementContextCharacteristicDetails:`
+ 
+ */
+- (void) bgmController:(UHNBGMController *) controller didReceiveGlucoseMeasurementContext:(NSDictionary *) measurementContextDetails;
+
+/**
+ Called when a transfer of stored records is complete
+ 
+ @param controller The controller that completed the transfer
+ @param numberOfRecords The number of records received
+ 
+ */
+- (void) bgmController:(UHNBGMController *) controller didCompleteTransferWithNumberOfRecords:(NSUInteger) numberOfRecords;
+
+@end
@@ -0,0 +1,257 @@
+//
+//  UHNBGMRecordUploader.h
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "UHNBGMRecordJSONWriter.h"
+#import "UHNBGMRecordSink.h"
+
+@protocol UHNBGMRecordUploaderDelegate;
+
+/**
+ `UHNBGMRecordUploader` is a record sink that uploads the records of a `UHNBGMController` to a server in batches, instead of one request per record.
+ 
+ @discussion Records are written by a `UHNBGMRecordJSONWriter` into the current batch, which is sealed once it holds `maximumNumberOfRecordsPerBatch` records, once `maximumBatchInterval` has passed since its first record, at the end of every transfer, or on `flush`. A sealed batch is gzip compressed and written to the outbox directory before it is uploaded, so batches survive the app being terminated and are uploaded by the next uploader created with the same outbox.
+ 
+ Each batch is sent as the body of a POST request to the upload URL, with at most `maximumNumberOfConcurrentUploads` requests in flight. A batch is deleted from the outbox once the server accepts it with a 2xx status. A 401 or 403 status refuses the credentials rather than the batch: the batch is kept and uploads are paused until `resumeUploads`, so the app can renew the `authorization`. Statuses that no retry can change (400, 409, 410, 413, 415 and 422) reject the batch, which is deleted and reported to the delegate. Transport errors and all the other statuses are retried with an exponential backoff from `initialRetryInterval` up to `maximumRetryInterval`.
+ 
+ A batch that cannot be written to the outbox is kept in memory, reported to the delegate and written again after the same backoff. It still counts towards backpressure.
+ 
+ Memory does not grow with a slow network: only the current batch and the batches in flight are held in memory, the others wait on disk. Once `maximumNumberOfQueuedBatches` batches are waiting the uploader reports backpressure, so the app can hold off further transfers, until half of them are uploaded.
+ 
+ Records are written straight from their raw characteristic values when lazy record parsing is enabled on the controller, and otherwise encoded again from their details (see `UHNBGMRecordJSONWriter`). The uploader does its work on its own serial queue and calls its delegate on the main queue. The configuration properties must be set before the uploader is added to a controller.
+ */
+@interface UHNBGMRecordUploader : NSObject <UHNBGMRecordSink>
+
+/**
+ The delegate of the uploader
+ */
+@property (nonatomic, weak) id<UHNBGMRecordUploaderDelegate> delegate;
+
+/**
+ The URL the batches are posted to
+ */
+@property (nonatomic, strong, readonly) NSURL *uploadURL;
+
+/**
+ The path of the outbox directory
+ */
+@property (nonatomic, copy, readonly) NSString *outboxPath;
+
+/**
+ The format of the records in a batch
+ */
+@property (nonatomic, assign, readonly) UHNBGMRecordJSONFormat format;
+
+/**
+ The patient reference of the FHIR Observation format (see `UHNBGMRecordJSONWriter`)
+ */
+@property (nonatomic, copy) NSString *patientReference;
+
+/**
+ The device reference of the FHIR Observation format (see `UHNBGMRecordJSONWriter`)
+ */
+@property (nonatomic, copy) NSString *deviceReference;
+
+/**
+ The time zone the clock of the glucose meter is set to (see `UHNBGMRecordJSONWriter`). Defaults to UTC
+ */
+@property (nonatomic, strong) NSTimeZone *meterTimeZone;
+
+/**
+ The number of records after which a batch is sealed. Defaults to 500
+ */
+@property (nonatomic, assign) NSUInteger maximumNumberOfRecordsPerBatch;
+
+/**
+ The time after the first record of a batch at which the batch is sealed, in seconds. Defaults to 10
+ */
+@property (nonatomic, assign) NSTimeInterval maximumBatchInterval;
+
+/**
+ The value of the Authorization header of the requests, such as `Bearer <token>`, or `nil` for none
+ 
+ @discussion Unlike the other configuration properties it can be changed at any time, for example to renew the credentials before `resumeUploads`
+ */
+@property (atomic, copy) NSString *authorization;
+
+/**
+ Indicates whether batches are gzip compressed. Defaults to `YES`
+ */
+@property (nonatomic, assign) BOOL compressesBatches;
+
+/**
+ The maximum number of requests in flight. Defaults to 2
+ */
+@property (nonatomic, assign) NSUInteger maximumNumberOfConcurrentUploads;
+
+/**
+ The delay before the first retry of a failed upload, in seconds. Doubled for every further retry of the same batch. Defaults to 1
+ */
+@property (nonatomic, assign) NSTimeInterval initialRetryInterval;
+
+/**
+ The longest delay between two retries of a failed upload, in seconds. Defaults to 300
+ */
+@property (nonatomic, assign) NSTimeInterval maximumRetryInterval;
+
+/**
+ The number of batches waiting in the outbox at which backpressure is reported. Defaults to 64
+ */
+@property (nonatomic, assign) NSUInteger maximumNumberOfQueuedBatches;
+
+///---------------------------------
+/// @name Initializing the Uploader
+///---------------------------------
+
+/**
+ Initializes an uploader with the default session configuration
+ 
+ @param uploadURL The URL the batches are posted to
+ @param outboxPath The path of the outbox directory, which is created if needed
+ @param format The format of the records in a batch
+ 
+ @return The initialized uploader
+ 
+ */
+- (instancetype) initWithUploadURL:(NSURL *) uploadURL outboxPath:(NSString *) outboxPath format:(UHNBGMRecordJSONFormat) format;
+
+/**
+ Initializes an uploader. Uploading of the batches left in the outbox starts straight away
+ 
+ @param uploadURL The URL the batches are posted to
+ @param outboxPath The path of the outbox directory, which is created if needed
+ @param format The format of the records in a batch
+ @param sessionConfiguration The configuration of the URL session the batches are posted with
+ 
+ @return The initialized uploader
+ 
+ */
+- (instancetype) initWithUploadURL:(NSURL *) uploadURL outboxPath:(NSString *) outboxPath format:(UHNBGMRecordJSONFormat) format sessionConfiguration:(NSURLSessionConfiguration *) sessionConfiguration;
+
+///---------------------
+/// @name Uploading
+///---------------------
+
+/**
+ Seals the current batch, if it holds any records, and queues it for upload
+ */
+- (void) flush;
+
+/**
+ The number of batches in the outbox, including the batches in flight
+ 
+ @return The number of batches not yet uploaded
+ 
+ */
+- (NSUInteger) numberOfPendingBatches;
+
+/**
+ Determine if the uploader is reporting backpressure
+ 
+ @return `YES` if too many batches are waiting to be uploaded, otherwise `NO`
+ 
+ */
+- (BOOL) isBackpressured;
+
+/**
+ Resumes the uploads paused because the server refused the credentials. The batch that was refused is uploaded first
+ */
+- (void) resumeUploads;
+
+/**
+ Determine if the uploads are paused
+ 
+ @return `YES` if the server refused the credentials and `resumeUploads` was not called since, otherwise `NO`
+ 
+ */
+- (BOOL) areUploadsPaused;
+
+@end
+
+/**
+ The `UHNBGMRecordUploaderDelegate` protocol defines the methods a delegate of a `UHNBGMRecordUploader` can adopt to follow the uploads. All the methods are called on the main queue
+ */
+@protocol UHNBGMRecordUploaderDelegate <NSObject>
+
+@optional
+
+/**
+ Notifies the delegate when a batch was accepted by the server
+ 
+ @param uploader The uploader that uploaded the batch
+ @param numberOfRecords The number of records in the batch
+ 
+ */
+- (void) recordUploader:(UHNBGMRecordUploader *) uploader didUploadBatchWithNumberOfRecords:(NSUInteger) numberOfRecords;
+
+/**
+ Notifies the delegate when a batch was rejected by the server. The batch is deleted from the outbox
+ 
+ @param uploader The uploader that uploaded the batch
+ @param numberOfRecords The number of records in the batch
+ @param statusCode The HTTP status code of the response
+ 
+ */
+- (void) recordUploader:(UHNBGMRecordUploader *) uploader didRejectBatchWithNumberOfRecords:(NSUInteger) numberOfRecords statusCode:(NSInteger) statusCode;
+
+/**
+ Notifies the delegate when the upload of a batch failed and will be retried
+ 
+ @param uploader The uploader that uploaded the batch
+ @param error The transport error, or `nil` if the server responded with a status that is retried
+ @param retryInterval The time until the batch is retried, in seconds
+ 
+ */
+- (void) recordUploader:(UHNBGMRecordUploader *) uploader willRetryBatchAfterError:(NSError *) error retryInterval:(NSTimeInterval) retryInterval;
+
+/**
+ Notifies the delegate when the server refused the credentials of a request. The batch is kept and uploads are paused until `resumeUploads`
+ 
+ @param uploader The uploader that uploaded the batch
+ @param statusCode The HTTP status code of the response, 401 or 403
+ 
+ */
+- (void) recordUploader:(UHNBGMRecordUploader *) uploader didPauseUploadsWithStatusCode:(NSInteger) statusCode;
+
+/**
+ Notifies the delegate when a sealed batch could not be written to the outbox. The batch is kept in memory and written again later
+ 
+ @param uploader The uploader that sealed the batch
+ @param numberOfRecords The number of records in the batch
+ @param error The error of the write
+ 
+ */
+- (void) recordUploader:(UHNBGMRecordUploader *) uploader didFailToSaveBatchWithNumberOfRecords:(NSUInteger) numberOfRecords error:(NSError *) error;
+
+/**
+ Notifies the delegate when the uploader starts or stops reporting backpressure
+ 
+ @param uploader The uploader
+ @param backpressured `YES` if too many batches are waiting to be uploaded, `NO` once half of them are uploaded
+ 
+ */
+- (void) recordUploader:(UHNBGMRecordUploader *) uploader didChangeBackpressure:(BOOL) backpressured;
+
+@end
@@ -0,0 +1,521 @@
+//
+//  UHNBGMRecordUploader.m
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+
+#import <zlib.h>
+#import "UHNBGMRecordUploader.h"
+#import "UHNDebug.h"
+
+#define kRecordUploaderDefaultMaximumNumberOfRecordsPerBatch    500
+#define kRecordUploaderDefaultMaximumBatchInterval              10.0
+#define kRecordUploaderDefaultMaximumNumberOfConcurrentUploads  2
+#define kRecordUploaderDefaultInitialRetryInterval              1.0
+#define kRecordUploaderDefaultMaximumRetryInterval              300.0
+#define kRecordUploaderDefaultMaximumNumberOfQueuedBatches      64
+
+#define kRecordUploaderBatchPrefix                              @"batch-"
+#define kRecordUploaderBatchExtension                           @"ndjson"
+#define kRecordUploaderCompressedBatchExtension                 @"gz"
+
+static NSData *UHNBGMGzipData(NSData *data)
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    
+    // 16 added to the window bits writes a gzip header and trailer instead of the zlib ones
+    if (Z_OK != deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY))
+    {
+        return nil;
+    }
+    
+    NSMutableData *compressedData = [NSMutableData dataWithLength:deflateBound(&stream, (uLong) [data length])];
+    stream.next_in = (Bytef *) [data bytes];
+    stream.avail_in = (uInt) [data length];
+    stream.next_out = [compressedData mutableBytes];
+    stream.avail_out = (uInt) [compressedData length];
+    
+    int status = deflate(&stream, Z_FINISH);
+    deflateEnd(&stream);
+    
+    if (Z_STREAM_END != status)
+    {
+        return nil;
+    }
+    
+    [compressedData setLength:stream.total_out];
+    
+    return compressedData;
+}
+
+// the statuses no retry can change, which reject a batch
+static BOOL UHNBGMIsPermanentStatusCode(NSInteger statusCode)
+{
+    switch (statusCode)
+    {
+        case 400:
+        case 409:
+        case 410:
+        case 413:
+        case 415:
+        case 422:
+            return YES;
+        default:
+            return NO;
+    }
+}
+
+@interface UHNBGMRecordUploader ()
+@property (nonatomic, strong, readwrite) NSURL *uploadURL;
+@property (nonatomic, copy, readwrite) NSString *outboxPath;
+@property (nonatomic, assign, readwrite) UHNBGMRecordJSONFormat format;
+@property (nonatomic, strong) NSURLSession *session;
+@property (nonatomic, strong) dispatch_queue_t uploaderQueue;
+
+// the batch being filled
+@property (nonatomic, strong) NSMutableData *currentBatchData;
+@property (nonatomic, strong) UHNBGMRecordJSONWriter *currentBatchWriter;
+@property (nonatomic, assign) NSUInteger batchGeneration;
+@property (nonatomic, assign) NSUInteger numberOfBatchesSealed;
+
+// the sealed batches that could not be written to the outbox yet, oldest first, and their data by file name
+@property (nonatomic, strong) NSMutableArray *unsavedBatchNames;
+@property (nonatomic, strong) NSMutableDictionary *unsavedBatches;
+@property (nonatomic, assign) NSUInteger saveRetryCount;
+@property (nonatomic, assign) BOOL saveRetryScheduled;
+
+// the sealed batches, by file name
+@property (nonatomic, strong) NSMutableArray *queuedBatchNames;
+@property (nonatomic, strong) NSMutableDictionary *retryCounts;
+@property (nonatomic, assign) NSUInteger numberOfBatchesInFlight;
+@property (nonatomic, assign) NSUInteger numberOfBatchesWaitingForRetry;
+@property (nonatomic, assign) BOOL backpressured;
+@property (nonatomic, assign) BOOL uploadsPaused;
+@end
+
+@implementation UHNBGMRecordUploader
+
+#pragma mark - Initialization Methods
+
+- (instancetype) initWithUploadURL:(NSURL *) uploadURL outboxPath:(NSString *) outboxPath format:(UHNBGMRecordJSONFormat) format;
+{
+    return [self initWithUploadURL:uploadURL outboxPath:outboxPath format:format sessionConfiguration:[NSURLSessionConfiguration defaultSessionConfiguration]];
+}
+
+- (instancetype) initWithUploadURL:(NSURL *) uploadURL outboxPath:(NSString *) outboxPath format:(UHNBGMRecordJSONFormat) format sessionConfiguration:(NSURLSessionConfiguration *) sessionConfiguration;
+{
+    if ((self = [super init]))
+    {
+        self.uploadURL = uploadURL;
+        self.outboxPath = outboxPath;
+        self.format = format;
+        self.session = [NSURLSession sessionWithConfiguration:sessionConfiguration];
+        self.uploaderQueue = dispatch_queue_create("ca.uhn.bgm.recorduploader", DISPATCH_QUEUE_SERIAL);
+        self.maximumNumberOfRecordsPerBatch = kRecordUploaderDefaultMaximumNumberOfRecordsPerBatch;
+        self.maximumBatchInterval = kRecordUploaderDefaultMaximumBatchInterval;
+        self.meterTimeZone = [NSTimeZone timeZoneForSecondsFromGMT:0];
+        self.compressesBatches = YES;
+        self.maximumNumberOfConcurrentUploads = kRecordUploaderDefaultMaximumNumberOfConcurrentUploads;
+        self.initialRetryInterval = kRecordUploaderDefaultInitialRetryInterval;
+        self.maximumRetryInterval = kRecordUploaderDefaultMaximumRetryInterval;
+        self.maximumNumberOfQueuedBatches = kRecordUploaderDefaultMaximumNumberOfQueuedBatches;
+        self.retryCounts = [NSMutableDictionary dictionary];
+        self.unsavedBatchNames = [NSMutableArray array];
+        self.unsavedBatches = [NSMutableDictionary dictionary];
+        
+        // the batches left by an earlier uploader are uploaded first, oldest first
+        [[NSFileManager defaultManager] createDirectoryAtPath:outboxPath withIntermediateDirectories:YES attributes:nil error:nil];
+        NSArray *fileNames = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:outboxPath error:nil];
+        NSPredicate *isBatch = [NSPredicate predicateWithFormat:@"SELF BEGINSWITH %@", kRecordUploaderBatchPrefix];
+        self.queuedBatchNames = [[[fileNames filteredArrayUsingPredicate:isBatch] sortedArrayUsingSelector:@selector(compare:)] mutableCopy];
+        
+        dispatch_async(self.uploaderQueue, ^{
+            [self updateBackpressure];
+            [self startUploads];
+        });
+    }
+    
+    return self;
+}
+
+- (void) dealloc;
+{
+    // the batches in flight stay in the outbox if they do not complete
+    [_session finishTasksAndInvalidate];
+}
+
+#pragma mark - Uploading Methods
+
+- (void) flush;
+{
+    dispatch_async(self.uploaderQueue, ^{
+        [self sealCurrentBatch];
+    });
+}
+
+- (NSUInteger) numberOfPendingBatches;
+{
+    __block NSUInteger numberOfPendingBatches;
+    dispatch_sync(self.uploaderQueue, ^{
+        numberOfPendingBatches = [self countPendingBatches];
+    });
+    
+    return numberOfPendingBatches;
+}
+
+- (BOOL) isBackpressured;
+{
+    __block BOOL isBackpressured;
+    dispatch_sync(self.uploaderQueue, ^{
+        isBackpressured = self.backpressured;
+    });
+    
+    return isBackpressured;
+}
+
+- (void) resumeUploads;
+{
+    dispatch_async(self.uploaderQueue, ^{
+        self.uploadsPaused = NO;
+        [self startUploads];
+    });
+}
+
+- (BOOL) areUploadsPaused;
+{
+    __block BOOL areUploadsPaused;
+    dispatch_sync(self.uploaderQueue, ^{
+        areUploadsPaused = self.uploadsPaused;
+    });
+    
+    return areUploadsPaused;
+}
+
+#pragma mark - Batch Methods
+
+- (void) startBatchIfNeeded;
+{
+    if (self.currentBatchWriter)
+    {
+        return;
+    }
+    
+    self.currentBatchData = [NSMutableData data];
+    self.currentBatchWriter = [[UHNBGMRecordJSONWriter alloc] initWithMutableData:self.currentBatchData format:self.format];
+    self.currentBatchWriter.patientReference = self.patientReference;
+    self.currentBatchWriter.deviceReference = self.deviceReference;
+    self.currentBatchWriter.meterTimeZone = self.meterTimeZone;
+    
+    // the batch is sealed when it gets too old, unless it was sealed before
+    NSUInteger batchGeneration = self.batchGeneration;
+    __weak UHNBGMRecordUploader *weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t) (self.maximumBatchInterval * NSEC_PER_SEC)), self.uploaderQueue, ^{
+        if (batchGeneration == weakSelf.batchGeneration)
+        {
+            [weakSelf sealCurrentBatch];
+        }
+    });
+}
+
+- (void) sealCurrentBatch;
+{
+    if (!self.currentBatchWriter)
+    {
+        return;
+    }
+    
+    [self.currentBatchWriter flush];
+    NSUInteger numberOfRecords = self.currentBatchWriter.numberOfRecordsWritten;
+    NSData *batchData = self.currentBatchData;
+    self.currentBatchWriter = nil;
+    self.currentBatchData = nil;
+    self.batchGeneration += 1;
+    
+    if (0 == numberOfRecords)
+    {
+        return;
+    }
+    
+    // the name orders the batches by creation and carries the number of records
+    NSString *batchName = [NSString stringWithFormat:@"%@%013llu-%06lu-%lu.%@", kRecordUploaderBatchPrefix, (unsigned long long) ([[NSDate date] timeIntervalSince1970] * 1000), (unsigned long) (self.numberOfBatchesSealed % 1000000), (unsigned long) numberOfRecords, kRecordUploaderBatchExtension];
+    self.numberOfBatchesSealed += 1;
+    
+    NSData *compressedBatchData = (self.compressesBatches ? UHNBGMGzipData(batchData) : nil);
+    if (compressedBatchData)
+    {
+        batchData = compressedBatchData;
+        batchName = [batchName stringByAppendingPathExtension:kRecordUploaderCompressedBatchExtension];
+    }
+    
+    [self.unsavedBatchNames addObject:batchName];
+    self.unsavedBatches[batchName] = batchData;
+    [self saveBatches];
+}
+
+- (void) saveBatches;
+{
+    // the batches are written in order, so the outbox keeps them in the order they were sealed
+    while ([self.unsavedBatchNames count] > 0)
+    {
+        NSString *batchName = self.unsavedBatchNames[0];
+        NSError *error = nil;
+        if (![self.unsavedBatches[batchName] writeToFile:[self.outboxPath stringByAppendingPathComponent:batchName] options:NSDataWritingAtomic error:&error])
+        {
+            DLog(@"Could not write batch %@ to the outbox: %@", batchName, error);
+            NSUInteger numberOfRecords = [self numberOfRecordsInBatchWithName:batchName];
+            [self notifyDelegate:^(id<UHNBGMRecordUploaderDelegate> delegate) {
+                if ([delegate respondsToSelector:@selector(recordUploader:didFailToSaveBatchWithNumberOfRecords:error:)])
+                {
+                    [delegate recordUploader:self didFailToSaveBatchWithNumberOfRecords:numberOfRecords error:error];
+                }
+            }];
+            [self scheduleSaveRetry];
+            break;
+        }
+        
+        [self.unsavedBatchNames removeObjectAtIndex:0];
+        [self.unsavedBatches removeObjectForKey:batchName];
+        [self.queuedBatchNames addObject:batchName];
+        self.saveRetryCount = 0;
+    }
+    
+    [self updateBackpressure];
+    [self startUploads];
+}
+
+- (void) scheduleSaveRetry;
+{
+    if (self.saveRetryScheduled)
+    {
+        return;
+    }
+    
+    NSTimeInterval retryInterval = MIN(self.initialRetryInterval * pow(2., MIN(self.saveRetryCount, 30)), self.maximumRetryInterval);
+    self.saveRetryCount += 1;
+    self.saveRetryScheduled = YES;
+    
+    // the outbox may have been removed from under the uploader
+    __weak UHNBGMRecordUploader *weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t) (retryInterval * NSEC_PER_SEC)), self.uploaderQueue, ^{
+        UHNBGMRecordUploader *strongSelf = weakSelf;
+        strongSelf.saveRetryScheduled = NO;
+        [[NSFileManager defaultManager] createDirectoryAtPath:strongSelf.outboxPath withIntermediateDirectories:YES attributes:nil error:nil];
+        [strongSelf saveBatches];
+    });
+}
+
+- (NSUInteger) numberOfRecordsInBatchWithName:(NSString *) batchName;
+{
+    NSString *baseName = [batchName stringByDeletingPathExtension];
+    if ([[baseName pathExtension] isEqualToString:kRecordUploaderBatchExtension])
+    {
+        baseName = [baseName stringByDeletingPathExtension];
+    }
+    
+    return (NSUInteger) [[[baseName componentsSeparatedByString:@"-"] lastObject] integerValue];
+}
+
+- (NSUInteger) countPendingBatches;
+{
+    return [self.unsavedBatchNames count] + [self.queuedBatchNames count] + self.numberOfBatchesInFlight + self.numberOfBatchesWaitingForRetry;
+}
+
+- (void) updateBackpressure;
+{
+    NSUInteger numberOfPendingBatches = [self countPendingBatches];
+    BOOL backpressured = self.backpressured;
+    
+    // released at half the limit so a draining outbox does not flip back and forth
+    if (!backpressured && numberOfPendingBatches >= MAX(self.maximumNumberOfQueuedBatches, 1))
+    {
+        backpressured = YES;
+    }
+    else if (backpressured && numberOfPendingBatches <= self.maximumNumberOfQueuedBatches / 2)
+    {
+        backpressured = NO;
+    }
+    
+    if (backpressured != self.backpressured)
+    {
+        self.backpressured = backpressured;
+        [self notifyDelegate:^(id<UHNBGMRecordUploaderDelegate> delegate) {
+            if ([delegate respondsToSelector:@selector(recordUploader:didChangeBackpressure:)])
+            {
+                [delegate recordUploader:self didChangeBackpressure:backpressured];
+            }
+        }];
+    }
+}
+
+#pragma mark - Request Methods
+
+- (void) startUploads;
+{
+    while (!self.uploadsPaused && self.numberOfBatchesInFlight < MAX(self.maximumNumberOfConcurrentUploads, 1) && [self.queuedBatchNames count] > 0)
+    {
+        NSString *batchName = self.queuedBatchNames[0];
+        [self.queuedBatchNames removeObjectAtIndex:0];
+        [self uploadBatchWithName:batchName];
+    }
+}
+
+- (void) uploadBatchWithName:(NSString *) batchName;
+{
+    NSData *batchData = [NSData dataWithContentsOfFile:[self.outboxPath stringByAppendingPathComponent:batchName]];
+    if (!batchData)
+    {
+        DLog(@"Batch %@ is no longer in the outbox", batchName);
+        [self.retryCounts removeObjectForKey:batchName];
+        [self updateBackpressure];
+        return;
+    }
+    
+    NSMutableURLRequest *request = [NSMutableURLRequest requestWithURL:self.uploadURL];
+    request.HTTPMethod = @"POST";
+    request.HTTPBody = batchData;
+    [request setValue:(UHNBGMRecordJSONFormatFHIRObservation == self.format ? @"application/fhir+ndjson" : @"application/x-ndjson") forHTTPHeaderField:@"Content-Type"];
+    [request setValue:self.authorization forHTTPHeaderField:@"Authorization"];
+    if ([[batchName pathExtension] isEqualToString:kRecordUploaderCompressedBatchExtension])
+    {
+        [request setValue:@"gzip" forHTTPHeaderField:@"Content-Encoding"];
+    }
+    
+    self.numberOfBatchesInFlight += 1;
+    
+    NSURLSessionDataTask *task = [self.session dataTaskWithRequest:request completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
+        dispatch_async(self.uploaderQueue, ^{
+            [self didFinishUploadingBatchWithName:batchName response:response error:error];
+        });
+    }];
+    [task resume];
+}
+
+- (void) didFinishUploadingBatchWithName:(NSString *) batchName response:(NSURLResponse *) response error:(NSError *) error;
+{
+    self.numberOfBatchesInFlight -= 1;
+    
+    NSInteger statusCode = ([response isKindOfClass:[NSHTTPURLResponse class]] ? [(NSHTTPURLResponse *) response statusCode] : 0);
+    NSUInteger numberOfRecords = [self numberOfRecordsInBatchWithName:batchName];
+    
+    if (!error && statusCode >= 200 && statusCode < 300)
+    {
+        [[NSFileManager defaultManager] removeItemAtPath:[self.outboxPath stringByAppendingPathComponent:batchName] error:nil];
+        [self.retryCounts removeObjectForKey:batchName];
+        [self notifyDelegate:^(id<UHNBGMRecordUploaderDelegate> delegate) {
+            if ([delegate respondsToSelector:@selector(recordUploader:didUploadBatchWithNumberOfRecords:)])
+            {
+                [delegate recordUploader:self didUploadBatchWithNumberOfRecords:numberOfRecords];
+            }
+        }];
+    }
+    else if (!error && (401 == statusCode || 403 == statusCode))
+    {
+        // the credentials are refused, not the batch, so it waits at the front of the queue until uploads are resumed
+        DLog(@"Uploads paused, batch %@ was refused with status %ld", batchName, (long) statusCode);
+        [self.queuedBatchNames addObject:batchName];
+        [self.queuedBatchNames sortUsingSelector:@selector(compare:)];
+        
+        if (!self.uploadsPaused)
+        {
+            self.uploadsPaused = YES;
+            [self notifyDelegate:^(id<UHNBGMRecordUploaderDelegate> delegate) {
+                if ([delegate respondsToSelector:@selector(recordUploader:didPauseUploadsWithStatusCode:)])
+                {
+                    [delegate recordUploader:self didPauseUploadsWithStatusCode:statusCode];
+                }
+            }];
+        }
+    }
+    else if (UHNBGMIsPermanentStatusCode(statusCode))
+    {
+        DLog(@"Batch %@ was rejected with status %ld", batchName, (long) statusCode);
+        [[NSFileManager defaultManager] removeItemAtPath:[self.outboxPath stringByAppendingPathComponent:batchName] error:nil];
+        [self.retryCounts removeObjectForKey:batchName];
+        [self notifyDelegate:^(id<UHNBGMRecordUploaderDelegate> delegate) {
+            if ([delegate respondsToSelector:@selector(recordUploader:didRejectBatchWithNumberOfRecords:statusCode:)])
+            {
+                [delegate recordUploader:self didRejectBatchWithNumberOfRecords:numberOfRecords statusCode:statusCode];
+            }
+        }];
+    }
+    else
+    {
+        // transport errors, 408, 429, 5xx and any status that is not known to be permanent
+        NSUInteger retryCount = [self.retryCounts[batchName] unsignedIntegerValue];
+        self.retryCounts[batchName] = @(retryCount + 1);
+        NSTimeInterval retryInterval = MIN(self.initialRetryInterval * pow(2., MIN(retryCount, 30)), self.maximumRetryInterval);
+        
+        // the batch does not hold a request slot while it waits, and goes back to the front of the queue
+        self.numberOfBatchesWaitingForRetry += 1;
+        __weak UHNBGMRecordUploader *weakSelf = self;
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t) (retryInterval * NSEC_PER_SEC)), self.uploaderQueue, ^{
+            UHNBGMRecordUploader *strongSelf = weakSelf;
+            strongSelf.numberOfBatchesWaitingForRetry -= 1;
+            [strongSelf.queuedBatchNames insertObject:batchName atIndex:0];
+            [strongSelf startUploads];
+        });
+        
+        [self notifyDelegate:^(id<UHNBGMRecordUploaderDelegate> delegate) {
+            if ([delegate respondsToSelector:@selector(recordUploader:willRetryBatchAfterError:retryInterval:)])
+            {
+                [delegate recordUploader:self willRetryBatchAfterError:error retryInterval:retryInterval];
+            }
+        }];
+    }
+    
+    [self updateBackpressure];
+    [self startUploads];
+}
+
+- (void) notifyDelegate:(void (^)(id<UHNBGMRecordUploaderDelegate> delegate)) notification;
+{
+    id<UHNBGMRecordUploaderDelegate> delegate = self.delegate;
+    if (!delegate)
+    {
+        return;
+    }
+    
+    dispatch_async(dispatch_get_main_queue(), ^{
+        notification(delegate);
+    });
+}
+
+#pragma mark - Record Sink Methods
+
+- (UHNBGMRecordSinkInterest) recordSinkInterests;
+{
+    return (UHNBGMRecordSinkInterestMeasurements | UHNBGMRecordSinkInterestMeasurementContexts | UHNBGMRecordSinkInterestTransferEvents);
+}
+
+- (void) bgmController:(UHNBGMController *) controller didReceiveGlucoseMeasurement:(NSDictionary *) measurementDetails;
+{
+    // eagerly decoded details are mutable, so they are copied before they leave the delegate queue
+    measurementDetails = [measurementDetails copy];
+    dispatch_async(self.uploaderQueue, ^{
+        // a full batch is sealed on the next measurement, so a measurement and its context stay in the same batch
+        if (self.currentBatchWriter.numberOfRecordsWritten >= MAX(self.maximumNumberOfRecordsPerBatch, 1))
+        {
+            [self sealCurrentBatch];
+        }
+        
+        [self startBatchIfNeeded];
+        [self.currentBatchWriter bgmController:controller didReceiveGlucoseMeasurement:measurementDetails];
+    });
+}
+
+- (void) bgmController:(UHNBGMController *) controller didReceiveGlucoseMeasurementContext:(NSDictionary *) measurementContextDetails;
+{
+    measurementContextDetails = [measurementContextDetails copy];
+    dispatch_async(self.uploaderQueue, ^{
+        [self.currentBatchWriter bgmController:controller didReceiveGlucoseMeasurementContext:measurementContextDetails];
+    });
+}
+
+- (void) bgmController:(UHNBGMController *) controller didCompleteTransferWithNumberOfRecords:(NSUInteger) numberOfRecords;
+{
+    [self flush];
+}
+
+@end
@@ -0,0 +1,150 @@
+//
+//  UHNBGMTimeNormalizer.h
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "UHNBGMBulkDecoder.h"
+
+/**
+ How the timestamp of a measurement was normalized
+ */
+typedef NS_OPTIONS (uint8_t, UHNBGMTimeNormalizationFlag)
+{
+    /** The clock offset estimated from a clock reference of the session was applied */
+    UHNBGMTimeNormalizationFlagClockCorrected   = (1 << 0),
+    /** The glucose sensor reported a time fault, or the measurement has no usable base time. The timestamp is taken from the previous measurement, or converted from its own time with `meterTimeZone` if there is none */
+    UHNBGMTimeNormalizationFlagTimeFault        = (1 << 1),
+    /** The timestamp was moved later to keep the timestamps in order */
+    UHNBGMTimeNormalizationFlagReordered        = (1 << 2),
+};
+
+/**
+ Normalized timestamps stored column by column, in the order of the measurements they were normalized from
+ */
+@interface UHNBGMNormalizedTimeColumns : NSObject
+
+/** The number of measurements */
+@property (nonatomic, assign, readonly) NSUInteger count;
+/** `NSTimeInterval`, the UTC timestamps in seconds since 1970-01-01 00:00:00 UTC */
+@property (nonatomic, strong, readonly) NSData *timestamps;
+/** `uint8_t`, the normalization flags (see UHNBGMTimeNormalizationFlag) */
+@property (nonatomic, strong, readonly) NSData *flags;
+
+@end
+
+/**
+ `UHNBGMTimeNormalizer` turns the creation times of the measurements of a session, as kept by the clock of the glucose sensor, into UTC timestamps that never go backwards, ready to be indexed.
+ 
+ @discussion The clock of a glucose sensor drifts and knows nothing of time zones, so its times are converted with one clock offset per session. The offset is estimated from the clock references of the session: a glucose sensor time read through the Current Time Service, or a measurement notified as it is taken, paired with the time it was received. Each reference gives the offset plus the delay before it was received, so the smallest is kept. Without a reference, the clock of the glucose sensor is taken to be set to `meterTimeZone`, each time converted with the UTC offset in effect at that time, unless the newest measurement would then be in the future, in which case the clock is moved back by one offset.
+ 
+ The offset is applied to a whole batch of decoded measurements at once. A measurement with a time fault, or without a usable base time, takes the timestamp of the measurement before it (the first measurements of a session take the first usable timestamp of their batch, or their own time in `meterTimeZone` if the batch has none), and a measurement older than the one before it is moved up to its timestamp, so the timestamps of a session are in the order of the measurements. The timestamps of the first batch carry on into the next batches of the session.
+ 
+ The normalizer is not thread safe.
+ */
+@interface UHNBGMTimeNormalizer : NSObject
+
+/**
+ The time zone the clock of the glucose sensor is taken to be set to when there is no clock reference. Defaults to the local time zone
+ */
+@property (nonatomic, strong) NSTimeZone *meterTimeZone;
+
+/**
+ `YES` if a clock reference was added in the session
+ */
+@property (nonatomic, assign, readonly) BOOL hasClockReference;
+
+/**
+ The seconds added to the times of the glucose sensor, as returned by `UHNBGMMeasurementLocalTimestamp`, to get UTC. Estimated by the first batch of the session when there is no clock reference, as the offset of its newest measurement when its times are converted with `meterTimeZone`
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval clockOffset;
+
+/**
+ Starts a session, forgetting the clock references and the timestamps of the previous session
+ */
+- (void) beginSession;
+
+///-----------------------
+/// @name Clock References
+///-----------------------
+
+/**
+ Adds a reading of the clock of the glucose sensor
+ 
+ @param meterTimestamp The time of the glucose sensor, in seconds since 1970-01-01 00:00:00 with its local time taken as UTC
+ @param date The time the reading was received
+ 
+ */
+- (void) addClockReferenceWithMeterTimestamp:(int64_t) meterTimestamp receivedAtDate:(NSDate *) date;
+
+/**
+ Adds the value of a Date Time or Current Time characteristic of the glucose sensor as a clock reference
+ 
+ @param data The characteristic value, starting with the 7 bytes of a Date Time
+ @param date The time the value was received
+ 
+ @return `YES` if the value holds a valid date, otherwise `NO`
+ 
+ */
+- (BOOL) addClockReferenceWithDateTimeData:(NSData *) data receivedAtDate:(NSDate *) date;
+
+/**
+ Adds a glucose measurement notified as it was taken as a clock reference
+ 
+ @param data The glucose measurement characteristic value
+ @param date The time the measurement was received
+ 
+ @return `YES` if the measurement was used, `NO` if it could not be decoded or has a time fault
+ 
+ */
+- (BOOL) addClockReferenceWithMeasurementData:(NSData *) data receivedAtDate:(NSDate *) date;
+
+///--------------------
+/// @name Normalization
+///--------------------
+
+/**
+ Normalizes the creation times of a batch of decoded measurements
+ 
+ @param columns The measurements, as decoded by `UHNBGMBulkDecoder`
+ 
+ @return The normalized timestamps
+ 
+ */
+- (UHNBGMNormalizedTimeColumns *) normalizeMeasurementColumns:(UHNBGMMeasurementColumns *) columns;
+
+/**
+ Normalizes the creation times of a batch of measurements into buffers of the caller
+ 
+ @param localTimestamps The creation times, as returned by `UHNBGMMeasurementLocalTimestamp`
+ @param measurementFlags The glucose measurement flags
+ @param sensorStatusAnnunciations The sensor status annunciations
+ @param valid 1 for each measurement that was decoded, or `NULL` if they all were
+ @param count The number of measurements
+ @param timestamps A buffer for `count` UTC timestamps
+ @param timeFlags A buffer for `count` normalization flags (see UHNBGMTimeNormalizationFlag)
+ 
+ */
+- (void) normalizeLocalTimestamps:(const int64_t *) localTimestamps measurementFlags:(const uint8_t *) measurementFlags sensorStatusAnnunciations:(const uint16_t *) sensorStatusAnnunciations valid:(const uint8_t *) valid count:(NSUInteger) count timestamps:(NSTimeInterval *) timestamps timeFlags:(uint8_t *) timeFlags;
+
+@end
@@ -0,0 +1,247 @@
+//
+//  UHNBGMTimeNormalizer.m
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+
+#import "UHNBGMTimeNormalizer.h"
+#import "UHNBGMConstants.h"
+
+// a base time before 2001 is taken as a clock that was never set, as glucose sensors start over from their reset date
+#define kTimeNormalizerEarliestTimestamp        978307200
+// how far in the future the newest measurement can be before the clock of the glucose sensor is taken to be ahead
+#define kTimeNormalizerFutureTolerance          60
+
+static inline BOOL UHNBGMTimeIsUsable(int64_t localTimestamp, uint8_t measurementFlags, uint16_t sensorStatusAnnunciation, uint8_t valid)
+{
+    BOOL hasTimeFault = ((measurementFlags & GlucoseMeasurementFlagPresentSensorStatusAnnunciation) && (sensorStatusAnnunciation & GlucoseMeasurementStatusFaultTime));
+    return (valid && !hasTimeFault && localTimestamp >= kTimeNormalizerEarliestTimestamp);
+}
+
+// the offset of the time zone at the time itself, looked up again at the time found in case a daylight saving change lies between the two
+static inline NSTimeInterval UHNBGMTimestampInTimeZone(CFTimeZoneRef timeZone, int64_t localTimestamp)
+{
+    CFAbsoluteTime time = localTimestamp - kCFAbsoluteTimeIntervalSince1970;
+    CFTimeInterval utcOffset = CFTimeZoneGetSecondsFromGMT(timeZone, time);
+    utcOffset = CFTimeZoneGetSecondsFromGMT(timeZone, time - utcOffset);
+    
+    return localTimestamp - utcOffset;
+}
+
+@interface UHNBGMNormalizedTimeColumns ()
+@property (nonatomic, assign, readwrite) NSUInteger count;
+@property (nonatomic, strong, readwrite) NSData *timestamps;
+@property (nonatomic, strong, readwrite) NSData *flags;
+@end
+
+@implementation UHNBGMNormalizedTimeColumns
+@end
+
+@interface UHNBGMTimeNormalizer ()
+{
+    // the timestamp of the latest measurement of the session with a usable time
+    NSTimeInterval _previousTimestamp;
+    BOOL _hasClockOffset;
+    // the times are converted with the UTC offset of the meter time zone at each of them instead of the clock offset
+    BOOL _convertsWithMeterTimeZone;
+}
+@property (nonatomic, assign, readwrite) BOOL hasClockReference;
+@property (nonatomic, assign, readwrite) NSTimeInterval clockOffset;
+@end
+
+@implementation UHNBGMTimeNormalizer
+
+#pragma mark - Initialization Methods
+
+- (instancetype) init;
+{
+    if ((self = [super init]))
+    {
+        self.meterTimeZone = [NSTimeZone localTimeZone];
+        [self beginSession];
+    }
+    
+    return self;
+}
+
+- (void) beginSession;
+{
+    self.hasClockReference = NO;
+    self.clockOffset = 0.;
+    _hasClockOffset = NO;
+    _convertsWithMeterTimeZone = NO;
+    _previousTimestamp = -INFINITY;
+}
+
+#pragma mark - Clock Reference Methods
+
+- (void) addClockReferenceWithMeterTimestamp:(int64_t) meterTimestamp receivedAtDate:(NSDate *) date;
+{
+    // every reference is late by the time it took to be received, so the smallest offset is the closest
+    NSTimeInterval clockOffset = [date timeIntervalSince1970] - meterTimestamp;
+    
+    if (!self.hasClockReference || clockOffset < self.clockOffset)
+    {
+        self.clockOffset = clockOffset;
+    }
+    
+    self.hasClockReference = YES;
+    _hasClockOffset = YES;
+    _convertsWithMeterTimeZone = NO;
+}
+
+- (BOOL) addClockReferenceWithDateTimeData:(NSData *) data receivedAtDate:(NSDate *) date;
+{
+    if ([data length] < 7)
+    {
+        return NO;
+    }
+    
+    const uint8_t *bytes = [data bytes];
+    UHNBGMMeasurementRecord record = {0};
+    record.year = bytes[0] | (bytes[1] << 8);
+    record.month = bytes[2];
+    record.day = bytes[3];
+    record.hours = bytes[4];
+    record.minutes = bytes[5];
+    record.seconds = bytes[6];
+    
+    // a year, month or day of 0 means the glucose sensor does not know it
+    if (record.month < 1 || record.month > 12 || record.day < 1 || record.day > 31 || record.hours > 23 || record.minutes > 59 || record.seconds > 59)
+    {
+        return NO;
+    }
+    
+    int64_t meterTimestamp = UHNBGMMeasurementLocalTimestamp(&record);
+    if (meterTimestamp < kTimeNormalizerEarliestTimestamp)
+    {
+        return NO;
+    }
+    
+    [self addClockReferenceWithMeterTimestamp:meterTimestamp receivedAtDate:date];
+    
+    return YES;
+}
+
+- (BOOL) addClockReferenceWithMeasurementData:(NSData *) data receivedAtDate:(NSDate *) date;
+{
+    UHNBGMMeasurementRecord record;
+    if (!UHNBGMDecodeMeasurement([data bytes], [data length], &record))
+    {
+        return NO;
+    }
+    
+    int64_t meterTimestamp = UHNBGMMeasurementLocalTimestamp(&record);
+    if (!UHNBGMTimeIsUsable(meterTimestamp, record.flags, record.sensorStatusAnnunciation, 1))
+    {
+        return NO;
+    }
+    
+    [self addClockReferenceWithMeterTimestamp:meterTimestamp receivedAtDate:date];
+    
+    return YES;
+}
+
+#pragma mark - Normalization Methods
+
+- (UHNBGMNormalizedTimeColumns *) normalizeMeasurementColumns:(UHNBGMMeasurementColumns *) columns;
+{
+    NSUInteger count = columns.count;
+    NSMutableData *timestamps = [NSMutableData dataWithLength:count * sizeof(NSTimeInterval)];
+    NSMutableData *flags = [NSMutableData dataWithLength:count * sizeof(uint8_t)];
+    
+    [self normalizeLocalTimestamps:[columns.localTimestamps bytes] measurementFlags:[columns.flags bytes] sensorStatusAnnunciations:[columns.sensorStatusAnnunciations bytes] valid:[columns.valid bytes] count:count timestamps:[timestamps mutableBytes] timeFlags:[flags mutableBytes]];
+    
+    UHNBGMNormalizedTimeColumns *normalizedColumns = [[UHNBGMNormalizedTimeColumns alloc] init];
+    normalizedColumns.count = count;
+    normalizedColumns.timestamps = timestamps;
+    normalizedColumns.flags = flags;
+    
+    return normalizedColumns;
+}
+
+- (void) normalizeLocalTimestamps:(const int64_t *) localTimestamps measurementFlags:(const uint8_t *) measurementFlags sensorStatusAnnunciations:(const uint16_t *) sensorStatusAnnunciations valid:(const uint8_t *) valid count:(NSUInteger) count timestamps:(NSTimeInterval *) timestamps timeFlags:(uint8_t *) timeFlags;
+{
+    if (!_hasClockOffset)
+    {
+        [self estimateClockOffsetWithLocalTimestamps:localTimestamps measurementFlags:measurementFlags sensorStatusAnnunciations:sensorStatusAnnunciations valid:valid count:count];
+    }
+    
+    NSTimeInterval clockOffset = self.clockOffset;
+    CFTimeZoneRef meterTimeZone = (__bridge CFTimeZoneRef) self.meterTimeZone;
+    NSTimeInterval previousTimestamp = _previousTimestamp;
+    uint8_t sessionFlags = (self.hasClockReference ? UHNBGMTimeNormalizationFlagClockCorrected : 0);
+    
+    for (NSUInteger index = 0; index < count; index++)
+    {
+        uint8_t flags = sessionFlags;
+        NSTimeInterval timestamp;
+        
+        if (!UHNBGMTimeIsUsable(localTimestamps[index], measurementFlags[index], sensorStatusAnnunciations[index], (valid ? valid[index] : 1)))
+        {
+            // the measurement was taken after the previous one, which is as close as its time can be known, and the first
+            // measurements of a session only have their own time to go on
+            flags |= UHNBGMTimeNormalizationFlagTimeFault;
+            timestamp = (isinf(previousTimestamp) ? UHNBGMTimestampInTimeZone(meterTimeZone, localTimestamps[index]) : previousTimestamp);
+        }
+        else
+        {
+            timestamp = (_convertsWithMeterTimeZone ? UHNBGMTimestampInTimeZone(meterTimeZone, localTimestamps[index]) : localTimestamps[index] + clockOffset);
+            
+            if (timestamp < previousTimestamp)
+            {
+                flags |= UHNBGMTimeNormalizationFlagReordered;
+                timestamp = previousTimestamp;
+            }
+            else if (isinf(previousTimestamp))
+            {
+                // the faulted measurements at the start of the session take the first usable time
+                for (NSUInteger faultedIndex = 0; faultedIndex < index; faultedIndex++)
+                {
+                    timestamps[faultedIndex] = timestamp;
+                }
+            }
+            
+            previousTimestamp = timestamp;
+        }
+        
+        timestamps[index] = timestamp;
+        timeFlags[index] = flags;
+    }
+    
+    _previousTimestamp = previousTimestamp;
+}
+
+- (void) estimateClockOffsetWithLocalTimestamps:(const int64_t *) localTimestamps measurementFlags:(const uint8_t *) measurementFlags sensorStatusAnnunciations:(const uint16_t *) sensorStatusAnnunciations valid:(const uint8_t *) valid count:(NSUInteger) count;
+{
+    NSDate *now = [NSDate date];
+    int64_t newestLocalTimestamp = INT64_MIN;
+    
+    for (NSUInteger index = 0; index < count; index++)
+    {
+        if (UHNBGMTimeIsUsable(localTimestamps[index], measurementFlags[index], sensorStatusAnnunciations[index], (valid ? valid[index] : 1)))
+        {
+            newestLocalTimestamp = MAX(newestLocalTimestamp, localTimestamps[index]);
+        }
+    }
+    
+    // without a reference the clock is taken at face value in the meter time zone, unless it is ahead of the phone
+    CFTimeZoneRef meterTimeZone = (__bridge CFTimeZoneRef) self.meterTimeZone;
+    NSTimeInterval newestTimestamp = (INT64_MIN != newestLocalTimestamp ? UHNBGMTimestampInTimeZone(meterTimeZone, newestLocalTimestamp) : [now timeIntervalSince1970]);
+    
+    if (newestTimestamp > [now timeIntervalSince1970] + kTimeNormalizerFutureTolerance)
+    {
+        self.clockOffset = [now timeIntervalSince1970] - newestLocalTimestamp;
+        _convertsWithMeterTimeZone = NO;
+    }
+    else
+    {
+        self.clockOffset = (INT64_MIN != newestLocalTimestamp ? newestTimestamp - newestLocalTimestamp : -[self.meterTimeZone secondsFromGMTForDate:now]);
+        _convertsWithMeterTimeZone = YES;
+    }
+    
+    _hasClockOffset = YES;
+}
+
+@end
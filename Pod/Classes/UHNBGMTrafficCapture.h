@@ -0,0 +1,119 @@
+//
+//  UHNBGMTrafficCapture.h
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "UHNBGMConstants.h"
+
+@class UHNBGMController;
+
+/**********  Traffic Capture File Format ***************
+ Header - 16 bytes
+    - Magic "BGMC" (4 bytes)
+    - Version uint8
+    - Reserved (3 bytes)
+    - Capture start date - float64, seconds since the NSDate reference date
+
+ Entry - 7 byte header followed by the raw characteristic value
+    - Time since the capture started - uint32, milliseconds
+    - Characteristic - uint8, the GlucoseServiceCharacteristic in the low 7 bits. The high bit is set if the value was written to the glucose sensor
+    - Length of the value - uint16
+    - Value
+
+ All multi-byte fields are little endian
+ **********************************************/
+
+/**
+ `UHNBGMTrafficRecorder` appends the raw values exchanged with a glucose sensor to a compact capture file. Entries are buffered and written in blocks, so the recorder must be closed to guarantee that all the entries are on disk.
+ */
+@interface UHNBGMTrafficRecorder : NSObject
+
+/**
+ Creates a recorder writing to a new capture file
+ 
+ @param path The path of the capture file. An existing file is replaced.
+ 
+ @return Instance of a UHNBGMTrafficRecorder, or `nil` if the file could not be created
+ 
+ */
+- (instancetype) initWithPath:(NSString *) path;
+
+/**
+ Append a value to the capture
+ 
+ @param value The raw value of the characteristic
+ @param characteristicUUID The UUID of the characteristic
+ @param written `YES` if the value was written to the glucose sensor, `NO` if it was received from the glucose sensor
+ 
+ */
+- (void) recordValue:(NSData *) value forCharacteristic:(NSString *) characteristicUUID written:(BOOL) written;
+
+/**
+ Write all the buffered entries and close the capture file
+ */
+- (void) close;
+
+@end
+
+/**
+ `UHNBGMTrafficReplayer` feeds the values received from a glucose sensor in a capture file back through a `UHNBGMController`, as if the glucose sensor was connected. Values that were written to the glucose sensor are not replayed.
+ */
+@interface UHNBGMTrafficReplayer : NSObject
+
+/**
+ The number of received values in the capture
+ */
+@property (nonatomic, assign, readonly) NSUInteger numberOfEntries;
+
+/**
+ The time between the first and the last received value of the capture
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval duration;
+
+/**
+ The date the capture was started
+ */
+@property (nonatomic, strong, readonly) NSDate *captureStartDate;
+
+/**
+ Loads a capture file
+ 
+ @param path The path of the capture file
+ 
+ @return Instance of a UHNBGMTrafficReplayer, or `nil` if the file is not a valid capture
+ 
+ */
+- (instancetype) initWithContentsOfFile:(NSString *) path;
+
+/**
+ Replay the capture through a controller
+ 
+ @param controller The `UHNBGMController` that receives the captured values. Its delegate is notified as it would be by the glucose sensor.
+ @param recordedTiming If `YES` the values are delivered on the main queue with the recorded timing. If `NO` they are delivered back to back, as fast as possible.
+ @param completion Block invoked on the delegate queue of the controller once all the values were delivered to its delegate, with the time it took to deliver them
+ 
+ */
+- (void) replayThroughController:(UHNBGMController *) controller atRecordedTiming:(BOOL) recordedTiming completion:(void (^)(NSTimeInterval elapsedTime)) completion;
+
+@end
@@ -0,0 +1,264 @@
+//
+//  UHNBGMTrafficCapture.m
+//  UHNBGMController
+//
+//  Created by agent on 2026-10-19.
+//  Copyright (c) 2026 University Health Network.
+
+#import "UHNBGMTrafficCapture.h"
+#import "UHNBGMController.h"
+#import "UHNBGMCharacteristicTable.h"
+#import "UHNBLEController.h"
+#import "UHNDebug.h"
+
+#define kTrafficCaptureMagic                "BGMC"
+#define kTrafficCaptureVersion              1
+#define kTrafficCaptureHeaderSize           16
+#define kTrafficCaptureEntryHeaderSize      7
+#define kTrafficCaptureWrittenFlag          0x80
+#define kTrafficCaptureFlushThreshold       4096
+
+// the BLE delegate methods of the controller are private, but the replay drives them as the BLE controller would
+@interface UHNBGMController (TrafficReplay) <UHNBLEControllerDelegate>
+@end
+
+#pragma mark - Traffic Recorder
+
+@interface UHNBGMTrafficRecorder ()
+@property (nonatomic, strong) NSFileHandle *fileHandle;
+@property (nonatomic, strong) NSMutableData *buffer;
+@property (nonatomic, assign) NSTimeInterval startUptime;
+@end
+
+@implementation UHNBGMTrafficRecorder
+
+- (instancetype) initWithPath:(NSString *) path;
+{
+    if (![[NSFileManager defaultManager] createFileAtPath:path contents:nil attributes:nil])
+    {
+        DLog(@"Could not create the capture file %@", path);
+        return nil;
+    }
+    
+    if ((self = [super init]))
+    {
+        self.fileHandle = [NSFileHandle fileHandleForWritingAtPath:path];
+        self.buffer = [NSMutableData dataWithCapacity:kTrafficCaptureFlushThreshold * 2];
+        self.startUptime = [[NSProcessInfo processInfo] systemUptime];
+        
+        // the uptime is monotonic, the date is only kept to give the capture a wall clock reference
+        uint8_t header[kTrafficCaptureHeaderSize] = {0};
+        Float64 startDate = [NSDate timeIntervalSinceReferenceDate];
+        uint64_t startDateBits = 0;
+        memcpy(&startDateBits, &startDate, sizeof(startDateBits));
+        memcpy(header, kTrafficCaptureMagic, 4);
+        header[4] = kTrafficCaptureVersion;
+        
+        for (NSUInteger byte = 0; byte < sizeof(startDateBits); byte++)
+        {
+            header[8 + byte] = (uint8_t) (startDateBits >> (8 * byte));
+        }
+        [self.buffer appendBytes:header length:sizeof(header)];
+    }
+    
+    return self;
+}
+
+- (void) dealloc;
+{
+    [self close];
+}
+
+- (void) recordValue:(NSData *) value forCharacteristic:(NSString *) characteristicUUID written:(BOOL) written;
+{
+    if (nil == self.fileHandle)
+    {
+        return;
+    }
+    
+    uint32_t milliseconds = (uint32_t) (([[NSProcessInfo processInfo] systemUptime] - self.startUptime) * 1000.);
+    uint8_t characteristic = UHNBGMGlucoseServiceCharacteristicForUUID(characteristicUUID) | (written ? kTrafficCaptureWrittenFlag : 0);
+    uint16_t length = (uint16_t) MIN([value length], UINT16_MAX);
+    uint8_t entryHeader[kTrafficCaptureEntryHeaderSize] = {milliseconds, (milliseconds >> 8), (milliseconds >> 16), (milliseconds >> 24), characteristic, length, (length >> 8)};
+    
+    [self.buffer appendBytes:entryHeader length:sizeof(entryHeader)];
+    [self.buffer appendBytes:[value bytes] length:length];
+    
+    if ([self.buffer length] >= kTrafficCaptureFlushThreshold)
+    {
+        [self flush];
+    }
+}
+
+- (void) close;
+{
+    if (self.fileHandle)
+    {
+        [self flush];
+        [self.fileHandle closeFile];
+        self.fileHandle = nil;
+    }
+}
+
+- (void) flush;
+{
+    [self.fileHandle writeData:self.buffer];
+    [self.buffer setLength:0];
+}
+
+@end
+
+#pragma mark - Traffic Replayer
+
+@interface UHNBGMTrafficReplayer ()
+@property (nonatomic, strong) NSData *capture;
+@property (nonatomic, strong) NSData *entryOffsets;
+@property (nonatomic, assign, readwrite) NSUInteger numberOfEntries;
+@property (nonatomic, assign, readwrite) NSTimeInterval duration;
+@property (nonatomic, strong, readwrite) NSDate *captureStartDate;
+@end
+
+@implementation UHNBGMTrafficReplayer
+
+- (instancetype) initWithContentsOfFile:(NSString *) path;
+{
+    NSData *capture = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:nil];
+    const uint8_t *bytes = [capture bytes];
+    
+    if ([capture length] < kTrafficCaptureHeaderSize || memcmp(bytes, kTrafficCaptureMagic, 4) || bytes[4] != kTrafficCaptureVersion)
+    {
+        DLog(@"%@ is not a valid capture file", path);
+        return nil;
+    }
+    
+    if ((self = [super init]))
+    {
+        self.capture = capture;
+        
+        uint64_t startDateBits = 0;
+        Float64 startDate = 0;
+        
+        for (NSUInteger byte = 0; byte < sizeof(startDateBits); byte++)
+        {
+            startDateBits |= ((uint64_t) bytes[8 + byte]) << (8 * byte);
+        }
+        
+        memcpy(&startDate, &startDateBits, sizeof(startDate));
+        self.captureStartDate = [NSDate dateWithTimeIntervalSinceReferenceDate:startDate];
+        
+        // index the received values once, so the replay itself only touches the values
+        NSMutableData *entryOffsets = [NSMutableData data];
+        NSUInteger offset = kTrafficCaptureHeaderSize;
+        uint32_t firstMilliseconds = 0;
+        uint32_t lastMilliseconds = 0;
+        
+        while (offset + kTrafficCaptureEntryHeaderSize <= [capture length])
+        {
+            uint32_t milliseconds = bytes[offset] | (bytes[offset + 1] << 8) | (bytes[offset + 2] << 16) | ((uint32_t) bytes[offset + 3] << 24);
+            uint16_t length = bytes[offset + 5] | (bytes[offset + 6] << 8);
+            
+            if (offset + kTrafficCaptureEntryHeaderSize + length > [capture length])
+            {
+                DLog(@"Ignoring the truncated entry at the end of the capture");
+                break;
+            }
+            
+            if (!(bytes[offset + 4] & kTrafficCaptureWrittenFlag))
+            {
+                uint32_t entryOffset = (uint32_t) offset;
+                [entryOffsets appendBytes:&entryOffset length:sizeof(entryOffset)];
+                firstMilliseconds = (0 == self.numberOfEntries) ? milliseconds : firstMilliseconds;
+                lastMilliseconds = milliseconds;
+                self.numberOfEntries += 1;
+            }
+            
+            offset += kTrafficCaptureEntryHeaderSize + length;
+        }
+        
+        self.entryOffsets = entryOffsets;
+        self.duration = (lastMilliseconds - firstMilliseconds) / 1000.;
+    }
+    
+    return self;
+}
+
+- (void) replayThroughController:(UHNBGMController *) controller atRecordedTiming:(BOOL) recordedTiming completion:(void (^)(NSTimeInterval elapsedTime)) completion;
+{
+    const uint32_t *entryOffsets = [self.entryOffsets bytes];
+    NSTimeInterval startUptime = [[NSProcessInfo processInfo] systemUptime];
+    
+    if (!recordedTiming)
+    {
+        for (NSUInteger index = 0; index < self.numberOfEntries; index++)
+        {
+            [self replayEntryAtOffset:entryOffsets[index] throughController:controller];
+        }
+        
+        // the controller handles the values on its own queue, so wait until the delegate got them all
+        [controller waitForPendingCallbacksWithCompletion:^{
+            if (completion)
+            {
+                completion([[NSProcessInfo processInfo] systemUptime] - startUptime);
+            }
+        }];
+        
+        return;
+    }
+    
+    if (0 == self.numberOfEntries)
+    {
+        if (completion)
+        {
+            completion(0);
+        }
+        
+        return;
+    }
+    
+    uint32_t firstMilliseconds = [self millisecondsOfEntryAtOffset:entryOffsets[0]];
+    
+    for (NSUInteger index = 0; index < self.numberOfEntries; index++)
+    {
+        uint32_t entryOffset = entryOffsets[index];
+        int64_t delay = (int64_t) ([self millisecondsOfEntryAtOffset:entryOffset] - firstMilliseconds) * NSEC_PER_MSEC;
+        BOOL isLastEntry = (index + 1 == self.numberOfEntries);
+        
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, delay), dispatch_get_main_queue(), ^{
+            [self replayEntryAtOffset:entryOffset throughController:controller];
+            
+            if (isLastEntry && completion)
+            {
+                [controller waitForPendingCallbacksWithCompletion:^{
+                    completion([[NSProcessInfo processInfo] systemUptime] - startUptime);
+                }];
+            }
+        });
+    }
+}
+
+#pragma mark - Private Methods
+
+- (uint32_t) millisecondsOfEntryAtOffset:(NSUInteger) offset;
+{
+    const uint8_t *bytes = [self.capture bytes];
+    
+    return bytes[offset] | (bytes[offset + 1] << 8) | (bytes[offset + 2] << 16) | ((uint32_t) bytes[offset + 3] << 24);
+}
+
+- (void) replayEntryAtOffset:(NSUInteger) offset throughController:(UHNBGMController *) controller;
+{
+    const uint8_t *bytes = [self.capture bytes];
+    GlucoseServiceCharacteristic characteristic = bytes[offset + 4] & ~kTrafficCaptureWrittenFlag;
+    uint16_t length = bytes[offset + 5] | (bytes[offset + 6] << 8);
+    NSString *characteristicUUID = UHNBGMUUIDForGlucoseServiceCharacteristic(characteristic);
+    
+    if (nil == characteristicUUID)
+    {
+        return;
+    }
+    
+    NSData *value = [self.capture subdataWithRange:NSMakeRange(offset + kTrafficCaptureEntryHeaderSize, length)];
+    [controller bleController:nil didUpdateValue:value forCharacteristic:characteristicUUID];
+}
+
+@end